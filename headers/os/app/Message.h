@@ -1,5 +1,5 @@
 /*
- * Copyright 2005-2015 Haiku, Inc. All rights reserved.
+ * Copyright 2005-2026 Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -511,6 +511,7 @@ public:
 	class Private;
 	struct message_header;
 	struct field_header;
+	struct field_index;
 
 private:
 	friend class Private;
@@ -531,6 +532,11 @@ private:
 			status_t			_ResizeData(uint32 offset, int32 change);
 
 			uint32				_HashName(const char* name) const;
+			status_t			_BuildFieldIndex();
+			void				_AddToFieldIndex(uint32 hash,
+									int32 field);
+			void				_RemoveFromFieldIndex(int32 field);
+			void				_DeleteFieldIndex();
 			status_t			_FindField(const char* name, type_code type,
 									field_header** _result) const;
 			status_t			_AddField(const char* name, type_code type,
@@ -580,7 +586,9 @@ private:
 
 			void*				fArchivingPointer;
 
-			uint32				fReserved[8];
+			field_index*		fFieldIndex;
+
+			uint32				fReserved[8 - sizeof(void*) / sizeof(uint32)];
 
 			enum				{ sNumReplyPorts = 3 };
 	static	port_id				sReplyPorts[sNumReplyPorts];
@@ -251,6 +251,12 @@ struct fs_vnode_ops {
 				const struct flock* lock, bool wait);
 	status_t (*release_lock)(fs_volume* volume, fs_vnode* vnode, void* cookie,
 				const struct flock* lock);
+
+	/* directory operations, continued; only used if the file system sets
+	   B_FS_SUPPORTS_READ_DIR_PLUS in its fs_info flags */
+	status_t (*read_dir_plus)(fs_volume* volume, fs_vnode* vnode,
+				void* cookie, struct dirent* buffer, size_t bufferSize,
+				struct stat* stats, uint32* _num);
 };
 
 struct file_system_module_info {
@@ -90,6 +90,9 @@ typedef struct area_info {
 	/* "stack" protection is not available on most platforms - it's used
 	   to only commit memory as needed, and have guard pages at the
 	   bottom of the stack. */
+#define B_LARGE_PAGES_AREA		0x8000
+	/* map the area with large pages where possible; only has an effect for
+	   B_FULL_LOCK and B_CONTIGUOUS areas */
 
 extern area_id		create_area(const char *name, void **startAddress,
 						uint32 addressSpec, size_t size, uint32 lock,
@@ -21,6 +21,8 @@
 #define B_FS_HAS_ALIASES				0x00100000
 #define B_FS_SUPPORTS_NODE_MONITORING	0x00200000
 #define B_FS_SUPPORTS_MONITOR_CHILDREN	0x00400000
+#define B_FS_IS_CASE_SENSITIVE			0x00800000
+#define B_FS_SUPPORTS_READ_DIR_PLUS		0x01000000
 
 typedef struct fs_info {
 	dev_t	dev;								/* volume dev_t */
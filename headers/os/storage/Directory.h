@@ -52,6 +52,11 @@ class BDirectory : public BNode, public BEntryList {
 			int32 count = INT_MAX);
 		virtual status_t Rewind();
 		virtual int32 CountEntries();
+		virtual int32 GetNextDirentsPlus(dirent_plus *buffer,
+			size_t bufferSize, int32 count = INT_MAX,
+			const char * const *attributes = NULL, int32 attributeCount = 0,
+			size_t maxAttributeSize = 0);
+			// takes over the vtable slot of _ErectorDirectory1()
 
 		status_t CreateDirectory(const char *path, BDirectory *dir);
 		status_t CreateFile(const char *path, BFile *file,
@@ -69,7 +74,6 @@ class BDirectory : public BNode, public BEntryList {
 		status_t _GetStatFor(const char *path, struct stat *st) const;
 		status_t _GetStatFor(const char *path, struct stat_beos *st) const;
 
-		virtual void _ErectorDirectory1();
 		virtual void _ErectorDirectory2();
 		virtual void _ErectorDirectory3();
 		virtual void _ErectorDirectory4();
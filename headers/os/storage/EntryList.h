@@ -7,6 +7,7 @@
 
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <SupportDefs.h>
 
@@ -15,6 +16,24 @@ class BEntry;
 struct entry_ref;
 
 
+struct dirent_plus {
+	uint32			dp_reclen;			// length of the whole record
+	status_t		dp_stat_status;
+	struct stat		dp_stat;
+	uint32			dp_attr_offset;		// of the first dirent_plus_attr
+	uint32			dp_attr_count;
+	struct dirent	dp_dirent;
+};
+
+struct dirent_plus_attr {
+	uint32			dpa_reclen;
+	status_t		dpa_status;
+	uint32			dpa_type;
+	uint32			dpa_length;			// of the data following the structure
+	off_t			dpa_size;
+};
+
+
 /*! Interface for iterating through a list of filesystem entries
 	Defines a general interface for iterating through a list of entries (i.e.
 	files in a folder
@@ -33,8 +52,14 @@ public:
 	virtual status_t			Rewind() = 0;
 	virtual int32				CountEntries() = 0;
 
+	virtual	int32				GetNextDirentsPlus(struct dirent_plus* buffer,
+									size_t bufferSize,
+									int32 maxEntries = INT_MAX,
+									const char* const* attributes = NULL,
+									int32 attributeCount = 0,
+									size_t maxAttributeSize = 0);
+
 private:
-	virtual	void				_ReservedEntryList1();
 	virtual	void				_ReservedEntryList2();
 	virtual	void				_ReservedEntryList3();
 	virtual	void				_ReservedEntryList4();
@@ -1,11 +1,14 @@
 /*
- * Copyright 2008-2012 Haiku, Inc. All rights reserved.
+ * Copyright 2008-2026 Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT license.
  */
 #ifndef _SCHED_H_
 #define _SCHED_H_
 
 
+#include <sys/types.h>
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,11 +23,35 @@ struct sched_param {
 	int sched_priority;
 };
 
+/* CPU affinity */
+#define CPU_SETSIZE		256
+
+typedef struct _cpuset {
+	__haiku_uint32	bits[CPU_SETSIZE / 32];
+} cpuset_t;
+
+#define CPU_ZERO(set) \
+	do { \
+		unsigned int _i; \
+		for (_i = 0; _i < CPU_SETSIZE / 32; _i++) \
+			(set)->bits[_i] = 0; \
+	} while (0)
+#define CPU_SET(cpu, set) \
+	((set)->bits[(cpu) / 32] |= (__haiku_uint32)1 << ((cpu) % 32))
+#define CPU_CLR(cpu, set) \
+	((set)->bits[(cpu) / 32] &= ~((__haiku_uint32)1 << ((cpu) % 32)))
+#define CPU_ISSET(cpu, set) \
+	(((set)->bits[(cpu) / 32] & ((__haiku_uint32)1 << ((cpu) % 32))) != 0)
+
 
 extern int sched_yield(void);
 extern int sched_get_priority_min(int);
 extern int sched_get_priority_max(int);
 
+extern int sched_getaffinity(pid_t thread, size_t setSize, cpuset_t* set);
+extern int sched_setaffinity(pid_t thread, size_t setSize,
+	const cpuset_t* set);
+
 #ifdef __cplusplus
 }
 #endif
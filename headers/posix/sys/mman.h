@@ -39,6 +39,15 @@
 #define POSIX_MADV_WILLNEED		4
 #define POSIX_MADV_DONTNEED		5
 
+/* madvise() values; unlike POSIX_MADV_DONTNEED, MADV_DONTNEED and MADV_FREE
+   may discard the contents of private anonymous memory */
+#define MADV_NORMAL				POSIX_MADV_NORMAL
+#define MADV_SEQUENTIAL			POSIX_MADV_SEQUENTIAL
+#define MADV_RANDOM				POSIX_MADV_RANDOM
+#define MADV_WILLNEED			POSIX_MADV_WILLNEED
+#define MADV_DONTNEED			POSIX_MADV_DONTNEED
+#define MADV_FREE				6
+
 
 __BEGIN_DECLS
 
@@ -50,6 +59,7 @@ int		mprotect(void* address, size_t length, int protection);
 int		msync(void* address, size_t length, int flags);
 
 int		posix_madvise(void* address, size_t length, int advice);
+int		madvise(void* address, size_t length, int advice);
 
 int		shm_open(const char* name, int openMode, mode_t permissions);
 int		shm_unlink(const char* name);
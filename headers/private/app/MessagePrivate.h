@@ -1,5 +1,5 @@
 /*
- * Copyright 2005-2015, Haiku Inc. All rights reserved.
+ * Copyright 2005-2026, Haiku Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -53,6 +53,26 @@ struct BMessage::field_header {
 } _PACKED;
 
 
+/*!	Maps the names of the fields to their index in the field list. It uses
+	open addressing, and is only built for messages with many fields. It is
+	never flattened: the hash table in the message header and the field
+	chains are kept valid as they are part of the flattened format.
+*/
+struct BMessage::field_index {
+	struct slot {
+		uint32	hash;
+		int32	field;
+	};
+
+	uint32		size;
+		// number of slots, a power of two
+	uint32		shift;
+		// 32 - log2(size)
+	uint32		count;
+	slot		slots[0];
+};
+
+
 struct BMessage::message_header {
 	uint32		format;
 	uint32		what;
@@ -896,6 +896,7 @@
 #define B_FS_HAS_ALIASES				FSSH_B_FS_HAS_ALIASES
 #define B_FS_SUPPORTS_NODE_MONITORING	FSSH_B_FS_SUPPORTS_NODE_MONITORING
 #define B_FS_SUPPORTS_MONITOR_CHILDREN	FSSH_B_FS_SUPPORTS_MONITOR_CHILDREN
+#define B_FS_IS_CASE_SENSITIVE			FSSH_B_FS_IS_CASE_SENSITIVE
 
 #define fs_info	fssh_fs_info
 
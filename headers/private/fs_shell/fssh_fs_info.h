@@ -22,6 +22,7 @@
 #define FSSH_B_FS_HAS_ALIASES				0x00100000
 #define FSSH_B_FS_SUPPORTS_NODE_MONITORING	0x00200000
 #define FSSH_B_FS_SUPPORTS_MONITOR_CHILDREN	0x00400000
+#define FSSH_B_FS_IS_CASE_SENSITIVE			0x00800000
 
 typedef struct fssh_fs_info {
 	fssh_dev_t	dev;								/* volume dev_t */
@@ -10,6 +10,8 @@
 #define ACPI_RSDT_SIGNATURE		"RSDT"
 #define ACPI_XSDT_SIGNATURE		"XSDT"
 #define ACPI_MADT_SIGNATURE		"APIC"
+#define ACPI_SRAT_SIGNATURE		"SRAT"
+#define ACPI_SLIT_SIGNATURE		"SLIT"
 
 #define ACPI_LOCAL_APIC_ENABLED	0x01
 
@@ -202,5 +204,62 @@ typedef struct acpi_local_x2_apic_nmi {
 	uint8	reserved3;				/* reserved (must be set to zero) */
 } _PACKED acpi_local_x2_apic_nmi;
 
+typedef struct acpi_srat {
+	acpi_descriptor_header	header;		/* "SRAT" signature */
+	uint32	table_revision;			/* must be 1 */
+	uint64	reserved;
+} _PACKED acpi_srat;
+
+enum {
+	ACPI_SRAT_PROCESSOR_AFFINITY = 0,
+	ACPI_SRAT_MEMORY_AFFINITY = 1,
+	ACPI_SRAT_X2_APIC_AFFINITY = 2
+};
+
+#define ACPI_SRAT_AFFINITY_ENABLED	0x01
+
+typedef struct acpi_srat_processor_affinity {
+	uint8	type;					/* 0 = processor local APIC affinity */
+	uint8	length;					/* 16 bytes */
+	uint8	proximity_domain_low;	/* bits 0-7 of the proximity domain */
+	uint8	apic_id;				/* the id of the processor's APIC */
+	uint32	flags;					/* 1 = enabled */
+	uint8	sapic_eid;
+	uint8	proximity_domain_high[3];	/* bits 8-31 of the proximity
+										   domain */
+	uint32	clock_domain;
+} _PACKED acpi_srat_processor_affinity;
+
+typedef struct acpi_srat_memory_affinity {
+	uint8	type;					/* 1 = memory affinity */
+	uint8	length;					/* 40 bytes */
+	uint32	proximity_domain;
+	uint16	reserved1;
+	uint64	base_address;			/* physical base address of the range */
+	uint64	range_length;			/* length of the range in bytes */
+	uint32	reserved2;
+	uint32	flags;					/* 1 = enabled, 2 = hot pluggable,
+									   4 = non-volatile */
+	uint64	reserved3;
+} _PACKED acpi_srat_memory_affinity;
+
+typedef struct acpi_srat_x2_apic_affinity {
+	uint8	type;					/* 2 = processor local x2APIC affinity */
+	uint8	length;					/* 24 bytes */
+	uint16	reserved1;
+	uint32	proximity_domain;
+	uint32	x2apic_id;				/* the processor's local x2APIC ID */
+	uint32	flags;					/* 1 = enabled */
+	uint32	clock_domain;
+	uint32	reserved2;
+} _PACKED acpi_srat_x2_apic_affinity;
+
+typedef struct acpi_slit {
+	acpi_descriptor_header	header;		/* "SLIT" signature */
+	uint64	locality_count;			/* number of proximity domains */
+	uint8	entries[];				/* locality_count * locality_count
+									   relative distances, 10 = local */
+} _PACKED acpi_slit;
+
 
 #endif	/* _KERNEL_ARCH_x86_ARCH_ACPI_H */
@@ -0,0 +1,17 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef KERNEL_BOOT_ARCH_X86_ARCH_NUMA_H
+#define KERNEL_BOOT_ARCH_X86_ARCH_NUMA_H
+
+
+#include <SupportDefs.h>
+
+#include <arch/x86/arch_acpi.h>
+
+
+extern void boot_arch_numa_init(acpi_srat* srat, acpi_slit* slit);
+
+
+#endif	/* KERNEL_BOOT_ARCH_X86_ARCH_NUMA_H */
@@ -21,8 +21,10 @@
 #include <util/FixedWidthPointer.h>
 
 
-#define CURRENT_KERNEL_ARGS_VERSION	1
+#define CURRENT_KERNEL_ARGS_VERSION	2
 #define MAX_KERNEL_ARGS_RANGE		20
+#define MAX_NUMA_NODES				8
+#define MAX_NUMA_MEMORY_RANGES		32
 
 // names of common boot_volume fields
 #define BOOT_METHOD						"boot method"
@@ -42,6 +44,13 @@ enum {
 	BOOT_METHOD_DEFAULT		= BOOT_METHOD_HARD_DISK
 };
 
+// physical memory range belonging to a NUMA node
+typedef struct numa_memory_range {
+	uint64	start;
+	uint64	size;
+	uint32	node;
+} _PACKED numa_memory_range;
+
 typedef struct kernel_args {
 	uint32		kernel_args_size;
 	uint32		version;
@@ -62,6 +71,14 @@ typedef struct kernel_args {
 	uint32		num_cpus;
 	addr_range	cpu_kstack[SMP_MAX_CPUS];
 
+	// NUMA topology, if the firmware describes one (num_numa_nodes > 1).
+	// Distances are relative, 10 meaning local.
+	uint32		num_numa_nodes;
+	uint32		num_numa_memory_ranges;
+	numa_memory_range numa_memory_range[MAX_NUMA_MEMORY_RANGES];
+	uint8		numa_distance[MAX_NUMA_NODES][MAX_NUMA_NODES];
+	uint8		cpu_numa_node[SMP_MAX_CPUS];
+
 	// boot volume KMessage data
 	FixedWidthPointer<void> boot_volume;
 	int32		boot_volume_size;
@@ -14,8 +14,11 @@
 // temporary/optional cache syscall API
 #define CACHE_SYSCALLS "cache"
 
-#define CACHE_CLEAR			1	// takes no parameters
-#define CACHE_SET_MODULE	2	// gets the module name as parameter
+#define CACHE_CLEAR					1	// takes no parameters
+#define CACHE_SET_MODULE			2	// gets the module name as parameter
+#define CACHE_GET_READ_AHEAD_STATS	3	// fills in a file_cache_read_ahead_stats
+#define CACHE_SET_READ_AHEAD_LIMIT	4	// gets the maximum window size (uint32),
+										// 0 turns read-ahead off
 
 #define CACHE_MODULES_NAME	"file_cache"
 
@@ -23,6 +26,16 @@
 #define FILE_CACHE_LOADED_COMPLETELY	0x02
 #define FILE_CACHE_NO_IO				0x04
 
+struct file_cache_read_ahead_stats {
+	uint64	read_pages;			// pages requested by file_cache_read()
+	uint64	hit_pages;			// ... that were already in the cache
+	uint64	read_ahead_pages;	// pages scheduled to be read ahead
+	uint64	sequential_reads;	// reads detected as part of a sequential stream
+	uint64	strided_reads;		// reads detected as part of a strided stream
+	uint64	random_reads;		// all other reads
+	uint32	max_window;			// current maximum read-ahead window in bytes
+};
+
 struct cache_module_info {
 	module_info	info;
 
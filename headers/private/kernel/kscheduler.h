@@ -14,6 +14,7 @@
 #include <thread_types.h>
 
 
+struct cpuset_info;
 struct scheduling_analysis;
 struct SchedulerListener;
 
@@ -44,6 +45,11 @@ void scheduler_reschedule(int32 next_state);
 */
 int32 scheduler_set_thread_priority(Thread* thread, int32 priority);
 
+/*!	Applies changes of the given thread's CPU affinity or its team's cpuset.
+	The thread may be running or may be in the ready-to-run queue.
+*/
+void scheduler_update_thread_cpu_mask(Thread* thread);
+
 /*!	Called when the Thread structure is first created.
 	Per-thread housekeeping resources can be allocated.
 	Interrupts must be enabled.
@@ -94,6 +100,20 @@ status_t _user_analyze_scheduling(bigtime_t from, bigtime_t until, void* buffer,
 status_t _user_set_scheduler_mode(int32 mode);
 int32 _user_get_scheduler_mode(void);
 
+status_t _user_set_thread_affinity(thread_id thread, const void* cpus,
+	size_t size);
+status_t _user_get_thread_affinity(thread_id thread, void* cpus, size_t size);
+int32 _user_create_cpuset(const char* name, const void* cpus, size_t size);
+status_t _user_delete_cpuset(int32 id);
+int32 _user_find_cpuset(const char* name);
+status_t _user_set_cpuset_cpus(int32 id, const void* cpus, size_t size);
+status_t _user_get_cpuset_info(int32 id, struct cpuset_info* info,
+	size_t size);
+status_t _user_get_next_cpuset_info(int32* cookie, struct cpuset_info* info,
+	size_t size);
+status_t _user_set_team_cpuset(team_id team, int32 id);
+int32 _user_get_team_cpuset(team_id team);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_NUMA_H
+#define _KERNEL_NUMA_H
+
+
+#include <boot/kernel_args.h>
+
+
+// relative distance of a node to itself
+#define NUMA_LOCAL_DISTANCE		10
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+status_t	numa_init(struct kernel_args* args);
+
+int32		numa_node_count(void);
+int32		numa_cpu_node(int32 cpu);
+int32		numa_physical_page_node(phys_addr_t pageNumber);
+uint8		numa_distance(int32 fromNode, int32 toNode);
+const int32* numa_nodes_by_distance(int32 node);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* _KERNEL_NUMA_H */
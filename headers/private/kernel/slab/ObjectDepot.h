@@ -12,16 +12,17 @@
 
 
 struct DepotMagazine;
+struct object_cache_info;
 
 typedef struct object_depot {
 	rw_lock					outer_lock;
-	spinlock				inner_lock;
-	DepotMagazine*			full;
-	DepotMagazine*			empty;
-	size_t					full_count;
-	size_t					empty_count;
+	struct depot_node*		nodes;
+	int32					node_count;
 	size_t					max_count;
 	size_t					magazine_capacity;
+	size_t					max_magazine_capacity;
+	int32					resize_needed;
+	uint32					resize_count;
 	struct depot_cpu_store*	stores;
 	void*					cookie;
 
@@ -35,7 +36,7 @@ extern "C" {
 #endif
 
 status_t object_depot_init(object_depot* depot, size_t capacity,
-	size_t maxCount, uint32 flags, void* cookie,
+	size_t maxCapacity, size_t maxCount, uint32 flags, void* cookie,
 	void (*returnObject)(object_depot* depot, void* cookie, void* object,
 		uint32 flags));
 void object_depot_destroy(object_depot* depot, uint32 flags);
@@ -45,6 +46,9 @@ void object_depot_store(object_depot* depot, void* object, uint32 flags);
 
 void object_depot_make_empty(object_depot* depot, uint32 flags);
 
+void object_depot_get_info(object_depot* depot,
+	struct object_cache_info* info);
+
 #if PARANOID_KERNEL_FREE
 bool object_depot_contains_object(object_depot* depot, void* object);
 #endif
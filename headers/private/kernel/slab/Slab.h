@@ -32,6 +32,7 @@ enum {
 
 struct ObjectCache;
 typedef struct ObjectCache object_cache;
+struct object_cache_info;
 
 typedef status_t (*object_cache_constructor)(void* cookie, void* object);
 typedef void (*object_cache_destructor)(void* cookie, void* object);
@@ -64,6 +65,9 @@ status_t object_cache_reserve(object_cache* cache, size_t object_count,
 
 void object_cache_get_usage(object_cache* cache, size_t* _allocatedMemory);
 
+status_t _user_get_next_object_cache_info(int32* cookie,
+	struct object_cache_info* info, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
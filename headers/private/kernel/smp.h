@@ -57,6 +57,9 @@ public:
 
 	inline	bool		IsEmpty() const;
 
+	inline	void		And(const CPUSet& other);
+	inline	bool		Matches(const CPUSet& other) const;
+
 private:
 	static	const int	kArraySize = ROUNDUP(SMP_MAX_CPUS, 32) / 32;
 
@@ -169,6 +172,28 @@ CPUSet::IsEmpty() const
 }
 
 
+inline void
+CPUSet::And(const CPUSet& other)
+{
+	for (int i = 0; i < kArraySize; i++)
+		fBitmap[i] &= other.fBitmap[i];
+}
+
+
+/*!	Returns whether the two sets have at least one CPU in common.
+*/
+inline bool
+CPUSet::Matches(const CPUSet& other) const
+{
+	for (int i = 0; i < kArraySize; i++) {
+		if ((fBitmap[i] & other.fBitmap[i]) != 0)
+			return true;
+	}
+
+	return false;
+}
+
+
 // Unless spinlock debug features are enabled, try to inline
 // {acquire,release}_spinlock().
 #if !DEBUG_SPINLOCKS && !B_DEBUG_SPINLOCK_CONTENTION
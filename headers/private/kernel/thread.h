@@ -98,6 +98,7 @@ const char* thread_state_to_text(Thread* thread, int32 state);
 
 int32 thread_get_io_priority(thread_id id);
 void thread_set_io_priority(int32 priority);
+int32 thread_get_io_class(thread_id id);
 
 #define thread_get_current_thread arch_thread_get_current_thread
 
@@ -141,6 +142,8 @@ void thread_unblock(Thread* thread, status_t status);
 
 // used in syscalls.c
 status_t _user_set_thread_priority(thread_id thread, int32 newPriority);
+status_t _user_set_io_class(team_id team, thread_id thread, int32 ioClass);
+int32 _user_get_io_class(team_id team, thread_id thread);
 status_t _user_rename_thread(thread_id thread, const char *name);
 status_t _user_suspend_thread(thread_id thread);
 status_t _user_resume_thread(thread_id thread);
@@ -233,6 +233,9 @@ struct Team : TeamThreadIteratorEntry<team_id>, KernelReferenceable,
 	int				state;			// current team state, see above
 	int32			flags;
 	struct io_context *io_context;
+	int32			io_class;		// written with fLock held, read atomically
+	int32			cpuset;			// protected by fLock, < 0: none
+	CPUSet			cpumask;		// protected by fLock
 	struct realtime_sem_context	*realtime_sem_context;
 	struct xsi_sem_context *xsi_sem_context;
 	struct team_death_entry *death_entry;	// protected by fLock
@@ -437,6 +440,11 @@ struct Thread : TeamThreadIteratorEntry<thread_id>, KernelReferenceable {
 	bool			going_to_suspend;	// protected by scheduler lock
 	int32			priority;		// protected by scheduler lock
 	int32			io_priority;	// protected by fLock
+	int32			io_class;		// written with fLock held, read atomically,
+									// < 0: use the team's
+	CPUSet			cpumask;		// protected by fLock, the CPUs the thread
+									// may run on, further restricted by the
+									// team's cpuset
 	int32			state;			// protected by scheduler lock
 	struct cpu_ent	*cpu;			// protected by scheduler lock
 	struct cpu_ent	*previous_cpu;	// protected by scheduler lock
@@ -32,6 +32,7 @@
 #define B_UNMOUNT_BUSY_PARTITION	0x80000000
 
 struct attr_info;
+struct dirent_plus;
 struct file_descriptor;
 struct generic_io_vec;
 struct kernel_args;
@@ -156,6 +157,11 @@ status_t	vfs_get_mount_point(dev_t mountID, dev_t* _mountPointMountID,
 status_t	vfs_bind_mount_directory(dev_t mountID, ino_t nodeID,
 				dev_t coveredMountID, ino_t coveredNodeID);
 
+/* cache invalidation for the node monitor */
+void		vfs_entry_changed(dev_t mountID, ino_t directoryID,
+				const char *name, ino_t nodeID);
+void		vfs_node_mode_changed(dev_t mountID, ino_t nodeID);
+
 /* calls the syscall dispatcher should use for user file I/O */
 dev_t		_user_mount(const char *path, const char *device,
 				const char *fs_name, uint32 flags, const char *args,
@@ -187,6 +193,10 @@ status_t	_user_read_stat(int fd, const char *path, bool traverseLink,
 				struct stat *stat, size_t statSize);
 status_t	_user_write_stat(int fd, const char *path, bool traverseLink,
 				const struct stat *stat, size_t statSize, int statMask);
+ssize_t		_user_read_dir_plus(int fd, struct dirent_plus *buffer,
+				size_t bufferSize, uint32 maxCount,
+				const char * const *attributes, uint32 attributeCount,
+				size_t maxAttributeSize);
 off_t		_user_seek(int fd, off_t pos, int seekType);
 status_t	_user_create_dir_entry_ref(dev_t device, ino_t inode,
 				const char *name, int perms);
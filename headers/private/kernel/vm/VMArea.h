@@ -112,6 +112,11 @@ public:
 	uint32					cache_type;
 	VMAreaMappings			mappings;
 	uint8*					page_protections;
+	addr_t					last_fault_address;
+	uint32					sequential_faults;
+		// detect sequential read faults, see vm_soft_fault()
+	uint8					access_advice;
+		// MADV_NORMAL, MADV_SEQUENTIAL, or MADV_RANDOM
 
 	struct VMAddressSpace*	address_space;
 	struct VMArea*			cache_next;
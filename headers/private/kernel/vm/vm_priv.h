@@ -20,6 +20,8 @@
 #define PAGE_MODIFIED 0x1000
 #define PAGE_ACCESSED 0x2000
 #define PAGE_PRESENT  0x4000
+#define PAGE_LARGE    0x8000
+	// mapped as part of a large page
 
 
 #ifdef __cplusplus
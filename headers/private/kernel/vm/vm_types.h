@@ -154,6 +154,7 @@ public:
 	uint8					unused : 1;
 
 	uint8					usage_count;
+	uint8					numa_node;
 
 	inline void Init(page_num_t pageNumber);
 
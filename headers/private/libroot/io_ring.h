@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LIBROOT_IO_RING_H
+#define _LIBROOT_IO_RING_H
+
+
+#include <sys/stat.h>
+
+#include <OS.h>
+
+#include <io_ring_defs.h>
+
+
+/*!	A team's view of an I/O ring. Submissions are prepared with
+	io_ring_get_submission() and one of the io_ring_prep_*() functions, and
+	handed to the kernel with io_ring_submit(). Completions are retrieved
+	with io_ring_peek_completion() or io_ring_wait_completion(), and must be
+	released with io_ring_completion_done() afterwards.
+
+	An io_ring must only be used by one thread at a time.
+*/
+typedef struct io_ring {
+	int							fd;
+	area_id						area;
+	uint32						flags;
+	struct io_ring_shared*		shared;
+	struct io_ring_submission*	submissions;
+	struct io_ring_completion*	completions;
+	uint32						submission_tail;
+		// the tail of the prepared submissions, not yet published
+} io_ring;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+status_t	io_ring_init(io_ring* ring, uint32 entries, uint32 flags);
+void		io_ring_uninit(io_ring* ring);
+
+struct io_ring_submission* io_ring_get_submission(io_ring* ring);
+int32		io_ring_submit(io_ring* ring);
+int32		io_ring_submit_and_wait(io_ring* ring, uint32 waitCount);
+
+struct io_ring_completion* io_ring_peek_completion(io_ring* ring);
+status_t	io_ring_wait_completion(io_ring* ring,
+				struct io_ring_completion** _completion, bigtime_t timeout);
+void		io_ring_completion_done(io_ring* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+static inline void
+io_ring_prep_read(struct io_ring_submission* submission, int fd,
+	void* buffer, size_t length, off_t offset)
+{
+	submission->opcode = IO_RING_OP_READ;
+	submission->fd = fd;
+	submission->buffer = (uint64)(addr_t)buffer;
+	submission->length = length;
+	submission->offset = offset;
+}
+
+
+static inline void
+io_ring_prep_write(struct io_ring_submission* submission, int fd,
+	const void* buffer, size_t length, off_t offset)
+{
+	submission->opcode = IO_RING_OP_WRITE;
+	submission->fd = fd;
+	submission->buffer = (uint64)(addr_t)buffer;
+	submission->length = length;
+	submission->offset = offset;
+}
+
+
+static inline void
+io_ring_prep_fsync(struct io_ring_submission* submission, int fd)
+{
+	submission->opcode = IO_RING_OP_FSYNC;
+	submission->fd = fd;
+}
+
+
+static inline void
+io_ring_prep_open(struct io_ring_submission* submission, int dirFD,
+	const char* path, int openMode, mode_t perms)
+{
+	submission->opcode = IO_RING_OP_OPEN;
+	submission->fd = dirFD;
+	submission->path = (uint64)(addr_t)path;
+	submission->open_mode = openMode;
+	submission->perms = perms;
+}
+
+
+static inline void
+io_ring_prep_close(struct io_ring_submission* submission, int fd)
+{
+	submission->opcode = IO_RING_OP_CLOSE;
+	submission->fd = fd;
+}
+
+
+static inline void
+io_ring_prep_stat(struct io_ring_submission* submission, int dirFD,
+	const char* path, struct stat* stat, bool traverseLink)
+{
+	submission->opcode = IO_RING_OP_STAT;
+	submission->fd = dirFD;
+	submission->path = (uint64)(addr_t)path;
+	submission->buffer = (uint64)(addr_t)stat;
+	submission->length = sizeof(struct stat);
+	if (!traverseLink)
+		submission->flags |= IO_RING_NO_TRAVERSE;
+}
+
+
+#endif	/* _LIBROOT_IO_RING_H */
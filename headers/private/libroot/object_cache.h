@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LIBROOT_OBJECT_CACHE_H
+#define _LIBROOT_OBJECT_CACHE_H
+
+
+#include <OS.h>
+
+
+/*!	Caches of objects of the same size, following the design of the kernel's
+	object caches. The objects are carved from slabs. The constructor is
+	called for every object when its slab is created, and the destructor when
+	the slab is freed again, so object_cache_alloc() returns objects in their
+	constructed state, and they must be back in that state when they are
+	passed to object_cache_free(). As in the kernel, the last pointer sized
+	bytes of an object are used while it is free.
+
+	Each thread keeps two magazines of free objects per cache, so most
+	allocations and frees don't need to lock the cache.
+*/
+typedef struct object_cache object_cache;
+
+typedef status_t (*object_cache_constructor)(void* cookie, void* object);
+typedef void (*object_cache_destructor)(void* cookie, void* object);
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+object_cache*	create_object_cache(const char* name, size_t objectSize,
+					size_t alignment, void* cookie,
+					object_cache_constructor constructor,
+					object_cache_destructor destructor);
+void			delete_object_cache(object_cache* cache);
+
+void*			object_cache_alloc(object_cache* cache);
+void			object_cache_free(object_cache* cache, void* object);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#ifdef __cplusplus
+
+#include <new>
+
+
+inline void*
+operator new(size_t size, object_cache* objectCache) throw()
+{
+	return object_cache_alloc(objectCache);
+}
+
+
+template<typename Type>
+inline void
+object_cache_delete(object_cache* objectCache, Type* object)
+{
+	if (object != NULL) {
+		object->~Type();
+		object_cache_free(objectCache, object);
+	}
+}
+
+#endif	// __cplusplus
+
+
+#endif	/* _LIBROOT_OBJECT_CACHE_H */
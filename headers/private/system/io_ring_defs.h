@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_IO_RING_DEFS_H
+#define _SYSTEM_IO_RING_DEFS_H
+
+
+#include <OS.h>
+
+
+#define IO_RING_MAX_ENTRIES			4096
+#define IO_RING_MAX_WORKERS			32
+
+
+// operations
+enum {
+	IO_RING_OP_NOP		= 0,
+	IO_RING_OP_READ,
+	IO_RING_OP_WRITE,
+	IO_RING_OP_FSYNC,
+	IO_RING_OP_OPEN,
+	IO_RING_OP_CLOSE,
+	IO_RING_OP_STAT
+};
+
+// io_ring_submission::flags
+#define IO_RING_LINK				0x01
+	// the next submission is only executed after this one has succeeded
+#define IO_RING_NO_TRAVERSE			0x02
+	// IO_RING_OP_STAT: don't traverse a symlink at the end of the path
+
+// _kern_io_ring_create() flags
+#define IO_RING_POLL				0x01
+	// a kernel thread polls the submission ring, so that submitting doesn't
+	// need a syscall while the ring is busy
+
+// _kern_io_ring_enter() flags
+#define IO_RING_ENTER_WAKEUP		0x01
+	// wake up the polling thread
+
+// io_ring_shared::flags
+#define IO_RING_NEED_WAKEUP			0x01
+	// the polling thread sleeps, and needs to be woken up by
+	// _kern_io_ring_enter() with IO_RING_ENTER_WAKEUP
+
+
+/*!	An operation to be executed. The meaning of the fields depends on the
+	opcode:
+	- IO_RING_OP_READ/WRITE: like pread()/pwrite() of \c length bytes from
+	  or to \c buffer at \c offset; an \c offset of -1 uses and moves the
+	  file position.
+	- IO_RING_OP_FSYNC, IO_RING_OP_CLOSE: only \c fd is used.
+	- IO_RING_OP_OPEN: like openat(), with \c path, \c open_mode, and
+	  \c perms.
+	- IO_RING_OP_STAT: like fstatat(), stores the stat data in \c buffer,
+	  \c length is the size of the stat structure. \c path may be \c NULL.
+	The completion reports the same result as the respective syscall.
+*/
+struct io_ring_submission {
+	uint8		opcode;
+	uint8		flags;
+	uint16		_reserved0;
+	int32		fd;
+	off_t		offset;
+	uint64		buffer;
+	uint64		length;
+	uint64		path;
+	uint32		open_mode;
+	uint32		perms;
+	uint64		user_data;
+	uint64		_reserved1;
+};
+
+struct io_ring_completion {
+	uint64		user_data;
+	int64		result;
+};
+
+/*!	A ring buffer. The producer writes the entries and then advances
+	\c tail, the consumer reads them and then advances \c head. Both indices
+	are free running, the entry of an index is at (index & mask).
+*/
+struct io_ring_queue {
+	uint32		head;
+	uint32		tail;
+	uint32		mask;
+	uint32		entries;
+	uint32		_reserved[12];
+};
+
+/*!	The start of the area shared between the team and the kernel. The
+	submission ring is produced by the team, the completion ring by the
+	kernel. The entries are found at the given offsets from the start of
+	the area.
+*/
+struct io_ring_shared {
+	struct io_ring_queue	submission;
+	struct io_ring_queue	completion;
+	uint32					flags;
+	uint32					completion_overflow;
+		// completions that are waiting for room in the completion ring
+	uint32					submission_offset;
+	uint32					completion_offset;
+};
+
+struct io_ring_info {
+	area_id		area;
+	uint32		submission_entries;
+	uint32		completion_entries;
+};
+
+
+#endif	/* _SYSTEM_IO_RING_DEFS_H */
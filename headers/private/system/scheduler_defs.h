@@ -5,6 +5,8 @@
 #ifndef _SYSTEM_SCHEDULER_DEFS_H
 #define _SYSTEM_SCHEDULER_DEFS_H
 
+#include <sched.h>
+
 #include <OS.h>
 
 
@@ -62,4 +64,17 @@ struct scheduling_analysis {
 };
 
 
+// A named set of CPUs that teams can be confined to (cf.
+// _kern_set_team_cpuset()). The threads of a team only run on CPUs of its
+// cpuset, further restricted by their own affinity.
+#define MAX_CPUSETS		64
+
+struct cpuset_info {
+	int32		id;
+	char		name[B_OS_NAME_LENGTH];
+	cpuset_t	cpus;
+	int32		team_count;
+};
+
+
 #endif	/* _SYSTEM_SCHEDULER_DEFS_H */
@@ -22,13 +22,18 @@ extern "C" {
 #endif
 
 struct attr_info;
+struct compressed_swap_info;
+struct cpuset_info;
 struct dirent;
+struct dirent_plus;
 struct fd_info;
 struct fd_set;
 struct fs_info;
+struct io_ring_info;
 struct iovec;
 struct msqid_ds;
 struct net_stat;
+struct object_cache_info;
 struct pollfd;
 struct rlimit;
 struct scheduling_analysis;
@@ -159,6 +164,9 @@ extern status_t		_kern_resume_thread(thread_id thread);
 extern status_t		_kern_rename_thread(thread_id thread, const char *newName);
 extern status_t		_kern_set_thread_priority(thread_id thread,
 						int32 newPriority);
+extern status_t		_kern_set_io_class(team_id team, thread_id thread,
+						int32 ioClass);
+extern int32		_kern_get_io_class(team_id team, thread_id thread);
 extern status_t		_kern_kill_thread(thread_id thread);
 extern void			_kern_exit_thread(status_t returnValue);
 extern status_t		_kern_cancel_thread(thread_id threadID,
@@ -199,6 +207,23 @@ extern bigtime_t	_kern_estimate_max_scheduling_latency(thread_id thread);
 extern status_t		_kern_set_scheduler_mode(int32 mode);
 extern int32		_kern_get_scheduler_mode(void);
 
+extern status_t		_kern_set_thread_affinity(thread_id thread,
+						const void* cpus, size_t size);
+extern status_t		_kern_get_thread_affinity(thread_id thread, void* cpus,
+						size_t size);
+extern int32		_kern_create_cpuset(const char* name, const void* cpus,
+						size_t size);
+extern status_t		_kern_delete_cpuset(int32 id);
+extern int32		_kern_find_cpuset(const char* name);
+extern status_t		_kern_set_cpuset_cpus(int32 id, const void* cpus,
+						size_t size);
+extern status_t		_kern_get_cpuset_info(int32 id, struct cpuset_info* info,
+						size_t size);
+extern status_t		_kern_get_next_cpuset_info(int32* cookie,
+						struct cpuset_info* info, size_t size);
+extern status_t		_kern_set_team_cpuset(team_id team, int32 id);
+extern int32		_kern_get_team_cpuset(team_id team);
+
 // user/group functions
 extern gid_t		_kern_getgid(bool effective);
 extern uid_t		_kern_getuid(bool effective);
@@ -323,9 +348,17 @@ extern ssize_t		_kern_write(int fd, off_t pos, const void *buffer,
 extern ssize_t		_kern_writev(int fd, off_t pos, const struct iovec *vecs,
 						size_t count);
 extern status_t		_kern_ioctl(int fd, uint32 cmd, void *data, size_t length);
+extern int			_kern_io_ring_create(uint32 entries, uint32 workerCount,
+						uint32 flags, struct io_ring_info *info);
+extern int32		_kern_io_ring_enter(int fd, uint32 submitCount,
+						uint32 waitCount, uint32 flags, bigtime_t timeout);
 extern ssize_t		_kern_read_dir(int fd, struct dirent *buffer,
 						size_t bufferSize, uint32 maxCount);
 extern status_t		_kern_rewind_dir(int fd);
+extern ssize_t		_kern_read_dir_plus(int fd, struct dirent_plus *buffer,
+						size_t bufferSize, uint32 maxCount,
+						const char * const *attributes, uint32 attributeCount,
+						size_t maxAttributeSize);
 extern status_t		_kern_read_stat(int fd, const char *path, bool traverseLink,
 						struct stat *stat, size_t statSize);
 extern status_t		_kern_write_stat(int fd, const char *path,
@@ -446,6 +479,10 @@ extern status_t		_kern_memory_advice(void *address, size_t size,
 
 extern status_t		_kern_get_memory_properties(team_id teamID,
 						const void *address, uint32* _protected, uint32* _lock);
+extern status_t		_kern_get_compressed_swap_info(
+						struct compressed_swap_info *info, size_t size);
+extern status_t		_kern_get_next_object_cache_info(int32 *cookie,
+						struct object_cache_info *info, size_t size);
 
 /* kernel port functions */
 extern port_id		_kern_create_port(int32 queue_length, const char *name);
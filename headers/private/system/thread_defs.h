@@ -34,6 +34,18 @@ enum {
 };
 
 
+// I/O priority classes, honored by the I/O schedulers (cf.
+// _kern_set_io_class()). Threads use their team's class, unless they have
+// one of their own; teams inherit their parent's class.
+enum {
+	IO_CLASS_REALTIME	= 0,
+	IO_CLASS_NORMAL		= 1,
+	IO_CLASS_IDLE		= 2,
+
+	IO_CLASS_COUNT
+};
+
+
 #define THREAD_CREATION_FLAG_DEFER_SIGNALS	0x01
 	// create the thread with signals deferred, i.e. with
 	// user_thread::defer_signals set to 1
@@ -20,6 +20,10 @@ enum {
 	TLS_ON_EXIT_THREAD_SLOT,
 	TLS_USER_THREAD_SLOT,
 	TLS_DYNAMIC_THREAD_VECTOR,
+	TLS_MALLOC_SLOT,
+		// the malloc() thread cache
+	TLS_OBJECT_CACHE_SLOT,
+		// the thread's object cache magazines
 
 	// Note: these entries can safely be changed between
 	// releases; 3rd party code always calls tls_allocate()
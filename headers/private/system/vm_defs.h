@@ -35,9 +35,11 @@
 	// Usable from userland according to its protection flags, but the area
 	// itself is not deletable, resizable, etc from userland.
 
-#define B_USER_AREA_FLAGS		(B_USER_PROTECTION | B_OVERCOMMITTING_AREA)
+#define B_USER_AREA_FLAGS \
+	(B_USER_PROTECTION | B_OVERCOMMITTING_AREA | B_LARGE_PAGES_AREA)
 #define B_KERNEL_AREA_FLAGS \
-	(B_KERNEL_PROTECTION | B_USER_CLONEABLE_AREA | B_SHARED_AREA)
+	(B_KERNEL_PROTECTION | B_USER_CLONEABLE_AREA | B_SHARED_AREA \
+		| B_LARGE_PAGES_AREA)
 
 // mapping argument for several internal VM functions
 enum {
@@ -54,4 +56,58 @@ enum {
 #define MEMORY_TYPE_SHIFT		28
 
 
+// statistics of the compressed swap pool, see
+// _kern_get_compressed_swap_info()
+struct compressed_swap_info {
+	uint64		pool_limit;
+		// maximum amount of memory the pool may use, 0 if it's disabled
+	uint64		pool_size;
+		// memory currently used for compressed pages
+	uint64		stored_pages;
+	uint64		compressed_bytes;
+		// size of the stored pages after compression
+	uint64		rejected_pages;
+		// pages that went to the swap file, because they didn't compress
+		// well enough, or the pool was full
+	uint64		pool_loads;
+	bigtime_t	pool_load_time;
+	uint64		disk_loads;
+	bigtime_t	disk_load_time;
+};
+
+
+// statistics of a kernel object cache, see
+// _kern_get_next_object_cache_info()
+#define B_OBJECT_CACHE_NAME_LENGTH	32
+
+struct object_cache_info {
+	char		name[B_OBJECT_CACHE_NAME_LENGTH];
+	uint64		object_size;
+	uint64		slab_size;
+	uint64		usage;
+		// memory used by the cache's slabs
+	uint64		total_objects;
+	uint64		used_objects;
+		// includes the objects held in the depot's magazines
+	uint64		empty_slabs;
+	uint32		flags;
+
+	// the per-CPU magazine layer, all zero if the cache doesn't have one
+	uint32		magazine_capacity;
+	uint32		max_magazine_capacity;
+	uint32		magazine_resizes;
+	uint32		full_magazines;
+	uint32		empty_magazines;
+	uint64		depot_hits;
+		// allocations served from a magazine
+	uint64		depot_misses;
+		// allocations that had to go to the slabs
+	uint64		magazine_exchanges;
+	uint64		remote_exchanges;
+		// full magazines taken from another NUMA node
+	uint64		depot_contention;
+		// retried magazine stack operations
+};
+
+
 #endif	/* _SYSTEM_VM_DEFS_H */
@@ -28,7 +28,7 @@
 
 #include "dma_resources.h"
 #include "IORequest.h"
-#include "IOSchedulerSimple.h"
+#include "IOSchedulerRoster.h"
 
 
 //#define TRACE_SCSI_DISK
@@ -466,8 +466,11 @@ das_set_capacity(das_driver_info* info, uint64 capacity, uint32 blockSize)
 		if (status != B_OK)
 			panic("initializing DMAResource failed: %s", strerror(status));
 
-		info->io_scheduler = new(std::nothrow) IOSchedulerSimple(
-			info->dma_resource);
+		char* path = sSCSIPeripheral->compose_device_name(info->node,
+			"disk/scsi");
+		info->io_scheduler = IOSchedulerRoster::CreateScheduler(
+			info->dma_resource, path);
+		free(path);
 		if (info->io_scheduler == NULL)
 			panic("allocating IOScheduler failed.");
 
@@ -52,6 +52,7 @@ typedef struct {
 	::virtio_queue			virtio_queue;
 	IOScheduler*			io_scheduler;
 	DMAResource*			dma_resource;
+	char					device_path[64];
 
 	struct virtio_blk_config	config;
 
@@ -77,7 +78,7 @@ typedef struct {
 
 #include "dma_resources.h"
 #include "IORequest.h"
-#include "IOSchedulerSimple.h"
+#include "IOSchedulerRoster.h"
 
 
 //#define TRACE_VIRTIO_BLOCK
@@ -517,8 +518,8 @@ virtio_block_set_capacity(virtio_block_driver_info* info, uint64 capacity,
 		if (status != B_OK)
 			panic("initializing DMAResource failed: %s", strerror(status));
 
-		info->io_scheduler = new(std::nothrow) IOSchedulerSimple(
-			info->dma_resource);
+		info->io_scheduler = IOSchedulerRoster::CreateScheduler(
+			info->dma_resource, info->device_path);
 		if (info->io_scheduler == NULL)
 			panic("allocating IOScheduler failed.");
 
@@ -631,11 +632,10 @@ virtio_block_register_child_devices(void* _cookie)
 	if (id < 0)
 		return id;
 
-	char name[64];
-	snprintf(name, sizeof(name), "disk/virtual/virtio_block/%" B_PRId32 "/raw",
-		id);
+	snprintf(info->device_path, sizeof(info->device_path),
+		"disk/virtual/virtio_block/%" B_PRId32 "/raw", id);
 
-	status = sDeviceManager->publish_device(info->node, name,
+	status = sDeviceManager->publish_device(info->node, info->device_path,
 		VIRTIO_BLOCK_DEVICE_MODULE_NAME);
 
 	return status;
@@ -209,7 +209,10 @@ bfs_read_fs_stat(fs_volume* _volume, struct fs_info* info)
 	info->flags = B_FS_IS_PERSISTENT | B_FS_HAS_ATTR | B_FS_HAS_MIME
 		| (volume->IndicesNode() != NULL ? B_FS_HAS_QUERY : 0)
 		| (volume->IsReadOnly() ? B_FS_IS_READONLY : 0)
-		| B_FS_SUPPORTS_MONITOR_CHILDREN;
+		| B_FS_SUPPORTS_MONITOR_CHILDREN | B_FS_IS_CASE_SENSITIVE;
+#ifndef FS_SHELL
+	info->flags |= B_FS_SUPPORTS_READ_DIR_PLUS;
+#endif
 
 	info->io_size = BFS_IO_SIZE;
 		// whatever is appropriate here?
@@ -1714,6 +1717,41 @@ bfs_read_dir(fs_volume* _volume, fs_vnode* _node, void* _cookie,
 }
 
 
+#ifndef FS_SHELL
+/*!	Reads directory entries like bfs_read_dir(), and fills in their stat
+	data, too.
+*/
+static status_t
+bfs_read_dir_plus(fs_volume* _volume, fs_vnode* _node, void* _cookie,
+	struct dirent* dirent, size_t bufferSize, struct stat* stats,
+	uint32* _num)
+{
+	FUNCTION();
+
+	status_t status = bfs_read_dir(_volume, _node, _cookie, dirent,
+		bufferSize, _num);
+	if (status != B_OK)
+		return status;
+
+	Volume* volume = (Volume*)_volume->private_volume;
+
+	for (uint32 i = 0; i < *_num; i++) {
+		// the inodes of the entries are usually cached already
+		Vnode vnode(volume, dirent->d_ino);
+		Inode* inode;
+		if (vnode.Get(&inode) == B_OK)
+			fill_stat_buffer(inode, stats[i]);
+		else
+			stats[i].st_mode = 0;
+
+		dirent = (struct dirent*)((uint8*)dirent + dirent->d_reclen);
+	}
+
+	return B_OK;
+}
+#endif	// !FS_SHELL
+
+
 /*!	Sets the TreeIterator back to the beginning of the directory. */
 static status_t
 bfs_rewind_dir(fs_volume* /*_volume*/, fs_vnode* /*node*/, void* _cookie)
@@ -2495,7 +2533,17 @@ fs_vnode_ops gBFSVnodeOps = {
 	&bfs_remove_attr,
 
 	/* special nodes */
-	&bfs_create_special_node
+	&bfs_create_special_node,
+	NULL,	// get_super_vnode
+
+#ifndef FS_SHELL
+	/* lock operations */
+	NULL,	// test_lock
+	NULL,	// acquire_lock
+	NULL,	// release_lock
+
+	&bfs_read_dir_plus
+#endif
 };
 
 static file_system_module_info sBeFileSystem = {
@@ -102,7 +102,8 @@ packagefs_read_fs_info(fs_volume* fsVolume, struct fs_info* info)
 	FUNCTION("volume: %p, info: %p\n", volume, info);
 
 	info->flags = B_FS_IS_PERSISTENT | B_FS_IS_READONLY | B_FS_HAS_MIME
-		| B_FS_HAS_ATTR | B_FS_HAS_QUERY | B_FS_SUPPORTS_NODE_MONITORING;
+		| B_FS_HAS_ATTR | B_FS_HAS_QUERY | B_FS_SUPPORTS_NODE_MONITORING
+		| B_FS_IS_CASE_SENSITIVE | B_FS_SUPPORTS_READ_DIR_PLUS;
 	info->block_size = 4096;
 	info->io_size = kOptimalIOSize;
 	info->total_blocks = info->free_blocks = 1;
@@ -299,18 +300,10 @@ packagefs_access(fs_volume* fsVolume, fs_vnode* fsNode, int mode)
 }
 
 
-static status_t
-packagefs_read_stat(fs_volume* fsVolume, fs_vnode* fsNode, struct stat* st)
+/*!	Fills in \a st from \a node. The caller must hold the node's lock. */
+static void
+fill_stat(Node* node, struct stat* st)
 {
-	Volume* volume = (Volume*)fsVolume->private_volume;
-	Node* node = (Node*)fsNode->private_node;
-
-	FUNCTION("volume: %p, node: %p (%" B_PRId64 ")\n", volume, node,
-		node->ID());
-	TOUCH(volume);
-
-	NodeReadLocker nodeLocker(node);
-
 	st->st_mode = node->Mode();
 	st->st_nlink = 1;
 	st->st_uid = node->UserID();
@@ -323,6 +316,21 @@ packagefs_read_stat(fs_volume* fsVolume, fs_vnode* fsNode, struct stat* st)
 		// TODO: Perhaps manage a changed time (particularly for directories)?
 	st->st_crtim = st->st_mtim;
 	st->st_blocks = (st->st_size + 511) / 512;
+}
+
+
+static status_t
+packagefs_read_stat(fs_volume* fsVolume, fs_vnode* fsNode, struct stat* st)
+{
+	Volume* volume = (Volume*)fsVolume->private_volume;
+	Node* node = (Node*)fsNode->private_node;
+
+	FUNCTION("volume: %p, node: %p (%" B_PRId64 ")\n", volume, node,
+		node->ID());
+	TOUCH(volume);
+
+	NodeReadLocker nodeLocker(node);
+	fill_stat(node, st);
 
 	return B_OK;
 }
@@ -563,19 +571,14 @@ packagefs_free_dir_cookie(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie)
 }
 
 
+/*!	Reads the next entries of \a cookie's directory. If \a stats is not
+	\c NULL, the stat data of the entries is filled in as well; the parent
+	directory's is left to the VFS, since it can't be locked here.
+*/
 static status_t
-packagefs_read_dir(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie,
-	struct dirent* buffer, size_t bufferSize, uint32* _count)
+read_directory(Volume* volume, DirectoryCookie* cookie, struct dirent* buffer,
+	size_t bufferSize, struct stat* stats, uint32* _count)
 {
-	Volume* volume = (Volume*)fsVolume->private_volume;
-	Node* node = (Node*)fsNode->private_node;
-	DirectoryCookie* cookie = (DirectoryCookie*)_cookie;
-
-	FUNCTION("volume: %p, node: %p (%" B_PRId64 "), cookie: %p\n", volume, node,
-		node->ID(), cookie);
-	TOUCH(volume);
-	TOUCH(node);
-
 	NodeWriteLocker dirLocker(cookie->directory);
 
 	uint32 maxCount = *_count;
@@ -615,6 +618,19 @@ packagefs_read_dir(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie,
 		buffer->d_dev = volume->ID();
 		buffer->d_ino = child->ID();
 
+		if (stats != NULL) {
+			if (cookie->state == 1) {
+				// ".." -- locking the parent would reverse the lock order
+				stats[count].st_mode = 0;
+			} else if (child == cookie->directory) {
+				// "." -- already locked
+				fill_stat(child, &stats[count]);
+			} else {
+				NodeReadLocker childLocker(child);
+				fill_stat(child, &stats[count]);
+			}
+		}
+
 		count++;
 		previousEntry = buffer;
 		bufferSize -= buffer->d_reclen;
@@ -628,6 +644,41 @@ packagefs_read_dir(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie,
 }
 
 
+static status_t
+packagefs_read_dir(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie,
+	struct dirent* buffer, size_t bufferSize, uint32* _count)
+{
+	Volume* volume = (Volume*)fsVolume->private_volume;
+	Node* node = (Node*)fsNode->private_node;
+	DirectoryCookie* cookie = (DirectoryCookie*)_cookie;
+
+	FUNCTION("volume: %p, node: %p (%" B_PRId64 "), cookie: %p\n", volume, node,
+		node->ID(), cookie);
+	TOUCH(volume);
+	TOUCH(node);
+
+	return read_directory(volume, cookie, buffer, bufferSize, NULL, _count);
+}
+
+
+static status_t
+packagefs_read_dir_plus(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie,
+	struct dirent* buffer, size_t bufferSize, struct stat* stats,
+	uint32* _count)
+{
+	Volume* volume = (Volume*)fsVolume->private_volume;
+	Node* node = (Node*)fsNode->private_node;
+	DirectoryCookie* cookie = (DirectoryCookie*)_cookie;
+
+	FUNCTION("volume: %p, node: %p (%" B_PRId64 "), cookie: %p\n", volume, node,
+		node->ID(), cookie);
+	TOUCH(volume);
+	TOUCH(node);
+
+	return read_directory(volume, cookie, buffer, bufferSize, stats, _count);
+}
+
+
 static status_t
 packagefs_rewind_dir(fs_volume* fsVolume, fs_vnode* fsNode, void* _cookie)
 {
@@ -1237,9 +1288,19 @@ fs_vnode_ops gPackageFSVnodeOps = {
 	&packagefs_read_attr_stat,
 	NULL,	// write_attr_stat,
 	NULL,	// rename_attr,
-	NULL	// remove_attr,
+	NULL,	// remove_attr,
 
 	// TODO: FS layer operations
+	NULL,	// create_special_node,
+	NULL,	// get_super_vnode,
+
+	// lock operations
+	NULL,	// test_lock,
+	NULL,	// acquire_lock,
+	NULL,	// release_lock,
+
+	// directory operations, continued
+	&packagefs_read_dir_plus
 };
 
 
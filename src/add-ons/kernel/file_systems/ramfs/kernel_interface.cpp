@@ -135,7 +135,7 @@ ramfs_read_fs_info(fs_volume* _volume, struct fs_info *info)
 	status_t error = B_OK;
 	if (VolumeReadLocker locker = volume) {
 		info->flags = B_FS_IS_PERSISTENT | B_FS_HAS_ATTR | B_FS_HAS_MIME
-			| B_FS_HAS_QUERY;
+			| B_FS_HAS_QUERY | B_FS_IS_CASE_SENSITIVE;
 		info->block_size = volume->GetBlockSize();
 		info->io_size = kOptimalIOSize;
 		info->total_blocks = volume->CountBlocks();
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <scheduler_defs.h>
+#include <syscalls.h>
+
+
+extern const char* __progname;
+static const char* kCommandName = __progname;
+
+static int32 sCPUCount;
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(exitCode == 0 ? stdout : stderr,
+		"Usage: %s [list]\n"
+		"       %s create <name> <cpus>\n"
+		"       %s set <name> <cpus>\n"
+		"       %s delete <name>\n"
+		"       %s team <team> [<name> | none]\n"
+		"       %s thread <thread> [<cpus>]\n"
+		"       %s exec (<name> | -c <cpus>) <command> [<arguments>...]\n"
+		"Manages the named sets of CPUs teams can be confined to, and the CPU\n"
+		"affinity of single threads.\n"
+		"\n"
+		"  list    Lists all cpusets with their CPUs.\n"
+		"  create  Creates a cpuset.\n"
+		"  set     Changes the CPUs of a cpuset.\n"
+		"  delete  Deletes a cpuset; its teams may use all CPUs again.\n"
+		"  team    Shows or sets the cpuset of a team.\n"
+		"  thread  Shows or sets the CPUs a thread may run on.\n"
+		"  exec    Runs a command in a cpuset, or on the given CPUs.\n"
+		"\n"
+		"<cpus> is a list of CPUs and ranges of CPUs, like \"0-3,6\".\n",
+		kCommandName, kCommandName, kCommandName, kCommandName, kCommandName,
+		kCommandName, kCommandName);
+	exit(exitCode);
+}
+
+
+static void
+check_status(status_t status, const char* action)
+{
+	if (status >= B_OK)
+		return;
+
+	fprintf(stderr, "%s: Failed to %s: %s\n", kCommandName, action,
+		strerror(status));
+	exit(1);
+}
+
+
+static void
+parse_cpus(const char* string, cpuset_t& set)
+{
+	CPU_ZERO(&set);
+
+	const char* pos = string;
+	while (*pos != '\0') {
+		char* end;
+		long first = strtol(pos, &end, 10);
+		long last = first;
+		if (end != pos && *end == '-') {
+			pos = end + 1;
+			last = strtol(pos, &end, 10);
+		}
+
+		if (end == pos || (*end != ',' && *end != '\0') || first < 0
+			|| last < first || last >= sCPUCount) {
+			fprintf(stderr, "%s: Invalid CPU list \"%s\".\n", kCommandName,
+				string);
+			exit(1);
+		}
+
+		for (long cpu = first; cpu <= last; cpu++)
+			CPU_SET(cpu, &set);
+
+		pos = *end == ',' ? end + 1 : end;
+	}
+
+	if (pos == string) {
+		fprintf(stderr, "%s: No CPUs given.\n", kCommandName);
+		exit(1);
+	}
+}
+
+
+static void
+print_cpus(const cpuset_t& set)
+{
+	bool first = true;
+	int32 cpu = 0;
+	while (cpu < sCPUCount) {
+		if (!CPU_ISSET(cpu, &set)) {
+			cpu++;
+			continue;
+		}
+
+		int32 last = cpu;
+		while (last + 1 < sCPUCount && CPU_ISSET(last + 1, &set))
+			last++;
+
+		if (!first)
+			putchar(',');
+		if (last > cpu)
+			printf("%" B_PRId32 "-%" B_PRId32, cpu, last);
+		else
+			printf("%" B_PRId32, cpu);
+
+		first = false;
+		cpu = last + 1;
+	}
+}
+
+
+static int32
+find_cpuset(const char* name)
+{
+	int32 id = _kern_find_cpuset(name);
+	if (id < 0) {
+		fprintf(stderr, "%s: There is no cpuset \"%s\".\n", kCommandName,
+			name);
+		exit(1);
+	}
+	return id;
+}
+
+
+static void
+list_cpusets()
+{
+	printf("%-32s %5s %6s  %s\n", "Name", "Id", "Teams", "CPUs");
+
+	int32 cookie = 0;
+	cpuset_info info;
+	while (_kern_get_next_cpuset_info(&cookie, &info, sizeof(info)) == B_OK) {
+		printf("%-32s %5" B_PRId32 " %6" B_PRId32 "  ", info.name, info.id,
+			info.team_count);
+		print_cpus(info.cpus);
+		putchar('\n');
+	}
+}
+
+
+static void
+show_team(team_id team)
+{
+	int32 id = _kern_get_team_cpuset(team);
+	if (id == B_ENTRY_NOT_FOUND) {
+		puts("none");
+		return;
+	}
+	check_status(id, "get the cpuset of the team");
+
+	cpuset_info info;
+	check_status(_kern_get_cpuset_info(id, &info, sizeof(info)),
+		"get the cpuset of the team");
+
+	printf("%s (", info.name);
+	print_cpus(info.cpus);
+	puts(")");
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info systemInfo;
+	get_system_info(&systemInfo);
+	sCPUCount = systemInfo.cpu_count;
+	if (sCPUCount > CPU_SETSIZE)
+		sCPUCount = CPU_SETSIZE;
+
+	if (argc < 2 || strcmp(argv[1], "list") == 0) {
+		list_cpusets();
+		return 0;
+	}
+
+	const char* command = argv[1];
+	if (strcmp(command, "-h") == 0 || strcmp(command, "--help") == 0)
+		usage(0);
+
+	if (strcmp(command, "create") == 0 || strcmp(command, "set") == 0) {
+		if (argc != 4)
+			usage(1);
+
+		cpuset_t set;
+		parse_cpus(argv[3], set);
+
+		if (command[0] == 'c') {
+			check_status(_kern_create_cpuset(argv[2], &set, sizeof(set)),
+				"create the cpuset");
+		} else {
+			check_status(_kern_set_cpuset_cpus(find_cpuset(argv[2]), &set,
+				sizeof(set)), "change the cpuset");
+		}
+		return 0;
+	}
+
+	if (strcmp(command, "delete") == 0) {
+		if (argc != 3)
+			usage(1);
+
+		check_status(_kern_delete_cpuset(find_cpuset(argv[2])),
+			"delete the cpuset");
+		return 0;
+	}
+
+	if (strcmp(command, "team") == 0) {
+		if (argc != 3 && argc != 4)
+			usage(1);
+
+		team_id team = strtol(argv[2], NULL, 0);
+		if (argc == 3) {
+			show_team(team);
+			return 0;
+		}
+
+		int32 id = strcmp(argv[3], "none") == 0 ? -1 : find_cpuset(argv[3]);
+		check_status(_kern_set_team_cpuset(team, id),
+			"set the cpuset of the team");
+		return 0;
+	}
+
+	if (strcmp(command, "thread") == 0) {
+		if (argc != 3 && argc != 4)
+			usage(1);
+
+		thread_id thread = strtol(argv[2], NULL, 0);
+		cpuset_t set;
+		if (argc == 3) {
+			check_status(_kern_get_thread_affinity(thread, &set, sizeof(set)),
+				"get the affinity of the thread");
+			print_cpus(set);
+			putchar('\n');
+			return 0;
+		}
+
+		parse_cpus(argv[3], set);
+		check_status(_kern_set_thread_affinity(thread, &set, sizeof(set)),
+			"set the affinity of the thread");
+		return 0;
+	}
+
+	if (strcmp(command, "exec") == 0) {
+		int argi = 2;
+		if (argi + 1 < argc && strcmp(argv[argi], "-c") == 0) {
+			cpuset_t set;
+			parse_cpus(argv[argi + 1], set);
+			check_status(_kern_set_thread_affinity(find_thread(NULL), &set,
+				sizeof(set)), "set the affinity");
+			argi += 2;
+		} else if (argi < argc) {
+			check_status(_kern_set_team_cpuset(B_CURRENT_TEAM,
+				find_cpuset(argv[argi])), "set the cpuset");
+			argi++;
+		}
+
+		if (argi >= argc)
+			usage(1);
+
+		execvp(argv[argi], argv + argi);
+		fprintf(stderr, "%s: Failed to execute \"%s\": %s\n", kCommandName,
+			argv[argi], strerror(errno));
+		return 1;
+	}
+
+	usage(1);
+	return 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <syscalls.h>
+#include <thread_defs.h>
+
+
+extern const char* __progname;
+static const char* kCommandName = __progname;
+
+static const char* const kClassNames[IO_CLASS_COUNT] = {
+	"realtime",
+	"normal",
+	"idle"
+};
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(exitCode == 0 ? stdout : stderr,
+		"Usage: %s [-c <class>] [-p <team> | -t <thread>]\n"
+		"       %s -c <class> <command> [<arguments>...]\n"
+		"Shows or sets the I/O class of a team or thread, or runs a command\n"
+		"with the given I/O class.\n"
+		"\n"
+		"  -c <class>   One of \"realtime\", \"normal\", or \"idle\". For a\n"
+		"               thread, \"team\" makes it use its team's class again.\n"
+		"  -p <team>    The team to show or change. Defaults to the parent\n"
+		"               team.\n"
+		"  -t <thread>  The thread to show or change.\n",
+		kCommandName, kCommandName);
+	exit(exitCode);
+}
+
+
+static int32
+parse_class(const char* name)
+{
+	for (int32 i = 0; i < IO_CLASS_COUNT; i++) {
+		if (strcmp(name, kClassNames[i]) == 0)
+			return i;
+	}
+
+	if (strcmp(name, "team") == 0)
+		return -1;
+
+	fprintf(stderr, "%s: Invalid I/O class \"%s\".\n", kCommandName, name);
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* className = NULL;
+	team_id team = getppid();
+	thread_id thread = -1;
+
+	int argi = 1;
+	for (; argi < argc && argv[argi][0] == '-'; argi++) {
+		const char* arg = argv[argi];
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+			usage(0);
+		if (argi + 1 >= argc)
+			usage(1);
+
+		if (strcmp(arg, "-c") == 0)
+			className = argv[++argi];
+		else if (strcmp(arg, "-p") == 0)
+			team = strtol(argv[++argi], NULL, 0);
+		else if (strcmp(arg, "-t") == 0)
+			thread = strtol(argv[++argi], NULL, 0);
+		else
+			usage(1);
+	}
+
+	if (argi < argc) {
+		// run a command with the given class
+		if (className == NULL || thread >= 0)
+			usage(1);
+
+		status_t status = _kern_set_io_class(B_CURRENT_TEAM, -1,
+			parse_class(className));
+		if (status != B_OK) {
+			fprintf(stderr, "%s: Failed to set the I/O class: %s\n",
+				kCommandName, strerror(status));
+			return 1;
+		}
+
+		execvp(argv[argi], argv + argi);
+		fprintf(stderr, "%s: Failed to execute \"%s\": %s\n", kCommandName,
+			argv[argi], strerror(errno));
+		return 1;
+	}
+
+	if (className != NULL) {
+		status_t status = _kern_set_io_class(team, thread,
+			parse_class(className));
+		if (status != B_OK) {
+			fprintf(stderr, "%s: Failed to set the I/O class: %s\n",
+				kCommandName, strerror(status));
+			return 1;
+		}
+		return 0;
+	}
+
+	int32 ioClass = _kern_get_io_class(team, thread);
+	if (ioClass < 0) {
+		fprintf(stderr, "%s: Failed to get the I/O class: %s\n", kCommandName,
+			strerror(ioClass));
+		return 1;
+	}
+
+	puts(ioClass < IO_CLASS_COUNT ? kClassNames[ioClass] : "unknown");
+	return 0;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright 2002-2008, Haiku Inc. All rights reserved.
+ * Copyright 2002-2026, Haiku Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -8,19 +8,23 @@
  *		Bjoern Herzig (xRaich[o]2x)
  *		Thomas Schmidt <thomas.compix@googlemail.com>
  */
+#include <sched.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 
 #include <OS.h>
 
+#include <syscalls.h>
+
 
 enum {
 	Team = 0,
 	Id,
 	Threads,
 	Gid,
-	Uid
+	Uid,
+	CPUSet
 };
 
 struct ColumnIndo {
@@ -32,7 +36,8 @@ struct ColumnIndo {
 	{ "Id",			"%5s",		"%5" B_PRId32  },
 	{ "Threads",	"#%7s",		"%8" B_PRId32 },
 	{ "Gid",		"%4s",		"%4d" },
-	{ "Uid",		"%4s",		"%4d" }
+	{ "Uid",		"%4s",		"%4d" },
+	{ "CPUSet",		"%6s",		"%6s" }
 };
 
 #define maxColumns  10
@@ -41,10 +46,47 @@ int ColumnsCount = 5;
 
 const char* sStates[] = {"run", "rdy", "msg", "zzz", "sus", "wait"};
 
-static void printTeamThreads(team_info* teamInfo, bool printSemaphoreInfo);
+static void printTeamThreads(team_info* teamInfo, bool printSemaphoreInfo,
+	bool printAffinity);
 static void printTeamInfo(team_info* teamInfo, bool printHeader);
 
 
+/*!	Prints the CPUs in \a set as a list of ranges, like "0-3,6".
+*/
+static void
+printCPUList(const cpuset_t* set)
+{
+	int32 cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+	int32 cpu = 0;
+	bool first = true;
+
+	if (cpuCount > CPU_SETSIZE)
+		cpuCount = CPU_SETSIZE;
+
+	while (cpu < cpuCount) {
+		int32 last;
+		if (!CPU_ISSET(cpu, set)) {
+			cpu++;
+			continue;
+		}
+
+		last = cpu;
+		while (last + 1 < cpuCount && CPU_ISSET(last + 1, set))
+			last++;
+
+		if (!first)
+			putchar(',');
+		if (last > cpu)
+			printf("%" B_PRId32 "-%" B_PRId32, cpu, last);
+		else
+			printf("%" B_PRId32, cpu);
+
+		first = false;
+		cpu = last + 1;
+	}
+}
+
+
 static void
 printTeamInfo(team_info* teamInfo, bool printHeader)
 {
@@ -75,6 +117,15 @@ printTeamInfo(team_info* teamInfo, bool printHeader)
 			case Uid:
 				printf(Infos[Uid].format, teamInfo->uid);
 				break;
+			case CPUSet:
+			{
+				char buffer[16] = "-";
+				int32 cpuset = _kern_get_team_cpuset(teamInfo->team);
+				if (cpuset >= 0)
+					snprintf(buffer, sizeof(buffer), "%" B_PRId32, cpuset);
+				printf(Infos[CPUSet].format, buffer);
+				break;
+			}
 		}
 		putchar(' ');
 	}
@@ -83,7 +134,8 @@ printTeamInfo(team_info* teamInfo, bool printHeader)
 
 
 static void
-printTeamThreads(team_info* teamInfo, bool printSemaphoreInfo)
+printTeamThreads(team_info* teamInfo, bool printSemaphoreInfo,
+	bool printAffinity)
 {
 	const char* threadState;
 	int32 threadCookie = 0;
@@ -105,6 +157,15 @@ printTeamThreads(team_info* teamInfo, bool printSemaphoreInfo)
 			threadInfo.priority, (threadInfo.user_time / 1000),
 			(threadInfo.kernel_time / 1000));
 
+		if (printAffinity) {
+			cpuset_t set;
+			if (sched_getaffinity(threadInfo.thread, sizeof(set), &set) == 0)
+				printCPUList(&set);
+			else
+				putchar('-');
+			putchar(' ');
+		}
+
 		if (printSemaphoreInfo) {
 			if (threadInfo.state == B_THREAD_WAITING && threadInfo.sem != -1) {
 				status_t status = get_sem_info(threadInfo.sem, &semaphoreInfo);
@@ -133,22 +194,25 @@ main(int argc, char** argv)
 	bool printThreads = false;
 	bool printHeader = true;
 	bool printSemaphoreInfo = false;
+	bool printAffinity = false;
 	bool customizeColumns = false;
 	// match this in team name
 	char* string_to_match;
 
 	int c;
 
-	while ((c = getopt(argc, argv, "-ihaso:")) != EOF) {
+	while ((c = getopt(argc, argv, "-ihasco:")) != EOF) {
 		switch (c) {
 			case 'i':
 				printSystemInfo = true;
 				break;
 			case 'h':
-				printf( "usage: ps [-hais] [-o columns list] [team]\n"
+				printf( "usage: ps [-haisc] [-o columns list] [team]\n"
 						"-h : show help\n"
 						"-i : show system info\n"
 						"-s : show semaphore info\n"
+						"-c : show the cpuset of teams and the CPU affinity "
+							"of threads\n"
 						"-o : display team info associated with the list\n"
 						"-a : show threads too (by default only teams are "
 							"displayed)\n");
@@ -160,6 +224,9 @@ main(int argc, char** argv)
 			case 's':
 				printSemaphoreInfo = true;
 				break;
+			case 'c':
+				printAffinity = true;
+				break;
 			case 'o':
 				if (!customizeColumns)
 					ColumnsCount = 0;
@@ -181,11 +248,14 @@ main(int argc, char** argv)
 		}
 	}
 
+	if (printAffinity && !customizeColumns && ColumnsCount < maxColumns)
+		Columns[ColumnsCount++] = CPUSet;
+
 	// TODO: parse command line
 	// Possible command line options:
 	//      -t  pstree like output
 
-	if (argc == 2 && (printSystemInfo || printThreads))
+	if (argc == 2 && (printSystemInfo || printThreads || printAffinity))
 		string_to_match = NULL;
 	else
 		string_to_match = (argc >= 2 && !customizeColumns)
@@ -196,9 +266,10 @@ main(int argc, char** argv)
 			printTeamInfo(&teamInfo, printHeader);
 			printHeader = false;
 			if (printThreads) {
-				printf("\n%-37s %5s %8s %4s %8s %8s\n", "Thread", "Id", \
-					"State", "Prio", "UTime", "KTime");
-				printTeamThreads(&teamInfo, printSemaphoreInfo);
+				printf("\n%-37s %5s %8s %4s %8s %8s%s\n", "Thread", "Id", \
+					"State", "Prio", "UTime", "KTime",
+					printAffinity ? " CPUs" : "");
+				printTeamThreads(&teamInfo, printSemaphoreInfo, printAffinity);
 				printf("----------------------------------------------" \
 					"-----------------------------\n");
 				printHeader = true;
@@ -215,9 +286,9 @@ main(int argc, char** argv)
 			if (strstr(p, string_to_match) == NULL)
 				continue;
 			printTeamInfo(&teamInfo, true);
-			printf("\n%-37s %5s %8s %4s %8s %8s\n", "Thread", "Id", "State", \
-				"Prio", "UTime", "KTime");
-			printTeamThreads(&teamInfo, printSemaphoreInfo);
+			printf("\n%-37s %5s %8s %4s %8s %8s%s\n", "Thread", "Id", "State", \
+				"Prio", "UTime", "KTime", printAffinity ? " CPUs" : "");
+			printTeamThreads(&teamInfo, printSemaphoreInfo, printAffinity);
 		}
 	}
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include <syscalls.h>
+#include <vm_defs.h>
+
+
+extern const char* __progname;
+static const char* kCommandName = __progname;
+
+
+static void
+usage(int exitCode)
+{
+	fprintf(exitCode == 0 ? stdout : stderr,
+		"Usage: %s [-d] [-s] [<name>]\n"
+		"Lists the kernel's object caches, and their memory usage.\n"
+		"\n"
+		"  -d      Also show the statistics of the per-CPU magazine layer.\n"
+		"  -s      Sort by memory usage instead of by creation.\n"
+		"  <name>  Only show the caches whose name contains <name>.\n",
+		kCommandName);
+	exit(exitCode);
+}
+
+
+static int
+compare_usage(const void* _a, const void* _b)
+{
+	const object_cache_info* a = (const object_cache_info*)_a;
+	const object_cache_info* b = (const object_cache_info*)_b;
+	if (a->usage == b->usage)
+		return strcmp(a->name, b->name);
+	return a->usage > b->usage ? -1 : 1;
+}
+
+
+static unsigned
+percentage(uint64 part, uint64 total)
+{
+	return total > 0 ? (unsigned)(part * 100 / total) : 0;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bool showDepot = false;
+	bool sortByUsage = false;
+	const char* filter = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+			usage(0);
+		else if (strcmp(arg, "-d") == 0)
+			showDepot = true;
+		else if (strcmp(arg, "-s") == 0)
+			sortByUsage = true;
+		else if (arg[0] != '-' && filter == NULL)
+			filter = arg;
+		else
+			usage(1);
+	}
+
+	// collect the caches
+
+	object_cache_info* infos = NULL;
+	int32 count = 0;
+	int32 capacity = 0;
+
+	int32 cookie = 0;
+	while (true) {
+		if (count == capacity) {
+			capacity = capacity > 0 ? capacity * 2 : 128;
+			object_cache_info* newInfos = (object_cache_info*)realloc(infos,
+				capacity * sizeof(object_cache_info));
+			if (newInfos == NULL) {
+				fprintf(stderr, "%s: Out of memory.\n", kCommandName);
+				return 1;
+			}
+			infos = newInfos;
+		}
+
+		status_t status = _kern_get_next_object_cache_info(&cookie,
+			&infos[count], sizeof(object_cache_info));
+		if (status == B_ENTRY_NOT_FOUND)
+			break;
+		if (status != B_OK) {
+			fprintf(stderr, "%s: Failed to get the object caches: %s\n",
+				kCommandName, strerror(status));
+			return 1;
+		}
+
+		if (filter == NULL || strstr(infos[count].name, filter) != NULL)
+			count++;
+	}
+
+	if (sortByUsage)
+		qsort(infos, count, sizeof(object_cache_info), compare_usage);
+
+	// print them
+
+	printf("%-32s %7s %9s %9s %9s %5s %4s\n", "name", "objsize", "used",
+		"total", "usage KB", "mag", "hit%");
+	if (showDepot) {
+		printf("%32s %9s %8s %10s %7s %7s %6s %6s\n", "", "exchanges",
+			"remote", "contention", "resizes", "max mag", "full", "empty");
+	}
+
+	uint64 totalUsage = 0;
+	for (int32 i = 0; i < count; i++) {
+		const object_cache_info& info = infos[i];
+		totalUsage += info.usage;
+
+		printf("%-32.32s %7" B_PRIu64 " %9" B_PRIu64 " %9" B_PRIu64 " %9"
+			B_PRIu64, info.name, info.object_size, info.used_objects,
+			info.total_objects, info.usage / 1024);
+
+		if (info.magazine_capacity == 0) {
+			printf(" %5s %4s\n", "-", "-");
+			continue;
+		}
+
+		printf(" %5" B_PRIu32 " %4u\n", info.magazine_capacity,
+			percentage(info.depot_hits, info.depot_hits + info.depot_misses));
+
+		if (showDepot) {
+			printf("%32s %9" B_PRIu64 " %8" B_PRIu64 " %10" B_PRIu64
+				" %7" B_PRIu32 " %7" B_PRIu32 " %6" B_PRIu32 " %6" B_PRIu32
+				"\n", "", info.magazine_exchanges, info.remote_exchanges,
+				info.depot_contention, info.magazine_resizes,
+				info.max_magazine_capacity, info.full_magazines,
+				info.empty_magazines);
+		}
+	}
+
+	printf("\n%" B_PRId32 " caches, %" B_PRIu64 " KB\n", count,
+		totalUsage / 1024);
+
+	free(infos);
+	return 0;
+}
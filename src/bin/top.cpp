@@ -11,6 +11,7 @@
 /*
  * Top -- a program for finding the top cpu-eating threads
  */
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -58,6 +59,7 @@ static int columns;	/* Columns on screen */
 static int rows;	/* how many rows on the screen */
 static int screen_size_changed = 0;	/* tells to refresh the screen size */
 static int cpus;	/* how many cpus we are runing on */
+static bool show_affinity = false;	/* show the CPUs a thread may run on */
 
 /* SIGWINCH handler */
 static void
@@ -110,6 +112,44 @@ cpu_perc(bigtime_t spent, bigtime_t interval)
 }
 
 
+/*
+ * Format the CPU affinity of a thread as a list of ranges, like "0-3,6"
+ */
+static void
+format_affinity(thread_id thread, char *buffer, size_t size)
+{
+	cpuset_t set;
+	if (sched_getaffinity(thread, sizeof(set), &set) != 0) {
+		strlcpy(buffer, "-", size);
+		return;
+	}
+
+	buffer[0] = '\0';
+	size_t length = 0;
+	int cpu = 0;
+	while (cpu < cpus && cpu < CPU_SETSIZE && length < size) {
+		if (!CPU_ISSET(cpu, &set)) {
+			cpu++;
+			continue;
+		}
+
+		int last = cpu;
+		while (last + 1 < cpus && last + 1 < CPU_SETSIZE
+			&& CPU_ISSET(last + 1, &set))
+			last++;
+
+		if (last > cpu) {
+			length += snprintf(buffer + length, size - length, "%s%d-%d",
+				length > 0 ? "," : "", cpu, last);
+		} else {
+			length += snprintf(buffer + length, size - length, "%s%d",
+				length > 0 ? "," : "", cpu);
+		}
+		cpu = last + 1;
+	}
+}
+
+
 /*
  * Compare an old snapshot with the new one
  */
@@ -187,8 +227,13 @@ compare(
 	 */
 	times.sort();
 
-	printf("%6s %7s %7s %7s %4s %16s %-16s \n", "THID", "TOTAL", "USER", "KERNEL",
-		"%CPU", "TEAM NAME", "THREAD NAME");
+	if (show_affinity) {
+		printf("%6s %7s %7s %7s %4s %-8s %16s %-16s \n", "THID", "TOTAL",
+			"USER", "KERNEL", "%CPU", "CPUS", "TEAM NAME", "THREAD NAME");
+	} else {
+		printf("%6s %7s %7s %7s %4s %16s %-16s \n", "THID", "TOTAL", "USER",
+			"KERNEL", "%CPU", "TEAM NAME", "THREAD NAME");
+	}
 	linecount = 1;
 	idletime = 0;
 	gtotal = 0;
@@ -229,14 +274,18 @@ compare(
 		}
 		if (!ignore && (!refresh || (linecount < (rows - 1)))) {
 
-			printf("%6ld %7.2f %7.2f %7.2f %4.1f %16s %s \n",
+			printf("%6ld %7.2f %7.2f %7.2f %4.1f ",
 				it->thid,
 				total / 1000.0,
 				(double)(it->user_time / 1000),
 				(double)(it->kernel_time / 1000),
-				cpu_perc(total, uinterval),
-				tm.args,
-				t.name);
+				cpu_perc(total, uinterval));
+			if (show_affinity) {
+				char affinity[9];
+				format_affinity(it->thid, affinity, sizeof(affinity));
+				printf("%-8s ", affinity);
+			}
+			printf("%16s %s \n", tm.args, t.name);
 			linecount++;
 		}
 	}
@@ -319,7 +368,9 @@ gather(ThreadTimeList *old, int refresh)
 static void
 usage(const char *myname)
 {
-	fprintf(stderr, "usage: %s [-d] [-i interval] [-n ntimes]\n", myname);
+	fprintf(stderr, "usage: %s [-c] [-d] [-i interval] [-n ntimes]\n", myname);
+	fprintf(stderr,
+			" -c,          show the CPUs each thread may run on\n");
 	fprintf(stderr,
 			" -d,          do not clear the screen between displays\n");
 	fprintf(stderr,
@@ -363,6 +414,8 @@ main(int argc, char **argv)
 			iters = atoi(argv[0]);
 		} else if (strcmp(argv[0], "-d") == 0) {
 			refresh = 0;
+		} else if (strcmp(argv[0], "-c") == 0) {
+			show_affinity = true;
 		} else {
 			usage(myname);
 		}
@@ -9,7 +9,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <syscalls.h>
 #include <system_info.h>
+#include <vm_defs.h>
 
 
 static struct option const kLongOptions[] = {
@@ -23,6 +25,38 @@ extern const char *__progname;
 static const char *kProgramName = __progname;
 
 
+static bigtime_t
+average_time(bigtime_t time, uint64 count)
+{
+	return count > 0 ? time / (bigtime_t)count : 0;
+}
+
+
+static void
+print_compressed_swap_info()
+{
+	compressed_swap_info info;
+	if (_kern_get_compressed_swap_info(&info, sizeof(info)) != B_OK)
+		return;
+
+	if (info.pool_limit > 0) {
+		printf("compressed swap pool:\t%" B_PRIu64 " of %" B_PRIu64 "\n",
+			info.pool_size, info.pool_limit);
+		printf("compressed pages:\t%" B_PRIu64 " (%" B_PRIu64
+			" rejected)\n", info.stored_pages, info.rejected_pages);
+		if (info.pool_size > 0) {
+			printf("compression ratio:\t%.2f\n",
+				(double)info.stored_pages * B_PAGE_SIZE / info.pool_size);
+		}
+	}
+
+	printf("swap-in latency:\t%" B_PRId64 " us compressed (%" B_PRIu64
+		" pages), %" B_PRId64 " us disk (%" B_PRIu64 " pages)\n",
+		average_time(info.pool_load_time, info.pool_loads), info.pool_loads,
+		average_time(info.disk_load_time, info.disk_loads), info.disk_loads);
+}
+
+
 void
 usage(int status)
 {
@@ -81,6 +115,7 @@ main(int argc, char** argv)
 	printf("max swap space:\t\t%Lu\n", info.max_swap_pages * B_PAGE_SIZE);
 	printf("free swap space:\t%Lu\n", info.free_swap_pages * B_PAGE_SIZE);
 	printf("page faults:\t\t%lu\n", info.page_faults);
+	print_compressed_swap_info();
 
 	if (periodically) {
 		puts("\npage faults  used memory    used swap  block cache");
@@ -1,5 +1,5 @@
 /*
- * Copyright 2005-2015 Haiku, Inc. All rights reserved.
+ * Copyright 2005-2026 Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -37,6 +37,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <locks.h>
+#include <object_cache.h>
+
 #include "tracing_config.h"
 	// kernel tracing configuration
 
@@ -83,6 +86,137 @@ BBlockCache* BMessage::sMsgCache = NULL;
 port_id BMessage::sReplyPorts[sNumReplyPorts];
 int32 BMessage::sReplyPortInUse[sNumReplyPorts];
 
+static object_cache* sHeaderCache = NULL;
+
+// Messages with more data than this are passed by area.
+static const size_t kPassByAreaThreshold = 4 * B_PAGE_SIZE;
+
+// Messages with at least this many fields get a field index, so that
+// looking up a field doesn't have to walk the header's hash chains. The index
+// is only ever built or changed by non-const methods, so that finding fields
+// in a shared message stays free of side effects.
+static const uint32 kFieldIndexThreshold = 16;
+
+static const int32 kMaxPooledAreas = 4;
+static const size_t kMaxPooledAreaSize = 1024 * 1024;
+
+struct pooled_area {
+	area_id		id;
+	size_t		size;
+	uint8*		address;
+};
+
+static pooled_area sAreaPool[kMaxPooledAreas];
+static int32 sPooledAreaCount = 0;
+static mutex sAreaPoolLock = MUTEX_INITIALIZER("BMessage area pool");
+
+
+// Headers are preceded by the source they were allocated from, so that they
+// are freed the same way, even if the cache didn't exist yet, or couldn't
+// provide one. The size keeps the headers aligned.
+static const size_t kHeaderSourceSize = sizeof(uint64);
+
+enum {
+	HEADER_FROM_HEAP	= 0,
+	HEADER_FROM_CACHE	= 1
+};
+
+
+/*!	Every message has a header, so they are allocated from an object cache
+	rather than from the heap. The cache is created once in
+	BMessage::_StaticInit(), and never deleted, as messages may outlive
+	the library's cleanup.
+*/
+static void*
+allocate_header(size_t size)
+{
+	uint32 source = HEADER_FROM_CACHE;
+	uint8* allocation = NULL;
+	if (sHeaderCache != NULL)
+		allocation = (uint8*)object_cache_alloc(sHeaderCache);
+	if (allocation == NULL) {
+		source = HEADER_FROM_HEAP;
+		allocation = (uint8*)malloc(kHeaderSourceSize + size);
+		if (allocation == NULL)
+			return NULL;
+	}
+
+	*(uint32*)allocation = source;
+	return allocation + kHeaderSourceSize;
+}
+
+
+static void
+free_header(void* header)
+{
+	uint8* allocation = (uint8*)header - kHeaderSourceSize;
+	if (*(uint32*)allocation == HEADER_FROM_CACHE)
+		object_cache_free(sHeaderCache, allocation);
+	else
+		free(allocation);
+}
+
+
+/*!	A message passed by area hands the area over to the receiving team,
+	which used to delete it as soon as it was done with the message.
+	Instead, the areas are now kept in a small pool, and reused for the
+	next large message the team sends. This saves creating the area and
+	faulting in its pages again.
+*/
+static area_id
+get_message_area(size_t size, uint8** _address)
+{
+	MutexLocker locker(sAreaPoolLock);
+
+	int32 best = -1;
+	for (int32 i = 0; i < sPooledAreaCount; i++) {
+		if (sAreaPool[i].size >= size
+			&& (best < 0 || sAreaPool[i].size < sAreaPool[best].size)) {
+			best = i;
+		}
+	}
+
+	if (best >= 0) {
+		pooled_area area = sAreaPool[best];
+		sAreaPool[best] = sAreaPool[--sPooledAreaCount];
+		locker.Unlock();
+
+		// The area must not be larger than needed, as the rest of it would
+		// pass on the data of an earlier message.
+		if ((area.size == size || resize_area(area.id, size) == B_OK)
+			&& set_area_protection(area.id, B_READ_AREA | B_WRITE_AREA)
+				== B_OK) {
+			*_address = area.address;
+			return area.id;
+		}
+
+		delete_area(area.id);
+	} else
+		locker.Unlock();
+
+	return create_area("BMessage data", (void**)_address, B_ANY_ADDRESS,
+		size, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+}
+
+
+static void
+put_message_area(area_id id)
+{
+	area_info info;
+	if (get_area_info(id, &info) == B_OK && info.size <= kMaxPooledAreaSize) {
+		MutexLocker locker(sAreaPoolLock);
+		if (sPooledAreaCount < kMaxPooledAreas) {
+			pooled_area& area = sAreaPool[sPooledAreaCount++];
+			area.id = id;
+			area.size = info.size;
+			area.address = (uint8*)info.address;
+			return;
+		}
+	}
+
+	delete_area(id);
+}
+
 
 template<typename Type>
 static void
@@ -195,7 +329,7 @@ BMessage::operator=(const BMessage& other)
 
 	_Clear();
 
-	fHeader = (message_header*)malloc(sizeof(message_header));
+	fHeader = (message_header*)allocate_header(sizeof(message_header));
 	if (fHeader == NULL)
 		return *this;
 
@@ -240,6 +374,9 @@ BMessage::operator=(const BMessage& other)
 	fFieldsAvailable = 0;
 	fDataAvailable = 0;
 
+	if (fHeader->field_count >= kFieldIndexThreshold)
+		_BuildFieldIndex();
+
 	return *this;
 }
 
@@ -359,6 +496,7 @@ BMessage::_InitCommon(bool initHeader)
 	fQueueLink = NULL;
 
 	fArchivingPointer = NULL;
+	fFieldIndex = NULL;
 
 	if (initHeader)
 		return _InitHeader();
@@ -372,7 +510,7 @@ BMessage::_InitHeader()
 {
 	DEBUG_FUNCTION_ENTER;
 	if (fHeader == NULL) {
-		fHeader = (message_header*)malloc(sizeof(message_header));
+		fHeader = (message_header*)allocate_header(sizeof(message_header));
 		if (fHeader == NULL)
 			return B_NO_MEMORY;
 	}
@@ -411,7 +549,7 @@ BMessage::_Clear()
 		if (fHeader->message_area >= 0)
 			_Dereference();
 
-		free(fHeader);
+		free_header(fHeader);
 		fHeader = NULL;
 	}
 
@@ -419,6 +557,7 @@ BMessage::_Clear()
 	fFields = NULL;
 	free(fData);
 	fData = NULL;
+	_DeleteFieldIndex();
 
 	fArchivingPointer = NULL;
 
@@ -786,13 +925,15 @@ BMessage::Rename(const char* oldEntry, const char* newEntry)
 			// nextField points to the field for oldEntry, save it and unlink
 			int32 index = *nextField;
 			*nextField = field->next_field;
-			field->next_field = -1;
 
 			hash = _HashName(newEntry) % fHeader->hash_table_size;
-			nextField = &fHeader->hash_table[hash];
-			while (*nextField >= 0)
-				nextField = &fFields[*nextField].next_field;
-			*nextField = index;
+			field->next_field = fHeader->hash_table[hash];
+			fHeader->hash_table[hash] = index;
+
+			if (fFieldIndex != NULL) {
+				_RemoveFromFieldIndex(index);
+				_AddToFieldIndex(_HashName(newEntry), index);
+			}
 
 			int32 newLength = strlen(newEntry) + 1;
 			result = _ResizeData(field->offset + 1,
@@ -1141,12 +1282,11 @@ BMessage::_FlattenToArea(message_header** _header) const
 	if (header->field_count == 0 && header->data_size == 0)
 		return B_OK;
 
-	char* address = NULL;
+	uint8* address = NULL;
 	size_t fieldsSize = header->field_count * sizeof(field_header);
-	size_t size = fieldsSize + header->data_size;
-	size = (size + B_PAGE_SIZE) & ~(B_PAGE_SIZE - 1);
-	area_id area = create_area("BMessage data", (void**)&address,
-		B_ANY_ADDRESS, size, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	size_t usedSize = fieldsSize + header->data_size;
+	size_t size = (usedSize + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+	area_id area = get_message_area(size, &address);
 
 	if (area < 0) {
 		free(header);
@@ -1156,6 +1296,7 @@ BMessage::_FlattenToArea(message_header** _header) const
 
 	memcpy(address, fFields, fieldsSize);
 	memcpy(address + fieldsSize, fData, fHeader->data_size);
+	memset(address + usedSize, 0, size - usedSize);
 	header->flags |= MESSAGE_FLAG_PASS_BY_AREA;
 	header->message_area = area;
 	return B_OK;
@@ -1200,7 +1341,7 @@ BMessage::_Dereference()
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	delete_area(fHeader->message_area);
+	put_message_area(fHeader->message_area);
 	fHeader->message_area = -1;
 	fFields = NULL;
 	fData = NULL;
@@ -1273,6 +1414,9 @@ BMessage::_ValidateMessage()
 		}
 	}
 
+	if (fHeader->field_count >= kFieldIndexThreshold)
+		_BuildFieldIndex();
+
 	return B_OK;
 }
 
@@ -1309,7 +1453,7 @@ BMessage::Unflatten(BDataIO* stream)
 
 	_Clear();
 
-	fHeader = (message_header*)malloc(sizeof(message_header));
+	fHeader = (message_header*)allocate_header(sizeof(message_header));
 	if (fHeader == NULL)
 		return B_NO_MEMORY;
 
@@ -1574,9 +1718,11 @@ BMessage::_ResizeData(uint32 offset, int32 change)
 		}
 
 		// We need to grow the buffer. We try to optimize reallocations by
-		// preallocating space for more fields.
+		// preallocating space for more fields. Large messages grow by a
+		// fraction of their size, so that building them stays linear.
 		size_t size = fHeader->data_size * 2;
-		size = min_c(size, fHeader->data_size + MAX_DATA_PREALLOCATION);
+		size = min_c(size, fHeader->data_size
+			+ max_c(MAX_DATA_PREALLOCATION, fHeader->data_size / 4));
 		size = max_c(size, fHeader->data_size + change);
 
 		uint8* newData = (uint8*)realloc(fData, size);
@@ -1636,6 +1782,120 @@ BMessage::_HashName(const char* name) const
 }
 
 
+/*!	Computes the same hash as _HashName(), but never reads more than
+	\a nameLength bytes, as the names of an unflattened message aren't
+	guaranteed to be terminated.
+*/
+static uint32
+hash_field_name(const char* name, uint32 nameLength)
+{
+	char ch;
+	uint32 result = 0;
+
+	for (uint32 i = 0; i < nameLength && (ch = name[i]) != 0; i++) {
+		result = (result << 7) ^ (result >> 24);
+		result ^= ch;
+	}
+
+	result ^= result << 12;
+	return result;
+}
+
+
+/*!	Builds the field index from scratch, with enough room for the current
+	fields to leave half of its slots empty.
+*/
+status_t
+BMessage::_BuildFieldIndex()
+{
+	uint32 size = kFieldIndexThreshold * 2;
+	uint32 shift = 32 - 5;
+	while (size < fHeader->field_count * 2) {
+		size *= 2;
+		shift--;
+	}
+
+	field_index* index = (field_index*)malloc(sizeof(field_index)
+		+ size * sizeof(field_index::slot));
+	if (index == NULL) {
+		_DeleteFieldIndex();
+		return B_NO_MEMORY;
+	}
+
+	index->size = size;
+	index->shift = shift;
+	index->count = 0;
+	for (uint32 i = 0; i < size; i++)
+		index->slots[i].field = -1;
+
+	free(fFieldIndex);
+	fFieldIndex = index;
+
+	for (uint32 i = 0; i < fHeader->field_count; i++) {
+		_AddToFieldIndex(hash_field_name(
+			(const char*)(fData + fFields[i].offset), fFields[i].name_length),
+			i);
+	}
+
+	return B_OK;
+}
+
+
+void
+BMessage::_AddToFieldIndex(uint32 hash, int32 field)
+{
+	// The name hash doesn't mix its lower bits well, so the slot is taken
+	// from the upper bits of its product with the golden ratio.
+	uint32 mask = fFieldIndex->size - 1;
+	uint32 slot = (hash * 2654435761U) >> fFieldIndex->shift;
+	while (fFieldIndex->slots[slot].field >= 0)
+		slot = (slot + 1) & mask;
+
+	fFieldIndex->slots[slot].hash = hash;
+	fFieldIndex->slots[slot].field = field;
+	fFieldIndex->count++;
+}
+
+
+/*!	Removes the entry of \a field from the field index. The entries following
+	it in its probe sequence are moved back, so that no lookup has to skip
+	over deleted slots.
+*/
+void
+BMessage::_RemoveFromFieldIndex(int32 field)
+{
+	uint32 mask = fFieldIndex->size - 1;
+	uint32 hole = 0;
+	while (fFieldIndex->slots[hole].field != field) {
+		if (++hole == fFieldIndex->size)
+			return;
+	}
+
+	for (uint32 slot = (hole + 1) & mask; fFieldIndex->slots[slot].field >= 0;
+			slot = (slot + 1) & mask) {
+		// An entry may only fill the hole if that doesn't put it before the
+		// slot its probe sequence starts at.
+		uint32 home = (fFieldIndex->slots[slot].hash * 2654435761U)
+			>> fFieldIndex->shift;
+		if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+			fFieldIndex->slots[hole] = fFieldIndex->slots[slot];
+			hole = slot;
+		}
+	}
+
+	fFieldIndex->slots[hole].field = -1;
+	fFieldIndex->count--;
+}
+
+
+void
+BMessage::_DeleteFieldIndex()
+{
+	free(fFieldIndex);
+	fFieldIndex = NULL;
+}
+
+
 status_t
 BMessage::_FindField(const char* name, type_code type, field_header** result)
 	const
@@ -1649,7 +1909,30 @@ BMessage::_FindField(const char* name, type_code type, field_header** result)
 	if (fHeader->field_count == 0 || fFields == NULL || fData == NULL)
 		return B_NAME_NOT_FOUND;
 
-	uint32 hash = _HashName(name) % fHeader->hash_table_size;
+	uint32 nameHash = _HashName(name);
+
+	if (fFieldIndex != NULL) {
+		uint32 mask = fFieldIndex->size - 1;
+		uint32 slot = (nameHash * 2654435761U) >> fFieldIndex->shift;
+		for (; fFieldIndex->slots[slot].field >= 0; slot = (slot + 1) & mask) {
+			if (fFieldIndex->slots[slot].hash != nameHash)
+				continue;
+
+			field_header* field = &fFields[fFieldIndex->slots[slot].field];
+			if (strncmp((const char*)(fData + field->offset), name,
+					field->name_length) == 0) {
+				if (type != B_ANY_TYPE && field->type != type)
+					return B_BAD_TYPE;
+
+				*result = field;
+				return B_OK;
+			}
+		}
+
+		return B_NAME_NOT_FOUND;
+	}
+
+	uint32 hash = nameHash % fHeader->hash_table_size;
 	int32 nextField = fHeader->hash_table[hash];
 
 	while (nextField >= 0) {
@@ -1682,7 +1965,8 @@ BMessage::_AddField(const char* name, type_code type, bool isFixedSize,
 
 	if (fFieldsAvailable <= 0) {
 		uint32 count = fHeader->field_count * 2 + 1;
-		count = min_c(count, fHeader->field_count + MAX_FIELD_PREALLOCATION);
+		count = min_c(count, fHeader->field_count
+			+ max_c(MAX_FIELD_PREALLOCATION, fHeader->field_count / 4));
 
 		field_header* newFields = (field_header*)realloc(fFields,
 			count * sizeof(field_header));
@@ -1693,17 +1977,10 @@ BMessage::_AddField(const char* name, type_code type, bool isFixedSize,
 		fFieldsAvailable = count - fHeader->field_count;
 	}
 
-	uint32 hash = _HashName(name) % fHeader->hash_table_size;
-	int32* nextField = &fHeader->hash_table[hash];
-	while (*nextField >= 0)
-		nextField = &fFields[*nextField].next_field;
-	*nextField = fHeader->field_count;
-
 	field_header* field = &fFields[fHeader->field_count];
 	field->type = type;
 	field->count = 0;
 	field->data_size = 0;
-	field->next_field = -1;
 	field->offset = fHeader->data_size;
 	field->name_length = strlen(name) + 1;
 	status_t status = _ResizeData(field->offset, field->name_length);
@@ -1715,8 +1992,24 @@ BMessage::_AddField(const char* name, type_code type, bool isFixedSize,
 	if (isFixedSize)
 		field->flags |= FIELD_FLAG_FIXED_SIZE;
 
+	// The order of the hash chains doesn't matter, so new fields are put at
+	// their start rather than at their end.
+	uint32 nameHash = _HashName(name);
+	int32* bucket = &fHeader->hash_table[nameHash % fHeader->hash_table_size];
+	field->next_field = *bucket;
+	*bucket = fHeader->field_count;
+
 	fFieldsAvailable--;
 	fHeader->field_count++;
+
+	if (fFieldIndex != NULL) {
+		if (fHeader->field_count * 2 > fFieldIndex->size)
+			_BuildFieldIndex();
+		else
+			_AddToFieldIndex(nameHash, fHeader->field_count - 1);
+	} else if (fHeader->field_count >= kFieldIndexThreshold)
+		_BuildFieldIndex();
+
 	*result = field;
 	return B_OK;
 }
@@ -1756,6 +2049,16 @@ BMessage::_RemoveField(field_header* field)
 	fHeader->field_count--;
 	fFieldsAvailable++;
 
+	if (fFieldIndex != NULL) {
+		_RemoveFromFieldIndex(index);
+
+		field_index::slot* slot = fFieldIndex->slots;
+		for (uint32 i = 0; i < fFieldIndex->size; i++, slot++) {
+			if (slot->field > index)
+				slot->field--;
+		}
+	}
+
 	if (fFieldsAvailable > MAX_FIELD_PREALLOCATION) {
 		ssize_t available = MAX_FIELD_PREALLOCATION / 2;
 		size = (fHeader->field_count + available) * sizeof(field_header);
@@ -2051,6 +2354,9 @@ BMessage::_StaticInit()
 	sReplyPortInUse[2] = 0;
 
 	sMsgCache = new BBlockCache(20, sizeof(BMessage), B_OBJECT_CACHE);
+
+	sHeaderCache = create_object_cache("message headers",
+		kHeaderSourceSize + sizeof(message_header), 0, NULL, NULL, NULL);
 }
 
 
@@ -2067,6 +2373,15 @@ BMessage::_StaticReInitForkedChild()
 	sReplyPortInUse[0] = 0;
 	sReplyPortInUse[1] = 0;
 	sReplyPortInUse[2] = 0;
+
+	// the pooled areas have been copied with new IDs
+	mutex_init(&sAreaPoolLock, "BMessage area pool");
+	for (int32 i = 0; i < sPooledAreaCount; i++) {
+		area_id area = area_for(sAreaPool[i].address);
+		if (area >= 0)
+			delete_area(area);
+	}
+	sPooledAreaCount = 0;
 }
 
 
@@ -2080,6 +2395,10 @@ BMessage::_StaticCleanup()
 	sReplyPorts[1] = -1;
 	delete_port(sReplyPorts[2]);
 	sReplyPorts[2] = -1;
+
+	MutexLocker locker(sAreaPoolLock);
+	while (sPooledAreaCount > 0)
+		delete_area(sAreaPool[--sPooledAreaCount].id);
 }
 
 
@@ -2148,9 +2467,10 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 			return result;
 
 		return toMessage.SendTo(port, token);
-	} else if (fHeader->data_size > B_PAGE_SIZE * 10) {
-		// ToDo: bind the above size to the max port message size
-		// use message passing by area for such a large message
+	} else if (fHeader->data_size > kPassByAreaThreshold) {
+		// Pass large messages by area: only the header goes through the
+		// port, and the receiver reads the data from the area without
+		// copying it, until it changes the message.
 		result = _FlattenToArea(&header);
 		if (result != B_OK)
 			return result;
@@ -2174,7 +2494,7 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 			area_id transfered = _kern_transfer_area(header->message_area,
 				&address, B_ANY_ADDRESS, target);
 			if (transfered < 0) {
-				delete_area(header->message_area);
+				put_message_area(header->message_area);
 				free(header);
 				return transfered;
 			}
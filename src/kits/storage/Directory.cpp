@@ -23,6 +23,7 @@
 #include <Path.h>
 #include <SymLink.h>
 
+#include <binary_compatibility/Global.h>
 #include <syscalls.h>
 #include <umask.h>
 
@@ -380,6 +381,25 @@ BDirectory::GetNextDirents(dirent* buf, size_t bufSize, int32 count)
 }
 
 
+int32
+BDirectory::GetNextDirentsPlus(dirent_plus* buffer, size_t bufferSize,
+	int32 count, const char* const* attributes, int32 attributeCount,
+	size_t maxAttributeSize)
+{
+	if (buffer == NULL || attributeCount < 0
+		|| (attributeCount > 0 && attributes == NULL)) {
+		return B_BAD_VALUE;
+	}
+	if (InitCheck() != B_OK)
+		return B_FILE_ERROR;
+	if (count <= 0)
+		return 0;
+
+	return _kern_read_dir_plus(fDirFd, buffer, bufferSize, count, attributes,
+		attributeCount, maxAttributeSize);
+}
+
+
 status_t
 BDirectory::Rewind()
 {
@@ -519,8 +539,20 @@ BDirectory::_GetStatFor(const char* path, struct stat_beos* st) const
 }
 
 
+extern "C" int32
+B_IF_GCC_2(_ErectorDirectory1__10BDirectory,
+	_ZN10BDirectory18_ErectorDirectory1Ev)(BDirectory* directory,
+	dirent_plus* buffer, size_t bufferSize, int32 count,
+	const char* const* attributes, int32 attributeCount,
+	size_t maxAttributeSize)
+{
+	// GetNextDirentsPlus(), for subclasses built before it was added
+	return directory->BDirectory::GetNextDirentsPlus(buffer, bufferSize,
+		count, attributes, attributeCount, maxAttributeSize);
+}
+
+
 // FBC
-void BDirectory::_ErectorDirectory1() {}
 void BDirectory::_ErectorDirectory2() {}
 void BDirectory::_ErectorDirectory3() {}
 void BDirectory::_ErectorDirectory4() {}
@@ -1,10 +1,27 @@
 //----------------------------------------------------------------------
-//  This software is part of the OpenBeOS distribution and is covered 
+//  This software is part of the OpenBeOS distribution and is covered
 //  by the MIT License.
 //---------------------------------------------------------------------
 
 #include <EntryList.h>
 
+#include <stddef.h>
+#include <string.h>
+
+#include <Entry.h>
+#include <fs_attr.h>
+#include <Node.h>
+#include <StorageDefs.h>
+
+#include <binary_compatibility/Global.h>
+
+
+static inline size_t
+dirent_plus_align(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
 
 BEntryList::BEntryList()
 {
@@ -16,8 +33,109 @@ BEntryList::~BEntryList()
 }
 
 
+int32
+BEntryList::GetNextDirentsPlus(struct dirent_plus* buffer, size_t bufferSize,
+	int32 maxEntries, const char* const* attributes, int32 attributeCount,
+	size_t maxAttributeSize)
+{
+	if (buffer == NULL || attributeCount < 0
+		|| (attributeCount > 0 && attributes == NULL)) {
+		return B_BAD_VALUE;
+	}
+
+	if (attributeCount == 0)
+		maxAttributeSize = 0;
+
+	// only read an entry if it is guaranteed to fit into the buffer
+	const size_t headerSize = offsetof(struct dirent_plus, dp_dirent);
+	const size_t maxRecordSize = dirent_plus_align(headerSize
+			+ sizeof(struct dirent) + B_FILE_NAME_LENGTH)
+		+ attributeCount * dirent_plus_align(sizeof(struct dirent_plus_attr)
+			+ maxAttributeSize);
+
+	uint8* recordBuffer = (uint8*)buffer;
+	int32 count = 0;
+	while (count < maxEntries) {
+		if (bufferSize < maxRecordSize) {
+			if (count == 0)
+				return B_BUFFER_OVERFLOW;
+			break;
+		}
+
+		struct dirent_plus* record = (struct dirent_plus*)recordBuffer;
+		int32 read = GetNextDirents(&record->dp_dirent,
+			bufferSize - headerSize, 1);
+		if (read <= 0) {
+			if (count == 0)
+				return read;
+			break;
+		}
+
+		struct dirent* entry = &record->dp_dirent;
+		size_t recordLength = dirent_plus_align(headerSize + entry->d_reclen);
+
+		entry_ref ref(entry->d_pdev, entry->d_pino, entry->d_name);
+		BNode node(&ref);
+		record->dp_stat_status = node.GetStat(&record->dp_stat);
+		if (record->dp_stat_status != B_OK)
+			memset(&record->dp_stat, 0, sizeof(struct stat));
+
+		record->dp_attr_offset = recordLength;
+		record->dp_attr_count = attributeCount;
+
+		for (int32 i = 0; i < attributeCount; i++) {
+			struct dirent_plus_attr* attr
+				= (struct dirent_plus_attr*)(recordBuffer + recordLength);
+			attr->dpa_type = 0;
+			attr->dpa_length = 0;
+			attr->dpa_size = 0;
+
+			attr_info info;
+			attr->dpa_status = node.GetAttrInfo(attributes[i], &info);
+			if (attr->dpa_status == B_OK) {
+				attr->dpa_type = info.type;
+				attr->dpa_size = info.size;
+
+				size_t length = (size_t)min_c((off_t)maxAttributeSize,
+					info.size);
+				ssize_t bytesRead = length > 0 ? node.ReadAttr(attributes[i],
+					info.type, 0, attr + 1, length) : 0;
+				if (bytesRead >= 0)
+					attr->dpa_length = bytesRead;
+				else
+					attr->dpa_status = bytesRead;
+			}
+
+			attr->dpa_reclen = dirent_plus_align(
+				sizeof(struct dirent_plus_attr) + attr->dpa_length);
+			recordLength += attr->dpa_reclen;
+		}
+
+		record->dp_reclen = recordLength;
+
+		recordBuffer += recordLength;
+		bufferSize -= recordLength;
+		count++;
+	}
+
+	return count;
+}
+
+
+extern "C" int32
+B_IF_GCC_2(_ReservedEntryList1__10BEntryList,
+	_ZN10BEntryList19_ReservedEntryList1Ev)(BEntryList* list,
+	struct dirent_plus* buffer, size_t bufferSize, int32 maxEntries,
+	const char* const* attributes, int32 attributeCount,
+	size_t maxAttributeSize)
+{
+	// GetNextDirentsPlus(), for subclasses built before it was added
+	return list->BEntryList::GetNextDirentsPlus(buffer, bufferSize,
+		maxEntries, attributes, attributeCount, maxAttributeSize);
+}
+
+
 // Currently unused
-void BEntryList::_ReservedEntryList1() {}
 void BEntryList::_ReservedEntryList2() {}
 void BEntryList::_ReservedEntryList3() {}
 void BEntryList::_ReservedEntryList4() {}
@@ -15,10 +15,23 @@
 
 #include <List.h>
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <object_cache.h>
+
+
+static const int32 kCachedArraySize = 20;
+	// the default block size, and thus the size of most lists' arrays
+static const uint32 kCachedArray = 0x01;
+	// set in BList::_reserved[0], if fObjectList was allocated from
+	// sArrayCache
+
+static object_cache* sArrayCache = NULL;
+static pthread_once_t sArrayCacheInitOnce = PTHREAD_ONCE_INIT;
+
 
 // helper function
 static inline void
@@ -29,6 +42,24 @@ move_items(void** items, int32 offset, int32 count)
 }
 
 
+static void
+init_array_cache()
+{
+	sArrayCache = create_object_cache("list arrays",
+		kCachedArraySize * sizeof(void*), 0, NULL, NULL, NULL);
+}
+
+
+static inline void
+free_array(void** array, uint32 flags)
+{
+	if ((flags & kCachedArray) != 0)
+		object_cache_free(sArrayCache, array);
+	else
+		free(array);
+}
+
+
 BList::BList(int32 count)
 	:
 	fObjectList(NULL),
@@ -37,6 +68,8 @@ BList::BList(int32 count)
 	fBlockSize(count),
 	fResizeThreshold(0)
 {
+	_reserved[0] = 0;
+
 	if (fBlockSize <= 0)
 		fBlockSize = 1;
 	_ResizeArray(fItemCount);
@@ -48,15 +81,17 @@ BList::BList(const BList& other)
 	fObjectList(NULL),
 	fPhysicalSize(0),
 	fItemCount(0),
-	fBlockSize(other.fBlockSize)
+	fBlockSize(other.fBlockSize),
+	fResizeThreshold(0)
 {
+	_reserved[0] = 0;
 	*this = other;
 }
 
 
 BList::~BList()
 {
-	free(fObjectList);
+	free_array(fObjectList, _reserved[0]);
 }
 
 
@@ -491,10 +526,38 @@ BList::_ResizeArray(int32 count)
 
 	// resize if necessary
 	if (newSize != fPhysicalSize) {
-		void** newObjectList
-			= (void**)realloc(fObjectList, newSize * sizeof(void*));
+		// Arrays of the most common size come from an object cache. Moving
+		// into or out of it can't be done by realloc().
+		uint32 newFlags = 0;
+		if (newSize == kCachedArraySize) {
+			pthread_once(&sArrayCacheInitOnce, &init_array_cache);
+			if (sArrayCache != NULL)
+				newFlags = kCachedArray;
+		}
+
+		void** newObjectList;
+		if (newFlags == 0 && (_reserved[0] & kCachedArray) == 0) {
+			newObjectList
+				= (void**)realloc(fObjectList, newSize * sizeof(void*));
+		} else {
+			if (newFlags != 0)
+				newObjectList = (void**)object_cache_alloc(sArrayCache);
+			else
+				newObjectList = (void**)malloc(newSize * sizeof(void*));
+
+			if (newObjectList != NULL) {
+				int32 itemCount = fItemCount < newSize ? fItemCount : newSize;
+				if (itemCount > 0) {
+					memcpy(newObjectList, fObjectList,
+						itemCount * sizeof(void*));
+				}
+				free_array(fObjectList, _reserved[0]);
+			}
+		}
+
 		if (newObjectList) {
 			fObjectList = newObjectList;
+			_reserved[0] = newFlags;
 			fPhysicalSize = newSize;
 			// set our lower bound to either 1/4
 			//of the current physical size, or 0
@@ -13,6 +13,9 @@
 #include <Debug.h>
 #include <Query.h>
 
+#include <syscalls.h>
+#include <thread_defs.h>
+
 #include "IndexServer.h"
 
 
@@ -77,6 +80,10 @@ CatchUpAnalyser::_CatchUp()
 	for (int i = 0; i < fFileAnalyserList.CountItems(); i++)
 		STRACE("- Analyser %s\n", fFileAnalyserList.ItemAt(i)->Name().String());
 
+	// Catching up is background work, it must not get in the way of
+	// interactive disk access.
+	_kern_set_io_class(B_CURRENT_TEAM, find_thread(NULL), IO_CLASS_IDLE);
+
 	BQuery query;
 	query.SetVolume(&fVolume);
 	query.PushAttr("last_modified");
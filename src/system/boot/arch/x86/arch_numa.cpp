@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <boot/arch/x86/arch_numa.h>
+
+#include <KernelExport.h>
+
+#include <boot/stage2.h>
+
+
+//#define TRACE_NUMA
+#ifdef TRACE_NUMA
+#	define TRACE(x) dprintf x
+#else
+#	define TRACE(x) ;
+#endif
+
+
+/*!	Returns the node index for the given ACPI proximity domain, adding a new
+	node, if necessary. Returns -1, if there are too many nodes already.
+*/
+static int32
+numa_node_for_domain(uint32* domains, uint32 domain)
+{
+	for (uint32 i = 0; i < gKernelArgs.num_numa_nodes; i++) {
+		if (domains[i] == domain)
+			return i;
+	}
+
+	if (gKernelArgs.num_numa_nodes == MAX_NUMA_NODES)
+		return -1;
+
+	domains[gKernelArgs.num_numa_nodes] = domain;
+	return gKernelArgs.num_numa_nodes++;
+}
+
+
+static void
+numa_set_cpu_node(uint32 apicID, int32 node)
+{
+	for (uint32 i = 0; i < gKernelArgs.num_cpus; i++) {
+		if (gKernelArgs.arch_args.cpu_apic_id[i] == apicID)
+			gKernelArgs.cpu_numa_node[i] = node;
+	}
+}
+
+
+/*!	Reads the NUMA topology from the given SRAT, and the optional SLIT into
+	the kernel args. Must be called after the CPUs have been enumerated.
+*/
+void
+boot_arch_numa_init(acpi_srat* srat, acpi_slit* slit)
+{
+	if (srat == NULL)
+		return;
+
+	uint32 domains[MAX_NUMA_NODES];
+	gKernelArgs.num_numa_nodes = 0;
+	gKernelArgs.num_numa_memory_ranges = 0;
+
+	acpi_apic* entry = (acpi_apic*)((uint8*)srat + sizeof(acpi_srat));
+	acpi_apic* end = (acpi_apic*)((uint8*)srat + srat->header.length);
+	while (entry < end && entry->length > 0) {
+		switch (entry->type) {
+			case ACPI_SRAT_PROCESSOR_AFFINITY:
+			{
+				acpi_srat_processor_affinity* affinity
+					= (acpi_srat_processor_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0)
+					break;
+
+				uint32 domain = affinity->proximity_domain_low
+					| (affinity->proximity_domain_high[0] << 8)
+					| (affinity->proximity_domain_high[1] << 16)
+					| (affinity->proximity_domain_high[2] << 24);
+				int32 node = numa_node_for_domain(domains, domain);
+				if (node >= 0)
+					numa_set_cpu_node(affinity->apic_id, node);
+				break;
+			}
+
+			case ACPI_SRAT_X2_APIC_AFFINITY:
+			{
+				acpi_srat_x2_apic_affinity* affinity
+					= (acpi_srat_x2_apic_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0)
+					break;
+
+				int32 node = numa_node_for_domain(domains,
+					affinity->proximity_domain);
+				if (node >= 0)
+					numa_set_cpu_node(affinity->x2apic_id, node);
+				break;
+			}
+
+			case ACPI_SRAT_MEMORY_AFFINITY:
+			{
+				acpi_srat_memory_affinity* affinity
+					= (acpi_srat_memory_affinity*)entry;
+				if ((affinity->flags & ACPI_SRAT_AFFINITY_ENABLED) == 0
+					|| affinity->range_length == 0) {
+					break;
+				}
+
+				int32 node = numa_node_for_domain(domains,
+					affinity->proximity_domain);
+				uint32 index = gKernelArgs.num_numa_memory_ranges;
+				if (node < 0 || index == MAX_NUMA_MEMORY_RANGES) {
+					TRACE(("numa: ignoring memory range of domain %" B_PRIu32
+						"\n", affinity->proximity_domain));
+					break;
+				}
+
+				gKernelArgs.numa_memory_range[index].start
+					= affinity->base_address;
+				gKernelArgs.numa_memory_range[index].size
+					= affinity->range_length;
+				gKernelArgs.numa_memory_range[index].node = node;
+				gKernelArgs.num_numa_memory_ranges++;
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		entry = (acpi_apic*)((uint8*)entry + entry->length);
+	}
+
+	// The SLIT is indexed by proximity domain. Without it, we assume all
+	// remote nodes to be equally far away.
+	for (uint32 i = 0; i < gKernelArgs.num_numa_nodes; i++) {
+		for (uint32 j = 0; j < gKernelArgs.num_numa_nodes; j++) {
+			uint8 distance = i == j ? 10 : 20;
+			if (slit != NULL && domains[i] < slit->locality_count
+				&& domains[j] < slit->locality_count) {
+				distance = slit->entries[
+					domains[i] * slit->locality_count + domains[j]];
+			}
+			gKernelArgs.numa_distance[i][j] = distance;
+		}
+	}
+
+	TRACE(("numa: found %" B_PRIu32 " NUMA nodes, %" B_PRIu32
+		" memory ranges\n",
+		gKernelArgs.num_numa_nodes, gKernelArgs.num_numa_memory_ranges));
+}
@@ -19,6 +19,7 @@
 #include <boot/platform.h>
 #include <boot/stage2.h>
 #include <boot/menu.h>
+#include <boot/arch/x86/arch_numa.h>
 #include <arch/x86/apic.h>
 #include <arch/x86/arch_acpi.h>
 #include <arch/x86/arch_cpu.h>
@@ -445,6 +446,9 @@ smp_init(void)
 	// physical as well as logical MP configurations as in multiple cpus,
 	// multiple cores or hyper threading.
 	if (smp_do_acpi_config() == B_OK) {
+		boot_arch_numa_init(
+			(acpi_srat*)acpi_find_table(ACPI_SRAT_SIGNATURE),
+			(acpi_slit*)acpi_find_table(ACPI_SLIT_SIGNATURE));
 		TRACE(("smp init success\n"));
 		return;
 	}
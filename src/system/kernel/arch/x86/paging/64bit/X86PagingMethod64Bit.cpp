@@ -331,9 +331,10 @@ X86PagingMethod64Bit::PageTableForAddress(uint64* virtualPML4,
 		mapCount++;
 	}
 
-	// No proper large page support at the moment, but they are used for the
-	// physical map area. Ensure that nothing tries to treat that as normal
-	// address space.
+	// Large pages are used for the physical map area, and by
+	// X86VMTranslationMap64Bit::MapLargePage(), which splits them before
+	// accessing the range with small pages. Ensure that nothing tries to
+	// treat them as normal address space.
 	ASSERT(!(*pde & X86_64_PDE_LARGE_PAGE));
 
 	return (uint64*)pageMapper->GetPageTableAt(*pde & X86_64_PDE_ADDRESS_MASK);
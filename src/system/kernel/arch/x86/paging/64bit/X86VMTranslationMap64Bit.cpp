@@ -68,8 +68,10 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 				uint64* virtualPageDir = (uint64*)fPageMapper->GetPageTableAt(
 					virtualPDPT[j] & X86_64_PDPTE_ADDRESS_MASK);
 				for (uint32 k = 0; k < 512; k++) {
-					if ((virtualPageDir[k] & X86_64_PDE_PRESENT) == 0)
+					if ((virtualPageDir[k] & X86_64_PDE_PRESENT) == 0
+						|| (virtualPageDir[k] & X86_64_PDE_LARGE_PAGE) != 0) {
 						continue;
+					}
 
 					address = virtualPageDir[k] & X86_64_PDE_ADDRESS_MASK;
 					page = vm_lookup_page(address / B_PAGE_SIZE);
@@ -107,6 +109,11 @@ X86VMTranslationMap64Bit::~X86VMTranslationMap64Bit()
 		fPageMapper->Delete();
 	}
 
+	while (vm_page* page = fSparePageTables.RemoveHead()) {
+		DEBUG_PAGE_ACCESS_START(page);
+		vm_page_set_state(page, PAGE_STATE_FREE);
+	}
+
 	fPagingStructures->RemoveReference();
 }
 
@@ -235,6 +242,8 @@ X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		_SplitLargePage(start);
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -271,6 +280,79 @@ X86VMTranslationMap64Bit::Unmap(addr_t start, addr_t end)
 }
 
 
+size_t
+X86VMTranslationMap64Bit::LargePageSize() const
+{
+	return k64BitPageTableRange;
+}
+
+
+status_t
+X86VMTranslationMap64Bit::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	TRACE("X86VMTranslationMap64Bit::MapLargePage(%#" B_PRIxADDR ", %#"
+		B_PRIxPHYSADDR ")\n", virtualAddress, physicalAddress);
+
+	ASSERT(virtualAddress % k64BitPageTableRange == 0);
+	ASSERT(physicalAddress % k64BitPageTableRange == 0);
+
+	ThreadCPUPinner pinner(thread_get_current_thread());
+
+	uint64* pde = X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPML4(), virtualAddress, fIsKernelMap,
+		true, reservation, fPageMapper, fMapCount);
+	ASSERT(pde != NULL);
+
+	// Keep the page table for the range aside, so that the large page can be
+	// split again without having to allocate memory. An existing table can
+	// only be used, if nothing is mapped in it.
+	vm_page* tablePage;
+	bool replacedTable = false;
+	if ((*pde & X86_64_PDE_PRESENT) != 0) {
+		if ((*pde & X86_64_PDE_LARGE_PAGE) != 0)
+			return B_BUSY;
+
+		uint64* pageTable = (uint64*)fPageMapper->GetPageTableAt(
+			*pde & X86_64_PDE_ADDRESS_MASK);
+		for (uint32 i = 0; i < k64BitTableEntryCount; i++) {
+			if ((pageTable[i] & X86_64_PTE_PRESENT) != 0)
+				return B_BUSY;
+		}
+
+		tablePage = vm_lookup_page(
+			(*pde & X86_64_PDE_ADDRESS_MASK) / B_PAGE_SIZE);
+		ASSERT(tablePage != NULL);
+		replacedTable = true;
+	} else {
+		tablePage = vm_page_allocate_page(reservation,
+			PAGE_STATE_WIRED | VM_PAGE_ALLOC_CLEAR);
+		DEBUG_PAGE_ACCESS_END(tablePage);
+		fMapCount++;
+	}
+
+	tablePage->cache_offset = virtualAddress / B_PAGE_SIZE;
+	fSparePageTables.Add(tablePage);
+
+	// The protection and memory type bits are the same for both levels.
+	uint64 entry;
+	X86PagingMethod64Bit::PutPageTableEntryInTable(&entry, physicalAddress,
+		attributes, memoryType, fIsKernelMap);
+	X86PagingMethod64Bit::SetTableEntry(pde,
+		entry | X86_64_PDE_LARGE_PAGE);
+
+	if (replacedTable) {
+		// the processor may have cached the page table
+		InvalidatePage(virtualAddress);
+	}
+
+	fMapCount += k64BitTableEntryCount;
+
+	return B_OK;
+}
+
+
 status_t
 X86VMTranslationMap64Bit::DebugMarkRangePresent(addr_t start, addr_t end,
 	bool markPresent)
@@ -285,6 +367,8 @@ X86VMTranslationMap64Bit::DebugMarkRangePresent(addr_t start, addr_t end,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		_SplitLargePage(start);
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -334,6 +418,8 @@ X86VMTranslationMap64Bit::UnmapPage(VMArea* area, addr_t address,
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	_SplitLargePage(address);
+
 	// Look up the page table for the virtual address.
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
@@ -402,6 +488,8 @@ X86VMTranslationMap64Bit::UnmapPages(VMArea* area, addr_t base, size_t size,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		_SplitLargePage(start);
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -636,7 +724,8 @@ X86VMTranslationMap64Bit::Query(addr_t virtualAddress,
 		| ((entry & X86_64_PTE_NOT_EXECUTABLE) == 0 ? B_KERNEL_EXECUTE_AREA : 0)
 		| ((entry & X86_64_PTE_DIRTY) != 0 ? PAGE_MODIFIED : 0)
 		| ((entry & X86_64_PTE_ACCESSED) != 0 ? PAGE_ACCESSED : 0)
-		| ((entry & X86_64_PTE_PRESENT) != 0 ? PAGE_PRESENT : 0);
+		| ((entry & X86_64_PTE_PRESENT) != 0 ? PAGE_PRESENT : 0)
+		| ((*pde & X86_64_PDE_LARGE_PAGE) != 0 ? PAGE_LARGE : 0);
 
 	TRACE("X86VMTranslationMap64Bit::Query(%#" B_PRIxADDR ") -> %#"
 		B_PRIxPHYSADDR " %#" B_PRIx32 " (entry: %#" B_PRIx64 ")\n",
@@ -683,6 +772,11 @@ X86VMTranslationMap64Bit::Protect(addr_t start, addr_t end, uint32 attributes,
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
 	do {
+		if (_ProtectLargePage(start, end, newProtectionFlags, memoryType)) {
+			start += k64BitPageTableRange;
+			continue;
+		}
+
 		uint64* pageTable = X86PagingMethod64Bit::PageTableForAddress(
 			fPagingStructures->VirtualPML4(), start, fIsKernelMap, false,
 			NULL, fPageMapper, fMapCount);
@@ -740,6 +834,8 @@ X86VMTranslationMap64Bit::ClearFlags(addr_t address, uint32 flags)
 
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	_SplitLargePage(address);
+
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
 		false, NULL, fPageMapper, fMapCount);
@@ -771,6 +867,8 @@ X86VMTranslationMap64Bit::ClearAccessedAndModified(VMArea* area, addr_t address,
 	RecursiveLocker locker(fLock);
 	ThreadCPUPinner pinner(thread_get_current_thread());
 
+	_SplitLargePage(address);
+
 	uint64* entry = X86PagingMethod64Bit::PageTableEntryForAddress(
 		fPagingStructures->VirtualPML4(), address, fIsKernelMap,
 		false, NULL, fPageMapper, fMapCount);
@@ -843,3 +941,129 @@ X86VMTranslationMap64Bit::PagingStructures() const
 {
 	return fPagingStructures;
 }
+
+
+/*!	Returns the page directory entry for the given address, if it maps a
+	large page that has been created by MapLargePage(), or \c NULL otherwise.
+	The caller must have pinned the thread.
+*/
+uint64*
+X86VMTranslationMap64Bit::_LargePageEntryForAddress(addr_t virtualAddress)
+{
+	if (fSparePageTables.IsEmpty())
+		return NULL;
+
+	uint64* pde = X86PagingMethod64Bit::PageDirectoryEntryForAddress(
+		fPagingStructures->VirtualPML4(), virtualAddress, fIsKernelMap,
+		false, NULL, fPageMapper, fMapCount);
+	if (pde == NULL || (*pde & X86_64_PDE_PRESENT) == 0
+		|| (*pde & X86_64_PDE_LARGE_PAGE) == 0) {
+		return NULL;
+	}
+
+	return pde;
+}
+
+
+/*!	If the given address is mapped by a large page, replaces it with its
+	spare page table, mapping the same physical range with small pages.
+	The caller must have pinned the thread.
+*/
+void
+X86VMTranslationMap64Bit::_SplitLargePage(addr_t virtualAddress)
+{
+	uint64* pde = _LargePageEntryForAddress(virtualAddress);
+	if (pde == NULL)
+		return;
+
+	RecursiveLocker locker(fLock);
+
+	addr_t base = ROUNDDOWN(virtualAddress, k64BitPageTableRange);
+	vm_page* tablePage = NULL;
+	for (PageTableList::Iterator it = fSparePageTables.GetIterator();
+			(tablePage = it.Next()) != NULL;) {
+		if (tablePage->cache_offset == base / B_PAGE_SIZE)
+			break;
+	}
+	if (tablePage == NULL) {
+		// not one of ours, like the physical map area
+		return;
+	}
+
+	phys_addr_t tableAddress
+		= (phys_addr_t)tablePage->physical_page_number * B_PAGE_SIZE;
+	uint64* pageTable = (uint64*)fPageMapper->GetPageTableAt(tableAddress);
+
+	// The processor may still set the accessed and dirty flags of the large
+	// page, so we have to fill in the table again, if the entry changed.
+	uint64 entry = *pde;
+	while (true) {
+		uint64 flags = entry & (X86_64_PTE_PRESENT | X86_64_PTE_WRITABLE
+			| X86_64_PTE_USER | X86_64_PTE_WRITE_THROUGH
+			| X86_64_PTE_CACHING_DISABLED | X86_64_PTE_ACCESSED
+			| X86_64_PTE_DIRTY | X86_64_PTE_GLOBAL
+			| X86_64_PTE_NOT_EXECUTABLE);
+		if ((entry & X86_64_PDE_PAT) != 0)
+			flags |= X86_64_PTE_PAT;
+
+		phys_addr_t physicalAddress = entry & X86_64_PDE_ADDRESS_MASK
+			& ~(phys_addr_t)(k64BitPageTableRange - 1);
+		for (uint32 i = 0; i < k64BitTableEntryCount; i++) {
+			X86PagingMethod64Bit::SetTableEntry(&pageTable[i],
+				(physicalAddress + i * B_PAGE_SIZE) | flags);
+		}
+
+		uint64 oldEntry = X86PagingMethod64Bit::TestAndSetTableEntry(pde,
+			(tableAddress & X86_64_PDE_ADDRESS_MASK) | X86_64_PDE_PRESENT
+				| X86_64_PDE_WRITABLE | X86_64_PDE_USER,
+			entry);
+		if (oldEntry == entry)
+			break;
+		entry = oldEntry;
+	}
+
+	fSparePageTables.Remove(tablePage);
+
+	InvalidatePage(base);
+}
+
+
+/*!	Changes the protection of the large page at \a start, if there is one and
+	the range covers it completely. Splits the large page, if it is only
+	covered partially.
+	Returns whether the large page has been taken care of.
+*/
+bool
+X86VMTranslationMap64Bit::_ProtectLargePage(addr_t start, addr_t end,
+	uint64 protectionFlags, uint32 memoryType)
+{
+	uint64* pde = _LargePageEntryForAddress(start);
+	if (pde == NULL)
+		return false;
+
+	if (start % k64BitPageTableRange != 0
+		|| end - start <= k64BitPageTableRange - B_PAGE_SIZE) {
+		_SplitLargePage(start);
+		return false;
+	}
+
+	uint64 entry = *pde;
+	uint64 oldEntry;
+	while (true) {
+		oldEntry = X86PagingMethod64Bit::TestAndSetTableEntry(pde,
+			(entry & ~(X86_64_PTE_PROTECTION_MASK
+					| X86_64_PTE_MEMORY_TYPE_MASK))
+				| protectionFlags
+				| X86PagingMethod64Bit::MemoryTypeToPageTableEntryFlags(
+					memoryType),
+			entry);
+		if (oldEntry == entry)
+			break;
+		entry = oldEntry;
+	}
+
+	if ((oldEntry & X86_64_PDE_ACCESSED) != 0)
+		InvalidatePage(start);
+
+	return true;
+}
@@ -7,6 +7,9 @@
 #define KERNEL_ARCH_X86_PAGING_64BIT_X86_VM_TRANSLATION_MAP_64BIT_H
 
 
+#include <util/DoublyLinkedList.h>
+#include <vm/vm_types.h>
+
 #include "paging/X86VMTranslationMap.h"
 
 
@@ -28,6 +31,12 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 									vm_page_reservation* reservation);
 	virtual	status_t			Unmap(addr_t start, addr_t end);
 
+	virtual	size_t				LargePageSize() const;
+	virtual	status_t			MapLargePage(addr_t virtualAddress,
+									phys_addr_t physicalAddress,
+									uint32 attributes, uint32 memoryType,
+									vm_page_reservation* reservation);
+
 	virtual	status_t			DebugMarkRangePresent(addr_t start, addr_t end,
 									bool markPresent);
 
@@ -61,8 +70,21 @@ struct X86VMTranslationMap64Bit final : X86VMTranslationMap {
 	inline	X86PagingStructures64Bit* PagingStructures64Bit() const
 									{ return fPagingStructures; }
 
+private:
+			typedef DoublyLinkedList<vm_page,
+				DoublyLinkedListMemberGetLink<vm_page, &vm_page::queue_link> >
+					PageTableList;
+
+			uint64*				_LargePageEntryForAddress(
+									addr_t virtualAddress);
+			void				_SplitLargePage(addr_t virtualAddress);
+			bool				_ProtectLargePage(addr_t start, addr_t end,
+									uint64 protectionFlags, uint32 memoryType);
+
 private:
 			X86PagingStructures64Bit* fPagingStructures;
+			PageTableList		fSparePageTables;
+				// one page table for each large page, used to split it
 };
 
 
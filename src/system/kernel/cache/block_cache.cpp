@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/uio.h>
 
 #include <KernelExport.h>
 #include <fs_cache.h>
@@ -27,9 +28,12 @@
 #include "kernel_debug_config.h"
 
 
-// TODO: this is a naive but growing implementation to test the API:
-//	block reading/writing is not at all optimized for speed, it will
-//	just read and write single blocks.
+// Blocks are read in on demand; when a cache detects sequential access, it
+// reads ahead a contiguous run of missing blocks with a single vectored read.
+// Dirty blocks that are adjacent on disk are written back in clusters.
+// The block hash and the unused list are split into lock-striped shards; a
+// block_cache_get()/block_cache_put() pair of an already cached block only
+// needs to lock the block's shard, not the whole cache.
 // TODO: the retrieval/copy of the original data could be delayed until the
 //		new data must be written, ie. in low memory situations.
 
@@ -49,6 +53,23 @@
 static const bigtime_t kTransactionIdleTime = 2000000LL;
 	// a transaction is considered idle after 2 seconds of inactivity
 
+static const size_t kMaxClusterBlocks = 32;
+static const size_t kMaxClusterSize = 64 * 1024;
+	// upper bounds for a single vectored read or write
+static const size_t kMinReadAheadBlocks = 4;
+static const uint32 kSequentialReadThreshold = 2;
+	// number of consecutive sequential misses before read-ahead kicks in
+
+static const uint32 kBlockShardShift = 3;
+static const uint32 kBlockShards = 1 << kBlockShardShift;
+	// number of lock-striped shards the blocks of a cache are spread over
+
+#if !BLOCK_CACHE_DEBUG_CHANGED && !BLOCK_CACHE_BLOCK_TRACING
+#	define BLOCK_CACHE_FAST_PATH 1
+#else
+#	define BLOCK_CACHE_FAST_PATH 0
+#endif
+
 
 namespace {
 
@@ -130,12 +151,14 @@ struct BlockHash {
 
 	size_t HashKey(KeyType key) const
 	{
-		return key;
+		// the lower bits select the shard, and are the same for all blocks
+		// in one table
+		return key >> kBlockShardShift;
 	}
 
 	size_t Hash(ValueType* block) const
 	{
-		return block->block_number;
+		return block->block_number >> kBlockShardShift;
 	}
 
 	bool Compare(KeyType key, ValueType* block) const
@@ -169,8 +192,24 @@ struct TransactionHash {
 typedef BOpenHashTable<TransactionHash> TransactionTable;
 
 
-struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
+/*!	A shard owns a subset of the blocks of a cache. Its lock protects the
+	reference count, the last access time, and the unused list membership of
+	its blocks, and must be held to change its hash table. The hash table can
+	also be read with just the cache lock held, as all changes to it are made
+	with both locks held.
+	Lock order is cache lock first, then shard lock; only one shard lock may
+	be held at a time.
+*/
+struct block_shard {
+	mutex			lock;
 	BlockTable*		hash;
+	block_list		unused_blocks;
+	uint32			unused_block_count;
+};
+
+
+struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
+	block_shard		shards[kBlockShards];
 	mutex			lock;
 	int				fd;
 	off_t			max_blocks;
@@ -180,8 +219,7 @@ struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	TransactionTable* transaction_hash;
 
 	object_cache*	buffer_cache;
-	block_list		unused_blocks;
-	uint32			unused_block_count;
+	uint32			next_unused_shard;
 
 	ConditionVariable busy_reading_condition;
 	uint32			busy_reading_count;
@@ -194,6 +232,11 @@ struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	uint32			num_dirty_blocks;
 	bool			read_only;
 
+	off_t			last_read_block;
+	uint32			sequential_reads;
+	size_t			read_ahead_blocks;
+	size_t			max_cluster_blocks;
+
 	NotificationList pending_notifications;
 	ConditionVariable condition_variable;
 
@@ -209,13 +252,28 @@ struct block_cache : DoublyLinkedListLinkImpl<block_cache> {
 	cached_block*	NewBlock(off_t blockNumber);
 	void			FreeBlockParentData(cached_block* block);
 
+	block_shard&	ShardFor(off_t blockNumber)
+						{ return shards[blockNumber & (kBlockShards - 1)]; }
+	cached_block*	LookupBlock(off_t blockNumber)
+						{ return ShardFor(blockNumber).hash->Lookup(
+							blockNumber); }
+	void			InsertBlock(cached_block* block);
+	void			AddUnusedBlock(block_shard& shard, cached_block* block);
+	void			RemoveUnusedBlock(block_shard& shard,
+						cached_block* block);
+	uint32			UnusedBlockCount() const;
+
 	void			RemoveUnusedBlocks(int32 count, int32 minSecondsOld = 0);
 	void			RemoveBlock(cached_block* block);
 	void			DiscardBlock(cached_block* block);
 
+	size_t			ReadAheadBlocks(off_t blockNumber);
+
 private:
 	static void		_LowMemoryHandler(void* data, uint32 resources,
 						int32 level);
+	int32			_RemoveUnusedBlocks(block_shard& shard, int32 count,
+						int32 minSecondsOld);
 	cached_block*	_GetUnusedBlock();
 };
 
@@ -272,6 +330,8 @@ public:
 private:
 			void*				_Data(cached_block* block) const;
 			status_t			_WriteBlock(cached_block* block);
+			status_t			_WriteBlocks(cached_block** blocks,
+									size_t count);
 			void				_BlockDone(cached_block* block,
 									cache_transaction* transaction);
 			void				_UnmarkWriting(cached_block* block);
@@ -1180,17 +1240,29 @@ BlockWriter::Write(cache_transaction* transaction, bool canUnlock)
 	qsort(fBlocks, fCount, sizeof(void*), &_CompareBlocks);
 	fDeletedTransaction = false;
 
-	for (uint32 i = 0; i < fCount; i++) {
-		status_t status = _WriteBlock(fBlocks[i]);
+	for (uint32 i = 0; i < fCount;) {
+		// Collect a run of blocks that are adjacent on disk
+		uint32 count = 1;
+		while (i + count < fCount && count < fCache->max_cluster_blocks
+			&& fBlocks[i + count]->block_number
+				== fBlocks[i]->block_number + count) {
+			count++;
+		}
+
+		status_t status = _WriteBlocks(fBlocks + i, count);
 		if (status != B_OK) {
 			// propagate to global error handling
 			if (fStatus == B_OK)
 				fStatus = status;
 
-			_UnmarkWriting(fBlocks[i]);
-			fBlocks[i] = NULL;
-				// This block will not be marked clean
+			for (uint32 j = i; j < i + count; j++) {
+				_UnmarkWriting(fBlocks[j]);
+				fBlocks[j] = NULL;
+					// This block will not be marked clean
+			}
 		}
+
+		i += count;
 	}
 
 	if (canUnlock)
@@ -1257,6 +1329,49 @@ BlockWriter::_WriteBlock(cached_block* block)
 }
 
 
+/*!	Writes back \a count blocks that are adjacent on disk using a single
+	vectored write.
+*/
+status_t
+BlockWriter::_WriteBlocks(cached_block** blocks, size_t count)
+{
+	if (count == 1)
+		return _WriteBlock(blocks[0]);
+
+	iovec vecs[kMaxClusterBlocks];
+	size_t blockSize = fCache->block_size;
+
+	for (size_t i = 0; i < count; i++) {
+		ASSERT(blocks[i]->busy_writing);
+
+		TB(Write(fCache, blocks[i]));
+		TB2(BlockData(fCache, blocks[i], "before write"));
+
+		vecs[i].iov_base = _Data(blocks[i]);
+		vecs[i].iov_len = blockSize;
+	}
+
+	TRACE(("BlockWriter::_WriteBlocks(blocks %" B_PRIdOFF " - %" B_PRIdOFF
+		")\n", blocks[0]->block_number, blocks[count - 1]->block_number));
+
+	ssize_t written = writev_pos(fCache->fd,
+		blocks[0]->block_number * blockSize, vecs, count);
+
+	if (written != (ssize_t)(count * blockSize)) {
+		TB(Error(fCache, blocks[0]->block_number, "write failed", written));
+		TRACE_ALWAYS(("could not write back blocks %" B_PRIdOFF " - %"
+			B_PRIdOFF " (%s)\n", blocks[0]->block_number,
+			blocks[count - 1]->block_number, strerror(errno)));
+		if (written < 0)
+			return errno;
+
+		return B_IO_ERROR;
+	}
+
+	return B_OK;
+}
+
+
 void
 BlockWriter::_BlockDone(cached_block* block,
 	cache_transaction* transaction)
@@ -1307,12 +1422,15 @@ BlockWriter::_BlockDone(cached_block* block,
 			fDeletedTransaction = true;
 		}
 	}
-	if (block->transaction == NULL && block->ref_count == 0 && !block->unused) {
-		// the block is no longer used
-		ASSERT(block->original_data == NULL && block->parent_data == NULL);
-		block->unused = true;
-		fCache->unused_blocks.Add(block);
-		fCache->unused_block_count++;
+	if (block->transaction == NULL && !block->unused) {
+		block_shard& shard = fCache->ShardFor(block->block_number);
+		MutexLocker shardLocker(shard.lock);
+
+		if (block->ref_count == 0) {
+			// the block is no longer used
+			ASSERT(block->original_data == NULL && block->parent_data == NULL);
+			fCache->AddUnusedBlock(shard, block);
+		}
 	}
 
 	TB2(BlockData(fCache, block, "after write"));
@@ -1356,7 +1474,6 @@ BlockWriter::_CompareBlocks(const void* _blockA, const void* _blockB)
 block_cache::block_cache(int _fd, off_t numBlocks, size_t blockSize,
 		bool readOnly)
 	:
-	hash(NULL),
 	fd(_fd),
 	max_blocks(numBlocks),
 	block_size(blockSize),
@@ -1364,14 +1481,25 @@ block_cache::block_cache(int _fd, off_t numBlocks, size_t blockSize,
 	last_transaction(NULL),
 	transaction_hash(NULL),
 	buffer_cache(NULL),
-	unused_block_count(0),
+	next_unused_shard(0),
 	busy_reading_count(0),
 	busy_reading_waiters(false),
 	busy_writing_count(0),
 	busy_writing_waiters(0),
 	num_dirty_blocks(0),
-	read_only(readOnly)
+	read_only(readOnly),
+	last_read_block(-1),
+	sequential_reads(0),
+	read_ahead_blocks(0),
+	max_cluster_blocks(min_c(kMaxClusterBlocks, kMaxClusterSize / blockSize))
 {
+	if (max_cluster_blocks == 0)
+		max_cluster_blocks = 1;
+
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		shards[i].hash = NULL;
+		shards[i].unused_block_count = 0;
+	}
 }
 
 
@@ -1381,7 +1509,11 @@ block_cache::~block_cache()
 	unregister_low_resource_handler(&_LowMemoryHandler, this);
 
 	delete transaction_hash;
-	delete hash;
+
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		delete shards[i].hash;
+		mutex_destroy(&shards[i].lock);
+	}
 
 	delete_object_cache(buffer_cache);
 
@@ -1396,15 +1528,20 @@ block_cache::Init()
 	busy_writing_condition.Init(this, "cache block busy writing");
 	condition_variable.Init(this, "cache transaction sync");
 	mutex_init(&lock, "block cache");
+	for (uint32 i = 0; i < kBlockShards; i++)
+		mutex_init(&shards[i].lock, "block cache shard");
 
 	buffer_cache = create_object_cache_etc("block cache buffers", block_size,
 		8, 0, 0, 0, CACHE_LARGE_SLAB, NULL, NULL, NULL, NULL);
 	if (buffer_cache == NULL)
 		return B_NO_MEMORY;
 
-	hash = new BlockTable();
-	if (hash == NULL || hash->Init(1024) != B_OK)
-		return B_NO_MEMORY;
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		shards[i].hash = new(std::nothrow) BlockTable();
+		if (shards[i].hash == NULL
+			|| shards[i].hash->Init(1024 / kBlockShards) != B_OK)
+			return B_NO_MEMORY;
+	}
 
 	transaction_hash = new(std::nothrow) TransactionTable();
 	if (transaction_hash == NULL || transaction_hash->Init(16) != B_OK)
@@ -1478,7 +1615,7 @@ block_cache::NewBlock(off_t blockNumber)
 		} else {
 			TB(Error(this, blockNumber, "allocation failed"));
 			dprintf("block allocation failed, unused list is %sempty.\n",
-				unused_blocks.IsEmpty() ? "" : "not ");
+				UnusedBlockCount() == 0 ? "" : "not ");
 
 			// allocation failed, try to reuse an unused block
 			block = _GetUnusedBlock();
@@ -1523,47 +1660,81 @@ block_cache::FreeBlockParentData(cached_block* block)
 }
 
 
+/*!	Inserts the new \a block into the hash table of its shard.
+	Cache must be locked.
+*/
 void
-block_cache::RemoveUnusedBlocks(int32 count, int32 minSecondsOld)
+block_cache::InsertBlock(cached_block* block)
 {
-	TRACE(("block_cache: remove up to %" B_PRId32 " unused blocks\n", count));
+	block_shard& shard = ShardFor(block->block_number);
+	MutexLocker shardLocker(shard.lock);
 
-	for (block_list::Iterator iterator = unused_blocks.GetIterator();
-			cached_block* block = iterator.Next();) {
-		if (minSecondsOld >= block->LastAccess()) {
-			// The list is sorted by last access
-			break;
-		}
-		if (block->busy_reading || block->busy_writing)
-			continue;
+	shard.hash->Insert(block);
+}
 
-		TB(Flush(this, block));
-		TRACE(("  remove block %" B_PRIdOFF ", last accessed %" B_PRId32 "\n",
-			block->block_number, block->last_accessed));
 
-		// this can only happen if no transactions are used
-		if (block->is_dirty && !block->discard) {
-			if (block->busy_writing)
-				continue;
+/*!	Cache and \a shard must be locked. */
+void
+block_cache::AddUnusedBlock(block_shard& shard, cached_block* block)
+{
+	ASSERT(!block->unused);
+	block->unused = true;
+	shard.unused_blocks.Add(block);
+	shard.unused_block_count++;
+}
 
-			BlockWriter::WriteBlock(this, block);
-		}
 
-		// remove block from lists
-		iterator.Remove();
-		unused_block_count--;
-		RemoveBlock(block);
+/*!	Cache and \a shard must be locked. */
+void
+block_cache::RemoveUnusedBlock(block_shard& shard, cached_block* block)
+{
+	ASSERT(block->unused);
+	block->unused = false;
+	shard.unused_blocks.Remove(block);
+	shard.unused_block_count--;
+}
 
-		if (--count <= 0)
-			break;
+
+uint32
+block_cache::UnusedBlockCount() const
+{
+	uint32 count = 0;
+	for (uint32 i = 0; i < kBlockShards; i++)
+		count += shards[i].unused_block_count;
+
+	return count;
+}
+
+
+void
+block_cache::RemoveUnusedBlocks(int32 count, int32 minSecondsOld)
+{
+	TRACE(("block_cache: remove up to %" B_PRId32 " unused blocks\n", count));
+
+	// start with a different shard every time, so that none is preferred
+	uint32 start = next_unused_shard++;
+	for (uint32 i = 0; i < kBlockShards && count > 0; i++) {
+		count = _RemoveUnusedBlocks(shards[(start + i) % kBlockShards], count,
+			minSecondsOld);
 	}
 }
 
 
+/*!	Removes the block from its hash table, and frees it. The block must not
+	be in the unused list anymore.
+	Cache must be locked.
+*/
 void
 block_cache::RemoveBlock(cached_block* block)
 {
-	hash->Remove(block);
+	ASSERT(!block->unused);
+
+	block_shard& shard = ShardFor(block->block_number);
+	MutexLocker shardLocker(shard.lock);
+
+	shard.hash->Remove(block);
+	shardLocker.Unlock();
+
 	FreeBlock(block);
 }
 
@@ -1585,10 +1756,52 @@ block_cache::DiscardBlock(cached_block* block)
 		block->original_data = NULL;
 	}
 
+	if (block->unused) {
+		block_shard& shard = ShardFor(block->block_number);
+		MutexLocker shardLocker(shard.lock);
+		RemoveUnusedBlock(shard, block);
+	}
+
 	RemoveBlock(block);
 }
 
 
+/*!	Feeds the read-ahead heuristic with a read miss of \a blockNumber, and
+	returns the number of blocks following it that should be read in along
+	with it.
+	Cache must be locked.
+*/
+size_t
+block_cache::ReadAheadBlocks(off_t blockNumber)
+{
+	if (blockNumber != last_read_block + 1) {
+		// random access, start over
+		sequential_reads = 0;
+		read_ahead_blocks = 0;
+		return 0;
+	}
+
+	if (sequential_reads < kSequentialReadThreshold
+		&& ++sequential_reads < kSequentialReadThreshold)
+		return 0;
+
+	// grow the window exponentially while the access stays sequential
+	if (read_ahead_blocks == 0)
+		read_ahead_blocks = kMinReadAheadBlocks;
+	else
+		read_ahead_blocks *= 2;
+	read_ahead_blocks = min_c(read_ahead_blocks, max_cluster_blocks - 1);
+
+	if (low_resource_state(B_KERNEL_RESOURCE_PAGES | B_KERNEL_RESOURCE_MEMORY
+			| B_KERNEL_RESOURCE_ADDRESS_SPACE) != B_NO_LOW_RESOURCE) {
+		// don't make matters worse
+		return 0;
+	}
+
+	return read_ahead_blocks;
+}
+
+
 void
 block_cache::_LowMemoryHandler(void* data, uint32 resources, int32 level)
 {
@@ -1604,15 +1817,15 @@ block_cache::_LowMemoryHandler(void* data, uint32 resources, int32 level)
 		case B_NO_LOW_RESOURCE:
 			return;
 		case B_LOW_RESOURCE_NOTE:
-			free = cache->unused_block_count / 8;
+			free = cache->UnusedBlockCount() / 8;
 			secondsOld = 120;
 			break;
 		case B_LOW_RESOURCE_WARNING:
-			free = cache->unused_block_count / 4;
+			free = cache->UnusedBlockCount() / 4;
 			secondsOld = 10;
 			break;
 		case B_LOW_RESOURCE_CRITICAL:
-			free = cache->unused_block_count / 2;
+			free = cache->UnusedBlockCount() / 2;
 			secondsOld = 0;
 			break;
 	}
@@ -1627,42 +1840,122 @@ block_cache::_LowMemoryHandler(void* data, uint32 resources, int32 level)
 	}
 
 #ifdef TRACE_BLOCK_CACHE
-	uint32 oldUnused = cache->unused_block_count;
+	uint32 oldUnused = cache->UnusedBlockCount();
 #endif
 
 	cache->RemoveUnusedBlocks(free, secondsOld);
 
 	TRACE(("block_cache::_LowMemoryHandler(): %p: unused: %" B_PRIu32 " -> %" B_PRIu32 "\n",
-		cache, oldUnused, cache->unused_block_count));
+		cache, oldUnused, cache->UnusedBlockCount()));
 }
 
 
-cached_block*
-block_cache::_GetUnusedBlock()
+/*!	Removes up to \a count unused blocks from the \a shard that have not been
+	accessed for at least \a minSecondsOld seconds, and returns how many of
+	\a count are left.
+	Cache must be locked.
+*/
+int32
+block_cache::_RemoveUnusedBlocks(block_shard& shard, int32 count,
+	int32 minSecondsOld)
 {
-	TRACE(("block_cache: get unused block\n"));
+	MutexLocker shardLocker(shard.lock);
 
-	for (block_list::Iterator iterator = unused_blocks.GetIterator();
+restart:
+	for (block_list::Iterator iterator = shard.unused_blocks.GetIterator();
 			cached_block* block = iterator.Next();) {
-		TB(Flush(this, block, true));
+		if (block->ref_count > 0) {
+			// The block has been acquired without the cache lock in the
+			// mean time; it will be added again once it has been put
+			RemoveUnusedBlock(shard, block);
+			continue;
+		}
+		if (minSecondsOld >= block->LastAccess()) {
+			// The list is sorted by last access
+			break;
+		}
+		if (block->busy_reading || block->busy_writing)
+			continue;
+
+		TB(Flush(this, block));
+		TRACE(("  remove block %" B_PRIdOFF ", last accessed %" B_PRId32 "\n",
+			block->block_number, block->last_accessed));
+
 		// this can only happen if no transactions are used
-		if (block->is_dirty && !block->busy_writing && !block->discard)
-			BlockWriter::WriteBlock(this, block);
+		if (block->is_dirty && !block->discard) {
+			// The cache is unlocked during the write, the list might have
+			// changed afterwards
+			shardLocker.Unlock();
+			status_t status = BlockWriter::WriteBlock(this, block);
+			shardLocker.Lock();
+
+			if (status != B_OK)
+				break;
+			goto restart;
+		}
 
 		// remove block from lists
-		iterator.Remove();
-		unused_block_count--;
-		hash->Remove(block);
+		RemoveUnusedBlock(shard, block);
+		shard.hash->Remove(block);
+		FreeBlock(block);
+
+		if (--count <= 0)
+			break;
+	}
+
+	return count;
+}
 
-		ASSERT(block->original_data == NULL && block->parent_data == NULL);
-		block->unused = false;
 
-		// TODO: see if compare data is handled correctly here!
+/*!	Takes a block out of the unused lists to be reused for another block
+	number. Cache must be locked.
+*/
+cached_block*
+block_cache::_GetUnusedBlock()
+{
+	TRACE(("block_cache: get unused block\n"));
+
+	uint32 start = next_unused_shard++;
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		block_shard& shard = shards[(start + i) % kBlockShards];
+		MutexLocker shardLocker(shard.lock);
+
+restart:
+		for (block_list::Iterator iterator = shard.unused_blocks.GetIterator();
+				cached_block* block = iterator.Next();) {
+			if (block->ref_count > 0) {
+				// acquired without the cache lock, see above
+				RemoveUnusedBlock(shard, block);
+				continue;
+			}
+			if (block->busy_reading || block->busy_writing)
+				continue;
+
+			TB(Flush(this, block, true));
+			// this can only happen if no transactions are used
+			if (block->is_dirty && !block->discard) {
+				shardLocker.Unlock();
+				status_t status = BlockWriter::WriteBlock(this, block);
+				shardLocker.Lock();
+
+				if (status != B_OK)
+					break;
+				goto restart;
+			}
+
+			// remove block from lists
+			RemoveUnusedBlock(shard, block);
+			shard.hash->Remove(block);
+
+			ASSERT(block->original_data == NULL && block->parent_data == NULL);
+
+			// TODO: see if compare data is handled correctly here!
 #if BLOCK_CACHE_DEBUG_CHANGED
-		if (block->compare != NULL)
-			Free(block->compare);
+			if (block->compare != NULL)
+				Free(block->compare);
 #endif
-		return block;
+			return block;
+		}
 	}
 
 	return NULL;
@@ -1677,6 +1970,8 @@ block_cache::_GetUnusedBlock()
 static void
 mark_block_busy_reading(block_cache* cache, cached_block* block)
 {
+	MutexLocker shardLocker(cache->ShardFor(block->block_number).lock);
+
 	block->busy_reading = true;
 	cache->busy_reading_count++;
 }
@@ -1687,7 +1982,12 @@ mark_block_busy_reading(block_cache* cache, cached_block* block)
 static void
 mark_block_unbusy_reading(block_cache* cache, cached_block* block)
 {
+	MutexLocker shardLocker(cache->ShardFor(block->block_number).lock);
+
 	block->busy_reading = false;
+	shardLocker.Unlock();
+		// the shard lock makes sure the fast path sees the block contents
+
 	cache->busy_reading_count--;
 
 	if ((cache->busy_reading_waiters && cache->busy_reading_count == 0)
@@ -1803,6 +2103,9 @@ put_cached_block(block_cache* cache, cached_block* block)
 #endif
 	TB(Put(cache, block));
 
+	block_shard& shard = cache->ShardFor(block->block_number);
+	MutexLocker shardLocker(shard.lock);
+
 	if (block->ref_count < 1) {
 		panic("Invalid ref_count for block %p, cache %p\n", block, cache);
 		return;
@@ -1814,15 +2117,20 @@ put_cached_block(block_cache* cache, cached_block* block)
 		block->is_writing = false;
 
 		if (block->discard) {
+			if (block->unused)
+				cache->RemoveUnusedBlock(shard, block);
+			shardLocker.Unlock();
+
 			cache->RemoveBlock(block);
+		} else if (block->unused) {
+			// the block has been acquired via the fast path, it only needs
+			// to be moved to the end of the list
+			shard.unused_blocks.Remove(block);
+			shard.unused_blocks.Add(block);
 		} else {
 			// put this block in the list of unused blocks
-			ASSERT(!block->unused);
-			block->unused = true;
-
 			ASSERT(block->original_data == NULL && block->parent_data == NULL);
-			cache->unused_blocks.Add(block);
-			cache->unused_block_count++;
+			cache->AddUnusedBlock(shard, block);
 		}
 	}
 }
@@ -1836,7 +2144,7 @@ put_cached_block(block_cache* cache, off_t blockNumber)
 			blockNumber, cache->max_blocks - 1);
 	}
 
-	cached_block* block = cache->hash->Lookup(blockNumber);
+	cached_block* block = cache->LookupBlock(blockNumber);
 	if (block != NULL)
 		put_cached_block(cache, block);
 	else {
@@ -1845,6 +2153,65 @@ put_cached_block(block_cache* cache, off_t blockNumber)
 }
 
 
+#if BLOCK_CACHE_FAST_PATH
+/*!	Tries to get an already cached block without locking the cache.
+	Returns \c NULL if the slow path has to be taken instead.
+	Blocks retrieved this way stay in the unused list if they were in it;
+	they are removed from it lazily by anyone holding the cache lock.
+*/
+static cached_block*
+get_cached_block_fast(block_cache* cache, off_t blockNumber)
+{
+	if (blockNumber < 0 || blockNumber >= cache->max_blocks)
+		return NULL;
+
+	block_shard& shard = cache->ShardFor(blockNumber);
+	MutexLocker shardLocker(shard.lock);
+
+	cached_block* block = shard.hash->Lookup(blockNumber);
+	if (block == NULL || block->busy_reading)
+		return NULL;
+
+	block->ref_count++;
+	block->last_accessed = system_time() / 1000000L;
+
+	return block;
+}
+
+
+/*!	Tries to release a reference to the block without locking the cache.
+	This only works if the block does not need to change its state, that is,
+	if there are other references left, or if it is still in the unused list.
+	Returns \c false if the slow path has to be taken instead.
+*/
+static bool
+put_cached_block_fast(block_cache* cache, off_t blockNumber)
+{
+	if (blockNumber < 0 || blockNumber >= cache->max_blocks)
+		return false;
+
+	block_shard& shard = cache->ShardFor(blockNumber);
+	MutexLocker shardLocker(shard.lock);
+
+	cached_block* block = shard.hash->Lookup(blockNumber);
+	if (block == NULL || block->ref_count < 1)
+		return false;
+
+	if (block->ref_count == 1) {
+		if (!block->unused || block->discard)
+			return false;
+
+		// move it to the end of the unused list
+		shard.unused_blocks.Remove(block);
+		shard.unused_blocks.Add(block);
+	}
+
+	block->ref_count--;
+	return true;
+}
+#endif	// BLOCK_CACHE_FAST_PATH
+
+
 /*!	Retrieves the block \a blockNumber from the hash table, if it's already
 	there, or reads it from the disk.
 	You need to have the cache locked when calling this function.
@@ -1869,7 +2236,7 @@ get_cached_block(block_cache* cache, off_t blockNumber, bool* _allocated,
 	}
 
 retry:
-	cached_block* block = cache->hash->Lookup(blockNumber);
+	cached_block* block = cache->LookupBlock(blockNumber);
 	*_allocated = false;
 
 	if (block == NULL) {
@@ -1877,8 +2244,17 @@ retry:
 		block = cache->NewBlock(blockNumber);
 		if (block == NULL)
 			return NULL;
+		if (cache->LookupBlock(blockNumber) != NULL) {
+			// NewBlock() might have unlocked the cache in the mean time
+			cache->FreeBlock(block);
+			goto retry;
+		}
 
-		cache->hash->Insert(block);
+		// mark the block busy before anyone can see it
+		if (readBlock)
+			mark_block_busy_reading(cache, block);
+
+		cache->InsertBlock(block);
 		*_allocated = true;
 	} else if (block->busy_reading) {
 		// The block is currently busy_reading - wait and try again later
@@ -1886,25 +2262,86 @@ retry:
 		goto retry;
 	}
 
-	if (block->unused) {
-		//TRACE(("remove block %" B_PRIdOFF " from unused\n", blockNumber));
-		block->unused = false;
-		cache->unused_blocks.Remove(block);
-		cache->unused_block_count--;
-	}
-
 	if (*_allocated && readBlock) {
-		// read block into cache
+		// read block into cache, together with the blocks following it if
+		// the cache is being accessed sequentially
 		int32 blockSize = cache->block_size;
+		cached_block* blocks[kMaxClusterBlocks];
+		iovec vecs[kMaxClusterBlocks];
+
+		blocks[0] = block;
+		size_t count = 1;
+
+		size_t readAhead = cache->ReadAheadBlocks(blockNumber);
+		for (off_t next = blockNumber + 1; count <= readAhead
+				&& next < cache->max_blocks; next++) {
+			if (cache->LookupBlock(next) != NULL)
+				break;
+
+			cached_block* aheadBlock = cache->NewBlock(next);
+			if (aheadBlock == NULL)
+				break;
+			if (cache->LookupBlock(next) != NULL) {
+				// NewBlock() might have unlocked the cache in the mean time
+				cache->FreeBlock(aheadBlock);
+				break;
+			}
+
+			mark_block_busy_reading(cache, aheadBlock);
+			cache->InsertBlock(aheadBlock);
+			blocks[count++] = aheadBlock;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			vecs[i].iov_base = blocks[i]->current_data;
+			vecs[i].iov_len = blockSize;
+		}
 
-		mark_block_busy_reading(cache, block);
 		mutex_unlock(&cache->lock);
 
-		ssize_t bytesRead = read_pos(cache->fd, blockNumber * blockSize,
-			block->current_data, blockSize);
+		ssize_t bytesRead;
+		if (count == 1) {
+			bytesRead = read_pos(cache->fd, blockNumber * blockSize,
+				block->current_data, blockSize);
+		} else {
+			bytesRead = readv_pos(cache->fd, blockNumber * blockSize, vecs,
+				count);
+		}
 
 		mutex_lock(&cache->lock);
-		if (bytesRead < blockSize) {
+
+		size_t blocksRead = bytesRead > 0 ? bytesRead / blockSize : 0;
+
+		// Read-ahead blocks are not referenced by anyone, they are put into
+		// the unused list right away; the ones that could not be read are
+		// removed again.
+		int32 now = system_time() / 1000000L;
+		for (size_t i = 1; i < count; i++) {
+			cached_block* aheadBlock = blocks[i];
+			block_shard& shard = cache->ShardFor(aheadBlock->block_number);
+
+			if (i >= blocksRead) {
+				// take it out of the hash before anyone can get it
+				MutexLocker shardLocker(shard.lock);
+				shard.hash->Remove(aheadBlock);
+				shardLocker.Unlock();
+
+				mark_block_unbusy_reading(cache, aheadBlock);
+				cache->FreeBlock(aheadBlock);
+				continue;
+			}
+
+			mark_block_unbusy_reading(cache, aheadBlock);
+			TB(Read(cache, aheadBlock));
+
+			MutexLocker shardLocker(shard.lock);
+			if (aheadBlock->ref_count == 0) {
+				aheadBlock->last_accessed = now;
+				cache->AddUnusedBlock(shard, aheadBlock);
+			}
+		}
+
+		if (blocksRead == 0) {
 			cache->RemoveBlock(block);
 			TB(Error(cache, blockNumber, "read failed", bytesRead));
 
@@ -1914,9 +2351,18 @@ retry:
 		}
 		TB(Read(cache, block));
 
+		cache->last_read_block = blockNumber + min_c(blocksRead, count) - 1;
 		mark_block_unbusy_reading(cache, block);
 	}
 
+	block_shard& shard = cache->ShardFor(blockNumber);
+	MutexLocker shardLocker(shard.lock);
+
+	if (block->unused) {
+		//TRACE(("remove block %" B_PRIdOFF " from unused\n", blockNumber));
+		cache->RemoveUnusedBlock(shard, block);
+	}
+
 	block->ref_count++;
 	block->last_accessed = system_time() / 1000000L;
 
@@ -2192,7 +2638,7 @@ dump_cache(int argc, char** argv)
 	off_t blockNumber = -1;
 	if (i + 1 < argc) {
 		blockNumber = parse_expression(argv[i + 1]);
-		cached_block* block = cache->hash->Lookup(blockNumber);
+		cached_block* block = cache->LookupBlock(blockNumber);
 		if (block != NULL)
 			dump_block_long(block);
 		else
@@ -2252,26 +2698,28 @@ dump_cache(int argc, char** argv)
 	uint32 count = 0;
 	uint32 dirty = 0;
 	uint32 discarded = 0;
-	BlockTable::Iterator iterator(cache->hash);
-	while (iterator.HasNext()) {
-		cached_block* block = iterator.Next();
-		if (showBlocks)
-			dump_block(block);
-
-		if (block->is_dirty)
-			dirty++;
-		if (block->discard)
-			discarded++;
-		if (block->ref_count)
-			referenced++;
-		count++;
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		BlockTable::Iterator iterator(cache->shards[i].hash);
+		while (iterator.HasNext()) {
+			cached_block* block = iterator.Next();
+			if (showBlocks)
+				dump_block(block);
+
+			if (block->is_dirty)
+				dirty++;
+			if (block->discard)
+				discarded++;
+			if (block->ref_count)
+				referenced++;
+			count++;
+		}
 	}
 
 	kprintf(" %" B_PRIu32 " blocks total, %" B_PRIu32 " dirty, %" B_PRIu32
 		" discarded, %" B_PRIu32 " referenced, %" B_PRIu32 " busy, %" B_PRIu32
 		" in unused.\n",
 		count, dirty, discarded, referenced, cache->busy_reading_count,
-		cache->unused_block_count);
+		cache->UnusedBlockCount());
 	return 0;
 }
 
@@ -2543,12 +2991,17 @@ block_notifier_and_writer(void* /*data*/)
 			if (cache->num_dirty_blocks) {
 				// This cache is not using transactions, we'll scan the blocks
 				// directly
-				BlockTable::Iterator iterator(cache->hash);
-
-				while (iterator.HasNext()) {
-					cached_block* block = iterator.Next();
-					if (block->CanBeWritten() && !writer.Add(block))
-						break;
+				bool full = false;
+				for (uint32 i = 0; i < kBlockShards && !full; i++) {
+					BlockTable::Iterator iterator(cache->shards[i].hash);
+
+					while (iterator.HasNext()) {
+						cached_block* block = iterator.Next();
+						if (block->CanBeWritten() && !writer.Add(block)) {
+							full = true;
+							break;
+						}
+					}
 				}
 
 			} else {
@@ -3066,11 +3519,11 @@ cache_abort_sub_transaction(void* _cache, int32 id)
 				block->original_data = NULL;
 				block->is_dirty = false;
 
+				block_shard& shard = cache->ShardFor(block->block_number);
+				MutexLocker shardLocker(shard.lock);
 				if (block->ref_count == 0) {
 					// Move the block into the unused list if possible
-					block->unused = true;
-					cache->unused_blocks.Add(block);
-					cache->unused_block_count++;
+					cache->AddUnusedBlock(shard, block);
 				}
 			}
 		} else {
@@ -3324,11 +3777,13 @@ block_cache_delete(void* _cache, bool allowWrites)
 
 	// free all blocks
 
-	cached_block* block = cache->hash->Clear(true);
-	while (block != NULL) {
-		cached_block* next = block->next;
-		cache->FreeBlock(block);
-		block = next;
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		cached_block* block = cache->shards[i].hash->Clear(true);
+		while (block != NULL) {
+			cached_block* next = block->next;
+			cache->FreeBlock(block);
+			block = next;
+		}
 	}
 
 	// free all transactions (they will all be aborted)
@@ -3375,12 +3830,15 @@ block_cache_sync(void* _cache)
 	MutexLocker locker(&cache->lock);
 
 	BlockWriter writer(cache);
-	BlockTable::Iterator iterator(cache->hash);
 
-	while (iterator.HasNext()) {
-		cached_block* block = iterator.Next();
-		if (block->CanBeWritten())
-			writer.Add(block);
+	for (uint32 i = 0; i < kBlockShards; i++) {
+		BlockTable::Iterator iterator(cache->shards[i].hash);
+
+		while (iterator.HasNext()) {
+			cached_block* block = iterator.Next();
+			if (block->CanBeWritten())
+				writer.Add(block);
+		}
 	}
 
 	status_t status = writer.Write();
@@ -3413,7 +3871,7 @@ block_cache_sync_etc(void* _cache, off_t blockNumber, size_t numBlocks)
 	BlockWriter writer(cache);
 
 	for (; numBlocks > 0; numBlocks--, blockNumber++) {
-		cached_block* block = cache->hash->Lookup(blockNumber);
+		cached_block* block = cache->LookupBlock(blockNumber);
 		if (block == NULL)
 			continue;
 
@@ -3447,7 +3905,7 @@ block_cache_discard(void* _cache, off_t blockNumber, size_t numBlocks)
 	BlockWriter writer(cache);
 
 	for (size_t i = 0; i < numBlocks; i++, blockNumber++) {
-		cached_block* block = cache->hash->Lookup(blockNumber);
+		cached_block* block = cache->LookupBlock(blockNumber);
 		if (block != NULL && block->previous_transaction != NULL)
 			writer.Add(block);
 	}
@@ -3459,15 +3917,19 @@ block_cache_discard(void* _cache, off_t blockNumber, size_t numBlocks)
 		// reset blockNumber to its original value
 
 	for (size_t i = 0; i < numBlocks; i++, blockNumber++) {
-		cached_block* block = cache->hash->Lookup(blockNumber);
+		cached_block* block = cache->LookupBlock(blockNumber);
 		if (block == NULL)
 			continue;
 
 		ASSERT(block->previous_transaction == NULL);
 
-		if (block->unused) {
-			cache->unused_blocks.Remove(block);
-			cache->unused_block_count--;
+		block_shard& shard = cache->ShardFor(blockNumber);
+		MutexLocker shardLocker(shard.lock);
+
+		if (block->unused && block->ref_count == 0) {
+			cache->RemoveUnusedBlock(shard, block);
+			shardLocker.Unlock();
+
 			cache->RemoveBlock(block);
 		} else {
 			if (block->transaction != NULL && block->parent_data != NULL
@@ -3551,6 +4013,13 @@ const void*
 block_cache_get_etc(void* _cache, off_t blockNumber, off_t base, off_t length)
 {
 	block_cache* cache = (block_cache*)_cache;
+
+#if BLOCK_CACHE_FAST_PATH
+	cached_block* cachedBlock = get_cached_block_fast(cache, blockNumber);
+	if (cachedBlock != NULL)
+		return cachedBlock->current_data;
+#endif
+
 	MutexLocker locker(&cache->lock);
 	bool allocated;
 
@@ -3591,7 +4060,7 @@ block_cache_set_dirty(void* _cache, off_t blockNumber, bool dirty,
 	block_cache* cache = (block_cache*)_cache;
 	MutexLocker locker(&cache->lock);
 
-	cached_block* block = cache->hash->Lookup(blockNumber);
+	cached_block* block = cache->LookupBlock(blockNumber);
 	if (block == NULL)
 		return B_BAD_VALUE;
 	if (block->is_dirty == dirty) {
@@ -3611,6 +4080,12 @@ void
 block_cache_put(void* _cache, off_t blockNumber)
 {
 	block_cache* cache = (block_cache*)_cache;
+
+#if BLOCK_CACHE_FAST_PATH
+	if (put_cached_block_fast(cache, blockNumber))
+		return;
+#endif
+
 	MutexLocker locker(&cache->lock);
 
 	put_cached_block(cache, blockNumber);
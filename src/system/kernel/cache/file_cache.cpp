@@ -6,6 +6,7 @@
 
 #include "vnode_store.h"
 
+#include <limits.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,6 +20,7 @@
 #include <low_resource_manager.h>
 #include <thread.h>
 #include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
 #include <util/kernel_cpp.h>
 #include <vfs.h>
 #include <vm/vm.h>
@@ -42,6 +44,17 @@
 #define BYPASS_IO_SIZE		65536
 #define LAST_ACCESSES		3
 
+// maximum number of pages that may be prefetched for a single file at a time
+#define MAX_PREFETCH_PAGES_IN_FLIGHT	1024	// 4 MB
+// maximum number of prefetch requests waiting to be processed
+#define MAX_QUEUED_PREFETCHES			256
+
+// read-ahead window sizes
+#define MIN_READ_AHEAD_WINDOW			(16 * B_PAGE_SIZE)	// 64 kB
+#define DEFAULT_MAX_READ_AHEAD_WINDOW	(256 * B_PAGE_SIZE)	// 1 MB
+#define MAX_STRIDED_READ_AHEAD			8
+	// maximum number of records to read ahead in a strided stream
+
 struct file_cache_ref {
 	VMCache			*cache;
 	struct vnode	*vnode;
@@ -52,6 +65,17 @@ struct file_cache_ref {
 	int32			last_access_index;
 	uint16			disabled_count;
 
+	// read-ahead state, only changed with the cache locked
+	off_t			read_ahead_next;
+		// where the next read of a sequential stream is expected
+	off_t			read_ahead_previous;
+		// offset of the previous read
+	off_t			read_ahead_stride;
+		// distance between the last two reads
+	off_t			read_ahead_end;
+		// end of what has been read ahead already
+	uint32			read_ahead_window;
+
 	inline void SetLastAccess(int32 index, off_t access, bool isWrite)
 	{
 		// we remember writes as negative offsets
@@ -72,7 +96,7 @@ struct file_cache_ref {
 class PrecacheIO : public AsyncIOCallback {
 public:
 								PrecacheIO(file_cache_ref* ref, off_t offset,
-									generic_size_t size);
+									generic_size_t size, bool prefetch);
 								~PrecacheIO();
 
 			status_t			Prepare(vm_page_reservation* reservation);
@@ -92,17 +116,37 @@ private:
 			off_t				fOffset;
 			uint32				fVecCount;
 			generic_size_t		fSize;
+			bool				fPrefetch;
 #if DEBUG_PAGE_ACCESS
 			thread_id			fAllocatingThread;
 #endif
 };
 
+struct read_ahead_request {
+	off_t			offsets[MAX_STRIDED_READ_AHEAD];
+	off_t			ends[MAX_STRIDED_READ_AHEAD];
+	uint32			count;
+};
+
+struct prefetch_request : DoublyLinkedListLinkImpl<prefetch_request> {
+	dev_t			device;
+	ino_t			node;
+	off_t			offset;
+	off_t			end;
+};
+
+typedef DoublyLinkedList<prefetch_request> PrefetchQueue;
+
 typedef status_t (*cache_func)(file_cache_ref* ref, void* cookie, off_t offset,
 	int32 pageOffset, addr_t buffer, size_t bufferSize, bool useBuffer,
 	vm_page_reservation* reservation, size_t reservePages);
 
 static void add_to_iovec(generic_io_vec* vecs, uint32 &index, uint32 max,
 	generic_addr_t address, generic_size_t size);
+static size_t read_pages_async(file_cache_ref* ref, off_t offset, off_t end,
+	bool prefetch);
+static void update_read_ahead(file_cache_ref* ref, off_t offset, size_t size,
+	read_ahead_request& request);
 
 
 static struct cache_module_info* sCacheModule;
@@ -113,11 +157,22 @@ static const size_t kZeroVecSize = kZeroVecCount * B_PAGE_SIZE;
 static phys_addr_t sZeroPage;	// physical address
 static generic_io_vec sZeroVecs[kZeroVecCount];
 
+static PrefetchQueue sPrefetchQueue;
+static uint32 sPrefetchQueueLength;
+static mutex sPrefetchLock = MUTEX_INITIALIZER("file cache prefetch");
+static sem_id sPrefetchSemaphore = -1;
+	// released whenever there are new requests, or prefetch I/O finished
+
+static uint32 sMaxReadAheadWindow = DEFAULT_MAX_READ_AHEAD_WINDOW;
+static file_cache_read_ahead_stats sReadAheadStats;
+static int64 sReadMissPages;
+
 
 //	#pragma mark -
 
 
-PrecacheIO::PrecacheIO(file_cache_ref* ref, off_t offset, generic_size_t size)
+PrecacheIO::PrecacheIO(file_cache_ref* ref, off_t offset, generic_size_t size,
+	bool prefetch)
 	:
 	fRef(ref),
 	fCache(ref->cache),
@@ -125,10 +180,16 @@ PrecacheIO::PrecacheIO(file_cache_ref* ref, off_t offset, generic_size_t size)
 	fVecs(NULL),
 	fOffset(offset),
 	fVecCount(0),
-	fSize(size)
+	fSize(size),
+	fPrefetch(prefetch)
 {
 	fPageCount = (size + B_PAGE_SIZE - 1) / B_PAGE_SIZE;
 	fCache->AcquireRefLocked();
+
+	// Only cache_prefetch() I/O is limited by the prefetch window of the
+	// file, read-ahead is limited by its own window.
+	if (fPrefetch)
+		((VMVnodeCache*)fCache)->AddPrefetchPages(fPageCount);
 }
 
 
@@ -136,6 +197,13 @@ PrecacheIO::~PrecacheIO()
 {
 	delete[] fPages;
 	delete[] fVecs;
+
+	if (fPrefetch) {
+		// the prefetch window of this file has room again
+		((VMVnodeCache*)fCache)->AddPrefetchPages(-(int32)fPageCount);
+		release_sem_etc(sPrefetchSemaphore, 1, B_DO_NOT_RESCHEDULE);
+	}
+
 	fCache->ReleaseRefLocked();
 }
 
@@ -407,6 +475,8 @@ read_into_cache(file_cache_ref* ref, void* cookie, off_t offset,
 	cache->Unlock();
 	vm_page_unreserve_pages(reservation);
 
+	atomic_add64(&sReadMissPages, pageIndex);
+
 	// read file into reserved pages
 	status_t status = read_pages_and_clear_partial(ref, cookie, offset, vecs,
 		vecCount, B_PHYSICAL_IO_REQUEST, &numBytes);
@@ -475,6 +545,9 @@ read_from_file(file_cache_ref* ref, void* cookie, off_t offset,
 	ref->cache->Unlock();
 	vm_page_unreserve_pages(reservation);
 
+	atomic_add64(&sReadMissPages,
+		PAGE_ALIGN(pageOffset + bufferSize) / B_PAGE_SIZE);
+
 	generic_size_t toRead = bufferSize;
 	status_t status = vfs_read_pages(ref->vnode, cookie, offset + pageOffset,
 		&vec, 1, 0, &toRead);
@@ -701,7 +774,7 @@ satisfy_cache_io(file_cache_ref* ref, void* cookie, cache_func function,
 
 static status_t
 cache_io(void* _cacheRef, void* cookie, off_t offset, addr_t buffer,
-	size_t* _size, bool doWrite)
+	size_t* _size, bool doWrite, read_ahead_request* readAhead = NULL)
 {
 	if (_cacheRef == NULL)
 		panic("cache_io() called with NULL ref!\n");
@@ -752,6 +825,9 @@ cache_io(void* _cacheRef, void* cookie, off_t offset, addr_t buffer,
 
 	AutoLocker<VMCache> locker(cache);
 
+	if (readAhead != NULL)
+		update_read_ahead(ref, offset + pageOffset, size, *readAhead);
+
 	while (bytesLeft > 0) {
 		// Periodically reevaluate the low memory situation and select the
 		// read/write hook accordingly
@@ -886,6 +962,119 @@ cache_io(void* _cacheRef, void* cookie, off_t offset, addr_t buffer,
 }
 
 
+/*!	Updates the read-ahead state of the file with a read of \a size bytes at
+	\a offset, and fills \a request with the ranges that should be read ahead
+	if the file is accessed sequentially or with a constant stride.
+	The window grows exponentially up to sMaxReadAheadWindow as long as the
+	pattern holds, and shrinks again on random access. A limit of 0 turns
+	read-ahead off.
+	The cache must be locked.
+*/
+static void
+update_read_ahead(file_cache_ref* ref, off_t offset, size_t size,
+	read_ahead_request& request)
+{
+	request.count = 0;
+
+	uint32 maxWindow = sMaxReadAheadWindow;
+	if (maxWindow == 0 || size == 0)
+		return;
+	maxWindow = max_c(maxWindow, (uint32)MIN_READ_AHEAD_WINDOW);
+
+	off_t end = offset + size;
+	off_t fileSize = ref->cache->virtual_end;
+	off_t stride = offset - ref->read_ahead_previous;
+
+	if (offset == ref->read_ahead_next) {
+		// sequential access
+		atomic_add64((int64*)&sReadAheadStats.sequential_reads, 1);
+
+		if (ref->read_ahead_window == 0) {
+			ref->read_ahead_window = max_c((uint32)MIN_READ_AHEAD_WINDOW,
+				(uint32)PAGE_ALIGN(2 * size));
+		} else if (ref->read_ahead_window < maxWindow)
+			ref->read_ahead_window *= 2;
+		ref->read_ahead_window = min_c(ref->read_ahead_window, maxWindow);
+
+		if (ref->read_ahead_end < end)
+			ref->read_ahead_end = PAGE_ALIGN(end);
+
+		// Read the next window once the reader has consumed half of what we
+		// have read ahead so far, so that the I/O overlaps with the reads
+		if (ref->read_ahead_end - end <= (off_t)ref->read_ahead_window / 2
+			&& ref->read_ahead_end < fileSize) {
+			request.offsets[0] = ref->read_ahead_end;
+			request.ends[0] = min_c(PAGE_ALIGN(end + ref->read_ahead_window),
+				PAGE_ALIGN(fileSize));
+			ref->read_ahead_end = request.ends[0];
+			request.count = 1;
+		}
+	} else if (stride > (off_t)size && stride == ref->read_ahead_stride) {
+		// strided access, read ahead the next records
+		atomic_add64((int64*)&sReadAheadStats.strided_reads, 1);
+
+		if (ref->read_ahead_window == 0)
+			ref->read_ahead_window = MIN_READ_AHEAD_WINDOW;
+		else if (ref->read_ahead_window < maxWindow)
+			ref->read_ahead_window *= 2;
+		ref->read_ahead_window = min_c(ref->read_ahead_window, maxWindow);
+
+		uint32 records = max_c(1, min_c(
+			ref->read_ahead_window / PAGE_ALIGN(size),
+			(uint32)MAX_STRIDED_READ_AHEAD));
+		off_t lastRecord = offset + records * stride;
+
+		// skip the records that have been read ahead before
+		off_t recordOffset = offset + stride;
+		if (ref->read_ahead_end > recordOffset) {
+			recordOffset += (ref->read_ahead_end - recordOffset + stride - 1)
+				/ stride * stride;
+		}
+
+		for (; recordOffset <= lastRecord && recordOffset < fileSize;
+				recordOffset += stride) {
+			request.offsets[request.count]
+				= ROUNDDOWN(recordOffset, B_PAGE_SIZE);
+			request.ends[request.count] = min_c(
+				PAGE_ALIGN(recordOffset + size), PAGE_ALIGN(fileSize));
+			ref->read_ahead_end = recordOffset + size;
+			request.count++;
+		}
+	} else {
+		// random access, shrink the window
+		atomic_add64((int64*)&sReadAheadStats.random_reads, 1);
+
+		ref->read_ahead_window /= 4;
+		if (ref->read_ahead_window < MIN_READ_AHEAD_WINDOW)
+			ref->read_ahead_window = 0;
+		ref->read_ahead_end = end;
+	}
+
+	ref->read_ahead_stride = stride;
+	ref->read_ahead_previous = offset;
+	ref->read_ahead_next = end;
+}
+
+
+/*!	Starts reading the ranges in \a request asynchronously, unless resources
+	are low.
+*/
+static void
+read_ahead(file_cache_ref* ref, const read_ahead_request& request)
+{
+	if (request.count == 0
+		|| low_resource_state(B_KERNEL_RESOURCE_PAGES) != B_NO_LOW_RESOURCE)
+		return;
+
+	size_t pages = 0;
+	for (uint32 i = 0; i < request.count; i++)
+		pages += read_pages_async(ref, request.offsets[i], request.ends[i],
+			false);
+
+	atomic_add64((int64*)&sReadAheadStats.read_ahead_pages, pages);
+}
+
+
 static status_t
 file_cache_control(const char* subsystem, uint32 function, void* buffer,
 	size_t bufferSize)
@@ -930,50 +1119,123 @@ file_cache_control(const char* subsystem, uint32 function, void* buffer,
 
 			return status;
 		}
+
+		case CACHE_GET_READ_AHEAD_STATS:
+		{
+			if (bufferSize != sizeof(file_cache_read_ahead_stats))
+				return B_BAD_VALUE;
+
+			file_cache_read_ahead_stats stats = sReadAheadStats;
+			stats.hit_pages = stats.read_pages - min_c(stats.read_pages,
+				(uint64)sReadMissPages);
+			stats.max_window = sMaxReadAheadWindow;
+
+			if (!IS_USER_ADDRESS(buffer)
+				|| user_memcpy(buffer, &stats, sizeof(stats)) != B_OK)
+				return B_BAD_ADDRESS;
+
+			return B_OK;
+		}
+
+		case CACHE_SET_READ_AHEAD_LIMIT:
+		{
+			if (geteuid() != 0)
+				return B_NOT_ALLOWED;
+
+			uint32 window;
+			if (bufferSize != sizeof(uint32) || !IS_USER_ADDRESS(buffer)
+				|| user_memcpy(&window, buffer, sizeof(uint32)) != B_OK)
+				return B_BAD_ADDRESS;
+
+			sMaxReadAheadWindow = PAGE_ALIGN(window);
+			dprintf("cache_control: read-ahead window limit %" B_PRIu32 "\n",
+				sMaxReadAheadWindow);
+			return B_OK;
+		}
 	}
 
 	return B_BAD_HANDLER;
 }
 
 
-//	#pragma mark - private kernel API
-
-
-extern "C" void
-cache_prefetch_vnode(struct vnode* vnode, off_t offset, size_t size)
+/*!	Starts asynchronous reads for all pages of the given range that are not
+	yet in the cache, as far as the prefetch window of the file allows.
+	Returns the number of bytes from the start of the range that have been
+	taken care of; the rest has to be prefetched later.
+*/
+static off_t
+prefetch_vnode_range(struct vnode* vnode, off_t offset, off_t end)
 {
-	if (size == 0)
-		return;
+	off_t start = offset;
+	off_t requestEnd = end;
 
 	VMCache* cache;
 	if (vfs_get_vnode_cache(vnode, &cache, false) != B_OK)
-		return;
+		return requestEnd - start;
 
 	file_cache_ref* ref = ((VMVnodeCache*)cache)->FileCacheRef();
 	off_t fileSize = cache->virtual_end;
 
-	if ((off_t)(offset + size) > fileSize)
-		size = fileSize - offset;
+	if (end > fileSize)
+		end = fileSize;
 
-	// "offset" and "size" are always aligned to B_PAGE_SIZE,
+	// "offset" and "end" are always aligned to B_PAGE_SIZE
 	offset = ROUNDDOWN(offset, B_PAGE_SIZE);
-	size = ROUNDUP(size, B_PAGE_SIZE);
-
-	size_t reservePages = size / B_PAGE_SIZE;
+	end = ROUNDUP(end, B_PAGE_SIZE);
 
 	// Don't do anything if we don't have the resources left, or the cache
 	// already contains more than 2/3 of its pages
-	if (offset >= fileSize || vm_page_num_unused_pages() < 2 * reservePages
-		|| 3 * cache->page_count > 2 * fileSize / B_PAGE_SIZE) {
+	if (ref == NULL || offset >= end || 3 * cache->page_count
+			> 2 * fileSize / B_PAGE_SIZE) {
 		cache->ReleaseRef();
-		return;
+		return requestEnd - start;
+	}
+
+	// Only read as much as still fits into the window of this file
+	int32 windowPages = MAX_PREFETCH_PAGES_IN_FLIGHT
+		- ((VMVnodeCache*)cache)->PrefetchPages();
+	if (windowPages <= 0) {
+		cache->ReleaseRef();
+		return 0;
+	}
+	if ((end - offset) / B_PAGE_SIZE > windowPages) {
+		end = offset + (off_t)windowPages * B_PAGE_SIZE;
+		requestEnd = end;
 	}
 
+	read_pages_async(ref, offset, end, true);
+	cache->ReleaseRef();
+
+	return requestEnd - start;
+}
+
+
+/*!	Starts asynchronous reads for all pages of the given range that are not
+	in the cache yet. Nothing is done if the pages cannot be reserved without
+	waiting.
+	The cache must not be locked, and the caller must have a reference to it.
+	If \a prefetch is \c true, the pages are counted against the prefetch
+	window of the file until their I/O has finished.
+	Returns the number of pages read.
+*/
+static size_t
+read_pages_async(file_cache_ref* ref, off_t offset, off_t end, bool prefetch)
+{
+	VMCache* cache = ref->cache;
+	size_t size = end - offset;
+	size_t reservePages = size / B_PAGE_SIZE;
+	size_t pagesRead = 0;
+
+	if (size == 0 || vm_page_num_unused_pages() < 2 * (off_t)reservePages)
+		return 0;
+
 	size_t bytesToRead = 0;
 	off_t lastOffset = offset;
 
 	vm_page_reservation reservation;
-	vm_page_reserve_pages(&reservation, reservePages, VM_PRIORITY_USER);
+	if (!vm_page_try_reserve_pages(&reservation, reservePages,
+			VM_PRIORITY_USER))
+		return 0;
 
 	cache->Lock();
 
@@ -993,7 +1255,7 @@ cache_prefetch_vnode(struct vnode* vnode, off_t offset, size_t size)
 		if (bytesToRead != 0) {
 			// read the part before the current page (or the end of the request)
 			PrecacheIO* io = new(std::nothrow) PrecacheIO(ref, lastOffset,
-				bytesToRead);
+				bytesToRead, prefetch);
 			if (io == NULL || io->Prepare(&reservation) != B_OK) {
 				delete io;
 				break;
@@ -1004,6 +1266,7 @@ cache_prefetch_vnode(struct vnode* vnode, off_t offset, size_t size)
 			io->ReadAsync();
 			cache->Lock();
 
+			pagesRead += bytesToRead / B_PAGE_SIZE;
 			bytesToRead = 0;
 		}
 
@@ -1015,25 +1278,133 @@ cache_prefetch_vnode(struct vnode* vnode, off_t offset, size_t size)
 		lastOffset = offset;
 	}
 
-	cache->ReleaseRefAndUnlock();
+	cache->Unlock();
 	vm_page_unreserve_pages(&reservation);
+
+	return pagesRead;
 }
 
 
+/*!	Queues a prefetch request for the given range of the file. If there is
+	already a request for that file pending that overlaps or touches the range,
+	it is extended instead.
+	The prefetch lock must be held.
+*/
+static void
+queue_prefetch_request(prefetch_request* request)
+{
+	PrefetchQueue::Iterator iterator = sPrefetchQueue.GetIterator();
+	while (prefetch_request* other = iterator.Next()) {
+		if (other->device != request->device || other->node != request->node
+			|| request->offset > other->end || request->end < other->offset)
+			continue;
+
+		other->offset = min_c(other->offset, request->offset);
+		other->end = max_c(other->end, request->end);
+		delete request;
+		return;
+	}
+
+	sPrefetchQueue.Add(request);
+	sPrefetchQueueLength++;
+}
+
+
+static status_t
+prefetch_thread(void* /*data*/)
+{
+	while (true) {
+		acquire_sem(sPrefetchSemaphore);
+
+		// Process each request that is queued right now once; the ones that
+		// could not be completed because their window is full are queued
+		// again, and are retried when more I/O has finished.
+		MutexLocker locker(sPrefetchLock);
+		uint32 count = sPrefetchQueueLength;
+
+		while (count-- > 0) {
+			prefetch_request* request = sPrefetchQueue.RemoveHead();
+			if (request == NULL)
+				break;
+			sPrefetchQueueLength--;
+
+			locker.Unlock();
+
+			TRACE(("prefetch vnode %ld:%Ld, %Ld - %Ld\n", request->device,
+				request->node, request->offset, request->end));
+
+			// get the vnode for the object, this also grabs a ref to it
+			struct vnode* vnode;
+			off_t done = request->end - request->offset;
+			if (vfs_get_vnode(request->device, request->node, true, &vnode)
+					== B_OK) {
+				done = prefetch_vnode_range(vnode, request->offset,
+					request->end);
+				vfs_put_vnode(vnode);
+			}
+
+			locker.Lock();
+
+			if (request->offset + done < request->end) {
+				request->offset += done;
+				queue_prefetch_request(request);
+			} else
+				delete request;
+		}
+	}
+
+	return B_OK;
+}
+
+
+//	#pragma mark - private kernel API
+
+
+/*!	Schedules the given range of the file to be read into the file cache.
+	The request is only queued; the pages are read in asynchronously by the
+	prefetcher thread, and this function returns immediately.
+*/
 extern "C" void
 cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size)
 {
-	// ToDo: schedule prefetch
-
 	TRACE(("cache_prefetch(vnode %ld:%Ld)\n", mountID, vnodeID));
 
-	// get the vnode for the object, this also grabs a ref to it
-	struct vnode* vnode;
-	if (vfs_get_vnode(mountID, vnodeID, true, &vnode) != B_OK)
+	if (size == 0 || offset < 0 || sPrefetchSemaphore < 0)
 		return;
 
-	cache_prefetch_vnode(vnode, offset, size);
-	vfs_put_vnode(vnode);
+	prefetch_request* request = new(std::nothrow) prefetch_request;
+	if (request == NULL)
+		return;
+
+	request->device = mountID;
+	request->node = vnodeID;
+	request->offset = offset;
+	request->end = size > (size_t)(LLONG_MAX - offset)
+		? LLONG_MAX : offset + (off_t)size;
+
+	MutexLocker locker(sPrefetchLock);
+
+	if (sPrefetchQueueLength >= MAX_QUEUED_PREFETCHES) {
+		// prefetching is only a hint, just drop the request
+		delete request;
+		return;
+	}
+
+	queue_prefetch_request(request);
+	locker.Unlock();
+
+	release_sem_etc(sPrefetchSemaphore, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+extern "C" void
+cache_prefetch_vnode(struct vnode* vnode, off_t offset, size_t size)
+{
+	dev_t mountID;
+	ino_t vnodeID;
+	vfs_vnode_to_node_ref(vnode, &mountID, &vnodeID);
+
+	cache_prefetch(mountID, vnodeID, offset, size);
 }
 
 
@@ -1113,6 +1484,19 @@ file_cache_init(void)
 	}
 
 	register_generic_syscall(CACHE_SYSCALLS, file_cache_control, 1, 0);
+
+	new(&sPrefetchQueue) PrefetchQueue;
+		// manually call constructor
+
+	sPrefetchSemaphore = create_sem(0, "file cache prefetch");
+	if (sPrefetchSemaphore < B_OK)
+		return sPrefetchSemaphore;
+
+	thread_id thread = spawn_kernel_thread(&prefetch_thread,
+		"file cache prefetcher", B_LOW_PRIORITY, NULL);
+	if (thread >= B_OK)
+		resume_thread(thread);
+
 	return B_OK;
 }
 
@@ -1134,6 +1518,12 @@ file_cache_create(dev_t mountID, ino_t vnodeID, off_t size)
 	ref->last_access_index = 0;
 	ref->disabled_count = 0;
 
+	ref->read_ahead_next = 0;
+	ref->read_ahead_previous = 0;
+	ref->read_ahead_stride = 0;
+	ref->read_ahead_end = 0;
+	ref->read_ahead_window = 0;
+
 	// TODO: delay VMCache creation until data is
 	//	requested/written for the first time? Listing lots of
 	//	files in Tracker (and elsewhere) could be slowed down.
@@ -1299,7 +1689,21 @@ file_cache_read(void* _cacheRef, void* cookie, off_t offset, void* buffer,
 		return error;
 	}
 
-	return cache_io(ref, cookie, offset, (addr_t)buffer, _size, false);
+	read_ahead_request readAhead;
+	readAhead.count = 0;
+
+	status_t status = cache_io(ref, cookie, offset, (addr_t)buffer, _size,
+		false, &readAhead);
+	if (status == B_OK && *_size > 0) {
+		// Only misses are counted by the read functions, all other pages
+		// were hits
+		atomic_add64((int64*)&sReadAheadStats.read_pages,
+			PAGE_ALIGN((offset & (B_PAGE_SIZE - 1)) + *_size) / B_PAGE_SIZE);
+
+		read_ahead(ref, readAhead);
+	}
+
+	return status;
 }
 
 
@@ -27,6 +27,7 @@ VMVnodeCache::Init(struct vnode* vnode, uint32 allocationFlags)
 	fVnode = vnode;
 	fFileCacheRef = NULL;
 	fVnodeDeleted = false;
+	fPrefetchPages = 0;
 
 	vfs_vnode_to_node_ref(fVnode, &fDevice, &fInode);
 
@@ -48,6 +48,11 @@ public:
 
 			void				VnodeDeleted()	{ fVnodeDeleted = true; }
 
+			int32				PrefetchPages() const
+									{ return fPrefetchPages; }
+			void				AddPrefetchPages(int32 count)
+									{ atomic_add(&fPrefetchPages, count); }
+
 			dev_t				DeviceId() const
 									{ return fDevice; }
 			ino_t				InodeId() const
@@ -62,6 +67,8 @@ private:
 			ino_t				fInode;
 			dev_t				fDevice;
 	volatile bool				fVnodeDeleted;
+			int32				fPrefetchPages;
+									// pages currently being prefetched
 };
 
 
@@ -764,6 +764,10 @@ IORequest::Init(off_t offset, generic_size_t firstVecOffset,
 	Thread* thread = thread_get_current_thread();
 	fTeam = thread->team->id;
 	fThread = thread->id;
+	// the I/O classes may be changed concurrently by _user_set_io_class()
+	fIOClass = atomic_get(&thread->io_class);
+	if (fIOClass < 0)
+		fIOClass = atomic_get(&thread->team->io_class);
 	fIsWrite = write;
 	fPartialTransfer = false;
 	fSuppressChildNotifications = false;
@@ -829,6 +833,7 @@ IORequest::CreateSubRequest(off_t parentOffset, off_t offset,
 	subRequest->fRelativeParentOffset = parentOffset - fOffset;
 	subRequest->fTeam = fTeam;
 	subRequest->fThread = fThread;
+	subRequest->fIOClass = fIOClass;
 
 	_subRequest = subRequest;
 	subRequest->SetParent(this);
@@ -1075,6 +1080,22 @@ IORequest::SetUnfinished()
 }
 
 
+/*!	Fails the request with \a status, unless it already has a status. The
+	operations that are still pending finish normally, but nothing beyond
+	what has been transferred so far is reported.
+*/
+void
+IORequest::Abort(status_t status)
+{
+	MutexLocker _(fLock);
+	if (fStatus != 1)
+		return;
+
+	fStatus = status;
+	fPartialTransfer = true;
+}
+
+
 void
 IORequest::SetTransferredBytes(bool partialTransfer,
 	generic_size_t transferredBytes)
@@ -1408,6 +1429,7 @@ IORequest::Dump() const
 	kprintf("  flags:             %#" B_PRIx32 "\n", fFlags);
 	kprintf("  team:              %" B_PRId32 "\n", fTeam);
 	kprintf("  thread:            %" B_PRId32 "\n", fThread);
+	kprintf("  I/O class:         %" B_PRId32 "\n", fIOClass);
 	kprintf("  r/w:               %s\n", fIsWrite ? "write" : "read");
 	kprintf("  partial transfer:  %s\n", fPartialTransfer ? "yes" : "no");
 	kprintf("  finished cvar:     %p\n", &fFinishedCondition);
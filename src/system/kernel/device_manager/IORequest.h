@@ -261,6 +261,7 @@ struct IORequest : IORequestChunk, DoublyLinkedListLinkImpl<IORequest> {
 									status_t status, bool partialTransfer,
 									generic_size_t transferEndOffset);
 			void				SetUnfinished();
+			void				Abort(status_t status);
 
 			generic_size_t		RemainingBytes() const
 									{ return fRemainingBytes; }
@@ -279,6 +280,9 @@ struct IORequest : IORequestChunk, DoublyLinkedListLinkImpl<IORequest> {
 			bool				IsRead() const	{ return !fIsWrite; }
 			team_id				TeamID() const		{ return fTeam; }
 			thread_id			ThreadID() const	{ return fThread; }
+			int32				IOClass() const		{ return fIOClass; }
+			void				SetIOClass(int32 ioClass)
+									{ fIOClass = ioClass; }
 			uint32				Flags() const	{ return fFlags; }
 
 			IOBuffer*			Buffer() const	{ return fBuffer; }
@@ -343,6 +347,7 @@ private:
 			uint32				fFlags;
 			team_id				fTeam;
 			thread_id			fThread;
+			int32				fIOClass;
 			bool				fIsWrite;
 			bool				fPartialTransfer;
 			bool				fSuppressChildNotifications;
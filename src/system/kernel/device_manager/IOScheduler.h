@@ -18,6 +18,7 @@ struct IORequestOwner : DoublyLinkedListLinkImpl<IORequestOwner> {
 	team_id			team;
 	thread_id		thread;
 	int32			priority;
+	int32			io_class;
 	IORequestList	requests;
 	IORequestList	completed_requests;
 	IOOperationList	operations;
@@ -0,0 +1,497 @@
+/*
+ * Copyright 2008-2011, Ingo Weinhold, ingo_weinhold@gmx.de.
+ * Copyright 2004-2010, Axel Dörfler, axeld@pinc-software.de.
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "IOSchedulerBase.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <thread.h>
+#include <util/AutoLock.h>
+
+#include "IOSchedulerRoster.h"
+
+
+//#define TRACE_IO_SCHEDULER
+#ifdef TRACE_IO_SCHEDULER
+#	define TRACE(x...) dprintf(x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+IOSchedulerBase::IOSchedulerBase(DMAResource* resource, const char* lockName)
+	:
+	IOScheduler(resource),
+	fSchedulerThread(-1),
+	fRequestNotifierThread(-1),
+	fOperationCount(0),
+	fBlockSize(0),
+	fPendingOperations(0),
+	fTerminating(false)
+{
+	mutex_init(&fLock, lockName);
+	B_INITIALIZE_SPINLOCK(&fFinisherLock);
+
+	fNewRequestCondition.Init(this, "I/O new request");
+	fFinishedOperationCondition.Init(this, "I/O finished operation");
+	fFinishedRequestCondition.Init(this, "I/O finished request");
+}
+
+
+IOSchedulerBase::~IOSchedulerBase()
+{
+	_StopThreads();
+
+	// destroy our belongings
+	mutex_lock(&fLock);
+	mutex_destroy(&fLock);
+
+	while (IOOperation* operation = fUnusedOperations.RemoveHead())
+		delete operation;
+}
+
+
+status_t
+IOSchedulerBase::Init(const char* name)
+{
+	status_t error = IOScheduler::Init(name);
+	if (error != B_OK)
+		return error;
+
+	fOperationCount = fDMAResource != NULL ? fDMAResource->BufferCount() : 16;
+	for (size_t i = 0; i < fOperationCount; i++) {
+		IOOperation* operation = new(std::nothrow) IOOperation;
+		if (operation == NULL)
+			return B_NO_MEMORY;
+
+		fUnusedOperations.Add(operation);
+	}
+
+	if (fDMAResource != NULL)
+		fBlockSize = fDMAResource->BlockSize();
+	if (fBlockSize == 0)
+		fBlockSize = 512;
+
+	return B_OK;
+}
+
+
+status_t
+IOSchedulerBase::ScheduleRequest(IORequest* request)
+{
+	TRACE("%p->IOSchedulerBase::ScheduleRequest(%p)\n", this, request);
+
+	IOBuffer* buffer = request->Buffer();
+
+	// TODO: it would be nice to be able to lock the memory later, but we can't
+	// easily do it in the I/O scheduler without being able to asynchronously
+	// lock memory (via another thread or a dedicated call).
+
+	if (buffer->IsVirtual()) {
+		status_t status = buffer->LockMemory(request->TeamID(),
+			request->IsWrite());
+		if (status != B_OK) {
+			request->SetStatusAndNotify(status);
+			return status;
+		}
+	}
+
+	MutexLocker locker(fLock);
+
+	status_t status = _AddRequest(request);
+	if (status != B_OK) {
+		locker.Unlock();
+		if (buffer->IsVirtual())
+			buffer->UnlockMemory(request->TeamID(), request->IsWrite());
+		request->SetStatusAndNotify(status);
+		return status;
+	}
+
+	IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_SCHEDULED, this,
+		request);
+
+	fNewRequestCondition.NotifyAll();
+
+	return B_OK;
+}
+
+
+/*!	Fails \a request with \a status, after its operations could not be
+	prepared. Called with \c fLock held.
+
+	The operations of the request that have been prepared already are still
+	executed, and the last of them to finish finishes the request as usual.
+	If there are none, IORequest::IsFinished() returns \c true afterwards,
+	and the scheduler removes the request from its queues and finishes it
+	itself, once it is done looking at it.
+*/
+void
+IOSchedulerBase::AbortRequest(IORequest* request, status_t status)
+{
+	TRACE("%p->IOSchedulerBase::AbortRequest(%p, %s)\n", this, request,
+		strerror(status));
+
+	request->Abort(status);
+}
+
+
+void
+IOSchedulerBase::OperationCompleted(IOOperation* operation, status_t status,
+	generic_size_t transferredBytes)
+{
+	InterruptsSpinLocker _(fFinisherLock);
+
+	// finish operation only once
+	if (operation->Status() <= 0)
+		return;
+
+	operation->SetStatus(status);
+
+	// set the bytes transferred (of the net data)
+	generic_size_t partialBegin
+		= operation->OriginalOffset() - operation->Offset();
+	operation->SetTransferredBytes(
+		transferredBytes > partialBegin ? transferredBytes - partialBegin : 0);
+
+	fCompletedOperations.Add(operation);
+	fFinishedOperationCondition.NotifyAll();
+}
+
+
+status_t
+IOSchedulerBase::_StartThreads(const char* name)
+{
+	char buffer[B_OS_NAME_LENGTH];
+	strlcpy(buffer, name, sizeof(buffer));
+	strlcat(buffer, " scheduler ", sizeof(buffer));
+	size_t nameLength = strlen(buffer);
+	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
+		fID);
+	fSchedulerThread = spawn_kernel_thread(&_SchedulerThread, buffer,
+		B_NORMAL_PRIORITY + 2, (void *)this);
+	if (fSchedulerThread < B_OK)
+		return fSchedulerThread;
+
+	strlcpy(buffer, name, sizeof(buffer));
+	strlcat(buffer, " notifier ", sizeof(buffer));
+	nameLength = strlen(buffer);
+	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
+		fID);
+	fRequestNotifierThread = spawn_kernel_thread(&_RequestNotifierThread,
+		buffer, B_NORMAL_PRIORITY + 2, (void *)this);
+	if (fRequestNotifierThread < B_OK)
+		return fRequestNotifierThread;
+
+	resume_thread(fSchedulerThread);
+	resume_thread(fRequestNotifierThread);
+
+	return B_OK;
+}
+
+
+/*!	Stops the scheduler and notifier threads. Subclasses must call this in
+	their destructor before they destroy anything the threads might use.
+*/
+void
+IOSchedulerBase::_StopThreads()
+{
+	MutexLocker locker(fLock);
+	InterruptsSpinLocker finisherLocker(fFinisherLock);
+	fTerminating = true;
+
+	fNewRequestCondition.NotifyAll();
+	fFinishedOperationCondition.NotifyAll();
+	fFinishedRequestCondition.NotifyAll();
+
+	finisherLocker.Unlock();
+	locker.Unlock();
+
+	if (fSchedulerThread >= 0) {
+		wait_for_thread(fSchedulerThread, NULL);
+		fSchedulerThread = -1;
+	}
+
+	if (fRequestNotifierThread >= 0) {
+		wait_for_thread(fRequestNotifierThread, NULL);
+		fRequestNotifierThread = -1;
+	}
+}
+
+
+/*!	Must not be called with the fLock held. */
+void
+IOSchedulerBase::_Finisher()
+{
+	while (true) {
+		InterruptsSpinLocker locker(fFinisherLock);
+		IOOperation* operation = fCompletedOperations.RemoveHead();
+		if (operation == NULL)
+			return;
+
+		locker.Unlock();
+
+		TRACE("IOSchedulerBase::_Finisher(): operation: %p\n", operation);
+
+		bool operationFinished = operation->Finish();
+
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_FINISHED,
+			this, operation->Parent(), operation);
+			// Notify for every time the operation is passed to the I/O hook,
+			// not only when it is fully finished.
+
+		if (!operationFinished) {
+			TRACE("  operation: %p not finished yet\n", operation);
+			MutexLocker _(fLock);
+			operation->SetTransferredBytes(0);
+			_RequeueOperation(operation);
+			fPendingOperations--;
+			continue;
+		}
+
+		// notify request and remove operation
+		IORequest* request = operation->Parent();
+
+		generic_size_t operationOffset
+			= operation->OriginalOffset() - request->Offset();
+		request->OperationFinished(operation, operation->Status(),
+			operation->TransferredBytes() < operation->OriginalLength(),
+			operation->Status() == B_OK
+				? operationOffset + operation->OriginalLength()
+				: operationOffset);
+
+		// recycle the operation
+		MutexLocker _(fLock);
+		if (fDMAResource != NULL)
+			fDMAResource->RecycleBuffer(operation->Buffer());
+
+		fPendingOperations--;
+		fUnusedOperations.Add(operation);
+
+		// If the request is done, we need to perform its notifications.
+		if (request->IsFinished()) {
+			if (request->Status() == B_OK && request->RemainingBytes() > 0) {
+				// The request has been processed OK so far, but it isn't really
+				// finished yet.
+				request->SetUnfinished();
+			} else {
+				_RemoveRequest(request);
+				_NotifyRequestFinished(request);
+			}
+		}
+	}
+}
+
+
+/*!	Called with \c fFinisherLock held.
+*/
+bool
+IOSchedulerBase::_FinisherWorkPending()
+{
+	return !fCompletedOperations.IsEmpty();
+}
+
+
+/*!	Performs the notifications of a finished \a request that has already
+	been removed from the queues. Called with \c fLock held.
+*/
+void
+IOSchedulerBase::_NotifyRequestFinished(IORequest* request)
+{
+	request->SetOwner(NULL);
+
+	if (request->HasCallbacks()) {
+		// The request has callbacks that may take some time to perform, so we
+		// hand it over to the request notifier.
+		fFinishedRequests.Add(request);
+		fFinishedRequestCondition.NotifyAll();
+	} else {
+		// No callbacks -- finish the request right now.
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_FINISHED,
+			this, request);
+		request->NotifyFinished();
+	}
+}
+
+
+/*!	Translates up to \a quantum bytes of \a request into operations, and adds
+	them to \a operations. Called with \c fLock held.
+	Returns \c false when no more operations could be prepared because the
+	resources needed are temporarily unavailable. If the request cannot be
+	prepared at all, it is aborted.
+*/
+bool
+IOSchedulerBase::_PrepareRequestOperations(IORequest* request,
+	IOOperationList& operations, int32& operationsPrepared, off_t quantum,
+	off_t& usedBandwidth)
+{
+//dprintf("IOSchedulerBase::_PrepareRequestOperations(%p)\n", request);
+	usedBandwidth = 0;
+
+	if (fDMAResource != NULL) {
+		while (quantum >= (off_t)fBlockSize && request->RemainingBytes() > 0) {
+			IOOperation* operation = fUnusedOperations.RemoveHead();
+			if (operation == NULL)
+				return false;
+
+			status_t status = fDMAResource->TranslateNext(request, operation,
+				quantum);
+			if (status != B_OK) {
+				operation->SetParent(NULL);
+				fUnusedOperations.Add(operation);
+
+				// B_BUSY means some resource (DMABuffers or
+				// DMABounceBuffers) was temporarily unavailable. That's OK,
+				// we'll retry later.
+				if (status == B_BUSY)
+					return false;
+
+				AbortRequest(request, status);
+				return true;
+			}
+//dprintf("  prepared operation %p\n", operation);
+
+			off_t bandwidth = operation->Length();
+			quantum -= bandwidth;
+			usedBandwidth += bandwidth;
+
+			operations.Add(operation);
+			operationsPrepared++;
+		}
+	} else {
+		// TODO: If the device has block size restrictions, we might need to use
+		// a bounce buffer.
+		IOOperation* operation = fUnusedOperations.RemoveHead();
+		if (operation == NULL)
+			return false;
+
+		status_t status = operation->Prepare(request);
+		if (status != B_OK) {
+			operation->SetParent(NULL);
+			fUnusedOperations.Add(operation);
+			AbortRequest(request, status);
+			return true;
+		}
+
+		operation->SetOriginalRange(request->Offset(), request->Length());
+		request->Advance(request->Length());
+
+		off_t bandwidth = operation->Length();
+		quantum -= bandwidth;
+		usedBandwidth += bandwidth;
+
+		operations.Add(operation);
+		operationsPrepared++;
+	}
+
+	return true;
+}
+
+
+/*!	Passes \a operations on to the driver in the given order, and waits
+	until all of them have been finished. Must be called without \c fLock
+	held, and with \c fPendingOperations set to the number of operations.
+*/
+void
+IOSchedulerBase::_ExecuteOperations(IOOperationList& operations)
+{
+#ifdef TRACE_IO_SCHEDULER
+	int32 i = 0;
+#endif
+	while (IOOperation* operation = operations.RemoveHead()) {
+		TRACE("IOSchedulerBase::_ExecuteOperations(): calling callback for "
+			"operation %ld: %p\n", i++, operation);
+
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_STARTED,
+			this, operation->Parent(), operation);
+
+		fIOCallback(fIOCallbackData, operation);
+
+		_Finisher();
+	}
+
+	// wait for all operations to finish
+	while (!fTerminating) {
+		MutexLocker locker(fLock);
+
+		if (fPendingOperations == 0)
+			break;
+
+		// Before waiting first check whether any finisher work has to be
+		// done.
+		InterruptsSpinLocker finisherLocker(fFinisherLock);
+		if (_FinisherWorkPending()) {
+			finisherLocker.Unlock();
+			locker.Unlock();
+			_Finisher();
+			continue;
+		}
+
+		// wait for finished operations
+		ConditionVariableEntry entry;
+		fFinishedOperationCondition.Add(&entry);
+
+		finisherLocker.Unlock();
+		locker.Unlock();
+
+		entry.Wait(B_CAN_INTERRUPT);
+		_Finisher();
+	}
+}
+
+
+/*static*/ status_t
+IOSchedulerBase::_SchedulerThread(void *_self)
+{
+	IOSchedulerBase *self = (IOSchedulerBase *)_self;
+	return self->_Scheduler();
+}
+
+
+status_t
+IOSchedulerBase::_RequestNotifier()
+{
+	while (true) {
+		MutexLocker locker(fLock);
+
+		// get a request
+		IORequest* request = fFinishedRequests.RemoveHead();
+
+		if (request == NULL) {
+			if (fTerminating)
+				return B_OK;
+
+			ConditionVariableEntry entry;
+			fFinishedRequestCondition.Add(&entry);
+
+			locker.Unlock();
+
+			entry.Wait();
+			continue;
+		}
+
+		locker.Unlock();
+
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_FINISHED,
+			this, request);
+
+		// notify the request
+		request->NotifyFinished();
+	}
+
+	// never can get here
+	return B_OK;
+}
+
+
+/*static*/ status_t
+IOSchedulerBase::_RequestNotifierThread(void *_self)
+{
+	IOSchedulerBase *self = (IOSchedulerBase*)_self;
+	return self->_RequestNotifier();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2008-2010, Ingo Weinhold, ingo_weinhold@gmx.de.
+ * Copyright 2004-2008, Axel Dörfler, axeld@pinc-software.de.
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef IO_SCHEDULER_BASE_H
+#define IO_SCHEDULER_BASE_H
+
+
+#include <KernelExport.h>
+
+#include <condition_variable.h>
+#include <lock.h>
+
+#include "dma_resources.h"
+#include "IOScheduler.h"
+
+
+/*!	The policy independent part of the thread based I/O schedulers.
+
+	It keeps the pool of operations, translates requests into operations,
+	passes them on to the driver and finishes them again, and runs the
+	callbacks of finished requests in a separate notifier thread.
+	Subclasses queue the requests, and choose which operations to execute
+	next in their _Scheduler() loop.
+*/
+class IOSchedulerBase : public IOScheduler {
+public:
+								IOSchedulerBase(DMAResource* resource,
+									const char* lockName);
+	virtual						~IOSchedulerBase();
+
+	virtual	status_t			Init(const char* name);
+
+	virtual	status_t			ScheduleRequest(IORequest* request);
+
+	virtual	void				AbortRequest(IORequest* request,
+									status_t status = B_CANCELED);
+	virtual	void				OperationCompleted(IOOperation* operation,
+									status_t status,
+									generic_size_t transferredBytes);
+									// called by the driver when the operation
+									// has been completed successfully or failed
+									// for some reason
+
+protected:
+	virtual	status_t			_AddRequest(IORequest* request) = 0;
+									// called with fLock held
+	virtual	void				_RemoveRequest(IORequest* request) = 0;
+									// called with fLock held, when the
+									// request is finished
+	virtual	void				_RequeueOperation(IOOperation* operation) = 0;
+									// called with fLock held, when the
+									// operation needs another pass
+	virtual	status_t			_Scheduler() = 0;
+
+			status_t			_StartThreads(const char* name);
+			void				_StopThreads();
+
+			void				_Finisher();
+			bool				_FinisherWorkPending();
+			void				_NotifyRequestFinished(IORequest* request);
+			bool				_PrepareRequestOperations(IORequest* request,
+									IOOperationList& operations,
+									int32& operationsPrepared, off_t quantum,
+									off_t& usedBandwidth);
+			void				_ExecuteOperations(
+									IOOperationList& operations);
+
+private:
+	static	status_t			_SchedulerThread(void* self);
+			status_t			_RequestNotifier();
+	static	status_t			_RequestNotifierThread(void* self);
+
+protected:
+			spinlock			fFinisherLock;
+			mutex				fLock;
+			thread_id			fSchedulerThread;
+			thread_id			fRequestNotifierThread;
+			IORequestList		fFinishedRequests;
+			ConditionVariable	fNewRequestCondition;
+			ConditionVariable	fFinishedOperationCondition;
+			ConditionVariable	fFinishedRequestCondition;
+			IOOperationList		fUnusedOperations;
+			IOOperationList		fCompletedOperations;
+			size_t				fOperationCount;
+			generic_size_t		fBlockSize;
+			int32				fPendingOperations;
+	volatile bool				fTerminating;
+};
+
+
+#endif	// IO_SCHEDULER_BASE_H
@@ -0,0 +1,534 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "IOSchedulerDeadline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <lock.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+
+#include "IOSchedulerRoster.h"
+
+
+//#define TRACE_IO_SCHEDULER
+#ifdef TRACE_IO_SCHEDULER
+#	define TRACE(x...) dprintf(x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+static const int32 kReadQueue = 0;
+static const int32 kWriteQueue = 1;
+
+static const int32 kMaxQueuedRequests = 1024;
+	// requests beyond this are kept in arrival order until entries free up
+
+static const bigtime_t kReadExpire = 500000;
+static const bigtime_t kWriteExpire = 5000000;
+static const bigtime_t kIdleExpire = 10000000;
+static const int32 kMaxStarvedWrites = 2;
+	// number of read batches that may be dispatched in a row while writes
+	// are pending
+static const bigtime_t kIdleGracePeriod = 10000;
+	// how long the device must not have served any other class before idle
+	// requests are dispatched
+
+static const off_t kDefaultBatchBandwidth = 1024 * 1024;
+	// how much a batch may transfer, unless configured otherwise
+
+static const char* const kIOClassNames[IO_CLASS_COUNT] = {
+	"realtime",
+	"normal",
+	"idle"
+};
+
+
+IOSchedulerDeadline::IOSchedulerDeadline(DMAResource* resource)
+	:
+	IOSchedulerBase(resource, "I/O deadline scheduler"),
+	fAllocatedEntries(NULL),
+	fLastOffset(0),
+	fLastBusyTime(0),
+	fStarvedWrites(0),
+	fBatchBandwidth(kDefaultBatchBandwidth)
+{
+	for (int32 ioClass = 0; ioClass < IO_CLASS_COUNT; ioClass++) {
+		for (int32 i = 0; i < 2; i++) {
+			Queue& queue = fQueues[ioClass][i];
+			queue.next = NULL;
+			if (ioClass == IO_CLASS_IDLE)
+				queue.expire = kIdleExpire;
+			else
+				queue.expire = i == kReadQueue ? kReadExpire : kWriteExpire;
+			queue.io_class = ioClass;
+			queue.count = 0;
+			queue.batches = 0;
+			queue.expired_batches = 0;
+		}
+
+		memset(&fClassStats[ioClass], 0, sizeof(ClassStats));
+	}
+}
+
+
+IOSchedulerDeadline::~IOSchedulerDeadline()
+{
+	_StopThreads();
+
+	delete[] fAllocatedEntries;
+}
+
+
+status_t
+IOSchedulerDeadline::Init(const char* name)
+{
+	status_t error = IOSchedulerBase::Init(name);
+	if (error != B_OK)
+		return error;
+
+	fAllocatedEntries = new(std::nothrow) RequestEntry[kMaxQueuedRequests];
+	if (fAllocatedEntries == NULL)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < kMaxQueuedRequests; i++) {
+		RequestEntry& entry = fAllocatedEntries[i];
+		entry.team = -1;
+		entry.thread = -1;
+		entry.priority = B_IDLE_PRIORITY;
+		entry.request = NULL;
+		entry.io_class = IO_CLASS_NORMAL;
+		entry.queued = false;
+		fUnusedEntries.Add(&entry);
+	}
+
+	if (fBatchBandwidth < (off_t)fBlockSize)
+		fBatchBandwidth = fBlockSize;
+
+	return _StartThreads(name);
+}
+
+
+/*!	Sets how many bytes a normal batch may transfer before the scheduler
+	looks at the other queues again. Realtime batches get twice as much,
+	idle ones a quarter.
+*/
+void
+IOSchedulerDeadline::SetBatchBandwidth(off_t bandwidth)
+{
+	fBatchBandwidth = bandwidth;
+}
+
+
+void
+IOSchedulerDeadline::Dump() const
+{
+	kprintf("IOSchedulerDeadline at %p\n", this);
+	kprintf("  DMA resource:   %p\n", fDMAResource);
+	kprintf("  last offset:    %" B_PRIdOFF "\n", fLastOffset);
+	kprintf("  starved writes: %" B_PRId32 "\n", fStarvedWrites);
+
+	for (int32 ioClass = 0; ioClass < IO_CLASS_COUNT; ioClass++) {
+		const ClassStats& stats = fClassStats[ioClass];
+		kprintf("  %s class: %" B_PRId32 " queued (max %" B_PRId32 "), "
+			"%" B_PRId64 " requests dispatched, %" B_PRId64 " bytes, "
+			"%" B_PRId64 " completed, average latency %" B_PRId64 " us\n",
+			kIOClassNames[ioClass], stats.queued, stats.max_queued,
+			stats.dispatched_requests, stats.dispatched_bytes,
+			stats.completed_requests, stats.completed_requests > 0
+				? stats.total_latency / stats.completed_requests : 0);
+
+		for (int32 i = 0; i < 2; i++) {
+			const Queue& queue = fQueues[ioClass][i];
+			if (queue.count == 0 && queue.batches == 0)
+				continue;
+
+			kprintf("    %s queue: %" B_PRId32 " requests, %" B_PRId64
+				" batches (%" B_PRId64 " expired), next %p\n",
+				i == kReadQueue ? "read" : "write", queue.count,
+				queue.batches, queue.expired_batches,
+				queue.next != NULL ? queue.next->request : NULL);
+
+			for (SortedList::ConstIterator it = queue.sorted.GetIterator();
+					const RequestEntry* entry = it.Next();) {
+				kprintf("      %p: offset %" B_PRIdOFF ", length %"
+					B_PRIuGENADDR ", thread %" B_PRId32 ", deadline %"
+					B_PRId64 "\n", entry->request, entry->request->Offset(),
+					entry->request->Length(), entry->thread, entry->deadline);
+			}
+		}
+	}
+
+	kprintf("  overflow requests:");
+	for (IORequestList::ConstIterator it = fOverflowRequests.GetIterator();
+			IORequest* request = it.Next();) {
+		kprintf(" %p", request);
+	}
+	kprintf("\n");
+}
+
+
+status_t
+IOSchedulerDeadline::_AddRequest(IORequest* request)
+{
+	TRACE("%p->IOSchedulerDeadline::_AddRequest(%p)\n", this, request);
+
+	RequestEntry* entry = fUnusedEntries.RemoveHead();
+	if (entry != NULL)
+		_QueueRequest(entry, request);
+	else
+		fOverflowRequests.Add(request);
+
+	return B_OK;
+}
+
+
+void
+IOSchedulerDeadline::_RemoveRequest(IORequest* request)
+{
+	_ReleaseEntry(static_cast<RequestEntry*>(request->Owner()));
+}
+
+
+void
+IOSchedulerDeadline::_RequeueOperation(IOOperation* operation)
+{
+	fUnfinishedOperations.Add(operation);
+}
+
+
+/*!	Waits until there is something to dispatch. Called with \c fLock held,
+	returns with it held. Returns \c false when we have been asked to
+	terminate.
+*/
+bool
+IOSchedulerDeadline::_WaitForWork()
+{
+	while (!fTerminating) {
+		if (!fUnfinishedOperations.IsEmpty() || _HasBusyRequests())
+			return true;
+
+		// Idle requests have to wait until the device has not been busy
+		// with anything else for a while.
+		bigtime_t timeout = B_INFINITE_TIMEOUT;
+		if (fClassStats[IO_CLASS_IDLE].queued > 0) {
+			bigtime_t idleTime = system_time() - fLastBusyTime;
+			if (idleTime >= kIdleGracePeriod)
+				return true;
+
+			timeout = kIdleGracePeriod - idleTime;
+		}
+
+		// First check whether any finisher work has to be done.
+		InterruptsSpinLocker finisherLocker(fFinisherLock);
+		if (_FinisherWorkPending()) {
+			finisherLocker.Unlock();
+			mutex_unlock(&fLock);
+			_Finisher();
+			mutex_lock(&fLock);
+			continue;
+		}
+
+		// Wait for new requests.
+		ConditionVariableEntry entry;
+		fNewRequestCondition.Add(&entry);
+
+		finisherLocker.Unlock();
+		mutex_unlock(&fLock);
+
+		if (timeout == B_INFINITE_TIMEOUT)
+			entry.Wait(B_CAN_INTERRUPT);
+		else
+			entry.Wait(B_CAN_INTERRUPT | B_RELATIVE_TIMEOUT, timeout);
+		_Finisher();
+		mutex_lock(&fLock);
+	}
+
+	return false;
+}
+
+
+/*!	Returns whether there are any requests queued that are not in the idle
+	class.
+*/
+bool
+IOSchedulerDeadline::_HasBusyRequests() const
+{
+	return fClassStats[IO_CLASS_REALTIME].queued > 0
+		|| fClassStats[IO_CLASS_NORMAL].queued > 0;
+}
+
+
+/*!	Chooses between the read and write queue of a class. Reads are
+	preferred, unless writes have already been passed over
+	\c kMaxStarvedWrites times in a row.
+*/
+IOSchedulerDeadline::Queue*
+IOSchedulerDeadline::_ChooseDirection(Queue* queues)
+{
+	Queue& reads = queues[kReadQueue];
+	Queue& writes = queues[kWriteQueue];
+
+	if (reads.count > 0
+		&& (writes.count == 0 || fStarvedWrites < kMaxStarvedWrites)) {
+		if (writes.count > 0)
+			fStarvedWrites++;
+		return &reads;
+	}
+
+	if (writes.count > 0) {
+		fStarvedWrites = 0;
+		return &writes;
+	}
+
+	return NULL;
+}
+
+
+/*!	Realtime requests go first, then normal ones. Idle requests are only
+	served when the device has been otherwise idle for \c kIdleGracePeriod,
+	or when they have expired.
+*/
+IOSchedulerDeadline::Queue*
+IOSchedulerDeadline::_ChooseQueue()
+{
+	bigtime_t now = system_time();
+
+	for (int32 i = 0; i < 2; i++) {
+		Queue& queue = fQueues[IO_CLASS_IDLE][i];
+		if (queue.count > 0 && queue.fifo.Head()->deadline <= now)
+			return &queue;
+	}
+
+	if (Queue* queue = _ChooseDirection(fQueues[IO_CLASS_REALTIME]))
+		return queue;
+	if (Queue* queue = _ChooseDirection(fQueues[IO_CLASS_NORMAL]))
+		return queue;
+
+	if (now - fLastBusyTime >= kIdleGracePeriod)
+		return _ChooseDirection(fQueues[IO_CLASS_IDLE]);
+
+	return NULL;
+}
+
+
+/*!	Prepares the operations for the next batch of \a queue. The batch starts
+	at the oldest request if that one has expired, and where the last batch
+	ended otherwise. It then continues in ascending offset order until the
+	batch bandwidth has been used up; requests that directly follow the
+	previous one are merged into the batch even beyond that, as they do not
+	cost a seek.
+*/
+void
+IOSchedulerDeadline::_PrepareBatch(Queue& queue, IOOperationList& operations,
+	int32& operationsPrepared)
+{
+	RequestEntry* entry = queue.fifo.Head();
+	if (entry->deadline > system_time()) {
+		entry = queue.next;
+		if (entry == NULL) {
+			// start a new sweep at the first request after the last offset
+			entry = queue.sorted.Head();
+			while (entry != NULL && entry->request->Offset() < fLastOffset)
+				entry = queue.sorted.GetNext(entry);
+			if (entry == NULL)
+				entry = queue.sorted.Head();
+		}
+	} else
+		queue.expired_batches++;
+
+	queue.batches++;
+
+	// realtime batches get twice the bandwidth, idle ones a quarter
+	ClassStats& stats = fClassStats[queue.io_class];
+	off_t batchBandwidth = fBatchBandwidth;
+	if (queue.io_class == IO_CLASS_REALTIME)
+		batchBandwidth *= 2;
+	else if (queue.io_class == IO_CLASS_IDLE)
+		batchBandwidth = std::max(batchBandwidth / 4, (off_t)fBlockSize);
+
+	off_t bandwidth = 0;
+	off_t lastEnd = -1;
+	bool resourcesAvailable = true;
+
+	while (entry != NULL && resourcesAvailable) {
+		IORequest* request = entry->request;
+		off_t limit = request->Offset() == lastEnd
+			? 2 * batchBandwidth : batchBandwidth;
+		if (limit - bandwidth < (off_t)fBlockSize)
+			break;
+
+		RequestEntry* next = queue.sorted.GetNext(entry);
+
+		off_t usedBandwidth = 0;
+		resourcesAvailable = _PrepareRequestOperations(request, operations,
+			operationsPrepared, limit - bandwidth, usedBandwidth);
+		bandwidth += usedBandwidth;
+		stats.dispatched_bytes += usedBandwidth;
+
+		if (request->RemainingBytes() > 0 && request->Status() > 0) {
+			// only partially prepared -- continue with it next time
+			break;
+		}
+
+		lastEnd = request->Offset() + request->Length();
+
+		if (request->IsFinished()) {
+			// It has been aborted without any operations in flight, so the
+			// finisher won't see it.
+			_ReleaseEntry(entry);
+			_NotifyRequestFinished(request);
+		} else {
+			_DequeueEntry(entry);
+			stats.dispatched_requests++;
+		}
+
+		entry = next;
+	}
+
+	queue.next = entry;
+	if (lastEnd >= 0)
+		fLastOffset = lastEnd;
+}
+
+
+status_t
+IOSchedulerDeadline::_Scheduler()
+{
+	while (!fTerminating) {
+		MutexLocker locker(fLock);
+
+		if (!_WaitForWork()) {
+			// we've been asked to terminate
+			return B_OK;
+		}
+
+		IOOperationList operations;
+		int32 operationCount = 0;
+
+		// Operations that need another pass (e.g. the write phase of a
+		// partial block write) go first.
+		while (IOOperation* operation = fUnfinishedOperations.RemoveHead()) {
+			operations.Add(operation);
+			operationCount++;
+		}
+
+		Queue* queue = _ChooseQueue();
+		if (queue != NULL)
+			_PrepareBatch(*queue, operations, operationCount);
+
+		if (operations.IsEmpty())
+			continue;
+
+		bool busy = queue == NULL || queue->io_class != IO_CLASS_IDLE;
+
+		fPendingOperations = operationCount;
+
+		locker.Unlock();
+
+		_ExecuteOperations(operations);
+
+		if (busy) {
+			locker.Lock();
+			fLastBusyTime = system_time();
+			locker.Unlock();
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	Adds \a request to its direction's queue. Called with \c fLock held. */
+void
+IOSchedulerDeadline::_QueueRequest(RequestEntry* entry, IORequest* request)
+{
+	entry->team = request->TeamID();
+	entry->thread = request->ThreadID();
+	int32 priority = thread_get_io_priority(request->ThreadID());
+	entry->priority = priority >= 0 ? priority : B_NORMAL_PRIORITY;
+	entry->io_class = request->IOClass();
+	if (entry->io_class < 0 || entry->io_class >= IO_CLASS_COUNT)
+		entry->io_class = IO_CLASS_NORMAL;
+	entry->request = request;
+	entry->queued = true;
+	request->SetOwner(entry);
+
+	Queue& queue = _QueueFor(entry);
+	entry->queued_time = system_time();
+	entry->deadline = entry->queued_time + queue.expire;
+	queue.fifo.Add(entry);
+
+	// Requests tend to come in ascending order, so search from the back.
+	off_t offset = request->Offset();
+	RequestEntry* previous = queue.sorted.Tail();
+	while (previous != NULL && previous->request->Offset() > offset)
+		previous = queue.sorted.GetPrevious(previous);
+
+	if (previous != NULL)
+		queue.sorted.InsertAfter(previous, entry);
+	else
+		queue.sorted.Add(entry, false);
+
+	queue.count++;
+
+	ClassStats& stats = fClassStats[entry->io_class];
+	if (++stats.queued > stats.max_queued)
+		stats.max_queued = stats.queued;
+
+	// If the request lies between the current elevator position and its
+	// next stop, it is served on the way.
+	if (queue.next != NULL && offset >= fLastOffset
+		&& offset < queue.next->request->Offset()) {
+		queue.next = entry;
+	}
+}
+
+
+void
+IOSchedulerDeadline::_DequeueEntry(RequestEntry* entry)
+{
+	if (!entry->queued)
+		return;
+
+	Queue& queue = _QueueFor(entry);
+	if (queue.next == entry)
+		queue.next = queue.sorted.GetNext(entry);
+
+	queue.fifo.Remove(entry);
+	queue.sorted.Remove(entry);
+	queue.count--;
+	fClassStats[entry->io_class].queued--;
+	entry->queued = false;
+}
+
+
+/*!	Returns the entry of a finished request to the pool, and hands it to the
+	oldest request that could not get one. Called with \c fLock held.
+*/
+void
+IOSchedulerDeadline::_ReleaseEntry(RequestEntry* entry)
+{
+	_DequeueEntry(entry);
+	entry->request = NULL;
+
+	ClassStats& stats = fClassStats[entry->io_class];
+	stats.completed_requests++;
+	stats.total_latency += system_time() - entry->queued_time;
+
+	IORequest* request = fOverflowRequests.RemoveHead();
+	if (request != NULL) {
+		_QueueRequest(entry, request);
+		fNewRequestCondition.NotifyAll();
+	} else
+		fUnusedEntries.Add(entry);
+}
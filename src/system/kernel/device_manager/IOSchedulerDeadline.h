@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef IO_SCHEDULER_DEADLINE_H
+#define IO_SCHEDULER_DEADLINE_H
+
+
+#include <thread_defs.h>
+
+#include "IOSchedulerBase.h"
+
+
+/*!	An elevator I/O scheduler with per-direction deadlines.
+
+	Reads and writes are kept in separate queues, each sorted by offset and
+	in arrival order. Batches are dispatched in ascending offset order from
+	where the previous batch left off, unless the oldest request of the queue
+	has exceeded its deadline, in which case the batch starts there. Reads
+	are preferred over writes, but only for a limited number of batches in a
+	row, so that writes cannot starve.
+
+	Each I/O class has its own pair of queues. Realtime requests go before
+	normal ones, and idle requests are only served once the device has been
+	idle otherwise for a short while, or when they have waited for too long.
+*/
+class IOSchedulerDeadline : public IOSchedulerBase {
+public:
+								IOSchedulerDeadline(DMAResource* resource);
+	virtual						~IOSchedulerDeadline();
+
+	virtual	status_t			Init(const char* name);
+
+			void				SetBatchBandwidth(off_t bandwidth);
+									// must be called before Init()
+
+	virtual	void				Dump() const;
+
+protected:
+	virtual	status_t			_AddRequest(IORequest* request);
+	virtual	void				_RemoveRequest(IORequest* request);
+	virtual	void				_RequeueOperation(IOOperation* operation);
+	virtual	status_t			_Scheduler();
+
+private:
+			struct RequestEntry : IORequestOwner {
+				IORequest*		request;
+				bigtime_t		queued_time;
+				bigtime_t		deadline;
+				bool			queued;
+				DoublyLinkedListLink<RequestEntry> fifo_link;
+				DoublyLinkedListLink<RequestEntry> sorted_link;
+			};
+
+			typedef DoublyLinkedList<RequestEntry,
+				DoublyLinkedListMemberGetLink<RequestEntry,
+					&RequestEntry::fifo_link> > FifoList;
+			typedef DoublyLinkedList<RequestEntry,
+				DoublyLinkedListMemberGetLink<RequestEntry,
+					&RequestEntry::sorted_link> > SortedList;
+
+			struct Queue {
+				FifoList		fifo;
+				SortedList		sorted;
+				RequestEntry*	next;
+				bigtime_t		expire;
+				int32			io_class;
+				int32			count;
+				int64			batches;
+				int64			expired_batches;
+			};
+
+			struct ClassStats {
+				int32			queued;
+				int32			max_queued;
+				int64			dispatched_requests;
+				int64			dispatched_bytes;
+				int64			completed_requests;
+				bigtime_t		total_latency;
+			};
+
+			bool				_WaitForWork();
+			bool				_HasBusyRequests() const;
+			Queue*				_ChooseDirection(Queue* queues);
+			Queue*				_ChooseQueue();
+			void				_PrepareBatch(Queue& queue,
+									IOOperationList& operations,
+									int32& operationsPrepared);
+
+			Queue&				_QueueFor(RequestEntry* entry)
+									{ return fQueues[entry->io_class][
+										entry->request->IsWrite() ? 1 : 0]; }
+			void				_QueueRequest(RequestEntry* entry,
+									IORequest* request);
+			void				_DequeueEntry(RequestEntry* entry);
+			void				_ReleaseEntry(RequestEntry* entry);
+
+private:
+			IORequestList		fOverflowRequests;
+			IOOperationList		fUnfinishedOperations;
+			RequestEntry*		fAllocatedEntries;
+			FifoList			fUnusedEntries;
+			Queue				fQueues[IO_CLASS_COUNT][2];
+									// reads, writes per class
+			ClassStats			fClassStats[IO_CLASS_COUNT];
+			off_t				fLastOffset;
+			bigtime_t			fLastBusyTime;
+			int32				fStarvedWrites;
+			off_t				fBatchBandwidth;
+};
+
+
+#endif	// IO_SCHEDULER_DEADLINE_H
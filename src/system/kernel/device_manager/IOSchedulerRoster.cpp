@@ -6,8 +6,15 @@
 
 #include "IOSchedulerRoster.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <driver_settings.h>
 #include <util/AutoLock.h>
 
+#include "IOSchedulerDeadline.h"
+#include "IOSchedulerSimple.h"
+
 
 /*static*/ IOSchedulerRoster IOSchedulerRoster::sDefaultInstance;
 
@@ -72,6 +79,68 @@ IOSchedulerRoster::NextID()
 }
 
 
+static const driver_parameter*
+find_scheduler_parameter(const driver_settings* settings, const char* name)
+{
+	// the last one wins, as with get_driver_parameter()
+	for (int i = settings->parameter_count; i-- > 0;) {
+		if (strcmp(settings->parameters[i].name, name) == 0)
+			return &settings->parameters[i];
+	}
+	return NULL;
+}
+
+
+/*!	Creates an uninitialized I/O scheduler for the device published as
+	\a path, as configured in the "io_scheduler" driver settings, e.g.:
+		default	simple
+		disk/scsi/0/0/0/raw	deadline {
+			batch_size	4194304
+		}
+	A device without an entry of its own uses the "default" one. Falls back
+	to IOSchedulerSimple if nothing is configured.
+*/
+/*static*/ IOScheduler*
+IOSchedulerRoster::CreateScheduler(DMAResource* resource, const char* path)
+{
+	bool deadline = false;
+	off_t batchSize = 0;
+
+	void* handle = load_driver_settings("io_scheduler");
+	const driver_settings* settings = get_driver_settings(handle);
+	if (settings != NULL) {
+		const driver_parameter* parameter = NULL;
+		if (path != NULL)
+			parameter = find_scheduler_parameter(settings, path);
+		if (parameter == NULL)
+			parameter = find_scheduler_parameter(settings, "default");
+
+		if (parameter != NULL && parameter->value_count > 0) {
+			deadline = strcmp(parameter->values[0], "deadline") == 0;
+
+			for (int i = 0; i < parameter->parameter_count; i++) {
+				const driver_parameter& option = parameter->parameters[i];
+				if (strcmp(option.name, "batch_size") == 0
+					&& option.value_count > 0) {
+					batchSize = strtoll(option.values[0], NULL, 0);
+				}
+			}
+		}
+	}
+	unload_driver_settings(handle);
+
+	if (deadline) {
+		IOSchedulerDeadline* scheduler
+			= new(std::nothrow) IOSchedulerDeadline(resource);
+		if (scheduler != NULL && batchSize > 0)
+			scheduler->SetBatchBandwidth(batchSize);
+		return scheduler;
+	}
+
+	return new(std::nothrow) IOSchedulerSimple(resource);
+}
+
+
 IOSchedulerRoster::IOSchedulerRoster()
 	:
 	fNextID(1),
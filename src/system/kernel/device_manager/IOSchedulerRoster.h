@@ -48,6 +48,9 @@ public:
 
 			int32				NextID();
 
+	static	IOScheduler*		CreateScheduler(DMAResource* resource,
+									const char* path);
+
 private:
 								IOSchedulerRoster();
 								~IOSchedulerRoster();
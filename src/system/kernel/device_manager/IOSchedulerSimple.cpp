@@ -40,6 +40,7 @@ IORequestOwner::Dump() const
 	kprintf("  team:     %" B_PRId32 "\n", team);
 	kprintf("  thread:   %" B_PRId32 "\n", thread);
 	kprintf("  priority: %" B_PRId32 "\n", priority);
+	kprintf("  I/O class: %" B_PRId32 "\n", io_class);
 
 	kprintf("  requests:");
 	for (IORequestList::ConstIterator it = requests.GetIterator();
@@ -86,52 +87,17 @@ struct IOSchedulerSimple::RequestOwnerHashTable
 
 IOSchedulerSimple::IOSchedulerSimple(DMAResource* resource)
 	:
-	IOScheduler(resource),
-	fSchedulerThread(-1),
-	fRequestNotifierThread(-1),
+	IOSchedulerBase(resource, "I/O scheduler"),
 	fOperationArray(NULL),
 	fAllocatedRequestOwners(NULL),
-	fRequestOwners(NULL),
-	fBlockSize(0),
-	fPendingOperations(0),
-	fTerminating(false)
+	fRequestOwners(NULL)
 {
-	mutex_init(&fLock, "I/O scheduler");
-	B_INITIALIZE_SPINLOCK(&fFinisherLock);
-
-	fNewRequestCondition.Init(this, "I/O new request");
-	fFinishedOperationCondition.Init(this, "I/O finished operation");
-	fFinishedRequestCondition.Init(this, "I/O finished request");
-
 }
 
 
 IOSchedulerSimple::~IOSchedulerSimple()
 {
-	// shutdown threads
-	MutexLocker locker(fLock);
-	InterruptsSpinLocker finisherLocker(fFinisherLock);
-	fTerminating = true;
-
-	fNewRequestCondition.NotifyAll();
-	fFinishedOperationCondition.NotifyAll();
-	fFinishedRequestCondition.NotifyAll();
-
-	finisherLocker.Unlock();
-	locker.Unlock();
-
-	if (fSchedulerThread >= 0)
-		wait_for_thread(fSchedulerThread, NULL);
-
-	if (fRequestNotifierThread >= 0)
-		wait_for_thread(fRequestNotifierThread, NULL);
-
-	// destroy our belongings
-	mutex_lock(&fLock);
-	mutex_destroy(&fLock);
-
-	while (IOOperation* operation = fUnusedOperations.RemoveHead())
-		delete operation;
+	_StopThreads();
 
 	delete[] fOperationArray;
 
@@ -143,25 +109,13 @@ IOSchedulerSimple::~IOSchedulerSimple()
 status_t
 IOSchedulerSimple::Init(const char* name)
 {
-	status_t error = IOScheduler::Init(name);
+	status_t error = IOSchedulerBase::Init(name);
 	if (error != B_OK)
 		return error;
 
-	size_t count = fDMAResource != NULL ? fDMAResource->BufferCount() : 16;
-	for (size_t i = 0; i < count; i++) {
-		IOOperation* operation = new(std::nothrow) IOOperation;
-		if (operation == NULL)
-			return B_NO_MEMORY;
-
-		fUnusedOperations.Add(operation);
-	}
-
-	fOperationArray = new(std::nothrow) IOOperation*[count];
-
-	if (fDMAResource != NULL)
-		fBlockSize = fDMAResource->BlockSize();
-	if (fBlockSize == 0)
-		fBlockSize = 512;
+	fOperationArray = new(std::nothrow) IOOperation*[fOperationCount];
+	if (fOperationArray == NULL)
+		return B_NO_MEMORY;
 
 	fAllocatedRequestOwnerCount = thread_max_threads();
 	fAllocatedRequestOwners
@@ -174,6 +128,7 @@ IOSchedulerSimple::Init(const char* name)
 		owner.team = -1;
 		owner.thread = -1;
 		owner.priority = B_IDLE_PRIORITY;
+		owner.io_class = IO_CLASS_NORMAL;
 		fUnusedRequestOwners.Add(&owner);
 	}
 
@@ -190,65 +145,35 @@ IOSchedulerSimple::Init(const char* name)
 	fMinOwnerBandwidth = fBlockSize * 1024;
 	fMaxOwnerBandwidth = fBlockSize * 4096;
 
-	// start threads
-	char buffer[B_OS_NAME_LENGTH];
-	strlcpy(buffer, name, sizeof(buffer));
-	strlcat(buffer, " scheduler ", sizeof(buffer));
-	size_t nameLength = strlen(buffer);
-	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
-		fID);
-	fSchedulerThread = spawn_kernel_thread(&_SchedulerThread, buffer,
-		B_NORMAL_PRIORITY + 2, (void *)this);
-	if (fSchedulerThread < B_OK)
-		return fSchedulerThread;
-
-	strlcpy(buffer, name, sizeof(buffer));
-	strlcat(buffer, " notifier ", sizeof(buffer));
-	nameLength = strlen(buffer);
-	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
-		fID);
-	fRequestNotifierThread = spawn_kernel_thread(&_RequestNotifierThread,
-		buffer, B_NORMAL_PRIORITY + 2, (void *)this);
-	if (fRequestNotifierThread < B_OK)
-		return fRequestNotifierThread;
-
-	resume_thread(fSchedulerThread);
-	resume_thread(fRequestNotifierThread);
-
-	return B_OK;
+	return _StartThreads(name);
 }
 
 
-status_t
-IOSchedulerSimple::ScheduleRequest(IORequest* request)
+void
+IOSchedulerSimple::Dump() const
 {
-	TRACE("%p->IOSchedulerSimple::ScheduleRequest(%p)\n", this, request);
-
-	IOBuffer* buffer = request->Buffer();
-
-	// TODO: it would be nice to be able to lock the memory later, but we can't
-	// easily do it in the I/O scheduler without being able to asynchronously
-	// lock memory (via another thread or a dedicated call).
+	kprintf("IOSchedulerSimple at %p\n", this);
+	kprintf("  DMA resource:   %p\n", fDMAResource);
 
-	if (buffer->IsVirtual()) {
-		status_t status = buffer->LockMemory(request->TeamID(),
-			request->IsWrite());
-		if (status != B_OK) {
-			request->SetStatusAndNotify(status);
-			return status;
-		}
+	kprintf("  active request owners:");
+	for (RequestOwnerList::ConstIterator it
+				= fActiveRequestOwners.GetIterator();
+			IORequestOwner* owner = it.Next();) {
+		kprintf(" %p", owner);
 	}
+	kprintf("\n");
+}
+
 
-	MutexLocker locker(fLock);
+status_t
+IOSchedulerSimple::_AddRequest(IORequest* request)
+{
+	TRACE("%p->IOSchedulerSimple::_AddRequest(%p)\n", this, request);
 
 	IORequestOwner* owner = _GetRequestOwner(request->TeamID(),
 		request->ThreadID(), true);
 	if (owner == NULL) {
 		panic("IOSchedulerSimple: Out of request owners!\n");
-		locker.Unlock();
-		if (buffer->IsVirtual())
-			buffer->UnlockMemory(request->TeamID(), request->IsWrite());
-		request->SetStatusAndNotify(B_NO_MEMORY);
 		return B_NO_MEMORY;
 	}
 
@@ -259,233 +184,50 @@ IOSchedulerSimple::ScheduleRequest(IORequest* request)
 	int32 priority = thread_get_io_priority(request->ThreadID());
 	if (priority >= 0)
 		owner->priority = priority;
+	owner->io_class = request->IOClass();
 //dprintf("  request %p -> owner %p (thread %ld, active %d)\n", request, owner, owner->thread, wasActive);
 
 	if (!wasActive)
 		fActiveRequestOwners.Add(owner);
 
-	IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_SCHEDULED, this,
-		request);
-
-	fNewRequestCondition.NotifyAll();
-
 	return B_OK;
 }
 
 
 void
-IOSchedulerSimple::AbortRequest(IORequest* request, status_t status)
-{
-	// TODO:...
-//B_CANCELED
-}
-
-
-void
-IOSchedulerSimple::OperationCompleted(IOOperation* operation, status_t status,
-	generic_size_t transferredBytes)
+IOSchedulerSimple::_RemoveRequest(IORequest* request)
 {
-	InterruptsSpinLocker _(fFinisherLock);
-
-	// finish operation only once
-	if (operation->Status() <= 0)
-		return;
-
-	operation->SetStatus(status);
-
-	// set the bytes transferred (of the net data)
-	generic_size_t partialBegin
-		= operation->OriginalOffset() - operation->Offset();
-	operation->SetTransferredBytes(
-		transferredBytes > partialBegin ? transferredBytes - partialBegin : 0);
-
-	fCompletedOperations.Add(operation);
-	fFinishedOperationCondition.NotifyAll();
-}
-
-
-void
-IOSchedulerSimple::Dump() const
-{
-	kprintf("IOSchedulerSimple at %p\n", this);
-	kprintf("  DMA resource:   %p\n", fDMAResource);
-
-	kprintf("  active request owners:");
-	for (RequestOwnerList::ConstIterator it
-				= fActiveRequestOwners.GetIterator();
-			IORequestOwner* owner = it.Next();) {
-		kprintf(" %p", owner);
+	// Remove the request from the request owner.
+	IORequestOwner* owner = request->Owner();
+	owner->requests.MoveFrom(&owner->completed_requests);
+	owner->requests.Remove(request);
+
+	if (!owner->IsActive()) {
+		fActiveRequestOwners.Remove(owner);
+		fUnusedRequestOwners.Add(owner);
 	}
-	kprintf("\n");
 }
 
 
-/*!	Must not be called with the fLock held. */
 void
-IOSchedulerSimple::_Finisher()
+IOSchedulerSimple::_RequeueOperation(IOOperation* operation)
 {
-	while (true) {
-		InterruptsSpinLocker locker(fFinisherLock);
-		IOOperation* operation = fCompletedOperations.RemoveHead();
-		if (operation == NULL)
-			return;
-
-		locker.Unlock();
-
-		TRACE("IOSchedulerSimple::_Finisher(): operation: %p\n", operation);
-
-		bool operationFinished = operation->Finish();
-
-		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_FINISHED,
-			this, operation->Parent(), operation);
-			// Notify for every time the operation is passed to the I/O hook,
-			// not only when it is fully finished.
-
-		if (!operationFinished) {
-			TRACE("  operation: %p not finished yet\n", operation);
-			MutexLocker _(fLock);
-			operation->SetTransferredBytes(0);
-			operation->Parent()->Owner()->operations.Add(operation);
-			fPendingOperations--;
-			continue;
-		}
-
-		// notify request and remove operation
-		IORequest* request = operation->Parent();
-
-		generic_size_t operationOffset
-			= operation->OriginalOffset() - request->Offset();
-		request->OperationFinished(operation, operation->Status(),
-			operation->TransferredBytes() < operation->OriginalLength(),
-			operation->Status() == B_OK
-				? operationOffset + operation->OriginalLength()
-				: operationOffset);
-
-		// recycle the operation
-		MutexLocker _(fLock);
-		if (fDMAResource != NULL)
-			fDMAResource->RecycleBuffer(operation->Buffer());
-
-		fPendingOperations--;
-		fUnusedOperations.Add(operation);
-
-		// If the request is done, we need to perform its notifications.
-		if (request->IsFinished()) {
-			if (request->Status() == B_OK && request->RemainingBytes() > 0) {
-				// The request has been processed OK so far, but it isn't really
-				// finished yet.
-				request->SetUnfinished();
-			} else {
-				// Remove the request from the request owner.
-				IORequestOwner* owner = request->Owner();
-				owner->requests.MoveFrom(&owner->completed_requests);
-				owner->requests.Remove(request);
-				request->SetOwner(NULL);
-
-				if (!owner->IsActive()) {
-					fActiveRequestOwners.Remove(owner);
-					fUnusedRequestOwners.Add(owner);
-				}
-
-				if (request->HasCallbacks()) {
-					// The request has callbacks that may take some time to
-					// perform, so we hand it over to the request notifier.
-					fFinishedRequests.Add(request);
-					fFinishedRequestCondition.NotifyAll();
-				} else {
-					// No callbacks -- finish the request right now.
-					IOSchedulerRoster::Default()->Notify(
-						IO_SCHEDULER_REQUEST_FINISHED, this, request);
-					request->NotifyFinished();
-				}
-			}
-		}
-	}
-}
-
-
-/*!	Called with \c fFinisherLock held.
-*/
-bool
-IOSchedulerSimple::_FinisherWorkPending()
-{
-	return !fCompletedOperations.IsEmpty();
-}
-
-
-bool
-IOSchedulerSimple::_PrepareRequestOperations(IORequest* request,
-	IOOperationList& operations, int32& operationsPrepared, off_t quantum,
-	off_t& usedBandwidth)
-{
-//dprintf("IOSchedulerSimple::_PrepareRequestOperations(%p)\n", request);
-	usedBandwidth = 0;
-
-	if (fDMAResource != NULL) {
-		while (quantum >= (off_t)fBlockSize && request->RemainingBytes() > 0) {
-			IOOperation* operation = fUnusedOperations.RemoveHead();
-			if (operation == NULL)
-				return false;
-
-			status_t status = fDMAResource->TranslateNext(request, operation,
-				quantum);
-			if (status != B_OK) {
-				operation->SetParent(NULL);
-				fUnusedOperations.Add(operation);
-
-				// B_BUSY means some resource (DMABuffers or
-				// DMABounceBuffers) was temporarily unavailable. That's OK,
-				// we'll retry later.
-				if (status == B_BUSY)
-					return false;
-
-				AbortRequest(request, status);
-				return true;
-			}
-//dprintf("  prepared operation %p\n", operation);
-
-			off_t bandwidth = operation->Length();
-			quantum -= bandwidth;
-			usedBandwidth += bandwidth;
-
-			operations.Add(operation);
-			operationsPrepared++;
-		}
-	} else {
-		// TODO: If the device has block size restrictions, we might need to use
-		// a bounce buffer.
-		IOOperation* operation = fUnusedOperations.RemoveHead();
-		if (operation == NULL)
-			return false;
-
-		status_t status = operation->Prepare(request);
-		if (status != B_OK) {
-			operation->SetParent(NULL);
-			fUnusedOperations.Add(operation);
-			AbortRequest(request, status);
-			return true;
-		}
-
-		operation->SetOriginalRange(request->Offset(), request->Length());
-		request->Advance(request->Length());
-
-		off_t bandwidth = operation->Length();
-		quantum -= bandwidth;
-		usedBandwidth += bandwidth;
-
-		operations.Add(operation);
-		operationsPrepared++;
-	}
-
-	return true;
+	operation->Parent()->Owner()->operations.Add(operation);
 }
 
 
 off_t
-IOSchedulerSimple::_ComputeRequestOwnerBandwidth(int32 priority) const
+IOSchedulerSimple::_ComputeRequestOwnerBandwidth(int32 ioClass) const
 {
 // TODO: Use a priority dependent quantum!
-	return fMinOwnerBandwidth;
+	switch (ioClass) {
+		case IO_CLASS_REALTIME:
+			return fMaxOwnerBandwidth;
+		case IO_CLASS_IDLE:
+			return std::max(fMinOwnerBandwidth / 4, (off_t)fBlockSize);
+		default:
+			return fMinOwnerBandwidth;
+	}
 }
 
 
@@ -503,7 +245,7 @@ IOSchedulerSimple::_NextActiveRequestOwner(IORequestOwner*& owner,
 			owner = fActiveRequestOwners.Head();
 
 		if (owner != NULL) {
-			quantum = _ComputeRequestOwnerBandwidth(owner->priority);
+			quantum = _ComputeRequestOwnerBandwidth(owner->io_class);
 			return true;
 		}
 
@@ -652,7 +394,7 @@ IOSchedulerSimple::_Scheduler()
 				IORequest* request = owner->requests.Head();
 				if (request == NULL) {
 					resourcesAvailable = false;
-if (operationCount == 0)
+if (operationCount == 0 && owner->IsActive())
 panic("no more requests for owner %p (thread %" B_PRId32 ")", owner, owner->thread);
 					break;
 				}
@@ -666,7 +408,17 @@ panic("no more requests for owner %p (thread %" B_PRId32 ")", owner, owner->thre
 					// If the request has been completed, move it to the
 					// completed list, so we don't pick it up again.
 					owner->requests.Remove(request);
-					owner->completed_requests.Add(request);
+
+					// An aborted request without any operations in flight
+					// won't be finished by the finisher -- do it here.
+					if (request->IsFinished()) {
+						_NotifyRequestFinished(request);
+						if (!owner->IsActive()) {
+							resourcesAvailable = false;
+							break;
+						}
+					} else
+						owner->completed_requests.Add(request);
 				}
 			}
 
@@ -680,6 +432,10 @@ panic("no more requests for owner %p (thread %" B_PRId32 ")", owner, owner->thre
 		// iteration.
 		if (owner->requests.IsEmpty()) {
 			fActiveRequestOwners.Insert(owner, &marker);
+			if (!owner->IsActive()) {
+				fActiveRequestOwners.Remove(owner);
+				fUnusedRequestOwners.Add(owner);
+			}
 			owner = NULL;
 		}
 
@@ -693,107 +449,13 @@ panic("no more requests for owner %p (thread %" B_PRId32 ")", owner, owner->thre
 		// sort the operations
 		_SortOperations(operations, lastOffset);
 
-		// execute the operations
-#ifdef TRACE_IO_SCHEDULER
-		int32 i = 0;
-#endif
-		while (IOOperation* operation = operations.RemoveHead()) {
-			TRACE("IOSchedulerSimple::_Scheduler(): calling callback for "
-				"operation %ld: %p\n", i++, operation);
-
-			IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_STARTED,
-				this, operation->Parent(), operation);
-
-			fIOCallback(fIOCallbackData, operation);
-
-			_Finisher();
-		}
-
-		// wait for all operations to finish
-		while (!fTerminating) {
-			locker.Lock();
-
-			if (fPendingOperations == 0)
-				break;
-
-			// Before waiting first check whether any finisher work has to be
-			// done.
-			InterruptsSpinLocker finisherLocker(fFinisherLock);
-			if (_FinisherWorkPending()) {
-				finisherLocker.Unlock();
-				locker.Unlock();
-				_Finisher();
-				continue;
-			}
-
-			// wait for finished operations
-			ConditionVariableEntry entry;
-			fFinishedOperationCondition.Add(&entry);
-
-			finisherLocker.Unlock();
-			locker.Unlock();
-
-			entry.Wait(B_CAN_INTERRUPT);
-			_Finisher();
-		}
-	}
-
-	return B_OK;
-}
-
-
-/*static*/ status_t
-IOSchedulerSimple::_SchedulerThread(void *_self)
-{
-	IOSchedulerSimple *self = (IOSchedulerSimple *)_self;
-	return self->_Scheduler();
-}
-
-
-status_t
-IOSchedulerSimple::_RequestNotifier()
-{
-	while (true) {
-		MutexLocker locker(fLock);
-
-		// get a request
-		IORequest* request = fFinishedRequests.RemoveHead();
-
-		if (request == NULL) {
-			if (fTerminating)
-				return B_OK;
-
-			ConditionVariableEntry entry;
-			fFinishedRequestCondition.Add(&entry);
-
-			locker.Unlock();
-
-			entry.Wait();
-			continue;
-		}
-
-		locker.Unlock();
-
-		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_FINISHED,
-			this, request);
-
-		// notify the request
-		request->NotifyFinished();
+		_ExecuteOperations(operations);
 	}
 
-	// never can get here
 	return B_OK;
 }
 
 
-/*static*/ status_t
-IOSchedulerSimple::_RequestNotifierThread(void *_self)
-{
-	IOSchedulerSimple *self = (IOSchedulerSimple*)_self;
-	return self->_RequestNotifier();
-}
-
-
 IORequestOwner*
 IOSchedulerSimple::_GetRequestOwner(team_id team, thread_id thread,
 	bool allocate)
@@ -815,6 +477,7 @@ IOSchedulerSimple::_GetRequestOwner(team_id team, thread_id thread,
 			owner->team = team;
 			owner->thread = thread;
 			owner->priority = B_IDLE_PRIORITY;
+			owner->io_class = IO_CLASS_NORMAL;
 			fRequestOwners->InsertUnchecked(owner);
 			break;
 		}
@@ -6,15 +6,24 @@
 
 #include "EntryCache.h"
 
+#include <stddef.h>
+
 #include <new>
 
 
 static const int32 kEntriesPerGeneration = 1024;
 
+static const int32 kMaxDirectories = 64;
+static const int32 kMaxDirectoryEntries = 256;
+	// larger directories are not cached completely
+
 static const int32 kEntryNotInArray = -1;
 static const int32 kEntryRemoved = -2;
 
 
+int32 EntryCache::sGlobalChangeCount = 0;
+
+
 // #pragma mark - EntryCacheGeneration
 
 
@@ -50,7 +59,9 @@ EntryCacheGeneration::Init()
 
 EntryCache::EntryCache()
 	:
-	fCurrentGeneration(0)
+	fCurrentGeneration(0),
+	fDirectoryCount(0),
+	fChangeCount(0)
 {
 	rw_lock_init(&fLock, "entry cache");
 
@@ -68,6 +79,14 @@ EntryCache::~EntryCache()
 		entry = next;
 	}
 
+	// delete directories
+	EntryCacheDirectory* directory = fDirectories.Clear(true);
+	while (directory != NULL) {
+		EntryCacheDirectory* next = directory->hash_link;
+		delete directory;
+		directory = next;
+	}
+
 	rw_lock_destroy(&fLock);
 }
 
@@ -79,6 +98,10 @@ EntryCache::Init()
 	if (error != B_OK)
 		return error;
 
+	error = fDirectories.Init();
+	if (error != B_OK)
+		return error;
+
 	for (int32 i = 0; i < kGenerationCount; i++) {
 		error = fGenerations[i].Init();
 		if (error != B_OK)
@@ -92,12 +115,43 @@ EntryCache::Init()
 status_t
 EntryCache::Add(ino_t dirID, const char* name, ino_t nodeID, bool missing)
 {
-	EntryCacheKey key(dirID, name);
+	WriteLocker _(fLock);
+
+	return _Add(dirID, name, nodeID, missing) != NULL ? B_OK : B_NO_MEMORY;
+}
+
 
+/*!	Adds an entry for \a name to \a dirID that states that it does not exist.
+	Unlike Add(), the entry is only added if the cache hasn't seen any change
+	since \a changeCount had been retrieved via ChangeCount(). This allows the
+	VFS to cache a failed lookup without the risk of overwriting an entry that
+	has been created while the file system was being asked.
+*/
+status_t
+EntryCache::AddMissing(ino_t dirID, const char* name, int32 changeCount)
+{
 	WriteLocker _(fLock);
 
+	if (fChangeCount != changeCount)
+		return B_BUSY;
+
+	return _Add(dirID, name, -1, true) != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+EntryCacheEntry*
+EntryCache::_Add(ino_t dirID, const char* name, ino_t nodeID, bool missing)
+{
+	EntryCacheKey key(dirID, name);
+
 	EntryCacheEntry* entry = fEntries.Lookup(key);
 	if (entry != NULL) {
+		if (entry->directory != NULL
+			&& (missing || entry->node_id != nodeID)) {
+			// the directory's contents we have cached are outdated
+			_RemoveDirectory(entry->directory);
+		}
+
 		entry->node_id = nodeID;
 		entry->missing = missing;
 		if (entry->generation != fCurrentGeneration) {
@@ -106,13 +160,14 @@ EntryCache::Add(ino_t dirID, const char* name, ino_t nodeID, bool missing)
 				_AddEntryToCurrentGeneration(entry);
 			}
 		}
-		return B_OK;
+		return entry;
 	}
 
 	entry = (EntryCacheEntry*)malloc(sizeof(EntryCacheEntry) + strlen(name));
 	if (entry == NULL)
-		return B_NO_MEMORY;
+		return NULL;
 
+	entry->directory = NULL;
 	entry->node_id = nodeID;
 	entry->dir_id = dirID;
 	entry->missing = missing;
@@ -124,7 +179,7 @@ EntryCache::Add(ino_t dirID, const char* name, ino_t nodeID, bool missing)
 
 	_AddEntryToCurrentGeneration(entry);
 
-	return B_OK;
+	return entry;
 }
 
 
@@ -135,24 +190,34 @@ EntryCache::Remove(ino_t dirID, const char* name)
 
 	WriteLocker writeLocker(fLock);
 
+	_DirectoryChanged(dirID);
+
 	EntryCacheEntry* entry = fEntries.Lookup(key);
 	if (entry == NULL)
 		return B_ENTRY_NOT_FOUND;
 
-	fEntries.Remove(entry);
+	_RemoveEntry(entry);
+	return B_OK;
+}
 
-	if (entry->index >= 0) {
-		// remove the entry from its generation and delete it
-		fGenerations[entry->generation].entries[entry->index] = NULL;
-		free(entry);
-	} else {
-		// We can't free it, since another thread is about to try to move it
-		// to another generation. We mark it removed and the other thread will
-		// take care of deleting it.
-		entry->index = kEntryRemoved;
-	}
 
-	return B_OK;
+/*!	Invalidates the cached information for the entry \a name in \a dirID
+	after it has been changed. \a nodeID is the node the entry refers to now,
+	or -1, if the entry doesn't exist anymore or the node isn't known. An
+	entry that already maps to \a nodeID is kept.
+*/
+void
+EntryCache::Invalidate(ino_t dirID, const char* name, ino_t nodeID)
+{
+	EntryCacheKey key(dirID, name);
+
+	WriteLocker writeLocker(fLock);
+
+	_DirectoryChanged(dirID);
+
+	EntryCacheEntry* entry = fEntries.Lookup(key);
+	if (entry != NULL && (entry->missing || entry->node_id != nodeID))
+		_RemoveEntry(entry);
 }
 
 
@@ -165,8 +230,16 @@ EntryCache::Lookup(ino_t dirID, const char* name, ino_t& _nodeID,
 	ReadLocker readLocker(fLock);
 
 	EntryCacheEntry* entry = fEntries.Lookup(key);
-	if (entry == NULL)
-		return false;
+	if (entry == NULL) {
+		// a completely cached directory knows all of its entries
+		EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+		if (directory == NULL || !directory->complete)
+			return false;
+
+		_nodeID = -1;
+		_missing = true;
+		return true;
+	}
 
 	int32 oldGeneration = atomic_get_and_set(&entry->generation,
 			fCurrentGeneration);
@@ -211,6 +284,157 @@ EntryCache::Lookup(ino_t dirID, const char* name, ino_t& _nodeID,
 }
 
 
+/*!	Called when \a reader starts reading the directory \a dirID from the
+	file system from its beginning. If no change happens to the directory
+	until the reader is done, all of its entries will be cached, and it will
+	be considered complete.
+*/
+void
+EntryCache::StartReadDirectory(ino_t dirID, const void* reader)
+{
+	WriteLocker _(fLock);
+
+	EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+	if (directory != NULL) {
+		if (directory->complete)
+			return;
+
+		// start over
+		while (EntryCacheEntry* entry = directory->entries.RemoveHead())
+			entry->directory = NULL;
+		directory->entry_count = 0;
+		directory->reader = reader;
+		return;
+	}
+
+	if (fDirectoryCount >= kMaxDirectories)
+		_RemoveDirectory(fDirectoryList.Head());
+
+	directory = new(std::nothrow) EntryCacheDirectory;
+	if (directory == NULL)
+		return;
+
+	directory->dir_id = dirID;
+	directory->entry_count = 0;
+	directory->reader = reader;
+	directory->complete = false;
+
+	fDirectories.Insert(directory);
+	fDirectoryList.Add(directory);
+	fDirectoryCount++;
+}
+
+
+/*!	Adds the \a count directory entries \a reader got from the file system
+	to the cache. They must be passed in in the order they were read, and
+	have not been adjusted by the VFS yet.
+*/
+void
+EntryCache::AddReadEntries(ino_t dirID, const void* reader,
+	const struct dirent* entries, uint32 count)
+{
+	WriteLocker _(fLock);
+
+	for (uint32 i = 0; i < count; i++) {
+		// Adding an entry may push older ones out of the cache -- which
+		// might just have made the directory incomplete.
+		EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+		if (directory == NULL || directory->reader != reader)
+			return;
+
+		EntryCacheEntry* entry = _Add(dirID, entries->d_name, entries->d_ino,
+			false);
+
+		directory = fDirectories.Lookup(dirID);
+		if (directory == NULL || directory->reader != reader)
+			return;
+
+		if (entry == NULL || directory->entry_count >= kMaxDirectoryEntries) {
+			_RemoveDirectory(directory);
+			return;
+		}
+
+		if (entry->directory == NULL) {
+			entry->directory = directory;
+			directory->entries.Add(entry);
+			directory->entry_count++;
+		}
+
+		entries = (const struct dirent*)((const uint8*)entries
+			+ entries->d_reclen);
+	}
+}
+
+
+/*!	Called when \a reader has reached the end of the directory \a dirID.
+	If nothing has changed since it started, the directory is complete now.
+*/
+void
+EntryCache::FinishReadDirectory(ino_t dirID, const void* reader)
+{
+	WriteLocker _(fLock);
+
+	EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+	if (directory == NULL || directory->reader != reader)
+		return;
+
+	directory->reader = NULL;
+	directory->complete = true;
+}
+
+
+/*!	Reads the entries of the completely cached directory \a dirID, starting
+	with the entry at \a index, in the same way the file system's read_dir()
+	hook would.
+	Returns \c B_ENTRY_NOT_FOUND if the directory isn't completely cached.
+*/
+status_t
+EntryCache::ReadDirectory(ino_t dirID, dev_t device, uint32 index,
+	struct dirent* buffer, size_t bufferSize, uint32& _count)
+{
+	ReadLocker _(fLock);
+
+	EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+	if (directory == NULL || !directory->complete)
+		return B_ENTRY_NOT_FOUND;
+
+	EntryCacheDirectoryEntryList::Iterator iterator
+		= directory->entries.GetIterator();
+	for (uint32 i = 0; i < index && iterator.HasNext(); i++)
+		iterator.Next();
+
+	uint32 count = 0;
+	while (count < _count) {
+		EntryCacheEntry* entry = iterator.Next();
+		if (entry == NULL)
+			break;
+
+		size_t nameLength = strlen(entry->name);
+		size_t length = (offsetof(struct dirent, d_name) + nameLength + 1 + 7)
+			& ~(size_t)7;
+		if (length > bufferSize) {
+			if (count == 0)
+				return B_BUFFER_OVERFLOW;
+			break;
+		}
+
+		buffer->d_dev = device;
+		buffer->d_pdev = device;
+		buffer->d_ino = entry->node_id;
+		buffer->d_pino = dirID;
+		buffer->d_reclen = length;
+		memcpy(buffer->d_name, entry->name, nameLength + 1);
+
+		buffer = (struct dirent*)((uint8*)buffer + length);
+		bufferSize -= length;
+		count++;
+	}
+
+	_count = count;
+	return B_OK;
+}
+
+
 const char*
 EntryCache::DebugReverseLookup(ino_t nodeID, ino_t& _dirID)
 {
@@ -247,6 +471,8 @@ EntryCache::_AddEntryToCurrentGeneration(EntryCacheEntry* entry)
 			continue;
 
 		fGenerations[newGeneration].entries[i] = NULL;
+		if (otherEntry->directory != NULL)
+			_RemoveDirectory(otherEntry->directory);
 		fEntries.Remove(otherEntry);
 		free(otherEntry);
 	}
@@ -258,3 +484,55 @@ EntryCache::_AddEntryToCurrentGeneration(EntryCacheEntry* entry)
 	entry->generation = newGeneration;
 	entry->index = 0;
 }
+
+
+void
+EntryCache::_RemoveEntry(EntryCacheEntry* entry)
+{
+	if (entry->directory != NULL)
+		_RemoveDirectory(entry->directory);
+
+	fEntries.Remove(entry);
+
+	if (entry->index >= 0) {
+		// remove the entry from its generation and delete it
+		fGenerations[entry->generation].entries[entry->index] = NULL;
+		free(entry);
+	} else {
+		// We can't free it, since another thread is about to try to move it
+		// to another generation. We mark it removed and the other thread will
+		// take care of deleting it.
+		entry->index = kEntryRemoved;
+	}
+}
+
+
+/*!	Must be called whenever an entry of \a dirID has been changed. Any
+	completely cached directory contents are dropped, and failed lookups that
+	are still in progress won't be cached. Path walks that resolved names
+	from the cache without locking anything will notice the change, too.
+*/
+void
+EntryCache::_DirectoryChanged(ino_t dirID)
+{
+	atomic_add(&fChangeCount, 1);
+	atomic_add(&sGlobalChangeCount, 1);
+
+	EntryCacheDirectory* directory = fDirectories.Lookup(dirID);
+	if (directory != NULL)
+		_RemoveDirectory(directory);
+}
+
+
+void
+EntryCache::_RemoveDirectory(EntryCacheDirectory* directory)
+{
+	while (EntryCacheEntry* entry = directory->entries.RemoveHead())
+		entry->directory = NULL;
+
+	fDirectories.Remove(directory);
+	fDirectoryList.Remove(directory);
+	fDirectoryCount--;
+
+	delete directory;
+}
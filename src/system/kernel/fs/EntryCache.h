@@ -6,9 +6,11 @@
 #define ENTRY_CACHE_H
 
 
+#include <dirent.h>
 #include <stdlib.h>
 
 #include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
 #include <util/OpenHashTable.h>
 #include <util/StringHash.h>
 
@@ -30,8 +32,13 @@ struct EntryCacheKey {
 };
 
 
+struct EntryCacheDirectory;
+
+
 struct EntryCacheEntry {
 			EntryCacheEntry*	hash_link;
+			DoublyLinkedListLink<EntryCacheEntry> directory_link;
+			EntryCacheDirectory* directory;
 			ino_t				node_id;
 			ino_t				dir_id;
 			int32				generation;
@@ -41,6 +48,26 @@ struct EntryCacheEntry {
 };
 
 
+typedef DoublyLinkedList<EntryCacheEntry,
+	DoublyLinkedListMemberGetLink<EntryCacheEntry,
+		&EntryCacheEntry::directory_link> > EntryCacheDirectoryEntryList;
+
+
+/*!	Tracks the contents of a directory that is being read, or has been read
+	completely. While \c complete is set, \c entries contains all entries of
+	the directory in the order the file system returned them.
+*/
+struct EntryCacheDirectory
+	: DoublyLinkedListLinkImpl<EntryCacheDirectory> {
+			EntryCacheDirectory* hash_link;
+			ino_t				dir_id;
+			EntryCacheDirectoryEntryList entries;
+			int32				entry_count;
+			const void*			reader;
+			bool				complete;
+};
+
+
 struct EntryCacheGeneration {
 			int32				next_index;
 			EntryCacheEntry**	entries;
@@ -52,6 +79,32 @@ struct EntryCacheGeneration {
 };
 
 
+struct EntryCacheDirectoryHashDefinition {
+	typedef ino_t				KeyType;
+	typedef EntryCacheDirectory	ValueType;
+
+	size_t HashKey(ino_t key) const
+	{
+		return (uint32)key ^ (uint32)(key >> 32);
+	}
+
+	size_t Hash(const EntryCacheDirectory* value) const
+	{
+		return HashKey(value->dir_id);
+	}
+
+	bool Compare(ino_t key, const EntryCacheDirectory* value) const
+	{
+		return value->dir_id == key;
+	}
+
+	EntryCacheDirectory*& GetLink(EntryCacheDirectory* value) const
+	{
+		return value->hash_link;
+	}
+};
+
+
 struct EntryCacheHashDefinition {
 	typedef EntryCacheKey	KeyType;
 	typedef EntryCacheEntry	ValueType;
@@ -90,28 +143,65 @@ public:
 			status_t			Add(ino_t dirID, const char* name,
 									ino_t nodeID, bool missing);
 
+			status_t			AddMissing(ino_t dirID, const char* name,
+									int32 changeCount);
+			int32				ChangeCount() const
+									{ return atomic_get(
+										(int32*)&fChangeCount); }
+	static	int32				GlobalChangeCount()
+									{ return atomic_get(&sGlobalChangeCount); }
+
 			status_t			Remove(ino_t dirID, const char* name);
+			void				Invalidate(ino_t dirID, const char* name,
+									ino_t nodeID);
 
 			bool				Lookup(ino_t dirID, const char* name,
 									ino_t& nodeID, bool& missing);
 
+			void				StartReadDirectory(ino_t dirID,
+									const void* reader);
+			void				AddReadEntries(ino_t dirID,
+									const void* reader,
+									const struct dirent* entries,
+									uint32 count);
+			void				FinishReadDirectory(ino_t dirID,
+									const void* reader);
+			status_t			ReadDirectory(ino_t dirID, dev_t device,
+									uint32 index, struct dirent* buffer,
+									size_t bufferSize, uint32& _count);
+
 			const char*			DebugReverseLookup(ino_t nodeID, ino_t& _dirID);
 
 private:
 	static	const int32			kGenerationCount = 8;
 
 			typedef BOpenHashTable<EntryCacheHashDefinition> EntryTable;
-			typedef DoublyLinkedList<EntryCacheEntry> EntryList;
+			typedef BOpenHashTable<EntryCacheDirectoryHashDefinition>
+				DirectoryTable;
+			typedef DoublyLinkedList<EntryCacheDirectory> DirectoryList;
 
 private:
+			EntryCacheEntry*	_Add(ino_t dirID, const char* name,
+									ino_t nodeID, bool missing);
 			void				_AddEntryToCurrentGeneration(
 									EntryCacheEntry* entry);
+			void				_RemoveEntry(EntryCacheEntry* entry);
+			void				_DirectoryChanged(ino_t dirID);
+			void				_RemoveDirectory(
+									EntryCacheDirectory* directory);
 
 private:
 			rw_lock				fLock;
 			EntryTable			fEntries;
 			EntryCacheGeneration fGenerations[kGenerationCount];
 			int32				fCurrentGeneration;
+			DirectoryTable		fDirectories;
+			DirectoryList		fDirectoryList;
+			int32				fDirectoryCount;
+			int32				fChangeCount;
+
+	static	int32				sGlobalChangeCount;
+									// changes in all entry caches
 };
 
 
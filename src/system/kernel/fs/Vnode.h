@@ -60,6 +60,13 @@ public:
 	inline	bool				IsCovering() const;
 	inline	void				SetCovering(bool covering);
 
+	// whether everybody is allowed to search the directory, setters require
+	// the vnode to be locked
+	inline	bool				IsSearchPermissionKnown() const;
+	inline	bool				IsSearchableByAll() const;
+	inline	void				SetSearchableByAll(bool searchable);
+	inline	void				ForgetSearchPermission();
+
 	inline	uint32				Type() const;
 	inline	void				SetType(uint32 type);
 
@@ -78,6 +85,8 @@ private:
 	static	const uint32		kFlagsHot			= 0x00000040;
 	static	const uint32		kFlagsCovered		= 0x00000080;
 	static	const uint32		kFlagsCovering		= 0x00000100;
+	static	const uint32		kFlagsSearchKnown	= 0x00000200;
+	static	const uint32		kFlagsSearchable	= 0x00000400;
 	static	const uint32		kFlagsType			= 0xfffff000;
 
 	static	const uint32		kBucketCount		= 32;
@@ -229,6 +238,40 @@ vnode::SetCovering(bool covering)
 }
 
 
+bool
+vnode::IsSearchPermissionKnown() const
+{
+	return (fFlags & kFlagsSearchKnown) != 0;
+}
+
+
+bool
+vnode::IsSearchableByAll() const
+{
+	return (fFlags & (kFlagsSearchKnown | kFlagsSearchable))
+		== (kFlagsSearchKnown | kFlagsSearchable);
+}
+
+
+void
+vnode::SetSearchableByAll(bool searchable)
+{
+	if (searchable)
+		atomic_or(&fFlags, kFlagsSearchKnown | kFlagsSearchable);
+	else {
+		atomic_and(&fFlags, ~kFlagsSearchable);
+		atomic_or(&fFlags, kFlagsSearchKnown);
+	}
+}
+
+
+void
+vnode::ForgetSearchPermission()
+{
+	atomic_and(&fFlags, ~(kFlagsSearchKnown | kFlagsSearchable));
+}
+
+
 uint32
 vnode::Type() const
 {
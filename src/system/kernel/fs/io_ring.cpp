@@ -0,0 +1,718 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Submission and completion rings for asynchronous file I/O.
+
+	A ring is an area shared between a team and the kernel, holding a
+	submission ring written by the team and a completion ring written by the
+	kernel, plus a file descriptor representing it. Any number of operations
+	can be submitted with a single _kern_io_ring_enter() call -- or without
+	any call at all, if the ring was created with IO_RING_POLL and is busy --
+	and completions are reaped directly from the shared memory.
+
+	The operations are executed by kernel threads that belong to the team
+	that created the ring. They use the team's I/O context and address space
+	like the team's own threads do, and run through the regular VFS paths,
+	so that reads and writes are coherent with the file cache. For the same
+	reason, the descriptor is neither inherited by forked children nor kept
+	across exec(), and is refused in any other team.
+*/
+
+
+#include <fs/io_ring.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include <AutoDeleter.h>
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <io_ring_defs.h>
+#include <kernel.h>
+#include <lock.h>
+#include <Referenceable.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
+#include <vfs.h>
+#include <vm/vm.h>
+#include <vm/VMAddressSpace.h>
+
+
+//#define TRACE_IO_RING
+#ifdef TRACE_IO_RING
+#	define TRACE(x...) dprintf("io_ring: " x)
+#else
+#	define TRACE(x...) do {} while (false)
+#endif
+
+
+static const uint32 kDefaultWorkerCount = 4;
+static const bigtime_t kPollInterval = 20;
+static const bigtime_t kPollIdleTime = 2000;
+	// how long the polling thread keeps polling without new submissions
+
+
+namespace {
+
+
+struct IORingRequest : DoublyLinkedListLinkImpl<IORingRequest> {
+	io_ring_submission	submission;
+	IORingRequest*		linked;
+		// executed after this one, if it succeeded
+	int64				result;
+};
+
+typedef DoublyLinkedList<IORingRequest> RequestList;
+
+
+class IORing : public BReferenceable {
+public:
+								IORing();
+	virtual						~IORing();
+
+			status_t			Init(uint32 entries, uint32 workerCount,
+									uint32 flags, io_ring_info& info);
+
+			int32				Enter(uint32 submitCount, uint32 waitCount,
+									uint32 flags, bigtime_t timeout);
+			void				Close();
+
+			team_id				Team() const { return fTeam; }
+
+private:
+			status_t			_SpawnThread(thread_func function,
+									const char* name);
+
+			uint32				_Submit(uint32 maxCount);
+			void				_Execute(IORingRequest* request);
+			void				_Complete(IORingRequest* request);
+			bool				_PostCompletion(IORingRequest* request);
+			void				_FlushOverflow();
+			uint32				_CompletionsAvailable() const;
+
+	static	status_t			_WorkerThread(void* self);
+			void				_Worker();
+	static	status_t			_PollerThread(void* self);
+			void				_Poller();
+
+private:
+			mutex				fLock;
+			ConditionVariable	fWorkCondition;
+			ConditionVariable	fCompletionCondition;
+			ConditionVariable	fPollerCondition;
+			team_id				fTeam;
+			area_id				fArea;
+				// the kernel's mapping of the shared area
+			io_ring_shared*		fShared;
+			io_ring_submission*	fSubmissions;
+			io_ring_completion*	fCompletions;
+			uint32				fSubmissionEntries;
+			uint32				fCompletionEntries;
+			uint32				fSubmissionHead;
+			uint32				fCompletionTail;
+			IORingRequest*		fRequests;
+			RequestList			fFreeRequests;
+			RequestList			fPendingRequests;
+			RequestList			fOverflowRequests;
+			uint32				fOverflowCount;
+			bool				fClosed;
+};
+
+
+}	// namespace
+
+
+IORing::IORing()
+	:
+	fTeam(team_get_current_team_id()),
+	fArea(-1),
+	fShared(NULL),
+	fSubmissions(NULL),
+	fCompletions(NULL),
+	fSubmissionEntries(0),
+	fCompletionEntries(0),
+	fSubmissionHead(0),
+	fCompletionTail(0),
+	fRequests(NULL),
+	fOverflowCount(0),
+	fClosed(false)
+{
+	mutex_init(&fLock, "io ring");
+	fWorkCondition.Init(this, "io ring work");
+	fCompletionCondition.Init(this, "io ring completion");
+	fPollerCondition.Init(this, "io ring poller");
+}
+
+
+IORing::~IORing()
+{
+	if (fArea >= 0)
+		delete_area(fArea);
+
+	delete[] fRequests;
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+IORing::Init(uint32 entries, uint32 workerCount, uint32 flags,
+	io_ring_info& info)
+{
+	if (entries == 0 || entries > IO_RING_MAX_ENTRIES
+		|| workerCount > IO_RING_MAX_WORKERS || (flags & ~IO_RING_POLL) != 0) {
+		return B_BAD_VALUE;
+	}
+
+	if (workerCount == 0)
+		workerCount = kDefaultWorkerCount;
+
+	fSubmissionEntries = 1;
+	while (fSubmissionEntries < entries)
+		fSubmissionEntries <<= 1;
+	fCompletionEntries = fSubmissionEntries * 2;
+
+	// There is one request per completion entry, so that completions can
+	// only overflow if the team doesn't reap them.
+	fRequests = new(std::nothrow) IORingRequest[fCompletionEntries];
+	if (fRequests == NULL)
+		return B_NO_MEMORY;
+
+	for (uint32 i = 0; i < fCompletionEntries; i++)
+		fFreeRequests.Add(&fRequests[i]);
+
+	// create the shared area in the team, and map it into the kernel, too
+	size_t submissionOffset = ROUNDUP(sizeof(io_ring_shared), 64);
+	size_t completionOffset = submissionOffset
+		+ fSubmissionEntries * sizeof(io_ring_submission);
+	size_t size = PAGE_ALIGN(completionOffset
+		+ fCompletionEntries * sizeof(io_ring_completion));
+
+	virtual_address_restrictions virtualRestrictions = {};
+	virtualRestrictions.address_specification = B_RANDOMIZED_ANY_ADDRESS;
+	physical_address_restrictions physicalRestrictions = {};
+	void* address;
+	area_id area = create_area_etc(fTeam, "io ring", size, B_FULL_LOCK,
+		B_READ_AREA | B_WRITE_AREA, 0, 0, &virtualRestrictions,
+		&physicalRestrictions, &address);
+	if (area < 0)
+		return area;
+
+	fArea = vm_clone_area(VMAddressSpace::KernelID(), "io ring", &address,
+		B_ANY_KERNEL_ADDRESS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA,
+		REGION_NO_PRIVATE_MAP, area, true);
+	if (fArea < 0) {
+		vm_delete_area(fTeam, area, true);
+		return fArea;
+	}
+
+	fShared = (io_ring_shared*)address;
+	fShared->submission.mask = fSubmissionEntries - 1;
+	fShared->submission.entries = fSubmissionEntries;
+	fShared->completion.mask = fCompletionEntries - 1;
+	fShared->completion.entries = fCompletionEntries;
+	fShared->submission_offset = submissionOffset;
+	fShared->completion_offset = completionOffset;
+
+	fSubmissions = (io_ring_submission*)((uint8*)address + submissionOffset);
+	fCompletions = (io_ring_completion*)((uint8*)address + completionOffset);
+
+	// start the threads
+	status_t status = B_OK;
+	for (uint32 i = 0; i < workerCount && status == B_OK; i++)
+		status = _SpawnThread(&_WorkerThread, "io ring worker");
+	if (status == B_OK && (flags & IO_RING_POLL) != 0)
+		status = _SpawnThread(&_PollerThread, "io ring poller");
+	if (status != B_OK) {
+		Close();
+		vm_delete_area(fTeam, area, true);
+		return status;
+	}
+
+	info.area = area;
+	info.submission_entries = fSubmissionEntries;
+	info.completion_entries = fCompletionEntries;
+	return B_OK;
+}
+
+
+/*!	Submits up to \a submitCount operations from the submission ring, and
+	then waits until at least \a waitCount completions are available in the
+	completion ring. Returns the number of submitted operations.
+*/
+int32
+IORing::Enter(uint32 submitCount, uint32 waitCount, uint32 flags,
+	bigtime_t timeout)
+{
+	MutexLocker locker(fLock);
+	if (fClosed)
+		return B_FILE_ERROR;
+
+	_FlushOverflow();
+
+	uint32 submitted = 0;
+	if (submitCount > 0)
+		submitted = _Submit(submitCount);
+
+	if ((flags & IO_RING_ENTER_WAKEUP) != 0)
+		fPollerCondition.NotifyAll();
+
+	if (waitCount > fCompletionEntries)
+		waitCount = fCompletionEntries;
+
+	uint32 waitFlags = B_CAN_INTERRUPT;
+	if (timeout != B_INFINITE_TIMEOUT) {
+		waitFlags |= B_ABSOLUTE_TIMEOUT;
+		timeout += system_time();
+	}
+
+	while (_CompletionsAvailable() < waitCount) {
+		ConditionVariableEntry entry;
+		fCompletionCondition.Add(&entry);
+
+		locker.Unlock();
+		status_t status = entry.Wait(waitFlags, timeout);
+		locker.Lock();
+
+		if (fClosed)
+			return B_FILE_ERROR;
+
+		if (status != B_OK) {
+			if (submitted > 0)
+				break;
+			return status;
+		}
+
+		_FlushOverflow();
+	}
+
+	return submitted;
+}
+
+
+void
+IORing::Close()
+{
+	MutexLocker locker(fLock);
+
+	fClosed = true;
+
+	fWorkCondition.NotifyAll();
+	fCompletionCondition.NotifyAll();
+	fPollerCondition.NotifyAll();
+}
+
+
+status_t
+IORing::_SpawnThread(thread_func function, const char* name)
+{
+	// the threads run in the team, and keep the ring alive until they quit
+	AcquireReference();
+
+	thread_id thread = spawn_kernel_thread_etc(function, name,
+		B_NORMAL_PRIORITY, this, fTeam);
+	if (thread < 0) {
+		ReleaseReference();
+		return thread;
+	}
+
+	resume_thread(thread);
+	return B_OK;
+}
+
+
+/*!	Moves up to \a maxCount submissions from the submission ring to the
+	pending list. The ring lock must be held.
+*/
+uint32
+IORing::_Submit(uint32 maxCount)
+{
+	uint32 tail = (uint32)atomic_get((int32*)&fShared->submission.tail);
+	uint32 available = tail - fSubmissionHead;
+	if (available > fSubmissionEntries) {
+		// the team has messed up the ring
+		TRACE("invalid submission tail %" B_PRIu32 "\n", tail);
+		return 0;
+	}
+
+	uint32 count = min_c(maxCount, available);
+	uint32 submitted = 0;
+	IORingRequest* chainHead = NULL;
+	IORingRequest* chainTail = NULL;
+
+	for (; submitted < count; submitted++) {
+		IORingRequest* request = fFreeRequests.RemoveHead();
+		if (request == NULL)
+			break;
+
+		// copy the submission, the team may change it anytime
+		memcpy(&request->submission,
+			&fSubmissions[fSubmissionHead & (fSubmissionEntries - 1)],
+			sizeof(io_ring_submission));
+		fSubmissionHead++;
+
+		request->linked = NULL;
+		if (chainTail != NULL)
+			chainTail->linked = request;
+		else
+			chainHead = request;
+		chainTail = request;
+
+		if ((request->submission.flags & IO_RING_LINK) == 0) {
+			fPendingRequests.Add(chainHead);
+			chainHead = chainTail = NULL;
+		}
+	}
+
+	if (chainHead != NULL)
+		fPendingRequests.Add(chainHead);
+
+	if (submitted > 0) {
+		atomic_set((int32*)&fShared->submission.head, fSubmissionHead);
+		fWorkCondition.NotifyAll();
+	}
+
+	return submitted;
+}
+
+
+void
+IORing::_Execute(IORingRequest* request)
+{
+	const io_ring_submission& submission = request->submission;
+	void* buffer = (void*)(addr_t)submission.buffer;
+	const char* path = (const char*)(addr_t)submission.path;
+
+	if (submission.length > SIZE_MAX) {
+		request->result = B_BAD_VALUE;
+		return;
+	}
+	size_t length = (size_t)submission.length;
+
+	switch (submission.opcode) {
+		case IO_RING_OP_NOP:
+			request->result = B_OK;
+			break;
+		case IO_RING_OP_READ:
+			request->result = _user_read(submission.fd, submission.offset,
+				buffer, length);
+			break;
+		case IO_RING_OP_WRITE:
+			request->result = _user_write(submission.fd, submission.offset,
+				buffer, length);
+			break;
+		case IO_RING_OP_FSYNC:
+			request->result = _user_fsync(submission.fd);
+			break;
+		case IO_RING_OP_OPEN:
+			request->result = _user_open(submission.fd, path,
+				submission.open_mode, submission.perms);
+			break;
+		case IO_RING_OP_CLOSE:
+			request->result = _user_close(submission.fd);
+			break;
+		case IO_RING_OP_STAT:
+			request->result = _user_read_stat(submission.fd, path,
+				(submission.flags & IO_RING_NO_TRAVERSE) == 0,
+				(struct stat*)buffer, length);
+			break;
+		default:
+			request->result = B_BAD_VALUE;
+			break;
+	}
+}
+
+
+/*!	Posts the completion of \a request, or queues it until there is room in
+	the completion ring. The ring lock must be held.
+*/
+void
+IORing::_Complete(IORingRequest* request)
+{
+	_FlushOverflow();
+
+	if (!fOverflowRequests.IsEmpty() || !_PostCompletion(request)) {
+		fOverflowRequests.Add(request);
+		fOverflowCount++;
+		atomic_set((int32*)&fShared->completion_overflow, fOverflowCount);
+	}
+}
+
+
+bool
+IORing::_PostCompletion(IORingRequest* request)
+{
+	uint32 head = (uint32)atomic_get((int32*)&fShared->completion.head);
+	if (fCompletionTail - head >= fCompletionEntries)
+		return false;
+
+	io_ring_completion& completion
+		= fCompletions[fCompletionTail & (fCompletionEntries - 1)];
+	completion.user_data = request->submission.user_data;
+	completion.result = request->result;
+
+	// the completion must be visible before the new tail
+	memory_write_barrier();
+	atomic_set((int32*)&fShared->completion.tail, ++fCompletionTail);
+
+	fFreeRequests.Add(request);
+	fCompletionCondition.NotifyAll();
+	return true;
+}
+
+
+void
+IORing::_FlushOverflow()
+{
+	while (IORingRequest* request = fOverflowRequests.Head()) {
+		if (!_PostCompletion(request))
+			break;
+
+		fOverflowRequests.Remove(request);
+		fOverflowCount--;
+		atomic_set((int32*)&fShared->completion_overflow, fOverflowCount);
+	}
+}
+
+
+uint32
+IORing::_CompletionsAvailable() const
+{
+	return fCompletionTail
+		- (uint32)atomic_get((int32*)&fShared->completion.head);
+}
+
+
+/*static*/ status_t
+IORing::_WorkerThread(void* self)
+{
+	IORing* ring = (IORing*)self;
+	ring->_Worker();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+void
+IORing::_Worker()
+{
+	MutexLocker locker(fLock);
+
+	while (!fClosed) {
+		IORingRequest* request = fPendingRequests.RemoveHead();
+		if (request == NULL) {
+			ConditionVariableEntry entry;
+			fWorkCondition.Add(&entry);
+
+			locker.Unlock();
+			status_t status = entry.Wait(B_KILL_CAN_INTERRUPT);
+			locker.Lock();
+
+			if (status == B_INTERRUPTED) {
+				// the team is going away
+				break;
+			}
+			continue;
+		}
+
+		locker.Unlock();
+
+		// execute the chain, cancelling the rest of it after a failure
+		bool failed = false;
+		for (IORingRequest* linked = request; linked != NULL;
+				linked = linked->linked) {
+			if (failed) {
+				linked->result = B_CANCELED;
+				continue;
+			}
+
+			_Execute(linked);
+			failed = linked->result < 0;
+		}
+
+		locker.Lock();
+
+		while (request != NULL) {
+			IORingRequest* next = request->linked;
+			_Complete(request);
+			request = next;
+		}
+	}
+}
+
+
+/*static*/ status_t
+IORing::_PollerThread(void* self)
+{
+	IORing* ring = (IORing*)self;
+	ring->_Poller();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+void
+IORing::_Poller()
+{
+	MutexLocker locker(fLock);
+	bigtime_t lastSubmission = system_time();
+
+	while (!fClosed) {
+		if (_Submit(fSubmissionEntries) > 0) {
+			lastSubmission = system_time();
+		} else if (system_time() - lastSubmission > kPollIdleTime) {
+			// Go to sleep until the team wakes us up. Since the team may
+			// have submitted before it saw the flag, check once more.
+			atomic_or((int32*)&fShared->flags, IO_RING_NEED_WAKEUP);
+
+			if (_Submit(fSubmissionEntries) == 0) {
+				ConditionVariableEntry entry;
+				fPollerCondition.Add(&entry);
+
+				locker.Unlock();
+				status_t status = entry.Wait(B_KILL_CAN_INTERRUPT);
+				locker.Lock();
+
+				if (status == B_INTERRUPTED)
+					break;
+			}
+
+			atomic_and((int32*)&fShared->flags, ~IO_RING_NEED_WAKEUP);
+			lastSubmission = system_time();
+			continue;
+		}
+
+		locker.Unlock();
+		status_t status = snooze_etc(kPollInterval, B_SYSTEM_TIMEBASE,
+			B_RELATIVE_TIMEOUT | B_KILL_CAN_INTERRUPT);
+		if (status == B_INTERRUPTED)
+			return;
+		locker.Lock();
+	}
+}
+
+
+// #pragma mark - file descriptor operations
+
+
+static status_t
+io_ring_close(struct file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->Close();
+	return B_OK;
+}
+
+
+static void
+io_ring_free(struct file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->ReleaseReference();
+}
+
+
+static struct fd_ops sIORingFDOps = {
+	NULL,	// fd_read
+	NULL,	// fd_write
+	NULL,	// fd_seek
+	NULL,	// fd_ioctl
+	NULL,	// fd_set_flags
+	NULL,	// fd_select
+	NULL,	// fd_deselect
+	NULL,	// fd_read_dir
+	NULL,	// fd_rewind_dir
+	NULL,	// fd_read_stat
+	NULL,	// fd_write_stat
+	&io_ring_close,
+	&io_ring_free
+};
+
+
+// #pragma mark - syscalls
+
+
+int
+_user_io_ring_create(uint32 entries, uint32 workerCount, uint32 flags,
+	io_ring_info* userInfo)
+{
+	if (userInfo == NULL || !IS_USER_ADDRESS(userInfo))
+		return B_BAD_ADDRESS;
+
+	IORing* ring = new(std::nothrow) IORing;
+	if (ring == NULL)
+		return B_NO_MEMORY;
+	BReference<IORing> ringReference(ring, true);
+
+	io_ring_info info;
+	status_t status = ring->Init(entries, workerCount, flags, info);
+	if (status != B_OK)
+		return status;
+
+	if (user_memcpy(userInfo, &info, sizeof(io_ring_info)) != B_OK) {
+		ring->Close();
+		vm_delete_area(team_get_current_team_id(), info.area, true);
+		return B_BAD_ADDRESS;
+	}
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL) {
+		ring->Close();
+		vm_delete_area(team_get_current_team_id(), info.area, true);
+		return B_NO_MEMORY;
+	}
+
+	descriptor->type = FDTYPE_IO_RING;
+	descriptor->ops = &sIORingFDOps;
+	descriptor->cookie = ring;
+	descriptor->open_mode = O_RDWR;
+
+	io_context* context = get_current_io_context(false);
+	int fd = new_fd(context, descriptor);
+	if (fd < 0) {
+		free(descriptor);
+		ring->Close();
+		vm_delete_area(team_get_current_team_id(), info.area, true);
+		return fd;
+	}
+
+	// the descriptor owns the reference now
+	ringReference.Detach();
+
+	fd_set_close_on_exec(context, fd, true);
+
+	TRACE("created ring %p, fd %d, %" B_PRIu32 " entries\n", ring, fd,
+		info.submission_entries);
+	return fd;
+}
+
+
+int32
+_user_io_ring_enter(int fd, uint32 submitCount, uint32 waitCount,
+	uint32 flags, bigtime_t timeout)
+{
+	if ((flags & ~IO_RING_ENTER_WAKEUP) != 0)
+		return B_BAD_VALUE;
+
+	file_descriptor* descriptor = get_fd(get_current_io_context(false), fd);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+	CObjectDeleter<file_descriptor> descriptorPutter(descriptor, put_fd);
+
+	if (descriptor->type != FDTYPE_IO_RING)
+		return B_BAD_VALUE;
+
+	// The ring's workers run in, and access the memory of, the team that
+	// created it. Another team that got hold of the descriptor, e.g. by
+	// having it passed over a socket, must not use it.
+	IORing* ring = (IORing*)descriptor->cookie;
+	if (ring->Team() != team_get_current_team_id())
+		return B_NOT_ALLOWED;
+
+	return ring->Enter(submitCount, waitCount, flags, timeout);
+}
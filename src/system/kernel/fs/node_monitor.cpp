@@ -1152,6 +1152,8 @@ status_t
 notify_entry_created(dev_t device, ino_t directory, const char *name,
 	ino_t node)
 {
+	vfs_entry_changed(device, directory, name, node);
+
 	return sNodeMonitorService.NotifyEntryCreatedOrRemoved(B_ENTRY_CREATED,
 		device, directory, name, node);
 }
@@ -1170,6 +1172,8 @@ status_t
 notify_entry_removed(dev_t device, ino_t directory, const char *name,
 	ino_t node)
 {
+	vfs_entry_changed(device, directory, name, -1);
+
 	return sNodeMonitorService.NotifyEntryCreatedOrRemoved(B_ENTRY_REMOVED,
 		device, directory, name, node);
 }
@@ -1191,6 +1195,9 @@ notify_entry_moved(dev_t device, ino_t fromDirectory,
 	const char *fromName, ino_t toDirectory, const char *toName,
 	ino_t node)
 {
+	vfs_entry_changed(device, fromDirectory, fromName, -1);
+	vfs_entry_changed(device, toDirectory, toName, node);
+
 	return sNodeMonitorService.NotifyEntryMoved(device, fromDirectory,
 		fromName, toDirectory, toName, node);
 }
@@ -1211,6 +1218,9 @@ status_t
 notify_stat_changed(dev_t device, ino_t directory, ino_t node,
 	uint32 statFields)
 {
+	if ((statFields & B_STAT_MODE) != 0)
+		vfs_node_mode_changed(device, node);
+
 	return sNodeMonitorService.NotifyStatChanged(device, directory, node,
 		statFields);
 }
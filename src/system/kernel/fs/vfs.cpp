@@ -22,10 +22,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <EntryList.h>
 #include <fs_attr.h>
 #include <fs_info.h>
 #include <fs_interface.h>
 #include <fs_volume.h>
+#include <NodeMonitor.h>
 #include <OS.h>
 #include <StorageDefs.h>
 
@@ -110,6 +112,15 @@ const static size_t kMaxPathLength = 65536;
 	// The absolute maximum path length (for getcwd() - this is not depending
 	// on PATH_MAX
 
+const static off_t kDirPositionDetached = (off_t)1 << 62;
+	// Flag in the position of a directory descriptor that has been served
+	// from the entry cache, see dir_read_plus()
+
+const static uint32 kMaxReadDirPlusCount = 128;
+const static uint32 kMaxReadDirPlusAttributes = 8;
+const static size_t kMaxReadDirPlusAttributeSize = 4096;
+	// limits of _user_read_dir_plus()
+
 
 typedef DoublyLinkedList<vnode> VnodeList;
 
@@ -162,6 +173,10 @@ struct fs_mount {
 	KPartition*		partition;
 	VnodeList		vnodes;
 	EntryCache		entry_cache;
+	bool			cache_missing_entries;
+		// whether failed lookups and complete directories may be cached
+	bool			has_read_dir_plus;
+		// whether the file system's vnode ops include read_dir_plus()
 	bool			unmounting;
 	bool			owns_file_device;
 };
@@ -324,6 +339,9 @@ typedef BOpenHashTable<MountHash> MountTable;
 
 #define VNODE_HASH_TABLE_SIZE 1024
 static VnodeTable* sVnodeTable;
+
+static int32 sSearchPermissionChangeCount = 0;
+	// incremented whenever the permissions of a vnode might have changed
 static struct vnode* sRoot;
 
 #define MOUNTS_HASH_TABLE_SIZE 16
@@ -2074,6 +2092,20 @@ entry_ref_to_vnode(dev_t mountID, ino_t directoryID, const char* name,
 }
 
 
+/*!	Lets the entry cache know that the entry \a name in \a dir has been
+	changed through the VFS. \a nodeID is the node the entry refers to now, or
+	-1, if it has been removed or isn't known.
+	The file system is supposed to send node monitoring notifications for the
+	change as well, which will invalidate the cache, too, but we cannot rely
+	on all of them doing so.
+*/
+static void
+entry_cache_invalidate(struct vnode* dir, const char* name, ino_t nodeID)
+{
+	dir->mount->entry_cache.Invalidate(dir->id, name, nodeID);
+}
+
+
 /*!	Looks up the entry with name \a name in the directory represented by \a dir
 	and returns the respective vnode.
 	On success a reference to the vnode is acquired for the caller.
@@ -2084,14 +2116,22 @@ lookup_dir_entry(struct vnode* dir, const char* name, struct vnode** _vnode)
 	ino_t id;
 	bool missing;
 
-	if (dir->mount->entry_cache.Lookup(dir->id, name, id, missing)) {
+	EntryCache& entryCache = dir->mount->entry_cache;
+	if (entryCache.Lookup(dir->id, name, id, missing)) {
 		return missing ? B_ENTRY_NOT_FOUND
 			: get_vnode(dir->device, id, _vnode, true, false);
 	}
 
+	int32 changeCount = entryCache.ChangeCount();
+
 	status_t status = FS_CALL(dir, lookup, name, &id);
-	if (status != B_OK)
+	if (status != B_OK) {
+		// Remember that the entry doesn't exist, unless it has been created
+		// in the meantime.
+		if (status == B_ENTRY_NOT_FOUND && dir->mount->cache_missing_entries)
+			entryCache.AddMissing(dir->id, name, changeCount);
 		return status;
+	}
 
 	// The lookup() hook calls get_vnode() or publish_vnode(), so we do already
 	// have a reference and just need to look the node up.
@@ -2113,6 +2153,170 @@ lookup_dir_entry(struct vnode* dir, const char* name, struct vnode** _vnode)
 }
 
 
+/*!	Remembers whether everybody is allowed to search the directory \a vnode,
+	after the caller has been granted permission to do so. The fast path of
+	vnode_path_to_vnode() can then skip the file system's access() hook for
+	it.
+	Only local file systems are trusted to base their decision on the mode
+	bits alone.
+*/
+static void
+update_search_permission(struct vnode* vnode)
+{
+	if (!vnode->mount->cache_missing_entries)
+		return;
+
+	int32 changeCount = atomic_get(&sSearchPermissionChangeCount);
+
+	bool searchable = true;
+	if (HAS_FS_CALL(vnode, access)) {
+		struct stat stat;
+		if (!HAS_FS_CALL(vnode, read_stat)
+			|| FS_CALL(vnode, read_stat, &stat) != B_OK) {
+			return;
+		}
+
+		const mode_t kSearchableByAll = S_IXUSR | S_IXGRP | S_IXOTH;
+		searchable = (stat.st_mode & kSearchableByAll) == kSearchableByAll;
+	}
+
+	ReadLocker locker(sVnodeLock);
+	AutoLocker<Vnode> nodeLocker(vnode);
+
+	// the permissions might have been changed while we were reading them
+	if (atomic_get(&sSearchPermissionChangeCount) == changeCount)
+		vnode->SetSearchableByAll(searchable);
+}
+
+
+/*!	To be called after the permissions of \a vnode might have been changed.
+*/
+static void
+search_permission_changed(struct vnode* vnode)
+{
+	ReadLocker locker(sVnodeLock);
+	AutoLocker<Vnode> nodeLocker(vnode);
+
+	atomic_add(&sSearchPermissionChangeCount, 1);
+	vnode->ForgetSearchPermission();
+}
+
+
+/*!	Tries to resolve \a path starting at \a vnode using the entry caches
+	only, without taking any references or vnode locks for the intermediate
+	components. The vnode table is read-locked for the whole walk, which keeps
+	the vnodes we pass alive, and the entry caches' global change count is
+	used to validate that no entry has been changed in the meantime.
+
+	Gives up as soon as anything would need the file system: an uncached
+	entry, a directory whose search permission isn't known to be granted to
+	everybody, a symbolic link to be traversed, or a busy vnode.
+
+	\return \c true, if the path could be resolved, either successfully or
+		to a missing entry, in which case \a _status is set accordingly.
+		The caller's reference to \a vnode is left untouched. \c false, if
+		the caller needs to take the slow path.
+*/
+static bool
+vnode_path_to_vnode_fast(struct vnode* vnode, const char* path,
+	bool traverseLeafLink, struct io_context* ioContext,
+	struct vnode** _vnode, ino_t* _parentID, status_t& _status)
+{
+	int32 changeCount = EntryCache::GlobalChangeCount();
+	ino_t lastParentID = vnode->id;
+
+	ReadLocker locker(sVnodeLock);
+
+	while (path[0] != '\0') {
+		// isolate the next path component
+		const char* end = path;
+		while (*end != '\0' && *end != '/')
+			end++;
+
+		size_t length = end - path;
+		if (length >= B_FILE_NAME_LENGTH)
+			return false;
+
+		char name[B_FILE_NAME_LENGTH];
+		memcpy(name, path, length);
+		name[length] = '\0';
+
+		const char* nextPath = end;
+		while (*nextPath == '/')
+			nextPath++;
+
+		if (strcmp(name, "..") == 0) {
+			if (vnode == ioContext->root) {
+				path = nextPath;
+				continue;
+			}
+
+			while (vnode->covers != NULL)
+				vnode = vnode->covers;
+		}
+
+		if (!S_ISDIR(vnode->Type()) || !vnode->IsSearchableByAll())
+			return false;
+
+		struct vnode* nextVnode;
+		if (strcmp(name, ".") == 0)
+			nextVnode = vnode;
+		else {
+			ino_t id;
+			bool missing;
+			if (!vnode->mount->entry_cache.Lookup(vnode->id, name, id,
+					missing)) {
+				return false;
+			}
+
+			if (missing) {
+				if (EntryCache::GlobalChangeCount() != changeCount)
+					return false;
+
+				_status = B_ENTRY_NOT_FOUND;
+				return true;
+			}
+
+			nextVnode = lookup_vnode(vnode->device, id);
+			if (nextVnode == NULL || nextVnode->IsBusy())
+				return false;
+		}
+
+		if (S_ISLNK(nextVnode->Type())
+			&& (traverseLeafLink || nextPath[0] != '\0')) {
+			return false;
+		}
+
+		lastParentID = vnode->id;
+		vnode = nextVnode;
+
+		while (vnode->covered_by != NULL)
+			vnode = vnode->covered_by;
+
+		path = nextPath;
+	}
+
+	// get a reference to the node we found
+	AutoLocker<Vnode> nodeLocker(vnode);
+
+	if (vnode->IsBusy() || EntryCache::GlobalChangeCount() != changeCount)
+		return false;
+
+	if (vnode->ref_count == 0) {
+		// this vnode has been unused before
+		vnode_used(vnode);
+	}
+	inc_vnode_ref_count(vnode);
+
+	*_vnode = vnode;
+	if (_parentID != NULL)
+		*_parentID = lastParentID;
+
+	_status = B_OK;
+	return true;
+}
+
+
 /*!	Returns the vnode for the relative path starting at the specified \a vnode.
 	\a path must not be NULL.
 	If it returns successfully, \a path contains the name of the last path
@@ -2141,6 +2345,12 @@ vnode_path_to_vnode(struct vnode* vnode, char* path, bool traverseLeafLink,
 		return B_ENTRY_NOT_FOUND;
 	}
 
+	if (vnode_path_to_vnode_fast(vnode, path, traverseLeafLink, ioContext,
+			_vnode, _parentID, status)) {
+		put_vnode(vnode);
+		return status;
+	}
+
 	while (true) {
 		struct vnode* nextVnode;
 		char* nextPath;
@@ -2191,6 +2401,9 @@ vnode_path_to_vnode(struct vnode* vnode, char* path, bool traverseLeafLink,
 		if (status == B_OK && HAS_FS_CALL(vnode, access))
 			status = FS_CALL(vnode, access, X_OK);
 
+		if (status == B_OK && !vnode->IsSearchPermissionKnown())
+			update_search_permission(vnode);
+
 		// Tell the filesystem to get the vnode of this path component (if we
 		// got the permission from the call above)
 		if (status == B_OK)
@@ -4574,6 +4787,9 @@ vfs_create_special_node(const char* path, fs_vnode* subVnode, mode_t mode,
 	if (status != B_OK)
 		return status;
 
+	if (leaf != NULL)
+		entry_cache_invalidate(dirNode, leaf, nodeID);
+
 	// lookup the node
 	rw_lock_read_lock(&sVnodeLock);
 	*_createdVnode = lookup_vnode(dirNode->mount->id, nodeID);
@@ -4969,6 +5185,10 @@ vfs_new_io_context(io_context* parentContext, bool purgeCloseOnExec)
 					if (closeOnExec && purgeCloseOnExec)
 						continue;
 
+					// I/O rings belong to the team that created them
+					if (descriptor->type == FDTYPE_IO_RING)
+						continue;
+
 					TFD(InheritFD(context, i, descriptor, parentContext));
 
 					context->fds[i] = descriptor;
@@ -5187,6 +5407,45 @@ vfs_bind_mount_directory(dev_t mountID, ino_t nodeID, dev_t coveredMountID,
 }
 
 
+/*!	Called by the node monitor when a file system reports a changed entry.
+	Invalidates what the mount's entry cache knows about it -- see
+	EntryCache::Invalidate().
+*/
+void
+vfs_entry_changed(dev_t mountID, ino_t directoryID, const char* name,
+	ino_t nodeID)
+{
+	// lookup mount -- the caller is required to make sure that the mount
+	// won't go away
+	MutexLocker locker(sMountMutex);
+	struct fs_mount* mount = find_mount(mountID);
+	if (mount == NULL)
+		return;
+	locker.Unlock();
+
+	mount->entry_cache.Invalidate(directoryID, name, nodeID);
+}
+
+
+/*!	Called by the node monitor when a file system reports that the mode of
+	a node has been changed.
+*/
+void
+vfs_node_mode_changed(dev_t mountID, ino_t nodeID)
+{
+	ReadLocker locker(sVnodeLock);
+
+	struct vnode* vnode = lookup_vnode(mountID, nodeID);
+	if (vnode == NULL)
+		return;
+
+	AutoLocker<Vnode> nodeLocker(vnode);
+
+	atomic_add(&sSearchPermissionChangeCount, 1);
+	vnode->ForgetSearchPermission();
+}
+
+
 int
 vfs_getrlimit(int resource, struct rlimit* rlp)
 {
@@ -5418,6 +5677,8 @@ create_vnode(struct vnode* directory, const char* name, int openMode,
 
 	// the node has been created successfully
 
+	entry_cache_invalidate(directory, name, newID);
+
 	rw_lock_read_lock(&sVnodeLock);
 	vnode = lookup_vnode(directory->device, newID);
 	rw_lock_read_unlock(&sVnodeLock);
@@ -5441,6 +5702,7 @@ create_vnode(struct vnode* directory, const char* name, int openMode,
 	put_vnode(vnode);
 
 	FS_CALL(directory, unlink, name);
+	entry_cache_invalidate(directory, name, -1);
 
 	return status;
 }
@@ -5805,9 +6067,11 @@ dir_create_entry_ref(dev_t mountID, ino_t parentID, const char* name, int perms,
 	if (status != B_OK)
 		return status;
 
-	if (HAS_FS_CALL(vnode, create_dir))
+	if (HAS_FS_CALL(vnode, create_dir)) {
 		status = FS_CALL(vnode, create_dir, name, perms);
-	else
+		if (status == B_OK)
+			entry_cache_invalidate(vnode, name, -1);
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 	put_vnode(vnode);
@@ -5831,6 +6095,8 @@ dir_create(int fd, char* path, int perms, bool kernel)
 
 	if (HAS_FS_CALL(vnode, create_dir)) {
 		status = FS_CALL(vnode, create_dir, filename, perms);
+		if (status == B_OK)
+			entry_cache_invalidate(vnode, filename, -1);
 	} else
 		status = B_READ_ONLY_DEVICE;
 
@@ -5925,15 +6191,6 @@ dir_free_fd(struct file_descriptor* descriptor)
 }
 
 
-static status_t
-dir_read(struct io_context* ioContext, struct file_descriptor* descriptor,
-	struct dirent* buffer, size_t bufferSize, uint32* _count)
-{
-	return dir_read(ioContext, descriptor->u.vnode, descriptor->cookie, buffer,
-		bufferSize, _count);
-}
-
-
 static status_t
 fix_dirent(struct vnode* parent, struct dirent* entry,
 	struct io_context* ioContext)
@@ -5966,6 +6223,22 @@ fix_dirent(struct vnode* parent, struct dirent* entry,
 }
 
 
+static status_t
+fix_dirents(struct vnode* parent, struct dirent* buffer, uint32 count,
+	struct io_context* ioContext)
+{
+	for (uint32 i = 0; i < count; i++) {
+		status_t error = fix_dirent(parent, buffer, ioContext);
+		if (error != B_OK)
+			return error;
+
+		buffer = (struct dirent*)((uint8*)buffer + buffer->d_reclen);
+	}
+
+	return B_OK;
+}
+
+
 static status_t
 dir_read(struct io_context* ioContext, struct vnode* vnode, void* cookie,
 	struct dirent* buffer, size_t bufferSize, uint32* _count)
@@ -5979,16 +6252,186 @@ dir_read(struct io_context* ioContext, struct vnode* vnode, void* cookie,
 		return error;
 
 	// we need to adjust the read dirents
+	return fix_dirents(vnode, buffer, *_count, ioContext);
+}
+
+
+/*!	Reads entries from the file system. If \a stats is not \c NULL and the
+	file system can read the entries' stat data along with them, it is
+	stored there, and \a _statsRead is set to \c true.
+*/
+static status_t
+read_dir_entries(struct vnode* vnode, void* cookie, struct dirent* buffer,
+	size_t bufferSize, struct stat* stats, bool* _statsRead, uint32* _count)
+{
+	if (stats == NULL || !vnode->mount->has_read_dir_plus
+		|| !HAS_FS_CALL(vnode, read_dir_plus)) {
+		if (_statsRead != NULL)
+			*_statsRead = false;
+		return FS_CALL(vnode, read_dir, cookie, buffer, bufferSize, _count);
+	}
+
+	status_t status = FS_CALL(vnode, read_dir_plus, cookie, buffer,
+		bufferSize, stats, _count);
+	if (status != B_OK)
+		return status;
+
+	// fill in the st_dev and st_ino fields like vfs_stat_vnode() does
+	struct dirent* entry = buffer;
+	for (uint32 i = 0; i < *_count; i++) {
+		stats[i].st_dev = entry->d_dev;
+		stats[i].st_ino = entry->d_ino;
+		if (!S_ISBLK(stats[i].st_mode) && !S_ISCHR(stats[i].st_mode))
+			stats[i].st_rdev = -1;
+
+		entry = (struct dirent*)((uint8*)entry + entry->d_reclen);
+	}
+
+	*_statsRead = true;
+	return B_OK;
+}
+
+
+/*!	Reads the directory of \a descriptor like dir_read() above, but lets
+	the entry cache remember the contents of directories that are read from
+	start to end, and serves completely cached directories from memory.
+
+	The descriptor's position is the index of the next entry to read. When
+	entries have been served from memory, kDirPositionDetached is set, as the
+	file system's cookie doesn't match the position anymore.
+
+	If \a stats is not \c NULL, the file system is asked to read the stat
+	data of the entries, too; see read_dir_entries().
+*/
+static status_t
+dir_read_plus(struct io_context* ioContext,
+	struct file_descriptor* descriptor, struct dirent* buffer,
+	size_t bufferSize, struct stat* stats, bool* _statsRead, uint32* _count)
+{
+	struct vnode* vnode = descriptor->u.vnode;
+
+	if (_statsRead != NULL)
+		*_statsRead = false;
+
+	if (!HAS_FS_CALL(vnode, read_dir))
+		return B_UNSUPPORTED;
+
+	if (!vnode->mount->cache_missing_entries
+		|| !HAS_FS_CALL(vnode, rewind_dir)) {
+		status_t status = read_dir_entries(vnode, descriptor->cookie, buffer,
+			bufferSize, stats, _statsRead, _count);
+		if (status != B_OK)
+			return status;
+
+		return fix_dirents(vnode, buffer, *_count, ioContext);
+	}
+
+	EntryCache& entryCache = vnode->mount->entry_cache;
+	uint32 index = (uint32)(descriptor->pos & ~kDirPositionDetached);
+
 	uint32 count = *_count;
-	for (uint32 i = 0; i < count; i++) {
-		error = fix_dirent(vnode, buffer, ioContext);
-		if (error != B_OK)
-			return error;
+	status_t status = entryCache.ReadDirectory(vnode->id, vnode->device, index,
+		buffer, bufferSize, count);
+	if (status == B_OK) {
+		descriptor->pos = (index + count) | kDirPositionDetached;
+		*_count = count;
+		return fix_dirents(vnode, buffer, count, ioContext);
+	}
+	if (status != B_ENTRY_NOT_FOUND)
+		return status;
 
-		buffer = (struct dirent*)((uint8*)buffer + buffer->d_reclen);
+	if ((descriptor->pos & kDirPositionDetached) != 0) {
+		// The directory has been changed since we read from the cache, move
+		// the file system's cookie to our position.
+		status = FS_CALL(vnode, rewind_dir, descriptor->cookie);
+
+		uint32 skipped = 0;
+		while (status == B_OK && skipped < index) {
+			count = index - skipped;
+			status = FS_CALL(vnode, read_dir, descriptor->cookie, buffer,
+				bufferSize, &count);
+			if (count == 0)
+				break;
+			skipped += count;
+		}
+		if (status != B_OK)
+			return status;
+
+		index = skipped;
+		descriptor->pos = index;
 	}
 
-	return error;
+	if (index == 0)
+		entryCache.StartReadDirectory(vnode->id, descriptor);
+
+	count = *_count;
+	status = read_dir_entries(vnode, descriptor->cookie, buffer, bufferSize,
+		stats, _statsRead, &count);
+	if (status != B_OK)
+		return status;
+
+	if (count > 0)
+		entryCache.AddReadEntries(vnode->id, descriptor, buffer, count);
+	else
+		entryCache.FinishReadDirectory(vnode->id, descriptor);
+
+	descriptor->pos = index + count;
+	*_count = count;
+
+	return fix_dirents(vnode, buffer, count, ioContext);
+}
+
+
+static status_t
+dir_read(struct io_context* ioContext, struct file_descriptor* descriptor,
+	struct dirent* buffer, size_t bufferSize, uint32* _count)
+{
+	return dir_read_plus(ioContext, descriptor, buffer, bufferSize, NULL,
+		NULL, _count);
+}
+
+
+/*!	Reads the attribute \a name of \a vnode into \a attr for
+	_user_read_dir_plus(). Up to \a maxSize bytes of its data are stored
+	directly after the structure.
+*/
+static void
+read_dir_plus_attribute(struct vnode* vnode, const char* name,
+	struct dirent_plus_attr* attr, size_t maxSize)
+{
+	attr->dpa_type = 0;
+	attr->dpa_length = 0;
+	attr->dpa_size = 0;
+
+	if (!HAS_FS_CALL(vnode, open_attr) || !HAS_FS_CALL(vnode, read_attr)
+		|| !HAS_FS_CALL(vnode, read_attr_stat)) {
+		attr->dpa_status = B_UNSUPPORTED;
+		return;
+	}
+
+	void* cookie;
+	status_t status = FS_CALL(vnode, open_attr, name, O_RDONLY, &cookie);
+	if (status == B_OK) {
+		struct stat stat;
+		status = FS_CALL(vnode, read_attr_stat, cookie, &stat);
+		if (status == B_OK) {
+			attr->dpa_type = stat.st_type;
+			attr->dpa_size = stat.st_size;
+
+			size_t length = (size_t)min_c((off_t)maxSize, stat.st_size);
+			if (length > 0) {
+				status = FS_CALL(vnode, read_attr, cookie, 0, attr + 1,
+					&length);
+			}
+			if (status == B_OK)
+				attr->dpa_length = length;
+		}
+
+		FS_CALL(vnode, close_attr, cookie);
+		FS_CALL(vnode, free_attr_cookie, cookie);
+	}
+
+	attr->dpa_status = status;
 }
 
 
@@ -5998,7 +6441,10 @@ dir_rewind(struct file_descriptor* descriptor)
 	struct vnode* vnode = descriptor->u.vnode;
 
 	if (HAS_FS_CALL(vnode, rewind_dir)) {
-		return FS_CALL(vnode, rewind_dir, descriptor->cookie);
+		status_t status = FS_CALL(vnode, rewind_dir, descriptor->cookie);
+		if (status == B_OK)
+			descriptor->pos = 0;
+		return status;
 	}
 
 	return B_UNSUPPORTED;
@@ -6041,9 +6487,11 @@ dir_remove(int fd, char* path, bool kernel)
 	if (status != B_OK)
 		return status;
 
-	if (HAS_FS_CALL(directory, remove_dir))
+	if (HAS_FS_CALL(directory, remove_dir)) {
 		status = FS_CALL(directory, remove_dir, name);
-	else
+		if (status == B_OK)
+			entry_cache_invalidate(directory, name, -1);
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 	put_vnode(directory);
@@ -6346,9 +6794,11 @@ common_create_symlink(int fd, char* path, const char* toPath, int mode,
 	if (status != B_OK)
 		return status;
 
-	if (HAS_FS_CALL(vnode, create_symlink))
+	if (HAS_FS_CALL(vnode, create_symlink)) {
 		status = FS_CALL(vnode, create_symlink, name, toPath, mode);
-	else {
+		if (status == B_OK)
+			entry_cache_invalidate(vnode, name, -1);
+	} else {
 		status = HAS_FS_CALL(vnode, write)
 			? B_UNSUPPORTED : B_READ_ONLY_DEVICE;
 	}
@@ -6386,9 +6836,11 @@ common_create_link(int pathFD, char* path, int toFD, char* toPath,
 		goto err1;
 	}
 
-	if (HAS_FS_CALL(directory, link))
+	if (HAS_FS_CALL(directory, link)) {
 		status = FS_CALL(directory, link, name, vnode);
-	else
+		if (status == B_OK)
+			entry_cache_invalidate(directory, name, vnode->id);
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 err1:
@@ -6414,9 +6866,11 @@ common_unlink(int fd, char* path, bool kernel)
 	if (status < 0)
 		return status;
 
-	if (HAS_FS_CALL(vnode, unlink))
+	if (HAS_FS_CALL(vnode, unlink)) {
 		status = FS_CALL(vnode, unlink, filename);
-	else
+		if (status == B_OK)
+			entry_cache_invalidate(vnode, filename, -1);
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 	put_vnode(vnode);
@@ -6481,9 +6935,13 @@ common_rename(int fd, char* path, int newFD, char* newPath, bool kernel)
 		goto err2;
 	}
 
-	if (HAS_FS_CALL(fromVnode, rename))
+	if (HAS_FS_CALL(fromVnode, rename)) {
 		status = FS_CALL(fromVnode, rename, fromName, toVnode, toName);
-	else
+		if (status == B_OK) {
+			entry_cache_invalidate(fromVnode, fromName, -1);
+			entry_cache_invalidate(toVnode, toName, -1);
+		}
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 err2:
@@ -6524,7 +6982,11 @@ common_write_stat(struct file_descriptor* descriptor, const struct stat* stat,
 	if (!HAS_FS_CALL(vnode, write_stat))
 		return B_READ_ONLY_DEVICE;
 
-	return FS_CALL(vnode, write_stat, stat, statMask);
+	status_t status = FS_CALL(vnode, write_stat, stat, statMask);
+	if (status == B_OK && (statMask & B_STAT_MODE) != 0)
+		search_permission_changed(vnode);
+
+	return status;
 }
 
 
@@ -6561,9 +7023,11 @@ common_path_write_stat(int fd, char* path, bool traverseLeafLink,
 	if (status != B_OK)
 		return status;
 
-	if (HAS_FS_CALL(vnode, write_stat))
+	if (HAS_FS_CALL(vnode, write_stat)) {
 		status = FS_CALL(vnode, write_stat, stat, statMask);
-	else
+		if (status == B_OK && (statMask & B_STAT_MODE) != 0)
+			search_permission_changed(vnode);
+	} else
 		status = B_READ_ONLY_DEVICE;
 
 	put_vnode(vnode);
@@ -7382,6 +7846,8 @@ fs_mount(char* path, const char* device, const char* fsName, uint32 flags,
 	mount->partition = NULL;
 	mount->root_vnode = NULL;
 	mount->covers_vnode = NULL;
+	mount->cache_missing_entries = false;
+	mount->has_read_dir_plus = false;
 	mount->unmounting = false;
 	mount->owns_file_device = false;
 	mount->volume = NULL;
@@ -7526,6 +7992,24 @@ fs_mount(char* path, const char* device, const char* fsName, uint32 flags,
 	}
 	rw_lock_write_unlock(&sVnodeLock);
 
+	// The contents of a shared file system can change without us noticing,
+	// so we can only cache what is not there for local ones. Also, a name
+	// that is not in the entry cache might still be found under a different
+	// case, unless the file system says otherwise.
+	// File systems built before read_dir_plus() was added have shorter vnode
+	// ops, so the hook may only be looked at if the file system says so.
+	if (HAS_FS_MOUNT_CALL(mount, read_fs_info)) {
+		struct fs_info info;
+		memset(&info, 0, sizeof(info));
+		if (FS_MOUNT_CALL(mount, read_fs_info, &info) == B_OK) {
+			mount->cache_missing_entries
+				= (info.flags & (B_FS_IS_SHARED | B_FS_IS_CASE_SENSITIVE))
+					== B_FS_IS_CASE_SENSITIVE;
+			mount->has_read_dir_plus
+				= (info.flags & B_FS_SUPPORTS_READ_DIR_PLUS) != 0;
+		}
+	}
+
 	if (!sRoot) {
 		sRoot = mount->root_vnode;
 		mutex_lock(&sIOContextRootLock);
@@ -9356,8 +9840,10 @@ _user_create_fifo(int fd, const char* userPath, mode_t perms)
 		S_IFIFO | (perms & S_IUMSK), 0, &superVnode, &nodeID);
 
 	// create_special_node() acquired a reference for us that we don't need.
-	if (status == B_OK)
+	if (status == B_OK) {
 		put_vnode(dir->mount->volume, nodeID);
+		entry_cache_invalidate(dir, filename, nodeID);
+	}
 
 	return status;
 }
@@ -9487,6 +9973,173 @@ _user_read_stat(int fd, const char* userPath, bool traverseLink,
 }
 
 
+/*!	Reads the next entries of the directory \a fd like _user_read_dir(),
+	together with their stat data and the given attributes. The records are
+	stored in the format described by BEntryList::GetNextDirentsPlus().
+
+	Only as many entries are read as are guaranteed to fit into the buffer,
+	so that no entry is lost; if not even one fits, \c B_BUFFER_OVERFLOW is
+	returned.
+*/
+ssize_t
+_user_read_dir_plus(int fd, struct dirent_plus* userBuffer, size_t bufferSize,
+	uint32 maxCount, const char* const* userAttributes, uint32 attributeCount,
+	size_t maxAttributeSize)
+{
+	if (maxCount == 0)
+		return 0;
+
+	if (userBuffer == NULL || !IS_USER_ADDRESS(userBuffer))
+		return B_BAD_ADDRESS;
+	if (attributeCount > kMaxReadDirPlusAttributes)
+		return B_BAD_VALUE;
+
+	if (attributeCount == 0)
+		maxAttributeSize = 0;
+	else if (maxAttributeSize > kMaxReadDirPlusAttributeSize)
+		maxAttributeSize = kMaxReadDirPlusAttributeSize;
+
+	// copy the attribute names
+	char* attributeNames = NULL;
+	if (attributeCount > 0) {
+		const char* userNames[kMaxReadDirPlusAttributes];
+		if (userAttributes == NULL || !IS_USER_ADDRESS(userAttributes)
+			|| user_memcpy(userNames, userAttributes,
+				attributeCount * sizeof(char*)) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+
+		attributeNames = (char*)malloc(attributeCount * B_ATTR_NAME_LENGTH);
+		if (attributeNames == NULL)
+			return B_NO_MEMORY;
+
+		for (uint32 i = 0; i < attributeCount; i++) {
+			if (userNames[i] == NULL || !IS_USER_ADDRESS(userNames[i])
+				|| user_strlcpy(attributeNames + i * B_ATTR_NAME_LENGTH,
+					userNames[i], B_ATTR_NAME_LENGTH) < B_OK) {
+				free(attributeNames);
+				return B_BAD_ADDRESS;
+			}
+		}
+	}
+	MemoryDeleter attributeNamesDeleter(attributeNames);
+
+	// determine how many entries fit into the buffer in the worst case
+	const size_t headerSize = offsetof(struct dirent_plus, dp_dirent);
+	const size_t maxRecordSize = ROUNDUP(headerSize + sizeof(struct dirent)
+			+ B_FILE_NAME_LENGTH, 8)
+		+ attributeCount * ROUNDUP(sizeof(struct dirent_plus_attr)
+			+ maxAttributeSize, 8);
+
+	uint32 count = min_c(maxCount, bufferSize / maxRecordSize);
+	if (count > kMaxReadDirPlusCount)
+		count = kMaxReadDirPlusCount;
+	if (count == 0)
+		return B_BUFFER_OVERFLOW;
+
+	// get the directory
+	io_context* ioContext = get_current_io_context(false);
+	struct file_descriptor* descriptor = get_fd(ioContext, fd);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+	CObjectDeleter<struct file_descriptor> descriptorPutter(descriptor,
+		put_fd);
+
+	if ((descriptor->open_mode & O_DISCONNECTED) != 0)
+		return B_FILE_ERROR;
+	if (descriptor->ops != &sDirectoryOps)
+		return B_NOT_A_DIRECTORY;
+
+	// allocate the buffers
+	size_t direntBufferSize = count * (sizeof(struct dirent)
+		+ B_FILE_NAME_LENGTH);
+	struct dirent* direntBuffer = (struct dirent*)malloc(direntBufferSize);
+	struct stat* stats = (struct stat*)malloc(count * sizeof(struct stat));
+	uint8* recordBuffer = (uint8*)malloc(maxRecordSize);
+	MemoryDeleter direntBufferDeleter(direntBuffer);
+	MemoryDeleter statsDeleter(stats);
+	MemoryDeleter recordBufferDeleter(recordBuffer);
+	if (direntBuffer == NULL || stats == NULL || recordBuffer == NULL)
+		return B_NO_MEMORY;
+
+	// read the entries, and possibly their stat data
+	bool statsRead;
+	status_t status = dir_read_plus(ioContext, descriptor, direntBuffer,
+		direntBufferSize, stats, &statsRead, &count);
+	if (status != B_OK)
+		return status;
+
+	uint8* userRecord = (uint8*)userBuffer;
+	struct dirent* entry = direntBuffer;
+	for (uint32 i = 0; i < count; i++) {
+		struct dirent_plus* record = (struct dirent_plus*)recordBuffer;
+
+		size_t recordLength = ROUNDUP(headerSize + entry->d_reclen, 8);
+		memcpy(&record->dp_dirent, entry, entry->d_reclen);
+		memset(recordBuffer + headerSize + entry->d_reclen, 0,
+			recordLength - headerSize - entry->d_reclen);
+
+		// The file system's stat data can't be used when fix_dirent() has
+		// replaced the node, or when the file system could not stat it.
+		bool needStat = !statsRead || stats[i].st_mode == 0
+			|| stats[i].st_dev != entry->d_dev
+			|| stats[i].st_ino != entry->d_ino;
+
+		struct vnode* vnode = NULL;
+		status = B_OK;
+		if (needStat || attributeCount > 0) {
+			status = get_vnode(entry->d_dev, entry->d_ino, &vnode, true,
+				false);
+		}
+		if (status == B_OK && needStat)
+			status = vfs_stat_vnode(vnode, &stats[i]);
+
+		record->dp_stat_status = status;
+		if (status == B_OK)
+			record->dp_stat = stats[i];
+		else
+			memset(&record->dp_stat, 0, sizeof(struct stat));
+
+		record->dp_attr_offset = recordLength;
+		record->dp_attr_count = attributeCount;
+
+		for (uint32 j = 0; j < attributeCount; j++) {
+			struct dirent_plus_attr* attr
+				= (struct dirent_plus_attr*)(recordBuffer + recordLength);
+			if (vnode != NULL) {
+				read_dir_plus_attribute(vnode,
+					attributeNames + j * B_ATTR_NAME_LENGTH, attr,
+					maxAttributeSize);
+			} else {
+				attr->dpa_status = status;
+				attr->dpa_type = 0;
+				attr->dpa_length = 0;
+				attr->dpa_size = 0;
+			}
+
+			size_t length = sizeof(struct dirent_plus_attr)
+				+ attr->dpa_length;
+			attr->dpa_reclen = ROUNDUP(length, 8);
+			memset((uint8*)attr + length, 0, attr->dpa_reclen - length);
+			recordLength += attr->dpa_reclen;
+		}
+
+		if (vnode != NULL)
+			put_vnode(vnode);
+
+		record->dp_reclen = recordLength;
+
+		if (user_memcpy(userRecord, record, recordLength) != B_OK)
+			return B_BAD_ADDRESS;
+
+		userRecord += recordLength;
+		entry = (struct dirent*)((uint8*)entry + entry->d_reclen);
+	}
+
+	return count;
+}
+
+
 status_t
 _user_write_stat(int fd, const char* userPath, bool traverseLeafLink,
 	const struct stat* userStat, size_t statSize, int statMask)
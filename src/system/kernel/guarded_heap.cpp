@@ -1052,6 +1052,14 @@ slab_init_post_thread()
 }
 
 
+status_t
+_user_get_next_object_cache_info(int32* userCookie,
+	object_cache_info* userInfo, size_t size)
+{
+	return B_ENTRY_NOT_FOUND;
+}
+
+
 #endif	// USE_GUARDED_HEAP_FOR_OBJECT_CACHE
 
 
@@ -40,6 +40,7 @@
 #include <low_resource_manager.h>
 #include <messaging.h>
 #include <Notifications.h>
+#include <numa.h>
 #include <port.h>
 #include <posix/realtime_sem.h>
 #include <posix/xsi_message_queue.h>
@@ -135,6 +136,8 @@ _start(kernel_args *bootKernelArgs, int currentCPU)
 		TRACE("init interrupts\n");
 		int_init(&sKernelArgs);
 
+		TRACE("init NUMA topology\n");
+		numa_init(&sKernelArgs);
 		TRACE("init VM\n");
 		vm_init(&sKernelArgs);
 			// Before vm_init_post_sem() is called, we have to make sure that
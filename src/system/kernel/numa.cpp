@@ -0,0 +1,284 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The NUMA topology: which node each CPU and each physical page belongs to,
+	and how far apart the nodes are. The boot loader reads it from the
+	firmware; the "fake_numa_nodes" kernel setting replaces it with an evenly
+	split topology, which allows testing the NUMA code paths on any machine.
+*/
+
+
+#include <numa.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include <KernelExport.h>
+
+#include <safemode.h>
+#include <smp.h>
+
+
+//#define TRACE_NUMA
+#ifdef TRACE_NUMA
+#	define TRACE(x...) dprintf("numa: " x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+struct node_page_range {
+	phys_addr_t	start;
+	phys_addr_t	end;
+	int32		node;
+};
+
+
+static int32 sNodeCount = 1;
+static node_page_range sPageRanges[MAX_NUMA_MEMORY_RANGES];
+static uint32 sPageRangeCount;
+static uint8 sDistances[MAX_NUMA_NODES][MAX_NUMA_NODES];
+static int32 sNodesByDistance[MAX_NUMA_NODES][MAX_NUMA_NODES];
+static int32 sCPUNodes[SMP_MAX_CPUS];
+
+
+static void
+add_page_range(uint64 start, uint64 size, int32 node)
+{
+	phys_addr_t startPage = start / B_PAGE_SIZE;
+	phys_addr_t endPage = (start + size) / B_PAGE_SIZE;
+	if (startPage >= endPage || sPageRangeCount == MAX_NUMA_MEMORY_RANGES)
+		return;
+
+	// keep the ranges sorted
+	uint32 index = sPageRangeCount;
+	while (index > 0 && sPageRanges[index - 1].start > startPage) {
+		sPageRanges[index] = sPageRanges[index - 1];
+		index--;
+	}
+
+	sPageRanges[index].start = startPage;
+	sPageRanges[index].end = endPage;
+	sPageRanges[index].node = node;
+	sPageRangeCount++;
+}
+
+
+static void
+init_default_distances()
+{
+	for (int32 i = 0; i < sNodeCount; i++) {
+		for (int32 j = 0; j < sNodeCount; j++)
+			sDistances[i][j] = i == j ? NUMA_LOCAL_DISTANCE : 20;
+	}
+}
+
+
+/*!	Splits the physical memory and the CPUs evenly into \a nodeCount nodes.
+*/
+static void
+init_fake_topology(kernel_args* args, int32 nodeCount)
+{
+	sNodeCount = nodeCount;
+	sPageRangeCount = 0;
+
+	uint64 totalSize = 0;
+	for (uint32 i = 0; i < args->num_physical_memory_ranges; i++)
+		totalSize += args->physical_memory_range[i].size;
+
+	uint64 nodeSize = totalSize / nodeCount;
+	uint64 assigned = 0;
+	for (uint32 i = 0; i < args->num_physical_memory_ranges; i++) {
+		uint64 start = args->physical_memory_range[i].start;
+		uint64 size = args->physical_memory_range[i].size;
+
+		while (size > 0) {
+			int32 node = nodeSize > 0
+				? std::min((int32)(assigned / nodeSize), nodeCount - 1) : 0;
+			uint64 chunk = node == nodeCount - 1
+				? size : std::min(size, (node + 1) * nodeSize - assigned);
+
+			add_page_range(start, chunk, node);
+			start += chunk;
+			size -= chunk;
+			assigned += chunk;
+		}
+	}
+
+	int32 cpuCount = args->num_cpus;
+	for (int32 i = 0; i < cpuCount; i++)
+		sCPUNodes[i] = i * nodeCount / cpuCount;
+
+	init_default_distances();
+}
+
+
+/*!	Takes over the topology the boot loader found. Returns \c false, if it
+	is unusable.
+*/
+static bool
+init_firmware_topology(kernel_args* args)
+{
+	if (args->num_numa_nodes < 2 || args->num_numa_nodes > MAX_NUMA_NODES)
+		return false;
+
+	sNodeCount = args->num_numa_nodes;
+
+	for (uint32 i = 0; i < args->num_cpus; i++) {
+		sCPUNodes[i] = args->cpu_numa_node[i];
+		if (sCPUNodes[i] >= sNodeCount)
+			return false;
+	}
+
+	sPageRangeCount = 0;
+	for (uint32 i = 0; i < args->num_numa_memory_ranges
+			&& i < MAX_NUMA_MEMORY_RANGES; i++) {
+		const numa_memory_range& range = args->numa_memory_range[i];
+		if ((int32)range.node >= sNodeCount)
+			return false;
+		add_page_range(range.start, range.size, range.node);
+	}
+
+	if (sPageRangeCount == 0)
+		return false;
+
+	// sanity check the distances
+	bool valid = true;
+	for (int32 i = 0; i < sNodeCount; i++) {
+		for (int32 j = 0; j < sNodeCount; j++) {
+			uint8 distance = args->numa_distance[i][j];
+			if ((i == j) != (distance == NUMA_LOCAL_DISTANCE)
+				|| distance < NUMA_LOCAL_DISTANCE) {
+				valid = false;
+			}
+			sDistances[i][j] = distance;
+		}
+	}
+
+	if (!valid) {
+		dprintf("numa: ignoring invalid node distances\n");
+		init_default_distances();
+	}
+
+	return true;
+}
+
+
+static void
+init_nodes_by_distance()
+{
+	for (int32 node = 0; node < sNodeCount; node++) {
+		int32* order = sNodesByDistance[node];
+		for (int32 i = 0; i < sNodeCount; i++) {
+			// insertion sort, ties are broken by the node index
+			int32 index = i;
+			while (index > 0
+				&& sDistances[node][order[index - 1]] > sDistances[node][i]) {
+				order[index] = order[index - 1];
+				index--;
+			}
+			order[index] = i;
+		}
+	}
+}
+
+
+// #pragma mark -
+
+
+status_t
+numa_init(kernel_args* args)
+{
+	char buffer[16];
+	size_t bufferSize = sizeof(buffer);
+	int32 fakeNodeCount = 0;
+	if (get_safemode_option_early(args, "fake_numa_nodes", buffer,
+			&bufferSize) == B_OK) {
+		fakeNodeCount = std::max(1,
+			std::min((int32)strtol(buffer, NULL, 0), (int32)MAX_NUMA_NODES));
+	}
+
+	if (fakeNodeCount > 0)
+		init_fake_topology(args, fakeNodeCount);
+	else if (!init_firmware_topology(args)) {
+		sNodeCount = 1;
+		sPageRangeCount = 0;
+		for (int32 i = 0; i < SMP_MAX_CPUS; i++)
+			sCPUNodes[i] = 0;
+		init_default_distances();
+	}
+
+	init_nodes_by_distance();
+
+	if (sNodeCount > 1) {
+		dprintf("numa: %" B_PRId32 " nodes%s\n", sNodeCount,
+			fakeNodeCount > 0 ? " (fake)" : "");
+		for (uint32 i = 0; i < sPageRangeCount; i++) {
+			TRACE("  pages %#" B_PRIxPHYSADDR " - %#" B_PRIxPHYSADDR
+				": node %" B_PRId32 "\n", sPageRanges[i].start,
+				sPageRanges[i].end, sPageRanges[i].node);
+		}
+	}
+
+	return B_OK;
+}
+
+
+int32
+numa_node_count(void)
+{
+	return sNodeCount;
+}
+
+
+int32
+numa_cpu_node(int32 cpu)
+{
+	return sCPUNodes[cpu];
+}
+
+
+/*!	Returns the node of the given physical page. Pages outside of the ranges
+	the firmware described belong to the node of the closest range below
+	them.
+*/
+int32
+numa_physical_page_node(phys_addr_t pageNumber)
+{
+	if (sNodeCount == 1 || sPageRangeCount == 0)
+		return 0;
+
+	// find the last range starting at or before the page
+	uint32 lower = 0;
+	uint32 upper = sPageRangeCount;
+	while (lower < upper) {
+		uint32 middle = (lower + upper) / 2;
+		if (sPageRanges[middle].start <= pageNumber)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	return lower > 0 ? sPageRanges[lower - 1].node : sPageRanges[0].node;
+}
+
+
+uint8
+numa_distance(int32 fromNode, int32 toNode)
+{
+	return sDistances[fromNode][toNode];
+}
+
+
+/*!	Returns all nodes ordered by their distance to \a node, starting with
+	\a node itself. The array has numa_node_count() entries.
+*/
+const int32*
+numa_nodes_by_distance(int32 node)
+{
+	return sNodesByDistance[node];
+}
@@ -24,13 +24,16 @@
 #include <AutoDeleter.h>
 
 #include <arch/int.h>
+#include <cpu.h>
 #include <heap.h>
 #include <kernel.h>
 #include <Notifications.h>
 #include <sem.h>
+#include <smp.h>
 #include <syscall_restart.h>
 #include <team.h>
 #include <tracing.h>
+#include <util/atomic.h>
 #include <util/AutoLock.h>
 #include <util/list.h>
 #include <vm/vm.h>
@@ -84,12 +87,19 @@
 //   understanding, the linearization points are annotated with comments.
 // * Ports are reference-counted so it's not a problem when someone still
 //   has a reference to a deleted port.
+//
+// Small messages are not allocated from the heap, but use one of the slots of
+// the port's message ring. Port::ring_free tracks the free slots and is only
+// accessed atomically, so that writers can get a slot and copy the message
+// into it before they lock the port.
 
 
 namespace {
 
 struct port_message : DoublyLinkedListLinkImpl<port_message> {
 	int32				code;
+	int32				ring_slot;
+		// slot in Port::ring, or -1 if allocated from the heap
 	size_t				size;
 	uid_t				sender;
 	gid_t				sender_group;
@@ -99,10 +109,21 @@ struct port_message : DoublyLinkedListLinkImpl<port_message> {
 
 typedef DoublyLinkedList<port_message> MessageList;
 
+struct Port;
+
 } // namespace
 
 
-static void put_port_message(port_message* message);
+static const int32 kPortRingSlots = 8;
+static const size_t kPortRingSlotSize = 512;
+static const size_t kPortRingMessageSize
+	= kPortRingSlotSize - sizeof(port_message);
+
+static const int32 kMaxPortSpinTime = 32;
+	// in microseconds
+
+static void put_port_message(Port& port, port_message* message);
+static void put_port_ring(Port& port);
 
 
 namespace {
@@ -131,6 +152,13 @@ struct Port : public KernelReferenceable {
 		// messages read from port since creation
 	select_info*		select_infos;
 	MessageList			messages;
+	port_message*		ring;
+		// slots for small messages, allocated on first use
+	int32				ring_slots;
+	int32				ring_free;
+		// bitmap of the free slots in ring
+	int32				spin_time;
+		// how long readers spin before they block, in microseconds
 
 	Port(team_id owner, int32 queueLength, char* name)
 		:
@@ -141,7 +169,11 @@ struct Port : public KernelReferenceable {
 		read_count(0),
 		write_count(queueLength),
 		total_count(0),
-		select_infos(NULL)
+		select_infos(NULL),
+		ring(NULL),
+		ring_slots(std::min(queueLength, kPortRingSlots)),
+		ring_free((1 << ring_slots) - 1),
+		spin_time(kMaxPortSpinTime / 4)
 	{
 		// id is initialized when the caller adds the port to the hash table
 
@@ -153,7 +185,8 @@ struct Port : public KernelReferenceable {
 	virtual ~Port()
 	{
 		while (port_message* message = messages.RemoveHead())
-			put_port_message(message);
+			put_port_message(*this, message);
+		put_port_ring(*this);
 
 		free((char*)lock.name);
 		lock.name = NULL;
@@ -544,6 +577,9 @@ _dump_port_info(Port* port)
 	kprintf(" read_count:      %" B_PRIu32 "\n", port->read_count);
 	kprintf(" write_count:     %" B_PRId32 "\n", port->write_count);
 	kprintf(" total count:     %" B_PRId32 "\n", port->total_count);
+	kprintf(" ring:            %p, %" B_PRId32 " slots, free %#" B_PRIx32 "\n",
+		port->ring, port->ring_slots, port->ring_free);
+	kprintf(" spin time:       %" B_PRId32 " us\n", port->spin_time);
 
 	if (!port->messages.IsEmpty()) {
 		kprintf("messages:\n");
@@ -665,8 +701,13 @@ is_port_closed(Port* port)
 
 
 static void
-put_port_message(port_message* message)
+put_port_message(Port& port, port_message* message)
 {
+	if (message->ring_slot >= 0) {
+		atomic_or(&port.ring_free, 1 << message->ring_slot);
+		return;
+	}
+
 	const size_t size = sizeof(port_message) + message->size;
 	free(message);
 
@@ -734,6 +775,7 @@ get_port_message(int32 code, size_t bufferSize, uint32 flags, bigtime_t timeout,
 		port_message* message = (port_message*)malloc(size);
 		if (message != NULL) {
 			message->code = code;
+			message->ring_slot = -1;
 			message->size = bufferSize;
 
 			*_message = message;
@@ -748,6 +790,165 @@ get_port_message(int32 code, size_t bufferSize, uint32 flags, bigtime_t timeout,
 }
 
 
+/*!	Returns a free slot of the port's message ring, or \c NULL if there is
+	none. Doesn't need the port lock, and never waits.
+*/
+static port_message*
+get_ring_message(int32 code, size_t bufferSize, Port& port)
+{
+	if (bufferSize > kPortRingMessageSize || port.ring_slots == 0)
+		return NULL;
+
+	port_message* ring = atomic_pointer_get(&port.ring);
+	if (ring == NULL) {
+		const size_t size = port.ring_slots * kPortRingSlotSize;
+		if (atomic_add(&sTotalSpaceCommited, size) + size > kTotalSpaceLimit) {
+			atomic_add(&sTotalSpaceCommited, -size);
+			return NULL;
+		}
+
+		ring = (port_message*)malloc(size);
+		if (ring == NULL) {
+			atomic_add(&sTotalSpaceCommited, -size);
+			return NULL;
+		}
+
+		port_message* other = atomic_pointer_test_and_set(&port.ring, ring,
+			(port_message*)NULL);
+		if (other != NULL) {
+			// someone else was faster
+			free(ring);
+			atomic_add(&sTotalSpaceCommited, -size);
+			ring = other;
+		}
+	}
+
+	int32 freeSlots;
+	int32 slot;
+	do {
+		freeSlots = atomic_get(&port.ring_free);
+		if (freeSlots == 0)
+			return NULL;
+
+		slot = 0;
+		while ((freeSlots & (1 << slot)) == 0)
+			slot++;
+	} while (atomic_test_and_set(&port.ring_free, freeSlots & ~(1 << slot),
+			freeSlots) != freeSlots);
+
+	port_message* message
+		= (port_message*)((uint8*)ring + slot * kPortRingSlotSize);
+	message->code = code;
+	message->ring_slot = slot;
+	message->size = bufferSize;
+	return message;
+}
+
+
+/*!	Frees the port's message ring. All of its slots must be free.
+*/
+static void
+put_port_ring(Port& port)
+{
+	if (port.ring == NULL)
+		return;
+
+	free(port.ring);
+	port.ring = NULL;
+	atomic_add(&sTotalSpaceCommited, -port.ring_slots * kPortRingSlotSize);
+}
+
+
+/*!	Fills in the sender credentials of the message, and copies its data
+	from \a msgVecs.
+*/
+static status_t
+fill_port_message(port_message* message, const iovec* msgVecs,
+	size_t vecCount, size_t bufferSize, bool userCopy)
+{
+	message->sender = geteuid();
+	message->sender_group = getegid();
+	message->sender_team = team_get_current_team_id();
+
+	size_t offset = 0;
+	for (uint32 i = 0; i < vecCount && bufferSize > 0; i++) {
+		size_t bytes = msgVecs[i].iov_len;
+		if (bytes > bufferSize)
+			bytes = bufferSize;
+
+		if (userCopy) {
+			status_t status = user_memcpy(message->buffer + offset,
+				msgVecs[i].iov_base, bytes);
+			if (status != B_OK)
+				return status;
+		} else
+			memcpy(message->buffer + offset, msgVecs[i].iov_base, bytes);
+
+		bufferSize -= bytes;
+		offset += bytes;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Called with the port locked when a reader would have to wait for a
+	message. Waking up a blocked thread costs a lot more than just waiting
+	a few microseconds for a writer on another CPU, so the reader spins for
+	a short while first. How long adapts to how often that was worth it.
+	Returns \c false if the port can no longer be read from.
+*/
+static bool
+spin_for_message(Port* port, MutexLocker& locker, uint32 flags,
+	bigtime_t timeout)
+{
+	int32 spinTime = atomic_get(&port->spin_time);
+	if (spinTime == 0 || smp_get_num_cpus() == 1)
+		return true;
+
+	if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout < spinTime)
+		return true;
+	if ((flags & B_ABSOLUTE_TIMEOUT) != 0
+		&& timeout - system_time() < spinTime) {
+		return true;
+	}
+
+	locker.Unlock();
+
+	bool arrived = false;
+	bigtime_t end = system_time() + spinTime;
+	while (atomic_get(&port->state) == Port::kActive
+		&& system_time() < end) {
+		if (atomic_get((int32*)&port->read_count) > 0) {
+			arrived = true;
+			break;
+		}
+		cpu_pause();
+	}
+
+	atomic_set(&port->spin_time,
+		arrived ? std::min(spinTime * 2, kMaxPortSpinTime) : spinTime / 2);
+
+	locker.Lock();
+	return port->state == Port::kActive
+		&& (!is_port_closed(port) || !port->messages.IsEmpty());
+}
+
+
+/*!	Called after a reader had to block for \a waitTime until a message
+	arrived. If spinning would have been enough, the reader should spin
+	again next time.
+*/
+static void
+blocked_for_message(Port* port, bigtime_t waitTime)
+{
+	if (waitTime < kMaxPortSpinTime
+		&& atomic_get(&port->spin_time) < waitTime) {
+		atomic_set(&port->spin_time, (int32)waitTime + 1);
+	}
+}
+
+
 /*!	Fills the port_info structure with information from the specified
 	port.
 	The port's lock must be held when called.
@@ -1353,6 +1554,12 @@ _get_port_message_info_etc(port_id id, port_message_info* info,
 		return B_BAD_PORT_ID;
 	}
 
+	if (portRef->read_count == 0
+		&& !spin_for_message(portRef, locker, flags, timeout)) {
+		T(Info(id, 0, 0, 0, B_BAD_PORT_ID));
+		return B_BAD_PORT_ID;
+	}
+
 	while (portRef->read_count == 0) {
 		// We need to wait for a message to appear
 		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
@@ -1364,6 +1571,7 @@ _get_port_message_info_etc(port_id id, port_message_info* info,
 		locker.Unlock();
 
 		// block if no message, or, if B_TIMEOUT flag set, block with timeout
+		bigtime_t waitStart = system_time();
 		status_t status = entry.Wait(flags, timeout);
 
 		if (status != B_OK) {
@@ -1371,6 +1579,8 @@ _get_port_message_info_etc(port_id id, port_message_info* info,
 			return status;
 		}
 
+		blocked_for_message(portRef, system_time() - waitStart);
+
 		// re-lock
 		BReference<Port> newPortRef = get_locked_port(id);
 		if (newPortRef == NULL) {
@@ -1462,6 +1672,12 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 		return B_BAD_PORT_ID;
 	}
 
+	if (portRef->read_count == 0
+		&& !spin_for_message(portRef, locker, flags, timeout)) {
+		T(Read(id, 0, 0, 0, B_BAD_PORT_ID));
+		return B_BAD_PORT_ID;
+	}
+
 	while (portRef->read_count == 0) {
 		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
 			return B_WOULD_BLOCK;
@@ -1473,6 +1689,7 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 		locker.Unlock();
 
 		// block if no message, or, if B_TIMEOUT flag set, block with timeout
+		bigtime_t waitStart = system_time();
 		status_t status = entry.Wait(flags, timeout);
 
 		// re-lock
@@ -1494,6 +1711,8 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 			T(Read(portRef, 0, status));
 			return status;
 		}
+
+		blocked_for_message(portRef, system_time() - waitStart);
 	}
 
 	// determine tail & get the length of the message
@@ -1530,7 +1749,7 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 	size_t size = copy_port_message(message, _code, buffer, bufferSize,
 		userCopy);
 
-	put_port_message(message);
+	put_port_message(*portRef, message);
 	return size;
 }
 
@@ -1580,21 +1799,40 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 	port_message* message = NULL;
 
 	// get the port
-	BReference<Port> portRef = get_locked_port(id);
-	if (portRef == NULL) {
+	BReference<Port> portRef = get_port(id);
+	if (portRef == NULL || atomic_get(&portRef->state) != Port::kActive) {
 		TRACE(("write_port_etc: invalid port_id %ld\n", id));
 		return B_BAD_PORT_ID;
 	}
-	MutexLocker locker(portRef->lock, true);
 
-	if (is_port_closed(portRef)) {
+	// Small messages are copied into a slot of the port's ring before the
+	// port is locked, so that readers and other writers aren't held up by
+	// the copy.
+	message = get_ring_message(msgCode, bufferSize, *portRef);
+	if (message != NULL) {
+		status = fill_port_message(message, msgVecs, vecCount, bufferSize,
+			userCopy);
+		if (status != B_OK) {
+			put_port_message(*portRef, message);
+			return status;
+		}
+	}
+
+	MutexLocker locker(portRef->lock);
+
+	if (portRef->state != Port::kActive || is_port_closed(portRef)) {
 		TRACE(("write_port_etc: port %ld closed\n", id));
+		if (message != NULL)
+			put_port_message(*portRef, message);
 		return B_BAD_PORT_ID;
 	}
 
 	if (portRef->write_count <= 0) {
-		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
+		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0) {
+			if (message != NULL)
+				put_port_message(*portRef, message);
 			return B_WOULD_BLOCK;
+		}
 
 		portRef->write_count--;
 
@@ -1610,6 +1848,8 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 		BReference<Port> newPortRef = get_locked_port(id);
 		if (newPortRef == NULL) {
 			T(Write(id, 0, 0, 0, 0, B_BAD_PORT_ID));
+			if (message != NULL)
+				put_port_message(*portRef, message);
 			return B_BAD_PORT_ID;
 		}
 		locker.SetTo(newPortRef->lock, true);
@@ -1617,6 +1857,8 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 		if (newPortRef != portRef || is_port_closed(portRef)) {
 			// the port is no longer there
 			T(Write(id, 0, 0, 0, 0, B_BAD_PORT_ID));
+			if (message != NULL)
+				put_port_message(*portRef, message);
 			return B_BAD_PORT_ID;
 		}
 
@@ -1625,46 +1867,23 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 	} else
 		portRef->write_count--;
 
-	status = get_port_message(msgCode, bufferSize, flags, timeout,
-		&message, *portRef);
-	if (status != B_OK) {
-		if (status == B_BAD_PORT_ID) {
-			// the port had to be unlocked and is now no longer there
-			T(Write(id, 0, 0, 0, 0, B_BAD_PORT_ID));
-			return B_BAD_PORT_ID;
-		}
-
-		goto error;
-	}
-
-	// sender credentials
-	message->sender = geteuid();
-	message->sender_group = getegid();
-	message->sender_team = team_get_current_team_id();
-
-	if (bufferSize > 0) {
-		size_t offset = 0;
-		for (uint32 i = 0; i < vecCount; i++) {
-			size_t bytes = msgVecs[i].iov_len;
-			if (bytes > bufferSize)
-				bytes = bufferSize;
-
-			if (userCopy) {
-				status_t status = user_memcpy(message->buffer + offset,
-					msgVecs[i].iov_base, bytes);
-				if (status != B_OK) {
-					put_port_message(message);
-					goto error;
-				}
-			} else
-				memcpy(message->buffer + offset, msgVecs[i].iov_base, bytes);
-
-			bufferSize -= bytes;
-			if (bufferSize == 0)
-				break;
+	if (message == NULL) {
+		status = get_port_message(msgCode, bufferSize, flags, timeout,
+			&message, *portRef);
+		if (status != B_OK) {
+			if (status == B_BAD_PORT_ID) {
+				// the port had to be unlocked and is now no longer there
+				T(Write(id, 0, 0, 0, 0, B_BAD_PORT_ID));
+				return B_BAD_PORT_ID;
+			}
 
-			offset += bytes;
+			goto error;
 		}
+
+		status = fill_port_message(message, msgVecs, vecCount, bufferSize,
+			userCopy);
+		if (status != B_OK)
+			goto error;
 	}
 
 	portRef->messages.Add(message);
@@ -1680,6 +1899,9 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 error:
 	// Give up our slot in the queue again, and let someone else
 	// try and fail
+	if (message != NULL)
+		put_port_message(*portRef, message);
+
 	T(Write(id, portRef->read_count, portRef->write_count, 0, 0, status));
 	portRef->write_count++;
 	notify_port_select_events(portRef, B_EVENT_WRITE);
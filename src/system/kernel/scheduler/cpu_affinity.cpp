@@ -0,0 +1,501 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	CPU affinity of threads, and named cpusets that teams can be confined to.
+	The threads of a team only run on the CPUs of the team's cpuset, further
+	restricted by their own affinity. The scheduler gets the result via
+	scheduler_update_thread_cpu_mask().
+*/
+
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <OS.h>
+
+#include <kernel.h>
+#include <kscheduler.h>
+#include <lock.h>
+#include <scheduler_defs.h>
+#include <smp.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <vm/vm.h>
+
+#include "scheduler_thread.h"
+
+
+using namespace Scheduler;
+
+
+struct cpuset_entry {
+	int32		id;			// 0: unused
+	char		name[B_OS_NAME_LENGTH];
+	CPUSet		cpus;
+};
+
+static cpuset_entry sCPUSets[MAX_CPUSETS];
+static int32 sNextCPUSetID = 1;
+static mutex sCPUSetsLock = MUTEX_INITIALIZER("cpusets");
+
+
+/*!	Converts a userland cpuset_t into a CPUSet. Only CPUs that exist are
+	taken over, and at least one of them must be given.
+*/
+static status_t
+copy_cpus_from_user(const void* userCPUs, size_t size, CPUSet& cpus)
+{
+	if (userCPUs == NULL || !IS_USER_ADDRESS(userCPUs))
+		return B_BAD_ADDRESS;
+	if (size == 0)
+		return B_BAD_VALUE;
+
+	cpuset_t set;
+	memset(&set, 0, sizeof(set));
+	if (user_memcpy(&set, userCPUs, std::min(size, sizeof(set))) != B_OK)
+		return B_BAD_ADDRESS;
+
+	cpus.ClearAll();
+
+	bool empty = true;
+	int32 cpuCount = std::min(smp_get_num_cpus(), (int32)CPU_SETSIZE);
+	for (int32 i = 0; i < cpuCount; i++) {
+		if (CPU_ISSET(i, &set)) {
+			cpus.SetBit(i);
+			empty = false;
+		}
+	}
+
+	return empty ? B_BAD_VALUE : B_OK;
+}
+
+
+static status_t
+copy_cpus_to_user(void* userCPUs, size_t size, const CPUSet& cpus)
+{
+	if (userCPUs == NULL || !IS_USER_ADDRESS(userCPUs))
+		return B_BAD_ADDRESS;
+
+	int32 cpuCount = std::min(smp_get_num_cpus(), (int32)CPU_SETSIZE);
+	if (size < ROUNDUP(cpuCount, 32) / 8)
+		return B_BAD_VALUE;
+
+	cpuset_t set;
+	CPU_ZERO(&set);
+	for (int32 i = 0; i < cpuCount; i++) {
+		if (cpus.GetBit(i))
+			CPU_SET(i, &set);
+	}
+
+	if (user_memcpy(userCPUs, &set, std::min(size, sizeof(set))) != B_OK)
+		return B_BAD_ADDRESS;
+
+	return B_OK;
+}
+
+
+static status_t
+copy_name_from_user(const char* userName, char* name)
+{
+	if (userName == NULL || !IS_USER_ADDRESS(userName)
+		|| user_strlcpy(name, userName, B_OS_NAME_LENGTH) < B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return name[0] != '\0' ? B_OK : B_BAD_VALUE;
+}
+
+
+static bool
+may_change_team(Team* team)
+{
+	uid_t uid = geteuid();
+	return team != team_get_kernel_team()
+		&& (uid == 0 || uid == team->effective_uid);
+}
+
+
+/*!	The caller must hold \c sCPUSetsLock.
+*/
+static cpuset_entry*
+lookup_cpuset(int32 id)
+{
+	if (id <= 0)
+		return NULL;
+
+	for (int32 i = 0; i < MAX_CPUSETS; i++) {
+		if (sCPUSets[i].id == id)
+			return &sCPUSets[i];
+	}
+
+	return NULL;
+}
+
+
+/*!	The caller must hold \c sCPUSetsLock.
+*/
+static cpuset_entry*
+lookup_cpuset(const char* name)
+{
+	for (int32 i = 0; i < MAX_CPUSETS; i++) {
+		if (sCPUSets[i].id > 0 && strcmp(sCPUSets[i].name, name) == 0)
+			return &sCPUSets[i];
+	}
+
+	return NULL;
+}
+
+
+/*!	Confines the team to the given cpuset, or releases it, if \a id is -1.
+	The caller must hold the team lock.
+*/
+static void
+set_team_cpuset(Team* team, int32 id, const CPUSet* cpus)
+{
+	team->cpuset = id;
+	if (cpus != NULL)
+		team->cpumask = *cpus;
+	else
+		team->cpumask.SetAll();
+
+	for (Thread* thread = team->thread_list; thread != NULL;
+			thread = thread->team_next) {
+		ThreadLocker threadLocker(thread);
+		scheduler_update_thread_cpu_mask(thread);
+	}
+}
+
+
+/*!	Applies a changed or deleted cpuset to all teams confined to it.
+	The caller must hold \c sCPUSetsLock.
+*/
+static void
+update_cpuset_teams(int32 id, const CPUSet* cpus)
+{
+	TeamListIterator iterator;
+	while (Team* team = iterator.Next()) {
+		BReference<Team> teamReference(team, true);
+		TeamLocker teamLocker(team);
+
+		if (team->cpuset == id)
+			set_team_cpuset(team, cpus != NULL ? id : -1, cpus);
+	}
+}
+
+
+static void
+fill_cpuset_info(const cpuset_entry& entry, cpuset_info& info)
+{
+	info.id = entry.id;
+	strlcpy(info.name, entry.name, sizeof(info.name));
+
+	CPU_ZERO(&info.cpus);
+	int32 cpuCount = std::min(smp_get_num_cpus(), (int32)CPU_SETSIZE);
+	for (int32 i = 0; i < cpuCount; i++) {
+		if (entry.cpus.GetBit(i))
+			CPU_SET(i, &info.cpus);
+	}
+
+	info.team_count = 0;
+
+	TeamListIterator iterator;
+	while (Team* team = iterator.Next()) {
+		BReference<Team> teamReference(team, true);
+		TeamLocker teamLocker(team);
+
+		if (team->cpuset == entry.id)
+			info.team_count++;
+	}
+}
+
+
+// #pragma mark - syscalls
+
+
+status_t
+_user_set_thread_affinity(thread_id threadID, const void* userCPUs,
+	size_t size)
+{
+	CPUSet cpus;
+	status_t status = copy_cpus_from_user(userCPUs, size, cpus);
+	if (status != B_OK)
+		return status;
+
+	Thread* thread = Thread::Get(threadID);
+	if (thread == NULL)
+		return B_BAD_THREAD_ID;
+	BReference<Thread> threadReference(thread, true);
+
+	Team* team = Team::GetAndLock(thread->team->id);
+	if (team == NULL)
+		return B_BAD_THREAD_ID;
+	BReference<Team> teamReference(team, true);
+	TeamLocker teamLocker(team, true);
+
+	if (!may_change_team(team))
+		return B_NOT_ALLOWED;
+
+	ThreadLocker threadLocker(thread);
+	if (thread->team != team)
+		return B_BAD_THREAD_ID;
+
+	thread->cpumask = cpus;
+	scheduler_update_thread_cpu_mask(thread);
+
+	threadLocker.Unlock();
+	teamLocker.Unlock();
+
+	scheduler_reschedule_if_necessary();
+	return B_OK;
+}
+
+
+/*!	Returns the CPUs the thread may run on, taking its team's cpuset into
+	account.
+*/
+status_t
+_user_get_thread_affinity(thread_id threadID, void* userCPUs, size_t size)
+{
+	Thread* thread = Thread::Get(threadID);
+	if (thread == NULL)
+		return B_BAD_THREAD_ID;
+	BReference<Thread> threadReference(thread, true);
+
+	InterruptsSpinLocker schedulerLocker(thread->scheduler_lock);
+	CPUSet cpus = thread->scheduler_data->CPUMask();
+	schedulerLocker.Unlock();
+
+	return copy_cpus_to_user(userCPUs, size, cpus);
+}
+
+
+int32
+_user_create_cpuset(const char* userName, const void* userCPUs, size_t size)
+{
+	if (geteuid() != 0)
+		return B_NOT_ALLOWED;
+
+	char name[B_OS_NAME_LENGTH];
+	status_t status = copy_name_from_user(userName, name);
+	if (status != B_OK)
+		return status;
+
+	CPUSet cpus;
+	status = copy_cpus_from_user(userCPUs, size, cpus);
+	if (status != B_OK)
+		return status;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	if (lookup_cpuset(name) != NULL)
+		return B_FILE_EXISTS;
+
+	for (int32 i = 0; i < MAX_CPUSETS; i++) {
+		cpuset_entry& entry = sCPUSets[i];
+		if (entry.id > 0)
+			continue;
+
+		entry.id = sNextCPUSetID++;
+		strlcpy(entry.name, name, sizeof(entry.name));
+		entry.cpus = cpus;
+		return entry.id;
+	}
+
+	return B_NO_MEMORY;
+}
+
+
+/*!	Deletes the cpuset. Teams confined to it may run on all CPUs again.
+*/
+status_t
+_user_delete_cpuset(int32 id)
+{
+	if (geteuid() != 0)
+		return B_NOT_ALLOWED;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	cpuset_entry* entry = lookup_cpuset(id);
+	if (entry == NULL)
+		return B_BAD_VALUE;
+
+	update_cpuset_teams(id, NULL);
+	entry->id = 0;
+
+	locker.Unlock();
+
+	scheduler_reschedule_if_necessary();
+	return B_OK;
+}
+
+
+int32
+_user_find_cpuset(const char* userName)
+{
+	char name[B_OS_NAME_LENGTH];
+	status_t status = copy_name_from_user(userName, name);
+	if (status != B_OK)
+		return status;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	cpuset_entry* entry = lookup_cpuset(name);
+	return entry != NULL ? entry->id : B_NAME_NOT_FOUND;
+}
+
+
+/*!	Changes the CPUs of the cpuset, and moves the threads of the teams
+	confined to it accordingly.
+*/
+status_t
+_user_set_cpuset_cpus(int32 id, const void* userCPUs, size_t size)
+{
+	if (geteuid() != 0)
+		return B_NOT_ALLOWED;
+
+	CPUSet cpus;
+	status_t status = copy_cpus_from_user(userCPUs, size, cpus);
+	if (status != B_OK)
+		return status;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	cpuset_entry* entry = lookup_cpuset(id);
+	if (entry == NULL)
+		return B_BAD_VALUE;
+
+	entry->cpus = cpus;
+	update_cpuset_teams(id, &cpus);
+
+	locker.Unlock();
+
+	scheduler_reschedule_if_necessary();
+	return B_OK;
+}
+
+
+status_t
+_user_get_cpuset_info(int32 id, cpuset_info* userInfo, size_t size)
+{
+	if (size != sizeof(cpuset_info))
+		return B_BAD_VALUE;
+	if (userInfo == NULL || !IS_USER_ADDRESS(userInfo))
+		return B_BAD_ADDRESS;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	cpuset_entry* entry = lookup_cpuset(id);
+	if (entry == NULL)
+		return B_BAD_VALUE;
+
+	cpuset_info info;
+	fill_cpuset_info(*entry, info);
+
+	locker.Unlock();
+
+	if (user_memcpy(userInfo, &info, sizeof(info)) != B_OK)
+		return B_BAD_ADDRESS;
+
+	return B_OK;
+}
+
+
+status_t
+_user_get_next_cpuset_info(int32* userCookie, cpuset_info* userInfo,
+	size_t size)
+{
+	if (size != sizeof(cpuset_info))
+		return B_BAD_VALUE;
+
+	int32 cookie;
+	if (userCookie == NULL || !IS_USER_ADDRESS(userCookie)
+		|| userInfo == NULL || !IS_USER_ADDRESS(userInfo)
+		|| user_memcpy(&cookie, userCookie, sizeof(cookie)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	if (cookie < 0)
+		return B_BAD_VALUE;
+
+	MutexLocker locker(sCPUSetsLock);
+
+	while (cookie < MAX_CPUSETS && sCPUSets[cookie].id <= 0)
+		cookie++;
+	if (cookie >= MAX_CPUSETS)
+		return B_ENTRY_NOT_FOUND;
+
+	cpuset_info info;
+	fill_cpuset_info(sCPUSets[cookie], info);
+	cookie++;
+
+	locker.Unlock();
+
+	if (user_memcpy(userCookie, &cookie, sizeof(cookie)) != B_OK
+		|| user_memcpy(userInfo, &info, sizeof(info)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Confines the team to the given cpuset, or, if \a id is -1, lets it run
+	on all CPUs again. Only root may change other users' teams, and only
+	root may release a team from its cpuset, or move it to another one;
+	the owner may only confine it. The threads' own affinity can't reach
+	beyond the cpuset either, so a confined team stays confined.
+*/
+status_t
+_user_set_team_cpuset(team_id teamID, int32 id)
+{
+	MutexLocker locker(sCPUSetsLock);
+
+	CPUSet cpus;
+	if (id != -1) {
+		cpuset_entry* entry = lookup_cpuset(id);
+		if (entry == NULL)
+			return B_BAD_VALUE;
+		cpus = entry->cpus;
+	}
+
+	Team* team = Team::GetAndLock(teamID);
+	if (team == NULL)
+		return B_BAD_TEAM_ID;
+	BReference<Team> teamReference(team, true);
+	TeamLocker teamLocker(team, true);
+
+	if (!may_change_team(team))
+		return B_NOT_ALLOWED;
+	if (team->cpuset >= 0 && team->cpuset != id && geteuid() != 0)
+		return B_NOT_ALLOWED;
+
+	set_team_cpuset(team, id, id != -1 ? &cpus : NULL);
+
+	teamLocker.Unlock();
+	locker.Unlock();
+
+	scheduler_reschedule_if_necessary();
+	return B_OK;
+}
+
+
+/*!	Returns the ID of the team's cpuset, or \c B_ENTRY_NOT_FOUND, if the team
+	isn't confined to one.
+*/
+int32
+_user_get_team_cpuset(team_id teamID)
+{
+	Team* team = Team::GetAndLock(teamID);
+	if (team == NULL)
+		return B_BAD_TEAM_ID;
+	BReference<Team> teamReference(team, true);
+	TeamLocker teamLocker(team, true);
+
+	return team->cpuset >= 0 ? team->cpuset : B_ENTRY_NOT_FOUND;
+}
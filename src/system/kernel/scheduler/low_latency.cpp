@@ -35,16 +35,12 @@ static bool
 has_cache_expired(const ThreadData* threadData)
 {
 	SCHEDULER_ENTER_FUNCTION();
-	if (threadData->WentSleepActive() == 0)
-		return false;
-	CoreEntry* core = threadData->Core();
-	bigtime_t activeTime = core->GetActiveTime();
-	return activeTime - threadData->WentSleepActive() > kCacheExpire;
+	return threadData->HasCoreCacheExpired(kCacheExpire);
 }
 
 
 static CoreEntry*
-choose_core(const ThreadData* /* threadData */)
+choose_core(const ThreadData* threadData)
 {
 	SCHEDULER_ENTER_FUNCTION();
 
@@ -68,7 +64,10 @@ choose_core(const ThreadData* /* threadData */)
 	}
 
 	ASSERT(core != NULL);
-	return core;
+
+	// Latency comes first, the home NUMA node only decides between equally
+	// loaded cores.
+	return threadData->PreferHomeNode(core, 0);
 }
 
 
@@ -88,6 +87,10 @@ rebalance(const ThreadData* threadData)
 	coreLocker.Unlock();
 	ASSERT(other != NULL);
 
+	// Leaving the home NUMA node makes memory accesses slower, only do that
+	// if the home node is significantly more loaded.
+	other = threadData->PreferHomeNode(other);
+
 	// Check if the least loaded core is significantly less loaded than
 	// the current one.
 	int32 coreLoad = core->GetLoad();
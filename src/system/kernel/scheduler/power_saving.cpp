@@ -107,6 +107,9 @@ choose_core(const ThreadData* threadData)
 				core = gCoreHighLoadHeap.PeekMinimum();
 			}
 		}
+		coreLocker.Unlock();
+
+		core = threadData->PreferHomeNode(core);
 	}
 
 	ASSERT(core != NULL);
@@ -145,6 +148,8 @@ rebalance(const ThreadData* threadData)
 		coreLocker.Unlock();
 		ASSERT(other != NULL);
 
+		other = threadData->PreferHomeNode(other);
+
 		int32 coreNewLoad = coreLoad - threadLoad;
 		int32 otherNewLoad = other->GetLoad() + threadLoad;
 		return coreNewLoad - otherNewLoad >= kLoadDifference / 2 ? other : core;
@@ -24,6 +24,7 @@
 #include <kscheduler.h>
 #include <listeners.h>
 #include <load_tracking.h>
+#include <numa.h>
 #include <scheduler_defs.h>
 #include <smp.h>
 #include <timer.h>
@@ -66,6 +67,7 @@ spinlock gSchedulerListenersLock = B_SPINLOCK_INITIALIZER;
 static scheduler_mode_operations* sSchedulerModes[] = {
 	&gSchedulerLowLatencyMode,
 	&gSchedulerPowerSavingMode,
+	&gSchedulerThroughputMode,
 };
 
 // Since CPU IDs used internally by the kernel bear no relation to the actual
@@ -217,6 +219,56 @@ scheduler_set_thread_priority(Thread *thread, int32 priority)
 }
 
 
+/*!	Recomputes the CPUs the thread may run on after its own affinity or its
+	team's cpuset has changed, and moves it away from CPUs it may no longer
+	use. The caller must hold the team lock and the thread's lock.
+	If the thread is the current one, the caller has to call
+	scheduler_reschedule_if_necessary() after releasing the locks.
+*/
+void
+scheduler_update_thread_cpu_mask(Thread* thread)
+{
+	ASSERT(are_interrupts_enabled());
+
+	InterruptsSpinLocker _(thread->scheduler_lock);
+	SchedulerModeLocker modeLocker;
+
+	SCHEDULER_ENTER_FUNCTION();
+
+	ThreadData* threadData = thread->scheduler_data;
+	threadData->UpdateCPUMask();
+
+	if (thread->state == B_THREAD_RUNNING) {
+		ASSERT(thread->cpu != NULL);
+		int32 cpu = thread->cpu->cpu_num;
+		if (threadData->IsAllowedOn(cpu))
+			return;
+
+		if (cpu == smp_get_current_cpu())
+			gCPU[cpu].invoke_scheduler = true;
+		else {
+			smp_send_ici(cpu, SMP_MSG_RESCHEDULE, 0, 0, 0, NULL,
+				SMP_MSG_FLAG_ASYNC);
+		}
+		return;
+	}
+
+	if (thread->state != B_THREAD_READY)
+		return;
+
+	// Enqueue the thread again, so that it ends up on a core and a CPU it may
+	// run on.
+	T(RemoveThread(thread));
+
+	// notify listeners
+	NotifySchedulerListeners(&SchedulerListener::ThreadRemovedFromRunQueue,
+		thread);
+
+	if (threadData->Dequeue())
+		enqueue(thread, true);
+}
+
+
 void
 scheduler_reschedule_ici()
 {
@@ -387,9 +439,14 @@ reschedule(int32 nextState)
 		} else
 			nextThreadData = oldThreadData;
 	} else {
-		nextThreadData
-			= cpu->ChooseNextThread(enqueueOldThread ? oldThreadData : NULL,
-				putOldThreadAtBack);
+		if (enqueueOldThread && !oldThreadData->IsAllowedOn(thisCPU)) {
+			// the thread's CPU affinity has changed, it has to move on
+			putOldThreadAtBack = true;
+			nextThreadData = cpu->ChooseNextThread(NULL, true);
+		} else {
+			nextThreadData = cpu->ChooseNextThread(
+				enqueueOldThread ? oldThreadData : NULL, putOldThreadAtBack);
+		}
 
 		// update CPU heap
 		CoreCPUHeapLocker cpuLocker(core);
@@ -518,7 +575,8 @@ status_t
 scheduler_set_operation_mode(scheduler_mode mode)
 {
 	if (mode != SCHEDULER_MODE_LOW_LATENCY
-		&& mode != SCHEDULER_MODE_POWER_SAVING) {
+		&& mode != SCHEDULER_MODE_POWER_SAVING
+		&& mode != SCHEDULER_MODE_THROUGHPUT) {
 		return B_BAD_VALUE;
 	}
 
@@ -663,6 +721,7 @@ init()
 
 	gCoreCount = coreCount;
 	gPackageCount = packageCount;
+	gNodeCount = numa_node_count();
 
 	gCPUEntries = new(std::nothrow) CPUEntry[cpuCount];
 	if (gCPUEntries == NULL)
@@ -682,6 +741,13 @@ init()
 	new(&gCoreLoadHeap) CoreLoadHeap(coreCount);
 	new(&gCoreHighLoadHeap) CoreLoadHeap(coreCount);
 
+	gNodeLoadHeaps = new(std::nothrow) NodeLoadHeap[gNodeCount];
+	if (gNodeLoadHeaps == NULL)
+		return B_NO_MEMORY;
+	ArrayDeleter<NodeLoadHeap> nodeLoadHeapsDeleter(gNodeLoadHeaps);
+	for (int32 i = 0; i < gNodeCount; i++)
+		new(&gNodeLoadHeaps[i]) NodeLoadHeap(coreCount);
+
 	new(&gIdlePackageList) IdlePackageList;
 
 	for (int32 i = 0; i < cpuCount; i++) {
@@ -689,12 +755,13 @@ init()
 		PackageEntry* package = &gPackageEntries[sCPUToPackage[i]];
 
 		package->Init(sCPUToPackage[i]);
-		core->Init(sCPUToCore[i], package);
+		core->Init(sCPUToCore[i], package, numa_cpu_node(i));
 		gCPUEntries[i].Init(i, core);
 
 		core->AddCPU(&gCPUEntries[i]);
 	}
 
+	nodeLoadHeapsDeleter.Detach();
 	packageEntriesDeleter.Detach();
 	coreEntriesDeleter.Detach();
 	cpuEntriesDeleter.Detach();
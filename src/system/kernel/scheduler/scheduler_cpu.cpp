@@ -29,6 +29,9 @@ IdlePackageList gIdlePackageList;
 rw_spinlock gIdlePackageLock = B_RW_SPINLOCK_INITIALIZER;
 int32 gPackageCount;
 
+NodeLoadHeap* gNodeLoadHeaps;
+int32 gNodeCount;
+
 
 }	// namespace Scheduler
 
@@ -232,7 +235,7 @@ CPUEntry::ChooseNextThread(ThreadData* oldThread, bool putAtBack)
 
 	CoreRunQueueLocker coreLocker(fCore);
 
-	ThreadData* sharedThread = fCore->PeekThread();
+	ThreadData* sharedThread = fCore->PeekThread(fCPUNumber);
 	ASSERT(sharedThread != NULL || pinnedThread != NULL || oldThread != NULL);
 
 	int32 sharedPriority = -1;
@@ -417,10 +420,11 @@ CoreEntry::CoreEntry()
 
 
 void
-CoreEntry::Init(int32 id, PackageEntry* package)
+CoreEntry::Init(int32 id, PackageEntry* package, int32 node)
 {
 	fCoreID = id;
 	fPackage = package;
+	fNode = node;
 }
 
 
@@ -459,12 +463,37 @@ CoreEntry::Remove(ThreadData* thread)
 }
 
 
+/*!	Returns the thread with the highest priority in the run queue that may
+	run on the given CPU.
+*/
+ThreadData*
+CoreEntry::PeekThread(int32 cpu) const
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	ThreadData* threadData = fRunQueue.PeekMaximum();
+	if (threadData == NULL || threadData->IsAllowedOn(cpu))
+		return threadData;
+
+	ThreadRunQueue::ConstIterator iterator = fRunQueue.GetConstIterator();
+	while (iterator.HasNext()) {
+		threadData = iterator.Next();
+		if (threadData->IsAllowedOn(cpu))
+			return threadData;
+	}
+
+	return NULL;
+}
+
+
 void
 CoreEntry::AddCPU(CPUEntry* cpu)
 {
 	ASSERT(fCPUCount >= 0);
 	ASSERT(fIdleCPUCount >= 0);
 
+	fCPUSet.SetBit(cpu->ID());
+
 	fIdleCPUCount++;
 	if (fCPUCount++ == 0) {
 		// core has been reenabled
@@ -472,6 +501,7 @@ CoreEntry::AddCPU(CPUEntry* cpu)
 		fCurrentLoad = 0;
 		fHighLoad = false;
 		gCoreLoadHeap.Insert(this, 0);
+		gNodeLoadHeaps[fNode].Insert(this, 0);
 
 		fPackage->AddIdleCore(this);
 	}
@@ -486,6 +516,8 @@ CoreEntry::RemoveCPU(CPUEntry* cpu, ThreadProcessing& threadPostProcessing)
 	ASSERT(fCPUCount > 0);
 	ASSERT(fIdleCPUCount > 0);
 
+	fCPUSet.ClearBit(cpu->ID());
+
 	fIdleCPUCount--;
 	if (--fCPUCount == 0) {
 		// unassign threads
@@ -502,6 +534,10 @@ CoreEntry::RemoveCPU(CPUEntry* cpu, ThreadProcessing& threadPostProcessing)
 			gCoreLoadHeap.RemoveMinimum();
 		}
 
+		gNodeLoadHeaps[fNode].ModifyKey(this, -1);
+		ASSERT(gNodeLoadHeaps[fNode].PeekMinimum() == this);
+		gNodeLoadHeaps[fNode].RemoveMinimum();
+
 		fPackage->RemoveIdleCore(this);
 
 		// get rid of threads
@@ -566,6 +602,8 @@ CoreEntry::_UpdateLoad(bool forceUpdate)
 	if (oldKey == newKey)
 		return;
 
+	gNodeLoadHeaps[fNode].ModifyKey(this, newKey);
+
 	if (newKey > kHighLoad) {
 		if (!fHighLoad) {
 			gCoreLoadHeap.ModifyKey(this, -1);
@@ -597,6 +635,19 @@ CoreEntry::_UpdateLoad(bool forceUpdate)
 }
 
 
+/*!	Returns the least loaded enabled core of the given NUMA node, or \c NULL,
+	if the node has none.
+*/
+/* static */ CoreEntry*
+CoreEntry::GetLeastLoadedCore(int32 node)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	ReadSpinLocker coreLocker(gCoreHeapsLock);
+	return gNodeLoadHeaps[node].PeekMinimum();
+}
+
+
 /* static */ void
 CoreEntry::_UnassignThread(Thread* thread, void* data)
 {
@@ -615,6 +666,15 @@ CoreLoadHeap::CoreLoadHeap(int32 coreCount)
 }
 
 
+NodeLoadHeap::NodeLoadHeap(int32 coreCount)
+	:
+	MinMaxHeap<CoreEntry, int32, MinMaxHeapCompare<int32>,
+		MinMaxHeapMemberGetLink<CoreEntry, int32,
+			&CoreEntry::fNodeLoadHeapLink> >(coreCount)
+{
+}
+
+
 void
 CoreLoadHeap::Dump()
 {
@@ -125,12 +125,16 @@ class CoreEntry : public MinMaxHeapLinkImpl<CoreEntry, int32>,
 public:
 										CoreEntry();
 
-						void			Init(int32 id, PackageEntry* package);
+						void			Init(int32 id, PackageEntry* package,
+											int32 node);
 
 	inline				int32			ID() const	{ return fCoreID; }
 	inline				PackageEntry*	Package() const	{ return fPackage; }
+	inline				int32			Node() const	{ return fNode; }
 	inline				int32			CPUCount() const
 											{ return fCPUCount; }
+	inline				const CPUSet&	CPUMask() const
+											{ return fCPUSet; }
 
 	inline				void			LockCPUHeap();
 	inline				void			UnlockCPUHeap();
@@ -148,6 +152,7 @@ public:
 											int32 priority);
 						void			Remove(ThreadData* thread);
 	inline				ThreadData*		PeekThread() const;
+						ThreadData*		PeekThread(int32 cpu) const;
 
 	inline				bigtime_t		GetActiveTime() const;
 	inline				void			IncreaseActiveTime(
@@ -171,6 +176,7 @@ public:
 												threadPostProcessing);
 
 	static inline		CoreEntry*		GetCore(int32 cpu);
+	static				CoreEntry*		GetLeastLoadedCore(int32 node);
 
 private:
 						void			_UpdateLoad(bool forceUpdate = false);
@@ -180,9 +186,11 @@ private:
 
 						int32			fCoreID;
 						PackageEntry*	fPackage;
+						int32			fNode;
 
 						int32			fCPUCount;
 						int32			fIdleCPUCount;
+						CPUSet			fCPUSet;
 						CPUPriorityHeap	fCPUHeap;
 						spinlock		fCPULock;
 
@@ -200,7 +208,11 @@ private:
 						bigtime_t		fLastLoadUpdate;
 						rw_spinlock		fLoadLock;
 
+						MinMaxHeapLink<CoreEntry, int32>
+										fNodeLoadHeapLink;
+
 						friend class DebugDumper;
+						friend class NodeLoadHeap;
 } CACHE_LINE_ALIGN;
 
 class CoreLoadHeap : public MinMaxHeap<CoreEntry, int32> {
@@ -211,6 +223,17 @@ public:
 						void			Dump();
 };
 
+// Every NUMA node keeps its enabled cores in a heap of its own, sorted by
+// their load, regardless of whether they are in gCoreLoadHeap or
+// gCoreHighLoadHeap. Protected by gCoreHeapsLock, too.
+class NodeLoadHeap : public MinMaxHeap<CoreEntry, int32,
+	MinMaxHeapCompare<int32>,
+	MinMaxHeapMemberGetLink<CoreEntry, int32, &CoreEntry::fNodeLoadHeapLink> > {
+public:
+										NodeLoadHeap() { }
+										NodeLoadHeap(int32 coreCount);
+};
+
 // gPackageEntries are used to decide which core should be woken up from the
 // idle state. When aiming for performance we should use as many packages as
 // possible with as little cores active in each package as possible (so that the
@@ -262,6 +285,9 @@ extern IdlePackageList gIdlePackageList;
 extern rw_spinlock gIdlePackageLock;
 extern int32 gPackageCount;
 
+extern NodeLoadHeap* gNodeLoadHeaps;
+extern int32 gNodeCount;
+
 
 inline void
 CPUEntry::EnterScheduler()
@@ -15,6 +15,19 @@ const int32 kMaximumQuantumLengthsCount	= 20;
 static bigtime_t sMaximumQuantumLengths[kMaximumQuantumLengthsCount];
 
 
+static int32
+count_cpus(const CPUSet& mask)
+{
+	int32 count = 0;
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		if (mask.GetBit(i))
+			count++;
+	}
+	return count;
+}
+
+
 void
 ThreadData::_InitBase()
 {
@@ -44,7 +57,32 @@ ThreadData::_ChooseCore() const
 	SCHEDULER_ENTER_FUNCTION();
 
 	ASSERT(!gSingleCore);
-	return gCurrentMode->choose_core(this);
+	CoreEntry* core = gCurrentMode->choose_core(this);
+	if (!IsAllowedOn(core))
+		core = _ChooseAllowedCore(core);
+	return core;
+}
+
+
+/*!	Returns the least loaded core the thread may run on, or \a fallback if
+	none of its allowed CPUs is enabled.
+*/
+CoreEntry*
+ThreadData::_ChooseAllowedCore(CoreEntry* fallback) const
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	CoreEntry* chosen = NULL;
+	for (int32 i = 0; i < gCoreCount; i++) {
+		CoreEntry* core = &gCoreEntries[i];
+		if (core->CPUCount() == 0 || !IsAllowedOn(core))
+			continue;
+
+		if (chosen == NULL || core->GetLoad() < chosen->GetLoad())
+			chosen = core;
+	}
+
+	return chosen != NULL ? chosen : fallback;
 }
 
 
@@ -58,7 +96,8 @@ ThreadData::_ChooseCPU(CoreEntry* core, bool& rescheduleNeeded) const
 	if (fThread->previous_cpu != NULL) {
 		CPUEntry* previousCPU
 			= CPUEntry::GetCPU(fThread->previous_cpu->cpu_num);
-		if (previousCPU->Core() == core && !fThread->previous_cpu->disabled) {
+		if (previousCPU->Core() == core && !fThread->previous_cpu->disabled
+			&& IsAllowedOn(previousCPU->ID())) {
 			CoreCPUHeapLocker _(core);
 			if (CPUPriorityHeap::GetKey(previousCPU) < threadPriority) {
 				previousCPU->UpdatePriority(threadPriority);
@@ -72,6 +111,9 @@ ThreadData::_ChooseCPU(CoreEntry* core, bool& rescheduleNeeded) const
 	CPUEntry* cpu = core->CPUHeap()->PeekRoot();
 	ASSERT(cpu != NULL);
 
+	if (!IsAllowedOn(cpu->ID()))
+		cpu = _ChooseAllowedCPU(core);
+
 	if (CPUPriorityHeap::GetKey(cpu) < threadPriority) {
 		cpu->UpdatePriority(threadPriority);
 		rescheduleNeeded = true;
@@ -82,6 +124,31 @@ ThreadData::_ChooseCPU(CoreEntry* core, bool& rescheduleNeeded) const
 }
 
 
+/*!	Returns the CPU of the core with the lowest priority thread that the
+	thread may run on. The caller must hold the core's CPU heap lock.
+*/
+CPUEntry*
+ThreadData::_ChooseAllowedCPU(CoreEntry* core) const
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	CPUEntry* chosen = NULL;
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		CPUEntry* cpu = &gCPUEntries[i];
+		if (cpu->Core() != core || gCPU[i].disabled || !IsAllowedOn(i))
+			continue;
+
+		if (chosen == NULL
+			|| CPUPriorityHeap::GetKey(cpu) < CPUPriorityHeap::GetKey(chosen)) {
+			chosen = cpu;
+		}
+	}
+
+	return chosen != NULL ? chosen : core->CPUHeap()->PeekRoot();
+}
+
+
 ThreadData::ThreadData(Thread* thread)
 	:
 	fThread(thread)
@@ -94,6 +161,8 @@ ThreadData::Init()
 {
 	_InitBase();
 	fCore = NULL;
+	fHomeNode = -1;
+	UpdateCPUMask();
 
 	Thread* currentThread = thread_get_current_thread();
 	ThreadData* currentThreadData = currentThread->scheduler_data;
@@ -115,8 +184,11 @@ ThreadData::Init(CoreEntry* core)
 	_InitBase();
 
 	fCore = core;
+	fHomeNode = core->Node();
 	fReady = true;
 	fNeededLoad = 0;
+	fCPUMask.SetAll();
+	fHasCPUMask = false;
 }
 
 
@@ -140,6 +212,17 @@ ThreadData::Dump() const
 	kprintf("\twent_sleep_active:\t%" B_PRId64 "\n", fWentSleepActive);
 	kprintf("\tcore:\t\t\t%" B_PRId32 "\n",
 		fCore != NULL ? fCore->ID() : -1);
+	if (gNodeCount > 1)
+		kprintf("\thome_node:\t\t%" B_PRId32 "\n", fHomeNode);
+	if (fHasCPUMask) {
+		kprintf("\tcpu_mask:\t\t");
+		int32 cpuCount = smp_get_num_cpus();
+		for (int32 i = 0; i < cpuCount; i++) {
+			if (fCPUMask.GetBit(i))
+				kprintf(" %" B_PRId32, i);
+		}
+		kprintf("\n");
+	}
 	if (fCore != NULL && HasCacheExpired())
 		kprintf("\tcache affinity has expired\n");
 }
@@ -164,6 +247,11 @@ ThreadData::ChooseCoreAndCPU(CoreEntry*& targetCore, CPUEntry*& targetCPU)
 	ASSERT(targetCore != NULL);
 	ASSERT(targetCPU != NULL);
 
+	// The memory a thread touches first is allocated on the node it runs on,
+	// so that is where it should stay.
+	if (fHomeNode < 0)
+		fHomeNode = targetCore->Node();
+
 	if (fCore != targetCore) {
 		fLoadMeasurementEpoch = targetCore->LoadMeasurementEpoch() - 1;
 		if (fReady) {
@@ -197,6 +285,49 @@ ThreadData::ComputeQuantum() const
 }
 
 
+/*!	Returns the least loaded core of the thread's home NUMA node instead of
+	\a core, if \a core belongs to another node and the home core's load
+	doesn't exceed that of \a core by more than \a tolerance.
+*/
+CoreEntry*
+ThreadData::PreferHomeNode(CoreEntry* core, int32 tolerance) const
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	if (gNodeCount == 1 || fHomeNode < 0 || core == NULL
+		|| core->Node() == fHomeNode) {
+		return core;
+	}
+
+	CoreEntry* homeCore = CoreEntry::GetLeastLoadedCore(fHomeNode);
+	if (homeCore == NULL
+		|| homeCore->GetLoad() > core->GetLoad() + tolerance) {
+		return core;
+	}
+
+	return homeCore;
+}
+
+
+/*!	Recomputes the CPUs the thread may run on from its own affinity and the
+	cpuset of its team. If the two have no CPU in common, the team's cpuset
+	wins. The caller must hold the team lock and the thread's lock, and,
+	unless the thread is still being created, its scheduler lock.
+*/
+void
+ThreadData::UpdateCPUMask()
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	fCPUMask = fThread->cpumask;
+	fCPUMask.And(fThread->team->cpumask);
+	if (count_cpus(fCPUMask) == 0)
+		fCPUMask = fThread->team->cpumask;
+
+	fHasCPUMask = count_cpus(fCPUMask) < smp_get_num_cpus();
+}
+
+
 void
 ThreadData::UnassignCore(bool running)
 {
@@ -26,8 +26,10 @@ private:
 	inline	int32		_GetMinimalPriority() const;
 
 	inline	CoreEntry*	_ChooseCore() const;
+			CoreEntry*	_ChooseAllowedCore(CoreEntry* fallback) const;
 	inline	CPUEntry*	_ChooseCPU(CoreEntry* core,
 							bool& rescheduleNeeded) const;
+			CPUEntry*	_ChooseAllowedCPU(CoreEntry* core) const;
 
 public:
 						ThreadData(Thread* thread);
@@ -44,6 +46,7 @@ public:
 	inline	bool		IsIdle() const;
 
 	inline	bool		HasCacheExpired() const;
+	inline	bool		HasCoreCacheExpired(bigtime_t cacheExpire) const;
 	inline	CoreEntry*	Rebalance() const;
 
 	inline	int32		GetEffectivePriority() const;
@@ -87,6 +90,15 @@ public:
 	inline	CoreEntry*	Core() const	{ return fCore; }
 			void		UnassignCore(bool running = false);
 
+	inline	int32		HomeNode() const	{ return fHomeNode; }
+			CoreEntry*	PreferHomeNode(CoreEntry* core,
+							int32 tolerance = kLoadDifference) const;
+
+			void		UpdateCPUMask();
+	inline	const CPUSet&	CPUMask() const	{ return fCPUMask; }
+	inline	bool		IsAllowedOn(int32 cpu) const;
+	inline	bool		IsAllowedOn(const CoreEntry* core) const;
+
 	static	void		ComputeQuantumLengths();
 
 private:
@@ -129,6 +141,10 @@ private:
 			uint32		fLoadMeasurementEpoch;
 
 			CoreEntry*	fCore;
+			int32		fHomeNode;
+
+			CPUSet		fCPUMask;
+			bool		fHasCPUMask;
 };
 
 class ThreadProcessing {
@@ -176,13 +192,54 @@ ThreadData::HasCacheExpired() const
 }
 
 
+/*!	Returns whether the thread's core has been active for more than
+	\a cacheExpire since the thread went to sleep, so that its data is
+	likely gone from the core's caches.
+*/
+inline bool
+ThreadData::HasCoreCacheExpired(bigtime_t cacheExpire) const
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	if (fWentSleepActive == 0)
+		return false;
+	return fCore->GetActiveTime() - fWentSleepActive > cacheExpire;
+}
+
+
 inline CoreEntry*
 ThreadData::Rebalance() const
 {
 	SCHEDULER_ENTER_FUNCTION();
 
 	ASSERT(!gSingleCore);
-	return gCurrentMode->rebalance(this);
+	CoreEntry* core = gCurrentMode->rebalance(this);
+	if (!IsAllowedOn(core))
+		core = _ChooseAllowedCore(core);
+	return core;
+}
+
+
+/*!	Returns whether the thread's CPU affinity allows it to run on the given
+	CPU. Pinned threads may run wherever they are pinned to. If none of the
+	allowed CPUs of the thread's core is enabled anymore, any CPU of the core
+	may run it, so that it isn't stuck in the core's run queue.
+*/
+inline bool
+ThreadData::IsAllowedOn(int32 cpu) const
+{
+	if (!fHasCPUMask || fThread->pinned_to_cpu > 0 || fCPUMask.GetBit(cpu))
+		return true;
+	return fCore != NULL && !fCPUMask.Matches(fCore->CPUMask());
+}
+
+
+inline bool
+ThreadData::IsAllowedOn(const CoreEntry* core) const
+{
+	if (!fHasCPUMask || fThread->pinned_to_cpu > 0)
+		return true;
+	return fCPUMask.Matches(core->CPUMask());
 }
 
 
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The throughput mode is meant for servers and batch jobs: the time slices
+	are longer, threads are kept close to their caches as long as possible,
+	and they are only migrated when the imbalance between cores is large.
+	Interrupts are moved away from busy cores, so that the threads running
+	there aren't disturbed.
+*/
+
+
+#include <util/AutoLock.h>
+
+#include "scheduler_common.h"
+#include "scheduler_cpu.h"
+#include "scheduler_modes.h"
+#include "scheduler_profiler.h"
+#include "scheduler_thread.h"
+
+
+using namespace Scheduler;
+
+
+const bigtime_t kCacheExpire = 250000;
+
+
+static void
+switch_to_mode()
+{
+}
+
+
+static void
+set_cpu_enabled(int32 /* cpu */, bool /* enabled */)
+{
+}
+
+
+static bool
+has_cache_expired(const ThreadData* threadData)
+{
+	SCHEDULER_ENTER_FUNCTION();
+	return threadData->HasCoreCacheExpired(kCacheExpire);
+}
+
+
+static CoreEntry*
+choose_core(const ThreadData* threadData)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	// The previous core may still have some of the data of the thread in its
+	// caches. Failing that, an idle core of the same package at least shares
+	// the last level cache with it.
+	CoreEntry* previous = threadData->Core();
+	if (previous != NULL && previous->CPUCount() > 0) {
+		if (previous->GetLoad() + threadData->GetLoad() < kHighLoad)
+			return previous;
+
+		CoreEntry* core = previous->Package()->GetIdleCore();
+		if (core != NULL)
+			return core;
+	}
+
+	if (gNodeCount > 1 && threadData->HomeNode() >= 0) {
+		CoreEntry* core
+			= CoreEntry::GetLeastLoadedCore(threadData->HomeNode());
+		if (core != NULL && core->GetLoad() < kHighLoad)
+			return core;
+	}
+
+	// spread the threads across the packages, so that they have as much
+	// cache for themselves as possible
+	PackageEntry* package = gIdlePackageList.Last();
+	if (package == NULL)
+		package = PackageEntry::GetMostIdlePackage();
+
+	CoreEntry* core = NULL;
+	if (package != NULL)
+		core = package->GetIdleCore();
+
+	if (core == NULL) {
+		ReadSpinLocker coreLocker(gCoreHeapsLock);
+		core = gCoreLoadHeap.PeekMinimum();
+		if (core == NULL)
+			core = gCoreHighLoadHeap.PeekMinimum();
+	}
+
+	ASSERT(core != NULL);
+	return core;
+}
+
+
+static CoreEntry*
+rebalance(const ThreadData* threadData)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	CoreEntry* core = threadData->Core();
+	ASSERT(core != NULL);
+
+	// Each migration costs the thread its caches, which is only worth it if
+	// the core is really overloaded.
+	int32 coreLoad = core->GetLoad();
+	if (coreLoad < kHighLoad)
+		return core;
+
+	ReadSpinLocker coreLocker(gCoreHeapsLock);
+	CoreEntry* other = gCoreLoadHeap.PeekMinimum();
+	if (other == NULL)
+		other = gCoreHighLoadHeap.PeekMinimum();
+	coreLocker.Unlock();
+	ASSERT(other != NULL);
+
+	other = threadData->PreferHomeNode(other);
+
+	int32 otherLoad = other->GetLoad();
+	if (other == core || otherLoad + 2 * kLoadDifference >= coreLoad)
+		return core;
+
+	// Only move the thread if that doesn't just make the other core the
+	// overloaded one.
+	int32 threadLoad = threadData->GetLoad() / core->CPUCount();
+	if (otherLoad + threadLoad >= kHighLoad)
+		return core;
+
+	int32 difference = coreLoad - otherLoad - 2 * kLoadDifference;
+	return difference >= threadLoad ? other : core;
+}
+
+
+static void
+rebalance_irqs(bool idle)
+{
+	SCHEDULER_ENTER_FUNCTION();
+
+	if (idle)
+		return;
+
+	cpu_ent* cpu = get_cpu_struct();
+	CoreEntry* core = CoreEntry::GetCore(cpu->cpu_num);
+	if (core->GetLoad() < kMediumLoad)
+		return;
+
+	ReadSpinLocker coreLocker(gCoreHeapsLock);
+	CoreEntry* other = gCoreLoadHeap.PeekMinimum();
+	coreLocker.Unlock();
+	if (other == NULL || other == core)
+		return;
+	if (other->GetLoad() + kLoadDifference >= core->GetLoad())
+		return;
+
+	int32 newCPU = other->CPUHeap()->PeekRoot()->ID();
+
+	// A busy core gives away all its interrupts that actually cause some
+	// load, not just the heaviest one.
+	const int32 kMaxMovedIRQs = 8;
+	uint32 vectors[kMaxMovedIRQs];
+	int32 count = 0;
+
+	SpinLocker locker(cpu->irqs_lock);
+	irq_assignment* irq = (irq_assignment*)list_get_first_item(&cpu->irqs);
+	while (irq != NULL && count < kMaxMovedIRQs) {
+		if (irq->load >= kLowLoad / 2)
+			vectors[count++] = irq->irq;
+		irq = (irq_assignment*)list_get_next_item(&cpu->irqs, irq);
+	}
+	locker.Unlock();
+
+	for (int32 i = 0; i < count; i++)
+		assign_io_interrupt_to_cpu(vectors[i], newCPU);
+}
+
+
+scheduler_mode_operations gSchedulerThroughputMode = {
+	"throughput",
+
+	5000,
+	1000,
+	{ 2, 4 },
+
+	50000,
+
+	switch_to_mode,
+	set_cpu_enabled,
+	has_cache_expired,
+	choose_core,
+	rebalance,
+	rebalance_irqs,
+};
@@ -10,6 +10,8 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include <util/AutoLock.h>
 #include <vm/vm.h>
 #include <vm/VMAddressSpace.h>
@@ -18,6 +20,10 @@
 #include "slab_private.h"
 
 
+static const size_t kMaxMagazineCapacity = 256;
+static const size_t kMaxMagazineBytes = 16 * 1024;
+
+
 RANGE_MARKER_FUNCTION_BEGIN(SlabObjectCache)
 
 
@@ -91,16 +97,23 @@ ObjectCache::Init(const char* name, size_t objectSize, size_t alignment,
 		this->flags |= CACHE_NO_DEPOT;
 
 	if (!(this->flags & CACHE_NO_DEPOT)) {
-		// Determine usable magazine configuration values if none had been given
+		// Determine usable magazine configuration values if none had been
+		// given. The magazines of such caches may grow under contention, as
+		// long as a magazine holds no more than kMaxMagazineBytes worth of
+		// objects.
+		size_t maxMagazineCapacity = magazineCapacity;
 		if (magazineCapacity == 0) {
 			magazineCapacity = objectSize < 256
 				? 32 : (objectSize < 512 ? 16 : 8);
+			maxMagazineCapacity = std::min(kMaxMagazineCapacity,
+				std::max(magazineCapacity, kMaxMagazineBytes / objectSize));
 		}
 		if (maxMagazineCount == 0)
 			maxMagazineCount = magazineCapacity / 2;
 
 		status_t status = object_depot_init(&depot, magazineCapacity,
-			maxMagazineCount, flags, this, object_cache_return_object_wrapper);
+			maxMagazineCapacity, maxMagazineCount, flags, this,
+			object_cache_return_object_wrapper);
 		if (status != B_OK) {
 			mutex_destroy(&lock);
 			return status;
@@ -9,12 +9,16 @@
 
 #include <slab/ObjectDepot.h>
 
+#include <string.h>
+
 #include <algorithm>
 
 #include <int.h>
+#include <numa.h>
 #include <slab/Slab.h>
 #include <smp.h>
 #include <util/AutoLock.h>
+#include <vm_defs.h>
 
 #include "slab_debug.h"
 #include "slab_private.h"
@@ -39,12 +43,59 @@ public:
 };
 
 
+/*!	The full and empty magazines of a depot are kept on lock-free stacks.
+	To avoid the ABA problem, the head combines the pointer to the top
+	magazine with a generation count that is incremented with every pop.
+	On 64 bit architectures only the lower 48 bits of the pointer are
+	stored, the upper ones are the sign extension of bit 47 for kernel
+	addresses.
+	Magazines are only ever freed with the depot's outer lock write locked,
+	so a pop racing with another one never reads freed memory.
+*/
+struct depot_magazine_stack {
+	int64			head;
+	int32			count;
+};
+
+
+struct depot_node {
+	depot_magazine_stack	full;
+	depot_magazine_stack	empty;
+};
+
+
 struct depot_cpu_store {
 	DepotMagazine*	loaded;
 	DepotMagazine*	previous;
+	int32			node;
+
+	// statistics since the last resize check
+	uint32			interval_exchanges;
+	uint32			interval_contention;
+
+	uint64			hits;
+	uint64			misses;
+	uint64			exchanges;
+	uint64			remote_exchanges;
+	uint64			contention;
 };
 
 
+#if B_HAIKU_64_BIT
+static const uint32 kStackGenerationShift = 48;
+#else
+static const uint32 kStackGenerationShift = 32;
+#endif
+static const uint64 kStackPointerMask
+	= ((uint64)1 << kStackGenerationShift) - 1;
+
+static const uint32 kResizeCheckInterval = 256;
+	// magazine exchanges of a CPU between checks of its contention
+static const uint32 kMaxContentionRatio = 16;
+	// the magazines grow, if more than one in that many exchanges needed to
+	// retry a stack operation
+
+
 RANGE_MARKER_FUNCTION_BEGIN(SlabObjectDepot)
 
 
@@ -96,6 +147,96 @@ DepotMagazine::ContainsObject(void* object) const
 #endif // PARANOID_KERNEL_FREE
 
 
+// #pragma mark - magazine stacks
+
+
+static inline DepotMagazine*
+stack_magazine(int64 head)
+{
+#if B_HAIKU_64_BIT
+	return (DepotMagazine*)(addr_t)((int64)((uint64)head << 16) >> 16);
+#else
+	return (DepotMagazine*)(addr_t)(uint32)head;
+#endif
+}
+
+
+static inline int64
+stack_head(DepotMagazine* magazine, uint64 generation)
+{
+	return (int64)(((uint64)(addr_t)magazine & kStackPointerMask)
+		| (generation << kStackGenerationShift));
+}
+
+
+static inline uint64
+stack_generation(int64 head)
+{
+	return (uint64)head >> kStackGenerationShift;
+}
+
+
+static inline void
+count_contention(depot_cpu_store* store)
+{
+	store->contention++;
+	store->interval_contention++;
+}
+
+
+static void
+push_magazine(depot_magazine_stack& stack, DepotMagazine* magazine,
+	depot_cpu_store* store)
+{
+	while (true) {
+		int64 head = atomic_get64(&stack.head);
+		magazine->next = stack_magazine(head);
+		if (atomic_test_and_set64(&stack.head,
+				stack_head(magazine, stack_generation(head)), head) == head) {
+			break;
+		}
+
+		count_contention(store);
+	}
+
+	atomic_add(&stack.count, 1);
+}
+
+
+static DepotMagazine*
+pop_magazine(depot_magazine_stack& stack, depot_cpu_store* store)
+{
+	while (true) {
+		int64 head = atomic_get64(&stack.head);
+		DepotMagazine* magazine = stack_magazine(head);
+		if (magazine == NULL)
+			return NULL;
+
+		int64 newHead = stack_head(magazine->next,
+			stack_generation(head) + 1);
+		if (atomic_test_and_set64(&stack.head, newHead, head) == head) {
+			atomic_add(&stack.count, -1);
+			return magazine;
+		}
+
+		count_contention(store);
+	}
+}
+
+
+/*!	Detaches all magazines from \a stack. The depot's outer lock must be
+	write locked.
+*/
+static DepotMagazine*
+detach_magazines(depot_magazine_stack& stack)
+{
+	DepotMagazine* magazines = stack_magazine(stack.head);
+	stack.head = stack_head(NULL, 0);
+	stack.count = 0;
+	return magazines;
+}
+
+
 // #pragma mark -
 
 
@@ -131,66 +272,194 @@ empty_magazine(object_depot* depot, DepotMagazine* magazine, uint32 flags)
 }
 
 
-static bool
-exchange_with_full(object_depot* depot, DepotMagazine*& magazine)
+/*!	Counts a magazine exchange of \a store, and requests larger magazines,
+	if the depot's stacks are contended.
+*/
+static void
+count_exchange(object_depot* depot, depot_cpu_store* store)
 {
-	ASSERT(magazine->IsEmpty());
+	store->exchanges++;
+	if (++store->interval_exchanges < kResizeCheckInterval)
+		return;
+
+	if (store->interval_contention * kMaxContentionRatio
+			> store->interval_exchanges
+		&& depot->magazine_capacity < depot->max_magazine_capacity) {
+		atomic_set(&depot->resize_needed, 1);
+	}
+
+	store->interval_exchanges = 0;
+	store->interval_contention = 0;
+}
+
+
+/*!	Pops a full or empty magazine from the stack of the CPU's own node, or,
+	if that one is empty, from the nearest node that has one.
+*/
+static DepotMagazine*
+pop_nearest_magazine(object_depot* depot, depot_cpu_store* store, bool full,
+	bool& _remote)
+{
+	depot_node& node = depot->nodes[store->node];
+	DepotMagazine* magazine = pop_magazine(full ? node.full : node.empty,
+		store);
+	_remote = false;
+	if (magazine != NULL || depot->node_count == 1)
+		return magazine;
+
+	const int32* nodes = numa_nodes_by_distance(store->node);
+	for (int32 i = 0; i < depot->node_count; i++) {
+		if (nodes[i] == store->node)
+			continue;
+
+		depot_node& otherNode = depot->nodes[nodes[i]];
+		magazine = pop_magazine(full ? otherNode.full : otherNode.empty,
+			store);
+		if (magazine != NULL) {
+			_remote = true;
+			return magazine;
+		}
+	}
 
-	SpinLocker _(depot->inner_lock);
+	return NULL;
+}
+
+
+/*!	Replaces the store's empty previous magazine with a full one.
+*/
+static bool
+exchange_with_full(object_depot* depot, depot_cpu_store* store)
+{
+	ASSERT(store->previous->IsEmpty());
 
-	if (depot->full == NULL)
+	bool remote;
+	DepotMagazine* magazine = pop_nearest_magazine(depot, store, true,
+		remote);
+	if (magazine == NULL)
 		return false;
 
-	depot->full_count--;
-	depot->empty_count++;
+	if (remote)
+		store->remote_exchanges++;
 
-	_push(depot->empty, magazine);
-	magazine = _pop(depot->full);
+	push_magazine(depot->nodes[store->node].empty, store->previous, store);
+	store->previous = magazine;
+	count_exchange(depot, store);
 	return true;
 }
 
 
+/*!	Replaces the store's full previous magazine, if any, with an empty one.
+	If the depot already has enough full magazines, the previous one is
+	returned in \a fullMagazine, and has to be emptied by the caller.
+*/
 static bool
-exchange_with_empty(object_depot* depot, DepotMagazine*& magazine,
-	DepotMagazine*& freeMagazine)
+exchange_with_empty(object_depot* depot, depot_cpu_store* store,
+	DepotMagazine*& fullMagazine)
 {
-	ASSERT(magazine == NULL || magazine->IsFull());
-
-	SpinLocker _(depot->inner_lock);
+	ASSERT(store->previous == NULL || store->previous->IsFull());
 
-	if (depot->empty == NULL)
+	bool remote;
+	DepotMagazine* magazine = pop_nearest_magazine(depot, store, false,
+		remote);
+	if (magazine == NULL)
 		return false;
 
-	depot->empty_count--;
-
-	if (magazine != NULL) {
-		if (depot->full_count < depot->max_count) {
-			_push(depot->full, magazine);
-			depot->full_count++;
-			freeMagazine = NULL;
-		} else
-			freeMagazine = magazine;
+	depot_node& node = depot->nodes[store->node];
+	fullMagazine = NULL;
+	if (store->previous != NULL) {
+		if ((size_t)atomic_get(&node.full.count) < depot->max_count)
+			push_magazine(node.full, store->previous, store);
+		else
+			fullMagazine = store->previous;
 	}
 
-	magazine = _pop(depot->empty);
+	store->previous = magazine;
+	count_exchange(depot, store);
 	return true;
 }
 
 
+static inline depot_cpu_store*
+object_depot_cpu(object_depot* depot)
+{
+	return &depot->stores[smp_get_current_cpu()];
+}
+
+
+/*!	Frees all magazines of the depot and returns their objects. The outer
+	lock must be write locked, it will be unlocked when this returns.
+*/
 static void
-push_empty_magazine(object_depot* depot, DepotMagazine* magazine)
+empty_depot(object_depot* depot, WriteLocker& writeLocker, uint32 flags)
 {
-	SpinLocker _(depot->inner_lock);
+	// collect the store magazines
 
-	_push(depot->empty, magazine);
-	depot->empty_count++;
+	DepotMagazine* storeMagazines = NULL;
+
+	int cpuCount = smp_get_num_cpus();
+	for (int i = 0; i < cpuCount; i++) {
+		depot_cpu_store& store = depot->stores[i];
+
+		if (store.loaded) {
+			_push(storeMagazines, store.loaded);
+			store.loaded = NULL;
+		}
+
+		if (store.previous) {
+			_push(storeMagazines, store.previous);
+			store.previous = NULL;
+		}
+	}
+
+	// detach the depot's full and empty magazines
+
+	DepotMagazine* fullMagazines = NULL;
+	DepotMagazine* emptyMagazines = NULL;
+
+	for (int32 i = 0; i < depot->node_count; i++) {
+		DepotMagazine* magazine = detach_magazines(depot->nodes[i].full);
+		while (magazine != NULL)
+			_push(fullMagazines, _pop(magazine));
+
+		magazine = detach_magazines(depot->nodes[i].empty);
+		while (magazine != NULL)
+			_push(emptyMagazines, _pop(magazine));
+	}
+
+	writeLocker.Unlock();
+
+	// free all magazines
+
+	while (storeMagazines != NULL)
+		empty_magazine(depot, _pop(storeMagazines), flags);
+
+	while (fullMagazines != NULL)
+		empty_magazine(depot, _pop(fullMagazines), flags);
+
+	while (emptyMagazines)
+		free_magazine(_pop(emptyMagazines), flags);
 }
 
 
-static inline depot_cpu_store*
-object_depot_cpu(object_depot* depot)
+/*!	Doubles the magazine capacity of the depot, as requested by
+	count_exchange(). As in Bonwick's design, the depot is purged, so that
+	only magazines of the new size are used from now on.
+*/
+static void
+resize_depot(object_depot* depot, uint32 flags)
 {
-	return &depot->stores[smp_get_current_cpu()];
+	WriteLocker writeLocker(depot->outer_lock);
+
+	if (atomic_get_and_set(&depot->resize_needed, 0) == 0
+		|| depot->magazine_capacity >= depot->max_magazine_capacity) {
+		return;
+	}
+
+	depot->magazine_capacity = std::min(depot->magazine_capacity * 2,
+		depot->max_magazine_capacity);
+	depot->resize_count++;
+
+	empty_depot(depot, writeLocker, flags);
 }
 
 
@@ -198,30 +467,48 @@ object_depot_cpu(object_depot* depot)
 
 
 status_t
-object_depot_init(object_depot* depot, size_t capacity, size_t maxCount,
-	uint32 flags, void* cookie, void (*return_object)(object_depot* depot,
-		void* cookie, void* object, uint32 flags))
+object_depot_init(object_depot* depot, size_t capacity, size_t maxCapacity,
+	size_t maxCount, uint32 flags, void* cookie,
+	void (*return_object)(object_depot* depot, void* cookie, void* object,
+		uint32 flags))
 {
-	depot->full = NULL;
-	depot->empty = NULL;
-	depot->full_count = depot->empty_count = 0;
 	depot->max_count = maxCount;
 	depot->magazine_capacity = capacity;
+	depot->max_magazine_capacity = std::max(capacity, maxCapacity);
+	depot->resize_needed = 0;
+	depot->resize_count = 0;
 
 	rw_lock_init(&depot->outer_lock, "object depot");
-	B_INITIALIZE_SPINLOCK(&depot->inner_lock);
+
+	depot->node_count = numa_node_count();
+	depot->nodes = (depot_node*)slab_internal_alloc(
+		sizeof(depot_node) * depot->node_count, flags);
+	if (depot->nodes == NULL) {
+		rw_lock_destroy(&depot->outer_lock);
+		return B_NO_MEMORY;
+	}
+
+	for (int32 i = 0; i < depot->node_count; i++) {
+		depot->nodes[i].full.head = stack_head(NULL, 0);
+		depot->nodes[i].full.count = 0;
+		depot->nodes[i].empty.head = stack_head(NULL, 0);
+		depot->nodes[i].empty.count = 0;
+	}
 
 	int cpuCount = smp_get_num_cpus();
 	depot->stores = (depot_cpu_store*)slab_internal_alloc(
 		sizeof(depot_cpu_store) * cpuCount, flags);
 	if (depot->stores == NULL) {
+		slab_internal_free(depot->nodes, flags);
 		rw_lock_destroy(&depot->outer_lock);
 		return B_NO_MEMORY;
 	}
 
 	for (int i = 0; i < cpuCount; i++) {
-		depot->stores[i].loaded = NULL;
-		depot->stores[i].previous = NULL;
+		memset(&depot->stores[i], 0, sizeof(depot_cpu_store));
+		depot->stores[i].node = numa_cpu_node(i);
+		if (depot->stores[i].node >= depot->node_count)
+			depot->stores[i].node = 0;
 	}
 
 	depot->cookie = cookie;
@@ -237,6 +524,7 @@ object_depot_destroy(object_depot* depot, uint32 flags)
 	object_depot_make_empty(depot, flags);
 
 	slab_internal_free(depot->stores, flags);
+	slab_internal_free(depot->nodes, flags);
 
 	rw_lock_destroy(&depot->outer_lock);
 }
@@ -257,19 +545,25 @@ object_depot_obtain(object_depot* depot)
 	// if it's not empty, or from the previous magazine if it's full
 	// and finally from the Slab if the magazine depot has no full magazines.
 
-	if (store->loaded == NULL)
+	if (store->loaded == NULL) {
+		store->misses++;
 		return NULL;
+	}
 
 	while (true) {
-		if (!store->loaded->IsEmpty())
+		if (!store->loaded->IsEmpty()) {
+			store->hits++;
 			return store->loaded->Pop();
+		}
 
 		if (store->previous
 			&& (store->previous->IsFull()
-				|| exchange_with_full(depot, store->previous))) {
+				|| exchange_with_full(depot, store))) {
 			std::swap(store->previous, store->loaded);
-		} else
+		} else {
+			store->misses++;
 			return NULL;
+		}
 	}
 }
 
@@ -277,6 +571,11 @@ object_depot_obtain(object_depot* depot)
 void
 object_depot_store(object_depot* depot, void* object, uint32 flags)
 {
+	if (atomic_get(&depot->resize_needed) != 0
+		&& (flags & CACHE_DONT_WAIT_FOR_MEMORY) == 0) {
+		resize_depot(depot, flags);
+	}
+
 	ReadLocker readLocker(depot->outer_lock);
 	InterruptsLocker interruptsLocker;
 
@@ -291,22 +590,31 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 		if (store->loaded != NULL && store->loaded->Push(object))
 			return;
 
-		DepotMagazine* freeMagazine = NULL;
+		DepotMagazine* fullMagazine = NULL;
 		if ((store->previous != NULL && store->previous->IsEmpty())
-			|| exchange_with_empty(depot, store->previous, freeMagazine)) {
+			|| exchange_with_empty(depot, store, fullMagazine)) {
 			std::swap(store->loaded, store->previous);
 
-			if (freeMagazine != NULL) {
-				// Free the magazine that didn't have space in the list
+			if (fullMagazine != NULL) {
+				// Return the objects of the magazine that didn't have space
+				// in the list. It might still be referenced by a concurrent
+				// pop_magazine(), so it is kept as an empty one instead of
+				// being freed.
 				interruptsLocker.Unlock();
 				readLocker.Unlock();
 
-				empty_magazine(depot, freeMagazine, flags);
+				for (uint16 i = 0; i < fullMagazine->current_round; i++) {
+					depot->return_object(depot, depot->cookie,
+						fullMagazine->rounds[i], flags);
+				}
+				fullMagazine->current_round = 0;
 
 				readLocker.Lock();
 				interruptsLocker.Lock();
 
 				store = object_depot_cpu(depot);
+				push_magazine(depot->nodes[store->node].empty, fullMagazine,
+					store);
 			}
 		} else {
 			// allocate a new empty magazine
@@ -322,8 +630,8 @@ object_depot_store(object_depot* depot, void* object, uint32 flags)
 			readLocker.Lock();
 			interruptsLocker.Lock();
 
-			push_empty_magazine(depot, magazine);
 			store = object_depot_cpu(depot);
+			push_magazine(depot->nodes[store->node].empty, magazine, store);
 		}
 	}
 }
@@ -333,46 +641,33 @@ void
 object_depot_make_empty(object_depot* depot, uint32 flags)
 {
 	WriteLocker writeLocker(depot->outer_lock);
+	empty_depot(depot, writeLocker, flags);
+}
 
-	// collect the store magazines
 
-	DepotMagazine* storeMagazines = NULL;
+void
+object_depot_get_info(object_depot* depot, object_cache_info* info)
+{
+	ReadLocker readLocker(depot->outer_lock);
 
-	int cpuCount = smp_get_num_cpus();
-	for (int i = 0; i < cpuCount; i++) {
-		depot_cpu_store& store = depot->stores[i];
+	info->magazine_capacity = depot->magazine_capacity;
+	info->max_magazine_capacity = depot->max_magazine_capacity;
+	info->magazine_resizes = depot->resize_count;
 
-		if (store.loaded) {
-			_push(storeMagazines, store.loaded);
-			store.loaded = NULL;
-		}
-
-		if (store.previous) {
-			_push(storeMagazines, store.previous);
-			store.previous = NULL;
-		}
+	for (int32 i = 0; i < depot->node_count; i++) {
+		info->full_magazines += atomic_get(&depot->nodes[i].full.count);
+		info->empty_magazines += atomic_get(&depot->nodes[i].empty.count);
 	}
 
-	// detach the depot's full and empty magazines
-
-	DepotMagazine* fullMagazines = depot->full;
-	depot->full = NULL;
-
-	DepotMagazine* emptyMagazines = depot->empty;
-	depot->empty = NULL;
-
-	writeLocker.Unlock();
-
-	// free all magazines
-
-	while (storeMagazines != NULL)
-		empty_magazine(depot, _pop(storeMagazines), flags);
-
-	while (fullMagazines != NULL)
-		empty_magazine(depot, _pop(fullMagazines), flags);
-
-	while (emptyMagazines)
-		free_magazine(_pop(emptyMagazines), flags);
+	int cpuCount = smp_get_num_cpus();
+	for (int i = 0; i < cpuCount; i++) {
+		const depot_cpu_store& store = depot->stores[i];
+		info->depot_hits += store.hits;
+		info->depot_misses += store.misses;
+		info->magazine_exchanges += store.exchanges;
+		info->remote_exchanges += store.remote_exchanges;
+		info->depot_contention += store.contention;
+	}
 }
 
 
@@ -398,10 +693,13 @@ object_depot_contains_object(object_depot* depot, void* object)
 		}
 	}
 
-	for (DepotMagazine* magazine = depot->full; magazine != NULL;
-			magazine = magazine->next) {
-		if (magazine->ContainsObject(object))
-			return true;
+	for (int32 i = 0; i < depot->node_count; i++) {
+		for (DepotMagazine* magazine
+				= stack_magazine(depot->nodes[i].full.head);
+				magazine != NULL; magazine = magazine->next) {
+			if (magazine->ContainsObject(object))
+				return true;
+		}
 	}
 
 	return false;
@@ -416,17 +714,33 @@ object_depot_contains_object(object_depot* depot, void* object)
 void
 dump_object_depot(object_depot* depot)
 {
-	kprintf("  full:     %p, count %lu\n", depot->full, depot->full_count);
-	kprintf("  empty:    %p, count %lu\n", depot->empty, depot->empty_count);
 	kprintf("  max full: %lu\n", depot->max_count);
-	kprintf("  capacity: %lu\n", depot->magazine_capacity);
+	kprintf("  capacity: %lu (max %lu, %" B_PRIu32 " resizes)\n",
+		depot->magazine_capacity, depot->max_magazine_capacity,
+		depot->resize_count);
+	kprintf("  nodes:\n");
+
+	for (int32 i = 0; i < depot->node_count; i++) {
+		depot_node& node = depot->nodes[i];
+		kprintf("  [%" B_PRId32 "] full:  %p, count %" B_PRId32 "\n", i,
+			stack_magazine(node.full.head), node.full.count);
+		kprintf("      empty: %p, count %" B_PRId32 "\n",
+			stack_magazine(node.empty.head), node.empty.count);
+	}
+
 	kprintf("  stores:\n");
 
 	int cpuCount = smp_get_num_cpus();
 
 	for (int i = 0; i < cpuCount; i++) {
-		kprintf("  [%d] loaded:   %p\n", i, depot->stores[i].loaded);
-		kprintf("      previous: %p\n", depot->stores[i].previous);
+		depot_cpu_store& store = depot->stores[i];
+		kprintf("  [%d] loaded:   %p\n", i, store.loaded);
+		kprintf("      previous: %p\n", store.previous);
+		kprintf("      node %" B_PRId32 ", hits %" B_PRIu64 ", misses %"
+			B_PRIu64 ", exchanges %" B_PRIu64 " (%" B_PRIu64 " remote), "
+			"contention %" B_PRIu64 "\n", store.node, store.hits,
+			store.misses, store.exchanges, store.remote_exchanges,
+			store.contention);
 	}
 }
 
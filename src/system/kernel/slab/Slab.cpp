@@ -27,6 +27,7 @@
 #include <util/DoublyLinkedList.h>
 #include <vm/vm.h>
 #include <vm/VMAddressSpace.h>
+#include <vm_defs.h>
 
 #include "HashedObjectCache.h"
 #include "MemoryManager.h"
@@ -1425,6 +1426,62 @@ slab_init_post_thread()
 }
 
 
+// #pragma mark - syscalls
+
+
+status_t
+_user_get_next_object_cache_info(int32* userCookie,
+	object_cache_info* userInfo, size_t size)
+{
+	if (size != sizeof(object_cache_info))
+		return B_BAD_VALUE;
+	if (userCookie == NULL || !IS_USER_ADDRESS(userCookie)
+		|| userInfo == NULL || !IS_USER_ADDRESS(userInfo)) {
+		return B_BAD_ADDRESS;
+	}
+
+	int32 cookie;
+	if (user_memcpy(&cookie, userCookie, sizeof(cookie)) != B_OK)
+		return B_BAD_ADDRESS;
+	if (cookie < 0)
+		return B_BAD_VALUE;
+
+	object_cache_info info = {};
+
+	// The cache can't go away while it's in the list. Its counters are read
+	// without its lock, as the debugger commands do.
+	MutexLocker cacheListLocker(sObjectCacheListLock);
+
+	ObjectCache* cache = sObjectCaches.Head();
+	for (int32 i = 0; cache != NULL && i < cookie; i++)
+		cache = sObjectCaches.GetNext(cache);
+	if (cache == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	strlcpy(info.name, cache->name, sizeof(info.name));
+	info.object_size = cache->object_size;
+	info.slab_size = cache->slab_size;
+	info.usage = cache->usage;
+	info.total_objects = cache->total_objects;
+	info.used_objects = cache->used_count;
+	info.empty_slabs = cache->empty_count;
+	info.flags = cache->flags;
+
+	if ((cache->flags & CACHE_NO_DEPOT) == 0)
+		object_depot_get_info(&cache->depot, &info);
+
+	cacheListLocker.Unlock();
+
+	cookie++;
+	if (user_memcpy(userCookie, &cookie, sizeof(cookie)) != B_OK
+		|| user_memcpy(userInfo, &info, sizeof(info)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return B_OK;
+}
+
+
 RANGE_MARKER_FUNCTION_END(Slab)
 
 
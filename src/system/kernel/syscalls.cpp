@@ -25,6 +25,7 @@
 #include <elf.h>
 #include <frame_buffer_console.h>
 #include <fs/fd.h>
+#include <fs/io_ring.h>
 #include <fs/node_monitor.h>
 #include <generic_syscall.h>
 #include <int.h>
@@ -41,6 +42,7 @@
 #include <real_time_clock.h>
 #include <safemode.h>
 #include <sem.h>
+#include <slab/Slab.h>
 #include <sys/resource.h>
 #include <system_profiler.h>
 #include <thread.h>
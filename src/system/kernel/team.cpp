@@ -441,6 +441,9 @@ Team::Team(team_id id, bool kernel)
 	fArgs[0] = '\0';
 	num_threads = 0;
 	io_context = NULL;
+	io_class = IO_CLASS_NORMAL;
+	cpuset = -1;
+	cpumask.SetAll();
 	address_space = NULL;
 	realtime_sem_context = NULL;
 	xsi_sem_context = NULL;
@@ -1731,6 +1734,10 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	// inherit the parent's user/group
 	inherit_parent_user_and_group(team, parent);
 
+	team->io_class = parent->io_class;
+	team->cpuset = parent->cpuset;
+	team->cpumask = parent->cpumask;
+
  	InterruptsSpinLocker teamsLocker(sTeamHashLock);
 
 	sTeamHash.Insert(team);
@@ -2068,6 +2075,10 @@ fork_team(void)
 	// Inherit the parent's user/group.
 	inherit_parent_user_and_group(team, parentTeam);
 
+	team->io_class = parentTeam->io_class;
+	team->cpuset = parentTeam->cpuset;
+	team->cpumask = parentTeam->cpumask;
+
 	// inherit signal handlers
 	team->InheritSignalActions(parentTeam);
 
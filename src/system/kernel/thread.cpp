@@ -170,6 +170,7 @@ Thread::Thread(const char* name, thread_id threadID, struct cpu_ent* cpu)
 	team_next(NULL),
 	priority(-1),
 	io_priority(-1),
+	io_class(-1),
 	cpu(cpu),
 	previous_cpu(NULL),
 	pinned_to_cpu(0),
@@ -202,6 +203,8 @@ Thread::Thread(const char* name, thread_id threadID, struct cpu_ent* cpu)
 	id = threadID >= 0 ? threadID : allocate_thread_id();
 	visible = false;
 
+	cpumask.SetAll();
+
 	// init locks
 	char lockName[32];
 	snprintf(lockName, sizeof(lockName), "Thread:%" B_PRId32, id);
@@ -985,9 +988,18 @@ thread_create_thread(const ThreadCreationAttributes& attributes, bool kernel)
 				return B_NO_MEMORY;
 		}
 
+		Thread* currentThread = thread_get_current_thread();
+
+		// Userland threads inherit the CPU affinity of the thread creating
+		// them, be it in the same or in a new team.
+		if (currentThread != NULL
+			&& currentThread->team != team_get_kernel_team()) {
+			ThreadLocker currentThreadLocker(currentThread);
+			thread->cpumask = currentThread->cpumask;
+		}
+
 		// If the new thread belongs to the same team as the current thread, it
 		// may inherit some of the thread debug flags.
-		Thread* currentThread = thread_get_current_thread();
 		if (currentThread != NULL && currentThread->team == team) {
 			// inherit all user flags...
 			int32 debugFlags = atomic_get(&currentThread->debug_info.flags)
@@ -2649,6 +2661,26 @@ thread_set_io_priority(int32 priority)
 }
 
 
+/*!	Returns the I/O class of the given thread, i.e. its own one if it has
+	been set, or else the one of its team.
+*/
+int32
+thread_get_io_class(thread_id id)
+{
+	Thread* thread = Thread::GetAndLock(id);
+	if (thread == NULL)
+		return B_BAD_THREAD_ID;
+	BReference<Thread> threadReference(thread, true);
+	ThreadLocker threadLocker(thread, true);
+
+	int32 ioClass = thread->io_class;
+	if (ioClass < 0)
+		ioClass = atomic_get(&thread->team->io_class);
+
+	return ioClass;
+}
+
+
 status_t
 thread_init(kernel_args *args)
 {
@@ -3383,6 +3415,72 @@ _user_set_thread_priority(thread_id thread, int32 newPriority)
 }
 
 
+/*!	Sets the I/O class of a team, or, if \a threadID is given, of one of its
+	threads. A thread's class of -1 makes it use its team's class again.
+	Only root may assign the realtime class, or change the class of other
+	users' teams.
+*/
+status_t
+_user_set_io_class(team_id teamID, thread_id threadID, int32 ioClass)
+{
+	if (ioClass < (threadID >= 0 ? -1 : 0) || ioClass >= IO_CLASS_COUNT)
+		return B_BAD_VALUE;
+
+	uid_t uid = geteuid();
+	if (ioClass == IO_CLASS_REALTIME && uid != 0)
+		return B_NOT_ALLOWED;
+
+	Thread* thread = NULL;
+	if (threadID >= 0) {
+		thread = Thread::Get(threadID);
+		if (thread == NULL)
+			return B_BAD_THREAD_ID;
+		teamID = thread->team->id;
+	}
+	BReference<Thread> threadReference(thread, true);
+
+	Team* team = Team::GetAndLock(teamID);
+	if (team == NULL)
+		return B_BAD_TEAM_ID;
+	BReference<Team> teamReference(team, true);
+	TeamLocker teamLocker(team, true);
+
+	if (team == team_get_kernel_team()
+		|| (uid != 0 && uid != team->effective_uid)) {
+		return B_NOT_ALLOWED;
+	}
+
+	if (thread != NULL) {
+		ThreadLocker threadLocker(thread);
+		if (thread->team != team)
+			return B_BAD_THREAD_ID;
+		atomic_set(&thread->io_class, ioClass);
+	} else
+		atomic_set(&team->io_class, ioClass);
+
+	return B_OK;
+}
+
+
+/*!	Returns the I/O class of a team, or, if \a threadID is given, the one in
+	effect for that thread.
+*/
+int32
+_user_get_io_class(team_id teamID, thread_id threadID)
+{
+	if (threadID >= 0)
+		return thread_get_io_class(threadID);
+
+	Team* team = Team::GetAndLock(teamID);
+	if (team == NULL)
+		return B_BAD_TEAM_ID;
+	BReference<Team> teamReference(team, true);
+	TeamLocker teamLocker(team, true);
+
+	return team->io_class;
+}
+
+
 thread_id
 _user_spawn_thread(thread_creation_attributes* userAttributes)
 {
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A compressor and decompressor for the LZ4 block format, tuned for small
+	inputs like single pages: speed matters far more than the ratio, and the
+	compressor gives up as soon as the output doesn't fit.
+*/
+
+
+#include <util/LZ4.h>
+
+#include <string.h>
+
+
+static const int kHashBits = 12;
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5;
+	// the last bytes of the input are always literals
+static const size_t kMatchFindLimit = 12;
+	// no match may start within the last bytes of the input
+static const size_t kMaxOffset = 65535;
+
+
+static inline uint32
+read32(const uint8* data)
+{
+	uint32 value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+
+static inline uint32
+hash_sequence(uint32 sequence)
+{
+	return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+
+/*!	Writes the remainder of a length that didn't fit into its token nibble.
+*/
+static inline uint8*
+write_length(uint8* output, size_t length)
+{
+	while (length >= 255) {
+		*output++ = 255;
+		length -= 255;
+	}
+	*output++ = (uint8)length;
+	return output;
+}
+
+
+/*!	Reads the remainder of a length whose token nibble is 15. Returns
+	\c false, if the input ends prematurely.
+*/
+static inline bool
+read_length(const uint8*& input, const uint8* inputEnd, size_t& length)
+{
+	uint8 byte;
+	do {
+		if (input >= inputEnd)
+			return false;
+		byte = *input++;
+		length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+
+/*!	Compresses \a sourceSize bytes from \a source into \a dest.
+	\param workMemory Scratch memory of LZ4_WORK_MEMORY_SIZE bytes.
+	\return The size of the compressed data, or \c B_BUFFER_OVERFLOW, if it
+		wouldn't fit into \a destCapacity bytes.
+*/
+ssize_t
+lz4_compress(const void* _source, size_t sourceSize, void* _dest,
+	size_t destCapacity, void* workMemory)
+{
+	if (sourceSize > LZ4_MAX_INPUT_SIZE)
+		return B_BAD_VALUE;
+
+	const uint8* source = (const uint8*)_source;
+	const uint8* sourceEnd = source + sourceSize;
+	uint8* output = (uint8*)_dest;
+	uint8* outputEnd = output + destCapacity;
+	uint16* hashTable = (uint16*)workMemory;
+
+	const uint8* input = source;
+	const uint8* anchor = source;
+
+	if (sourceSize > kMatchFindLimit) {
+		const uint8* matchFindLimit = sourceEnd - kMatchFindLimit;
+		const uint8* matchLimit = sourceEnd - kLastLiterals;
+
+		memset(hashTable, 0, LZ4_WORK_MEMORY_SIZE);
+
+		while (input < matchFindLimit) {
+			uint32 sequence = read32(input);
+			uint32 hash = hash_sequence(sequence);
+			const uint8* reference = source + hashTable[hash];
+			hashTable[hash] = (uint16)(input - source);
+
+			if (reference >= input || (size_t)(input - reference) > kMaxOffset
+				|| read32(reference) != sequence) {
+				input++;
+				continue;
+			}
+
+			// extend the match backwards and forwards
+			while (input > anchor && reference > source
+				&& input[-1] == reference[-1]) {
+				input--;
+				reference--;
+			}
+
+			const uint8* matchEnd = input + kMinMatch;
+			const uint8* referenceEnd = reference + kMinMatch;
+			while (matchEnd < matchLimit && *matchEnd == *referenceEnd) {
+				matchEnd++;
+				referenceEnd++;
+			}
+
+			size_t literalLength = input - anchor;
+			size_t matchLength = matchEnd - input - kMinMatch;
+			if ((size_t)(outputEnd - output) < 1 + literalLength
+					+ literalLength / 255 + 1 + 2 + matchLength / 255 + 1) {
+				return B_BUFFER_OVERFLOW;
+			}
+
+			uint8* token = output++;
+			if (literalLength >= 15) {
+				*token = 15 << 4;
+				output = write_length(output, literalLength - 15);
+			} else
+				*token = (uint8)(literalLength << 4);
+
+			memcpy(output, anchor, literalLength);
+			output += literalLength;
+
+			size_t offset = input - reference;
+			*output++ = (uint8)offset;
+			*output++ = (uint8)(offset >> 8);
+
+			if (matchLength >= 15) {
+				*token |= 15;
+				output = write_length(output, matchLength - 15);
+			} else
+				*token |= (uint8)matchLength;
+
+			input = matchEnd;
+			anchor = input;
+		}
+	}
+
+	// the last literals
+	size_t literalLength = sourceEnd - anchor;
+	if ((size_t)(outputEnd - output)
+			< 1 + literalLength + literalLength / 255 + 1) {
+		return B_BUFFER_OVERFLOW;
+	}
+
+	if (literalLength >= 15) {
+		*output++ = 15 << 4;
+		output = write_length(output, literalLength - 15);
+	} else
+		*output++ = (uint8)(literalLength << 4);
+
+	memcpy(output, anchor, literalLength);
+	output += literalLength;
+
+	return output - (uint8*)_dest;
+}
+
+
+/*!	Decompresses \a sourceSize bytes of LZ4 block data from \a source into
+	\a dest.
+	\return The size of the decompressed data, or \c B_BAD_DATA, if the input
+		is malformed or would decompress to more than \a destCapacity bytes.
+*/
+ssize_t
+lz4_decompress(const void* _source, size_t sourceSize, void* _dest,
+	size_t destCapacity)
+{
+	const uint8* input = (const uint8*)_source;
+	const uint8* inputEnd = input + sourceSize;
+	uint8* dest = (uint8*)_dest;
+	uint8* output = dest;
+	uint8* outputEnd = dest + destCapacity;
+
+	while (input < inputEnd) {
+		uint8 token = *input++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15
+			&& !read_length(input, inputEnd, literalLength)) {
+			return B_BAD_DATA;
+		}
+
+		if (literalLength > (size_t)(inputEnd - input)
+			|| literalLength > (size_t)(outputEnd - output)) {
+			return B_BAD_DATA;
+		}
+
+		memcpy(output, input, literalLength);
+		input += literalLength;
+		output += literalLength;
+
+		if (input == inputEnd) {
+			// the last sequence has no match
+			break;
+		}
+
+		if (inputEnd - input < 2)
+			return B_BAD_DATA;
+
+		size_t offset = input[0] | ((size_t)input[1] << 8);
+		input += 2;
+		if (offset == 0 || offset > (size_t)(output - dest))
+			return B_BAD_DATA;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !read_length(input, inputEnd, matchLength))
+			return B_BAD_DATA;
+		matchLength += kMinMatch;
+
+		if (matchLength > (size_t)(outputEnd - output))
+			return B_BAD_DATA;
+
+		const uint8* match = output - offset;
+		if (offset >= matchLength) {
+			memcpy(output, match, matchLength);
+			output += matchLength;
+		} else {
+			// the match overlaps the output, copy it byte by byte
+			while (matchLength-- > 0)
+				*output++ = *match++;
+		}
+	}
+
+	return output - dest;
+}
@@ -40,6 +40,7 @@
 #include <fs_info.h>
 #include <fs_interface.h>
 #include <heap.h>
+#include <kernel.h>
 #include <kernel_daemon.h>
 #include <slab/Slab.h>
 #include <syscalls.h>
@@ -47,6 +48,7 @@
 #include <tracing.h>
 #include <util/AutoLock.h>
 #include <util/DoublyLinkedList.h>
+#include <util/LZ4.h>
 #include <util/OpenHashTable.h>
 #include <util/RadixBitmap.h>
 #include <vfs.h>
@@ -82,6 +84,20 @@
 #define SWAP_BLOCK_SHIFT 5		/* 1 << SWAP_BLOCK_SHIFT == SWAP_BLOCK_PAGES */
 #define SWAP_BLOCK_MASK  (SWAP_BLOCK_PAGES - 1)
 
+// The slots of the compressed swap pool live above those of the swap files.
+#define COMPRESSED_SWAP_FIRST_SLOT	0xc0000000
+
+// Compressed pages are stored in objects of size classes in steps of 256
+// bytes. Pages that don't compress to at most 3 KB aren't worth keeping in
+// memory, and go to the swap file.
+#define COMPRESSED_SWAP_CLASS_SHIFT	8
+#define COMPRESSED_SWAP_CLASS_COUNT	12
+#define COMPRESSED_SWAP_MAX_SIZE \
+	(COMPRESSED_SWAP_CLASS_COUNT << COMPRESSED_SWAP_CLASS_SHIFT)
+
+// default share of the RAM the compressed pages may use (in percent)
+#define DEFAULT_COMPRESSED_SWAP_SIZE	25
+
 
 static const char* const kDefaultSwapPath = "/var/swap";
 
@@ -94,6 +110,37 @@ struct swap_file : DoublyLinkedListLinkImpl<swap_file> {
 	radix_bitmap*	bmp;
 };
 
+// A slot of the compressed swap pool. Pages that consist of a single
+// repeated 32 bit value (mostly zero pages) don't need an object: their
+// size is 0, and \c data is the value itself.
+struct compressed_slot {
+	void*			data;
+	uint16			size;
+};
+
+// Compressing a page needs a buffer for the result and some work memory.
+// Every store gets its own from \c compressed_swap_pool::buffers, so that
+// the pool lock isn't held while compressing.
+struct compressed_swap_buffer {
+	uint8				data[COMPRESSED_SWAP_MAX_SIZE];
+	uint8				work_memory[LZ4_WORK_MEMORY_SIZE];
+};
+
+struct compressed_swap_pool {
+	mutex				lock;
+	swap_addr_t			first_slot;
+	swap_addr_t			last_slot;
+	radix_bitmap*		bmp;
+	compressed_slot*	slots;
+	object_cache*		caches[COMPRESSED_SWAP_CLASS_COUNT];
+	object_cache*		buffers;
+	size_t				limit;
+	size_t				size;
+	uint64				stored_pages;
+	uint64				compressed_bytes;
+	uint64				rejected_pages;
+};
+
 struct swap_hash_key {
 	VMAnonymousCache	*cache;
 	off_t				page_index;  // page index in the cache
@@ -155,6 +202,12 @@ static mutex sAvailSwapSpaceLock;
 
 static object_cache* sSwapBlockCache;
 
+static compressed_swap_pool* sCompressedSwap = NULL;
+static int64 sCompressedSwapLoads = 0;
+static int64 sCompressedSwapLoadTime = 0;
+static int64 sDiskSwapLoads = 0;
+static int64 sDiskSwapLoadTime = 0;
+
 
 #if SWAP_TRACING
 namespace SwapTracing {
@@ -227,11 +280,316 @@ private:
 #endif
 
 
+// #pragma mark - compressed swap pool
+
+
+static inline bool
+is_compressed_swap_slot(swap_addr_t slotIndex)
+{
+	return sCompressedSwap != NULL && slotIndex >= sCompressedSwap->first_slot
+		&& slotIndex < sCompressedSwap->last_slot;
+}
+
+
+/*!	Makes the page at \a base accessible. \a base is a physical address, if
+	\a flags contains \c B_PHYSICAL_IO_REQUEST.
+*/
+static status_t
+compressed_swap_get_page(generic_addr_t base, uint32 flags, addr_t& address,
+	void*& handle)
+{
+	handle = NULL;
+	if ((flags & B_PHYSICAL_IO_REQUEST) == 0) {
+		address = base;
+		return B_OK;
+	}
+
+	return vm_get_physical_page(base, &address, &handle);
+}
+
+
+static inline void
+compressed_swap_put_page(addr_t address, void* handle)
+{
+	if (handle != NULL)
+		vm_put_physical_page(address, handle);
+}
+
+
+/*!	Compresses the page at \a base into the pool.
+	\return The slot the page was stored in, or \c SWAP_SLOT_NONE, if it
+		didn't compress well enough, or there is no room in the pool.
+*/
+static swap_addr_t
+compressed_swap_store(generic_addr_t base, uint32 flags)
+{
+	compressed_swap_pool* pool = sCompressedSwap;
+	if (pool == NULL)
+		return SWAP_SLOT_NONE;
+
+	addr_t address;
+	void* handle;
+	if (compressed_swap_get_page(base, flags, address, handle) != B_OK)
+		return SWAP_SLOT_NONE;
+
+	// check for a page filled with a single value first
+	const uint32* words = (const uint32*)address;
+	uint32 fill = words[0];
+	bool sameFilled = true;
+	for (size_t i = 1; i < B_PAGE_SIZE / sizeof(uint32); i++) {
+		if (words[i] != fill) {
+			sameFilled = false;
+			break;
+		}
+	}
+
+	// compress the page and copy it into an object of its size class
+	ssize_t size = 0;
+	int32 sizeClass = -1;
+	size_t allocationSize = 0;
+	void* data = (void*)(addr_t)fill;
+	if (!sameFilled) {
+		compressed_swap_buffer* buffer
+			= (compressed_swap_buffer*)object_cache_alloc(pool->buffers,
+				CACHE_DONT_WAIT_FOR_MEMORY | CACHE_DONT_LOCK_KERNEL_SPACE);
+		if (buffer != NULL) {
+			size = lz4_compress((const void*)address, B_PAGE_SIZE,
+				buffer->data, sizeof(buffer->data), buffer->work_memory);
+		} else
+			size = B_NO_MEMORY;
+
+		if (size > 0) {
+			sizeClass = (size - 1) >> COMPRESSED_SWAP_CLASS_SHIFT;
+			allocationSize
+				= (size_t)(sizeClass + 1) << COMPRESSED_SWAP_CLASS_SHIFT;
+			data = object_cache_alloc(pool->caches[sizeClass],
+				CACHE_DONT_WAIT_FOR_MEMORY | CACHE_DONT_LOCK_KERNEL_SPACE);
+			if (data != NULL)
+				memcpy(data, buffer->data, size);
+			else
+				size = B_NO_MEMORY;
+		}
+
+		if (buffer != NULL) {
+			object_cache_free(pool->buffers, buffer,
+				CACHE_DONT_WAIT_FOR_MEMORY | CACHE_DONT_LOCK_KERNEL_SPACE);
+		}
+	}
+
+	compressed_swap_put_page(address, handle);
+
+	MutexLocker locker(pool->lock);
+
+	swap_addr_t slotIndex = SWAP_SLOT_NONE;
+	if (size >= 0 && pool->size + allocationSize <= pool->limit)
+		slotIndex = radix_bitmap_alloc(pool->bmp, 1);
+
+	if (slotIndex == SWAP_SLOT_NONE) {
+		pool->rejected_pages++;
+		locker.Unlock();
+
+		if (size > 0) {
+			object_cache_free(pool->caches[sizeClass], data,
+				CACHE_DONT_WAIT_FOR_MEMORY | CACHE_DONT_LOCK_KERNEL_SPACE);
+		}
+		return SWAP_SLOT_NONE;
+	}
+
+	compressed_slot& slot = pool->slots[slotIndex];
+	slot.data = data;
+	slot.size = size;
+	pool->size += allocationSize;
+	pool->stored_pages++;
+	pool->compressed_bytes += size;
+
+	return slotIndex + pool->first_slot;
+}
+
+
+static status_t
+compressed_swap_load(swap_addr_t slotIndex, generic_addr_t base, uint32 flags)
+{
+	compressed_swap_pool* pool = sCompressedSwap;
+
+	addr_t address;
+	void* handle;
+	status_t status = compressed_swap_get_page(base, flags, address, handle);
+	if (status != B_OK)
+		return status;
+
+	// The slot can't be freed while its page is being read in, so it's
+	// enough to get its contents under the lock.
+	MutexLocker locker(pool->lock);
+	compressed_slot slot = pool->slots[slotIndex - pool->first_slot];
+	locker.Unlock();
+
+	if (slot.size == 0) {
+		uint32 fill = (uint32)(addr_t)slot.data;
+		uint32* words = (uint32*)address;
+		for (size_t i = 0; i < B_PAGE_SIZE / sizeof(uint32); i++)
+			words[i] = fill;
+	} else {
+		ssize_t size = lz4_decompress(slot.data, slot.size, (void*)address,
+			B_PAGE_SIZE);
+		if (size != B_PAGE_SIZE) {
+			panic("compressed_swap_load(): slot %" B_PRIu32 " is corrupt",
+				slotIndex);
+			status = B_BAD_DATA;
+		}
+	}
+
+	compressed_swap_put_page(address, handle);
+	return status;
+}
+
+
+static void
+compressed_swap_free(swap_addr_t slotIndex, uint32 count)
+{
+	compressed_swap_pool* pool = sCompressedSwap;
+
+	MutexLocker locker(pool->lock);
+
+	slotIndex -= pool->first_slot;
+	for (uint32 i = 0; i < count; i++) {
+		compressed_slot& slot = pool->slots[slotIndex + i];
+		if (slot.size > 0) {
+			int32 sizeClass = (slot.size - 1) >> COMPRESSED_SWAP_CLASS_SHIFT;
+			object_cache_free(pool->caches[sizeClass], slot.data,
+				CACHE_DONT_WAIT_FOR_MEMORY | CACHE_DONT_LOCK_KERNEL_SPACE);
+			pool->size
+				-= (size_t)(sizeClass + 1) << COMPRESSED_SWAP_CLASS_SHIFT;
+		}
+
+		pool->stored_pages--;
+		pool->compressed_bytes -= slot.size;
+		slot.data = NULL;
+		slot.size = 0;
+	}
+
+	radix_bitmap_dealloc(pool->bmp, slotIndex, count);
+}
+
+
+/*!	Sets up the compressed swap pool according to the "virtual_memory"
+	settings. The pool may use up to "compressed_swap_size" percent of the
+	RAM for compressed pages. It provides twice as many slots as that memory
+	has pages, but only the memory itself counts as swap space, since the
+	compression ratio isn't known in advance.
+*/
+static void
+compressed_swap_init()
+{
+	bool enabled = true;
+	int32 percent = DEFAULT_COMPRESSED_SWAP_SIZE;
+
+	void* settings = load_driver_settings("virtual_memory");
+	if (settings != NULL) {
+		enabled = get_driver_boolean_parameter(settings, "compressed_swap",
+			true, true);
+		const char* size = get_driver_parameter(settings,
+			"compressed_swap_size", NULL, NULL);
+		if (size != NULL)
+			percent = strtol(size, NULL, 0);
+		unload_driver_settings(settings);
+	}
+
+	if (!enabled || percent <= 0 || percent > 90) {
+		dprintf("%s: compressed swap is disabled\n", __func__);
+		return;
+	}
+
+	compressed_swap_pool* pool
+		= (compressed_swap_pool*)malloc(sizeof(compressed_swap_pool));
+	if (pool == NULL)
+		return;
+
+	page_num_t limitPages = vm_page_num_pages() / 100 * percent;
+	uint32 slotCount = min_c(limitPages * 2,
+		(page_num_t)(SWAP_SLOT_NONE - COMPRESSED_SWAP_FIRST_SLOT - 1));
+
+	mutex_init(&pool->lock, "compressed swap");
+	pool->first_slot = COMPRESSED_SWAP_FIRST_SLOT;
+	pool->last_slot = COMPRESSED_SWAP_FIRST_SLOT + slotCount;
+	pool->limit = (size_t)limitPages * B_PAGE_SIZE;
+	pool->size = 0;
+	pool->stored_pages = 0;
+	pool->compressed_bytes = 0;
+	pool->rejected_pages = 0;
+	memset(pool->caches, 0, sizeof(pool->caches));
+	pool->buffers = create_object_cache("compressed swap buffers",
+		sizeof(compressed_swap_buffer), 8, NULL, NULL, NULL);
+
+	pool->bmp = radix_bitmap_create(slotCount);
+	pool->slots = (compressed_slot*)calloc(slotCount, sizeof(compressed_slot));
+	bool ok = pool->bmp != NULL && pool->slots != NULL
+		&& pool->buffers != NULL;
+
+	for (int32 i = 0; ok && i < COMPRESSED_SWAP_CLASS_COUNT; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "compressed swap %" B_PRId32,
+			(i + 1) << COMPRESSED_SWAP_CLASS_SHIFT);
+		pool->caches[i] = create_object_cache(name,
+			(i + 1) << COMPRESSED_SWAP_CLASS_SHIFT, 8, NULL, NULL, NULL);
+		ok = pool->caches[i] != NULL;
+	}
+
+	if (!ok) {
+		dprintf("%s: failed to create the compressed swap pool\n", __func__);
+		for (int32 i = 0; i < COMPRESSED_SWAP_CLASS_COUNT; i++) {
+			if (pool->caches[i] != NULL)
+				delete_object_cache(pool->caches[i]);
+		}
+		if (pool->buffers != NULL)
+			delete_object_cache(pool->buffers);
+		if (pool->bmp != NULL)
+			radix_bitmap_destroy(pool->bmp);
+		free(pool->slots);
+		mutex_destroy(&pool->lock);
+		free(pool);
+		return;
+	}
+
+	sCompressedSwap = pool;
+
+	mutex_lock(&sAvailSwapSpaceLock);
+	sAvailSwapSpace += (off_t)pool->limit;
+	mutex_unlock(&sAvailSwapSpaceLock);
+
+	dprintf("%s: %" B_PRIu32 " slots, using up to %" B_PRIuSIZE " bytes\n",
+		__func__, slotCount, pool->limit);
+}
+
+
+static void
+compressed_swap_get_info(compressed_swap_info* info)
+{
+	compressed_swap_pool* pool = sCompressedSwap;
+	if (pool != NULL) {
+		MutexLocker locker(pool->lock);
+		info->pool_limit = pool->limit;
+		info->pool_size = pool->size;
+		info->stored_pages = pool->stored_pages;
+		info->compressed_bytes = pool->compressed_bytes;
+		info->rejected_pages = pool->rejected_pages;
+	}
+
+	info->pool_loads = atomic_get64(&sCompressedSwapLoads);
+	info->pool_load_time = atomic_get64(&sCompressedSwapLoadTime);
+	info->disk_loads = atomic_get64(&sDiskSwapLoads);
+	info->disk_load_time = atomic_get64(&sDiskSwapLoadTime);
+}
+
+
+// #pragma mark -
+
+
 static int
 dump_swap_info(int argc, char** argv)
 {
 	swap_addr_t totalSwapPages = 0;
 	swap_addr_t freeSwapPages = 0;
+	swap_addr_t swapSpacePages = 0;
 
 	kprintf("swap files:\n");
 
@@ -243,14 +601,33 @@ dump_swap_info(int argc, char** argv)
 
 		totalSwapPages += total;
 		freeSwapPages += file->bmp->free_slots;
+		swapSpacePages += total;
+	}
+
+	compressed_swap_pool* pool = sCompressedSwap;
+	if (pool != NULL) {
+		swap_addr_t total = pool->last_slot - pool->first_slot;
+		kprintf("  compressed pool: pages: total: %" B_PRIu32 ", free: %"
+			B_PRIu32 "\n", total, pool->bmp->free_slots);
+		kprintf("    size: %" B_PRIuSIZE " of %" B_PRIuSIZE " bytes, "
+			"compressed data: %" B_PRIu64 " bytes, rejected pages: %" B_PRIu64
+			"\n", pool->size, pool->limit, pool->compressed_bytes,
+			pool->rejected_pages);
+
+		totalSwapPages += total;
+		freeSwapPages += pool->bmp->free_slots;
+		swapSpacePages += pool->limit / B_PAGE_SIZE;
 	}
 
 	kprintf("\n");
 	kprintf("swap space in pages:\n");
-	kprintf("total:     %9" B_PRIu32 "\n", totalSwapPages);
+	kprintf("total:     %9" B_PRIu32 "\n", swapSpacePages);
 	kprintf("available: %9" B_PRIdOFF "\n", sAvailSwapSpace / B_PAGE_SIZE);
 	kprintf("reserved:  %9" B_PRIdOFF "\n",
-		totalSwapPages - sAvailSwapSpace / B_PAGE_SIZE);
+		swapSpacePages - sAvailSwapSpace / B_PAGE_SIZE);
+	kprintf("\n");
+	kprintf("swap slots:\n");
+	kprintf("total:     %9" B_PRIu32 "\n", totalSwapPages);
 	kprintf("used:      %9" B_PRIu32 "\n", totalSwapPages - freeSwapPages);
 	kprintf("free:      %9" B_PRIu32 "\n", freeSwapPages);
 
@@ -265,7 +642,10 @@ swap_slot_alloc(uint32 count)
 
 	if (sSwapFileList.IsEmpty()) {
 		mutex_unlock(&sSwapFileListLock);
-		panic("swap_slot_alloc(): no swap file in the system\n");
+		// With a compressed swap pool, the committed swap space might not be
+		// backed by a swap file.
+		if (sCompressedSwap == NULL)
+			panic("swap_slot_alloc(): no swap file in the system\n");
 		return SWAP_SLOT_NONE;
 	}
 
@@ -293,7 +673,8 @@ swap_slot_alloc(uint32 count)
 
 	if (j == sSwapFileCount) {
 		mutex_unlock(&sSwapFileListLock);
-		panic("swap_slot_alloc: swap space exhausted!\n");
+		if (sCompressedSwap == NULL)
+			panic("swap_slot_alloc: swap space exhausted!\n");
 		return SWAP_SLOT_NONE;
 	}
 
@@ -333,6 +714,11 @@ swap_slot_dealloc(swap_addr_t slotIndex, uint32 count)
 	if (slotIndex == SWAP_SLOT_NONE)
 		return;
 
+	if (is_compressed_swap_slot(slotIndex)) {
+		compressed_swap_free(slotIndex, count);
+		return;
+	}
+
 	mutex_lock(&sSwapFileListLock);
 	swap_file* swapFile = find_swap_file(slotIndex);
 	slotIndex -= swapFile->first_slot;
@@ -489,58 +875,27 @@ status_t
 VMAnonymousCache::Resize(off_t newSize, int priority)
 {
 	// If the cache size shrinks, drop all swap pages beyond the new size.
-	if (fAllocatedSwapSize > 0) {
-		off_t oldPageCount = (virtual_end + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
-		swap_block* swapBlock = NULL;
-
-		for (off_t pageIndex = (newSize + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
-			pageIndex < oldPageCount && fAllocatedSwapSize > 0; pageIndex++) {
+	_FreeSwapPageRange(newSize, virtual_end);
 
-			WriteLocker locker(sSwapHashLock);
+	return VMCache::Resize(newSize, priority);
+}
 
-			// Get the swap slot index for the page.
-			swap_addr_t blockIndex = pageIndex & SWAP_BLOCK_MASK;
-			if (swapBlock == NULL || blockIndex == 0) {
-				swap_hash_key key = { this, pageIndex };
-				swapBlock = sSwapHashTable.Lookup(key);
 
-				if (swapBlock == NULL) {
-					pageIndex = ROUNDUP(pageIndex + 1, SWAP_BLOCK_PAGES);
-					continue;
-				}
-			}
+void
+VMAnonymousCache::Discard(off_t offset, off_t size)
+{
+	VMCache::Discard(offset, size);
+	_FreeSwapPageRange(offset, offset + size);
+}
 
-			swap_addr_t slotIndex = swapBlock->swap_slots[blockIndex];
-			vm_page* page;
-			if (slotIndex != SWAP_SLOT_NONE
-				&& ((page = LookupPage((off_t)pageIndex * B_PAGE_SIZE)) == NULL
-					|| !page->busy)) {
-					// TODO: We skip (i.e. leak) swap space of busy pages, since
-					// there could be I/O going on (paging in/out). Waiting is
-					// not an option as 1. unlocking the cache means that new
-					// swap pages could be added in a range we've already
-					// cleared (since the cache still has the old size) and 2.
-					// we'd risk a deadlock in case we come from the file cache
-					// and the FS holds the node's write-lock. We should mark
-					// the page invalid and let the one responsible clean up.
-					// There's just no such mechanism yet.
-				swap_slot_dealloc(slotIndex, 1);
-				fAllocatedSwapSize -= B_PAGE_SIZE;
-
-				swapBlock->swap_slots[blockIndex] = SWAP_SLOT_NONE;
-				if (--swapBlock->used == 0) {
-					// All swap pages have been freed -- we can discard the swap
-					// block.
-					sSwapHashTable.RemoveUnchecked(swapBlock);
-					object_cache_free(sSwapBlockCache, swapBlock,
-						CACHE_DONT_WAIT_FOR_MEMORY
-							| CACHE_DONT_LOCK_KERNEL_SPACE);
-				}
-			}
-		}
-	}
 
-	return VMCache::Resize(newSize, priority);
+void
+VMAnonymousCache::MarkDiscardable(off_t offset, off_t size)
+{
+	// Pages that are only in swap are dropped right away, resident pages keep
+	// their contents until the page daemon frees them.
+	VMCache::MarkDiscardable(offset, size);
+	_FreeSwapPageRange(offset, offset + size);
 }
 
 
@@ -597,6 +952,23 @@ VMAnonymousCache::Read(off_t offset, const generic_io_vec* vecs, size_t count,
 
 	for (uint32 i = 0, j = 0; i < count; i = j) {
 		swap_addr_t startSlotIndex = _SwapBlockGetAddress(pageIndex + i);
+		bigtime_t startTime = system_time();
+
+		if (is_compressed_swap_slot(startSlotIndex)) {
+			j = i + 1;
+
+			T(ReadPage(this, pageIndex + i, startSlotIndex));
+
+			status_t status = compressed_swap_load(startSlotIndex, vecs[i].base,
+				flags);
+			if (status != B_OK)
+				return status;
+
+			atomic_add64(&sCompressedSwapLoads, 1);
+			atomic_add64(&sCompressedSwapLoadTime, system_time() - startTime);
+			continue;
+		}
+
 		for (j = i + 1; j < count; j++) {
 			swap_addr_t slotIndex = _SwapBlockGetAddress(pageIndex + j);
 			if (slotIndex != startSlotIndex + j - i)
@@ -615,6 +987,9 @@ VMAnonymousCache::Read(off_t offset, const generic_io_vec* vecs, size_t count,
 			vecs + i, j - i, flags, _numBytes);
 		if (status != B_OK)
 			return status;
+
+		atomic_add64(&sDiskSwapLoads, j - i);
+		atomic_add64(&sDiskSwapLoadTime, system_time() - startTime);
 	}
 
 	return B_OK;
@@ -657,16 +1032,35 @@ VMAnonymousCache::Write(off_t offset, const generic_io_vec* vecs, size_t count,
 
 		generic_addr_t vectorBase = vecs[i].base;
 		generic_size_t vectorLength = vecs[i].length;
-		page_num_t n = pageCount;
+		page_num_t n;
 
 		for (page_num_t j = 0; j < pageCount; j += n) {
-			swap_addr_t slotIndex;
+			n = pageCount - j;
+
+			// try to keep the page in the compressed pool first
+			swap_addr_t slotIndex = compressed_swap_store(vectorBase, flags);
+			if (slotIndex != SWAP_SLOT_NONE) {
+				T(WritePage(this, pageIndex + totalPages + j, slotIndex));
+
+				n = 1;
+				_SwapBlockBuild(pageIndex + totalPages + j, slotIndex, 1);
+				pagesLeft--;
+				vectorBase += B_PAGE_SIZE;
+				vectorLength -= B_PAGE_SIZE;
+				continue;
+			}
+
 			// try to allocate n slots, if fail, try to allocate n/2
 			while ((slotIndex = swap_slot_alloc(n)) == SWAP_SLOT_NONE && n >= 2)
 				n >>= 1;
 
-			if (slotIndex == SWAP_SLOT_NONE)
-				panic("VMAnonymousCache::Write(): can't allocate swap space\n");
+			if (slotIndex == SWAP_SLOT_NONE) {
+				// only possible when the pool provides swap space
+				locker.Lock();
+				fAllocatedSwapSize -= (off_t)pagesLeft * B_PAGE_SIZE;
+				locker.Unlock();
+				return B_ERROR;
+			}
 
 			T(WritePage(this, pageIndex, slotIndex));
 				// TODO: Assumes that only one page is written.
@@ -691,13 +1085,11 @@ VMAnonymousCache::Write(off_t offset, const generic_io_vec* vecs, size_t count,
 				return status;
 			}
 
-			_SwapBlockBuild(pageIndex + totalPages, slotIndex, n);
+			_SwapBlockBuild(pageIndex + totalPages + j, slotIndex, n);
 			pagesLeft -= n;
 
-			if (n != pageCount) {
-				vectorBase = vectorBase + n * B_PAGE_SIZE;
-				vectorLength -= n * B_PAGE_SIZE;
-			}
+			vectorBase = vectorBase + n * B_PAGE_SIZE;
+			vectorLength -= n * B_PAGE_SIZE;
 		}
 
 		totalPages += pageCount;
@@ -721,6 +1113,18 @@ VMAnonymousCache::WriteAsync(off_t offset, const generic_io_vec* vecs,
 
 	page_num_t pageIndex = offset >> PAGE_SHIFT;
 	swap_addr_t slotIndex = _SwapBlockGetAddress(pageIndex);
+
+	// A copy in the compressed pool can't be overwritten in place -- free
+	// it, the page gets a new slot below.
+	if (is_compressed_swap_slot(slotIndex)) {
+		swap_slot_dealloc(slotIndex, 1);
+		_SwapBlockFree(pageIndex, 1);
+
+		AutoLocker<VMCache> locker(this);
+		fAllocatedSwapSize -= B_PAGE_SIZE;
+		slotIndex = SWAP_SLOT_NONE;
+	}
+
 	bool newSlot = slotIndex == SWAP_SLOT_NONE;
 
 	// If the page doesn't have any swap space yet, allocate it.
@@ -732,8 +1136,29 @@ VMAnonymousCache::WriteAsync(off_t offset, const generic_io_vec* vecs,
 		}
 
 		fAllocatedSwapSize += B_PAGE_SIZE;
+		locker.Unlock();
+
+		// Pages that compress well stay in memory; that's done
+		// synchronously.
+		slotIndex = compressed_swap_store(vecs[0].base, flags);
+		if (slotIndex != SWAP_SLOT_NONE) {
+			T(WritePage(this, pageIndex, slotIndex));
+
+			_SwapBlockBuild(pageIndex, slotIndex, 1);
+			_callback->IOFinished(B_OK, false, numBytes);
+			return B_OK;
+		}
 
 		slotIndex = swap_slot_alloc(1);
+		if (slotIndex == SWAP_SLOT_NONE) {
+			// only possible when the pool provides swap space
+			locker.Lock();
+			fAllocatedSwapSize -= B_PAGE_SIZE;
+			locker.Unlock();
+
+			_callback->IOFinished(B_ERROR, true, 0);
+			return B_ERROR;
+		}
 	}
 
 	// create our callback
@@ -965,6 +1390,68 @@ VMAnonymousCache::_SwapBlockGetAddress(off_t pageIndex)
 }
 
 
+/*!	Frees the swap space of the pages in the given range, except for busy
+	ones. The cache must be locked.
+*/
+void
+VMAnonymousCache::_FreeSwapPageRange(off_t fromOffset, off_t toOffset)
+{
+	if (fAllocatedSwapSize == 0)
+		return;
+
+	off_t endPageIndex = (toOffset + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
+	swap_block* swapBlock = NULL;
+
+	for (off_t pageIndex = (fromOffset + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
+		pageIndex < endPageIndex && fAllocatedSwapSize > 0; pageIndex++) {
+
+		WriteLocker locker(sSwapHashLock);
+
+		// Get the swap slot index for the page.
+		swap_addr_t blockIndex = pageIndex & SWAP_BLOCK_MASK;
+		if (swapBlock == NULL || blockIndex == 0) {
+			swap_hash_key key = { this, pageIndex };
+			swapBlock = sSwapHashTable.Lookup(key);
+
+			if (swapBlock == NULL) {
+				// continue with the first page of the next block
+				pageIndex = ROUNDUP(pageIndex + 1, SWAP_BLOCK_PAGES) - 1;
+				continue;
+			}
+		}
+
+		swap_addr_t slotIndex = swapBlock->swap_slots[blockIndex];
+		vm_page* page;
+		if (slotIndex != SWAP_SLOT_NONE
+			&& ((page = LookupPage((off_t)pageIndex * B_PAGE_SIZE)) == NULL
+				|| !page->busy)) {
+				// TODO: We skip (i.e. leak) swap space of busy pages, since
+				// there could be I/O going on (paging in/out). Waiting is
+				// not an option as 1. unlocking the cache means that new
+				// swap pages could be added in a range we've already
+				// cleared (since the cache still has the old size) and 2.
+				// we'd risk a deadlock in case we come from the file cache
+				// and the FS holds the node's write-lock. We should mark
+				// the page invalid and let the one responsible clean up.
+				// There's just no such mechanism yet.
+			swap_slot_dealloc(slotIndex, 1);
+			fAllocatedSwapSize -= B_PAGE_SIZE;
+
+			swapBlock->swap_slots[blockIndex] = SWAP_SLOT_NONE;
+			if (--swapBlock->used == 0) {
+				// All swap pages have been freed -- we can discard the swap
+				// block.
+				sSwapHashTable.RemoveUnchecked(swapBlock);
+				object_cache_free(sSwapBlockCache, swapBlock,
+					CACHE_DONT_WAIT_FOR_MEMORY
+						| CACHE_DONT_LOCK_KERNEL_SPACE);
+				swapBlock = NULL;
+			}
+		}
+	}
+}
+
+
 status_t
 VMAnonymousCache::_Commit(off_t size, int priority)
 {
@@ -1443,6 +1930,9 @@ swap_init(void)
 void
 swap_init_post_modules()
 {
+	// The compressed pool doesn't need a writable device.
+	compressed_swap_init();
+
 	// Never try to create a swap file on a read-only device - when booting
 	// from CD, the write overlay is used.
 	if (gReadOnlyBootDevice)
@@ -1660,6 +2150,10 @@ swap_total_swap_pages()
 		totalSwapSlots += swapFile->last_slot - swapFile->first_slot;
 	}
 
+	// only the memory of the compressed pool counts as swap space
+	if (sCompressedSwap != NULL)
+		totalSwapSlots += sCompressedSwap->limit / B_PAGE_SIZE;
+
 	mutex_unlock(&sSwapFileListLock);
 
 	return totalSwapSlots;
@@ -1681,3 +2175,20 @@ swap_get_info(system_info* info)
 #endif
 }
 
+
+status_t
+_user_get_compressed_swap_info(compressed_swap_info* userInfo, size_t size)
+{
+	if (size != sizeof(compressed_swap_info))
+		return B_BAD_VALUE;
+	if (userInfo == NULL || !IS_USER_ADDRESS(userInfo))
+		return B_BAD_ADDRESS;
+
+	compressed_swap_info info = {};
+#if ENABLE_SWAP_SUPPORT
+	compressed_swap_get_info(&info);
+#endif
+
+	return user_memcpy(userInfo, &info, sizeof(info));
+}
+
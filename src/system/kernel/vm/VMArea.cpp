@@ -12,6 +12,8 @@
 
 #include <new>
 
+#include <sys/mman.h>
+
 #include <heap.h>
 #include <vm/VMAddressSpace.h>
 
@@ -37,6 +39,9 @@ VMArea::VMArea(VMAddressSpace* addressSpace, uint32 wiring, uint32 protection)
 	cache_offset(0),
 	cache_type(0),
 	page_protections(NULL),
+	last_fault_address(0),
+	sequential_faults(0),
+	access_advice(MADV_NORMAL),
 	address_space(addressSpace),
 	cache_next(NULL),
 	cache_prev(NULL),
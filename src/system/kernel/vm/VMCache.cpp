@@ -1142,6 +1142,82 @@ VMCache::Resize(off_t newSize, int priority)
 }
 
 
+/*!	Frees all pages in the given range of the cache, so that their contents
+	are lost. Busy pages are waited for, unless they are being written.
+	The cache must be locked.
+*/
+void
+VMCache::Discard(off_t offset, off_t size)
+{
+	AssertLocked();
+
+	page_num_t startPage = offset >> PAGE_SHIFT;
+	page_num_t endPage = (offset + size + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+	for (VMCachePagesTree::Iterator it
+				= pages.GetIterator(startPage, true, true);
+			vm_page* page = it.Next();) {
+		if (page->cache_offset >= endPage)
+			break;
+
+		if (page->busy) {
+			if (page->busy_writing) {
+				// the writer will free the page
+				page->busy_writing = false;
+			} else {
+				WaitForPageEvents(page, PAGE_EVENT_NOT_BUSY, true);
+				it = pages.GetIterator(startPage, true, true);
+			}
+			continue;
+		}
+
+		DEBUG_PAGE_ACCESS_START(page);
+		vm_remove_all_page_mappings(page);
+		ASSERT(page->WiredCount() == 0);
+		RemovePage(page);
+		vm_page_free(this, page);
+	}
+}
+
+
+/*!	Marks the unmapped pages in the given range of the cache as clean and
+	moves them to the cached queue, so that the page daemon may free them
+	instead of writing them to swap. Until then, they keep their contents.
+	Pages that are still mapped are marked modified instead, since derived
+	classes may drop their backing store. Only sensible for temporary caches.
+	The cache must be locked.
+*/
+void
+VMCache::MarkDiscardable(off_t offset, off_t size)
+{
+	AssertLocked();
+
+	page_num_t startPage = offset >> PAGE_SHIFT;
+	page_num_t endPage = (offset + size + B_PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+	for (VMCachePagesTree::Iterator it
+				= pages.GetIterator(startPage, true, true);
+			vm_page* page = it.Next();) {
+		if (page->cache_offset >= endPage)
+			break;
+
+		if (page->busy)
+			continue;
+
+		if (page->IsMapped()) {
+			page->modified = true;
+			continue;
+		}
+
+		DEBUG_PAGE_ACCESS_START(page);
+		page->modified = false;
+		if (page->State() != PAGE_STATE_CACHED)
+			vm_page_set_state(page, PAGE_STATE_CACHED);
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+}
+
+
 /*!	You have to call this function with the VMCache lock held. */
 status_t
 VMCache::FlushAndRemoveAllPages()
@@ -31,6 +31,33 @@ VMTranslationMap::~VMTranslationMap()
 }
 
 
+/*!	Returns the size of the large pages MapLargePage() can map, or \c 0, if
+	the implementation doesn't support them.
+*/
+size_t
+VMTranslationMap::LargePageSize() const
+{
+	return 0;
+}
+
+
+/*!	Maps a physically contiguous range of LargePageSize() bytes with a single
+	large page. Both addresses must be aligned to LargePageSize(), and nothing
+	must be mapped in the range yet.
+	Later operations that only affect a part of the range will split the
+	large page, so that callers don't need to care about it.
+	The caller must have reserved the pages MaxPagesNeededToMap() returns for
+	the range.
+*/
+status_t
+VMTranslationMap::MapLargePage(addr_t virtualAddress,
+	phys_addr_t physicalAddress, uint32 attributes, uint32 memoryType,
+	vm_page_reservation* reservation)
+{
+	return B_NOT_SUPPORTED;
+}
+
+
 status_t
 VMTranslationMap::DebugMarkRangePresent(addr_t start, addr_t end,
 	bool markPresent)
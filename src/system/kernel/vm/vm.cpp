@@ -33,6 +33,7 @@
 #include <condition_variable.h>
 #include <console.h>
 #include <debug.h>
+#include <driver_settings.h>
 #include <file_cache.h>
 #include <fs/fd.h>
 #include <heap.h>
@@ -57,6 +58,7 @@
 #include "VMAnonymousCache.h"
 #include "VMAnonymousNoSwapCache.h"
 #include "IORequest.h"
+#include "../cache/vnode_store.h"
 
 
 //#define TRACE_VM
@@ -251,6 +253,16 @@ static off_t sNeededMemory;
 static mutex sAvailableMemoryLock = MUTEX_INITIALIZER("available memory lock");
 static uint32 sPageFaults;
 
+// On a read fault, already cached pages in an aligned window of this many
+// pages around the faulting address are mapped as well.
+static const uint32 kMaxFaultAroundPages = 32;
+static uint32 sFaultAroundPages = 16;
+
+// After this many sequential read faults in an area, the file cache reads
+// ahead of them.
+static const uint32 kSequentialFaultThreshold = 2;
+static const size_t kMaxFaultReadAhead = 1024 * 1024;
+
 static VMPhysicalPageMapper* sPhysicalPageMapper;
 
 #if DEBUG_CACHE_LIST
@@ -585,6 +597,55 @@ map_page(VMArea* area, vm_page* page, addr_t address, uint32 protection,
 }
 
 
+/*!	Allocates a run of pages for the large page at \a address of the given
+	B_FULL_LOCK area, inserts them into the area's cache, and maps them.
+	The caller must have locked the area's cache, and must hold the address
+	space lock. \a reservation must contain enough pages for the run and for
+	the mapping.
+	Returns whether it succeeded; if not, nothing has been changed.
+*/
+static bool
+map_large_page(VMArea* area, addr_t address, uint32 pageAllocFlags,
+	vm_page_reservation* reservation)
+{
+	VMTranslationMap* map = area->address_space->TranslationMap();
+	page_num_t pageCount = map->LargePageSize() / B_PAGE_SIZE;
+
+	vm_page* firstPage = vm_page_allocate_large_page(reservation,
+		PAGE_STATE_WIRED | pageAllocFlags, pageCount);
+	if (firstPage == NULL)
+		return false;
+
+	VMCache* cache = area->cache;
+	off_t offset = address - area->Base() + area->cache_offset;
+	phys_addr_t physicalAddress
+		= (phys_addr_t)firstPage->physical_page_number * B_PAGE_SIZE;
+
+	for (page_num_t i = 0; i < pageCount; i++) {
+		vm_page* page = vm_lookup_page(firstPage->physical_page_number + i);
+		cache->InsertPage(page, offset + i * B_PAGE_SIZE);
+		increment_page_wired_count(page);
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+
+	map->Lock();
+
+	if (map->MapLargePage(address, physicalAddress, area->protection,
+			area->MemoryType(), reservation) != B_OK) {
+		// map the pages individually instead
+		for (page_num_t i = 0; i < pageCount; i++) {
+			map->Map(address + i * B_PAGE_SIZE,
+				physicalAddress + i * B_PAGE_SIZE, area->protection,
+				area->MemoryType(), reservation);
+		}
+	}
+
+	map->Unlock();
+
+	return true;
+}
+
+
 /*!	If \a preserveModified is \c true, the caller must hold the lock of the
 	page's cache.
 */
@@ -1299,6 +1360,7 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 	// For full lock or contiguous areas we're also going to map the pages and
 	// thus need to reserve pages for the mapping backend upfront.
 	addr_t reservedMapPages = 0;
+	size_t largePageSize = 0;
 	if (wiring == B_FULL_LOCK || wiring == B_CONTIGUOUS) {
 		AddressSpaceWriteLocker locker;
 		status_t status = locker.SetTo(team);
@@ -1307,6 +1369,22 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 
 		VMTranslationMap* map = locker.AddressSpace()->TranslationMap();
 		reservedMapPages = map->MaxPagesNeededToMap(0, size - 1);
+
+		if ((protection & B_LARGE_PAGES_AREA) != 0 && !isStack)
+			largePageSize = map->LargePageSize();
+		if (size < largePageSize)
+			largePageSize = 0;
+	}
+
+	// Large pages can only be used, if the area is aligned accordingly.
+	virtual_address_restrictions largePageRestrictions;
+	if (largePageSize != 0
+		&& virtualAddressRestrictions->address_specification
+			!= B_EXACT_ADDRESS
+		&& virtualAddressRestrictions->alignment < largePageSize) {
+		largePageRestrictions = *virtualAddressRestrictions;
+		largePageRestrictions.alignment = largePageSize;
+		virtualAddressRestrictions = &largePageRestrictions;
 	}
 
 	int priority;
@@ -1361,8 +1439,20 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 	if (wiring == B_CONTIGUOUS) {
 		// we try to allocate the page run here upfront as this may easily
 		// fail for obvious reasons
-		page = vm_page_allocate_page_run(PAGE_STATE_WIRED | pageAllocFlags,
-			size / B_PAGE_SIZE, physicalAddressRestrictions, priority);
+		if (largePageSize != 0
+			&& physicalAddressRestrictions->alignment < largePageSize
+			&& physicalAddressRestrictions->boundary == 0) {
+			// try to get a run that can be mapped with large pages first
+			physical_address_restrictions largePageRestrictions
+				= *physicalAddressRestrictions;
+			largePageRestrictions.alignment = largePageSize;
+			page = vm_page_allocate_page_run(PAGE_STATE_WIRED | pageAllocFlags,
+				size / B_PAGE_SIZE, &largePageRestrictions, priority);
+		}
+		if (page == NULL) {
+			page = vm_page_allocate_page_run(PAGE_STATE_WIRED | pageAllocFlags,
+				size / B_PAGE_SIZE, physicalAddressRestrictions, priority);
+		}
 		if (page == NULL) {
 			status = B_NO_MEMORY;
 			goto err0;
@@ -1435,6 +1525,15 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 #	endif
 					continue;
 #endif
+				if (largePageSize != 0 && address % largePageSize == 0
+					&& area->Base() + area->Size() - address >= largePageSize
+					&& map_large_page(area, address, pageAllocFlags,
+						&reservation)) {
+					address += largePageSize - B_PAGE_SIZE;
+					offset += largePageSize - B_PAGE_SIZE;
+					continue;
+				}
+
 				vm_page* page = vm_page_allocate_page(&reservation,
 					PAGE_STATE_WIRED | pageAllocFlags);
 				cache->InsertPage(page, offset);
@@ -1497,6 +1596,7 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 			phys_addr_t physicalAddress
 				= (phys_addr_t)page->physical_page_number * B_PAGE_SIZE;
 			addr_t virtualAddress = area->Base();
+			addr_t largePageEnd = 0;
 			off_t offset = 0;
 
 			map->Lock();
@@ -1508,10 +1608,23 @@ vm_create_anonymous_area(team_id team, const char *name, addr_t size,
 				if (page == NULL)
 					panic("couldn't lookup physical page just allocated\n");
 
-				status = map->Map(virtualAddress, physicalAddress, protection,
-					area->MemoryType(), &reservation);
-				if (status < B_OK)
-					panic("couldn't map physical page in page run\n");
+				if (largePageSize != 0
+					&& virtualAddress % largePageSize == 0
+					&& physicalAddress % largePageSize == 0
+					&& area->Base() + area->Size() - virtualAddress
+						>= largePageSize
+					&& map->MapLargePage(virtualAddress, physicalAddress,
+						protection, area->MemoryType(), &reservation)
+							== B_OK) {
+					largePageEnd = virtualAddress + largePageSize;
+				}
+
+				if (virtualAddress >= largePageEnd) {
+					status = map->Map(virtualAddress, physicalAddress,
+						protection, area->MemoryType(), &reservation);
+					if (status < B_OK)
+						panic("couldn't map physical page in page run\n");
+				}
 
 				cache->InsertPage(page, offset);
 				increment_page_wired_count(page);
@@ -1590,6 +1703,18 @@ vm_map_physical_memory(team_id team, const char* name, void** _address,
 
 	size = PAGE_ALIGN(size);
 
+	// Large pages are only used, if the physical and virtual addresses can be
+	// aligned to them.
+	VMTranslationMap* map = locker.AddressSpace()->TranslationMap();
+	size_t largePageSize = 0;
+	if ((protection & B_LARGE_PAGES_AREA) != 0 && !alreadyWired) {
+		largePageSize = map->LargePageSize();
+		if (size < largePageSize || physicalAddress % largePageSize != 0
+			|| (addressSpec & ~B_MTR_MASK) == B_EXACT_ADDRESS) {
+			largePageSize = 0;
+		}
+	}
+
 	// create a device cache
 	status_t status = VMCacheFactory::CreateDeviceCache(cache, physicalAddress);
 	if (status != B_OK)
@@ -1602,6 +1727,7 @@ vm_map_physical_memory(team_id team, const char* name, void** _address,
 	virtual_address_restrictions addressRestrictions = {};
 	addressRestrictions.address = *_address;
 	addressRestrictions.address_specification = addressSpec & ~B_MTR_MASK;
+	addressRestrictions.alignment = largePageSize;
 	status = map_backing_store(locker.AddressSpace(), cache, 0, name, size,
 		B_FULL_LOCK, protection, REGION_NO_PRIVATE_MAP, 0, &addressRestrictions,
 		true, &area, _address);
@@ -1627,8 +1753,6 @@ vm_map_physical_memory(team_id team, const char* name, void** _address,
 	if (status != B_OK)
 		return status;
 
-	VMTranslationMap* map = locker.AddressSpace()->TranslationMap();
-
 	if (alreadyWired) {
 		// The area is already mapped, but possibly not with the right
 		// memory type.
@@ -1649,6 +1773,15 @@ vm_map_physical_memory(team_id team, const char* name, void** _address,
 		map->Lock();
 
 		for (addr_t offset = 0; offset < size; offset += B_PAGE_SIZE) {
+			if (largePageSize != 0 && offset % largePageSize == 0
+				&& size - offset >= largePageSize
+				&& map->MapLargePage(area->Base() + offset,
+					physicalAddress + offset, protection, area->MemoryType(),
+					&reservation) == B_OK) {
+				offset += largePageSize - B_PAGE_SIZE;
+				continue;
+			}
+
 			map->Map(area->Base() + offset, physicalAddress + offset,
 				protection, area->MemoryType(), &reservation);
 		}
@@ -2508,6 +2641,8 @@ vm_copy_area(team_id team, const char* name, void** _address,
 	if (status < B_OK)
 		return status;
 
+	target->access_advice = source->access_advice;
+
 	if (sharedArea) {
 		// The new area uses the old area's cache, but map_backing_store()
 		// hasn't acquired a ref. So we have to do that now.
@@ -3956,6 +4091,212 @@ vm_allocate_early(kernel_args* args, size_t virtualSize, size_t physicalSize,
 }
 
 
+//	#pragma mark - large page collapser
+
+
+/*!	Replaces the small pages mapping the \a index th large page sized chunk
+	of the given area by a large page. If the pages aren't physically
+	contiguous and suitably aligned already, their contents are moved to a
+	new page run.
+	The caller must have reserved the pages for the run in \a reservation.
+	Returns \c B_ENTRY_NOT_FOUND, if the area or the chunk doesn't exist
+	(anymore).
+*/
+static status_t
+collapse_large_page(area_id areaID, uint32 index, size_t largePageSize,
+	vm_page_reservation* reservation)
+{
+	AddressSpaceWriteLocker locker;
+	VMArea* area;
+	if (locker.SetFromArea(areaID, area) != B_OK)
+		return B_ENTRY_NOT_FOUND;
+
+	addr_t address = ROUNDUP(area->Base(), largePageSize)
+		+ index * largePageSize;
+	if (address < area->Base()
+		|| address + (largePageSize - 1) > area->Base() + (area->Size() - 1)) {
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	// Moving the pages is only safe, if the area is the only user of the
+	// pages, and nobody depends on their physical addresses.
+	if (area->wiring != B_FULL_LOCK || area->page_protections != NULL
+		|| area->IsWired(address, largePageSize)) {
+		return B_NOT_ALLOWED;
+	}
+
+	AreaCacheLocker cacheLocker(area);
+	VMCache* cache = area->cache;
+	if (!cache->temporary || cache->source != NULL
+		|| !cache->consumers.IsEmpty() || cache->areas != area
+		|| area->cache_next != NULL) {
+		return B_NOT_ALLOWED;
+	}
+
+	VMTranslationMap* map = area->address_space->TranslationMap();
+	phys_addr_t physicalAddress;
+	uint32 flags;
+	map->Lock();
+	map->Query(address, &physicalAddress, &flags);
+	map->Unlock();
+	if ((flags & PAGE_LARGE) != 0)
+		return B_OK;
+
+	page_num_t pageCount = largePageSize / B_PAGE_SIZE;
+	off_t cacheOffset = address - area->Base() + area->cache_offset;
+
+	page_num_t firstPageNumber = 0;
+	bool contiguous = true;
+	for (page_num_t i = 0; i < pageCount; i++) {
+		vm_page* page = cache->LookupPage(cacheOffset + i * B_PAGE_SIZE);
+		if (page == NULL || page->busy || page->WiredCount() != 1)
+			return B_BUSY;
+
+		if (i == 0)
+			firstPageNumber = page->physical_page_number;
+		else if (page->physical_page_number != firstPageNumber + i)
+			contiguous = false;
+	}
+
+	if (contiguous && firstPageNumber % pageCount == 0) {
+		// the pages only have to be remapped
+		physicalAddress = (phys_addr_t)firstPageNumber * B_PAGE_SIZE;
+	} else {
+		vm_page* firstPage = vm_page_allocate_large_page(reservation,
+			PAGE_STATE_WIRED, pageCount);
+		if (firstPage == NULL)
+			return B_NO_MEMORY;
+
+		firstPageNumber = firstPage->physical_page_number;
+		physicalAddress = (phys_addr_t)firstPageNumber * B_PAGE_SIZE;
+
+		// Unmap the range before copying, so that nobody can write to the
+		// old pages anymore. Accesses fault and wait for the address space
+		// lock.
+		map->Lock();
+		map->Unmap(address, address + (largePageSize - 1));
+		map->Unlock();
+
+		for (page_num_t i = 0; i < pageCount; i++) {
+			off_t offset = cacheOffset + i * B_PAGE_SIZE;
+			vm_page* oldPage = cache->LookupPage(offset);
+			vm_page* page = vm_lookup_page(firstPageNumber + i);
+
+			vm_memcpy_physical_page(physicalAddress + i * B_PAGE_SIZE,
+				(phys_addr_t)oldPage->physical_page_number * B_PAGE_SIZE);
+
+			DEBUG_PAGE_ACCESS_START(oldPage);
+			decrement_page_wired_count(oldPage);
+			cache->RemovePage(oldPage);
+			vm_page_set_state(oldPage, PAGE_STATE_FREE);
+
+			cache->InsertPage(page, offset);
+			increment_page_wired_count(page);
+			DEBUG_PAGE_ACCESS_END(page);
+		}
+	}
+
+	// The page tables for the range exist already, so the mapping doesn't
+	// need any pages.
+	map->Lock();
+	map->Unmap(address, address + (largePageSize - 1));
+	if (map->MapLargePage(address, physicalAddress, area->protection,
+			area->MemoryType(), reservation) != B_OK) {
+		for (page_num_t i = 0; i < pageCount; i++) {
+			map->Map(address + i * B_PAGE_SIZE,
+				physicalAddress + i * B_PAGE_SIZE, area->protection,
+				area->MemoryType(), reservation);
+		}
+	}
+	map->Unlock();
+
+	return B_OK;
+}
+
+
+/*!	Kernel thread that periodically looks for areas that want large pages,
+	but are (partially) mapped with small pages, because there was no
+	suitable page run when they were created, or because a large page had to
+	be split. Like khugepaged on Linux.
+	Only areas of user address spaces are considered, since the kernel may
+	access its areas in a context where it can't wait for a page fault to be
+	resolved.
+*/
+static status_t
+large_page_collapser(void* /*unused*/)
+{
+	static const bigtime_t kInterval = 5000000;
+	static const int32 kMaxAreasPerRun = 64;
+
+	size_t largePageSize
+		= VMAddressSpace::Kernel()->TranslationMap()->LargePageSize();
+	page_num_t pageCount = largePageSize / B_PAGE_SIZE;
+	area_id lastArea = -1;
+
+	while (true) {
+		snooze(kInterval);
+
+		// Collect the candidates first, since we can't lock the address
+		// spaces while holding the area hash lock. The hash table isn't
+		// ordered, so we pick the candidates with the lowest IDs after the
+		// last one we looked at, keeping them sorted.
+		area_id areas[kMaxAreasPerRun];
+		int32 areaCount = 0;
+
+		VMAreaHash::ReadLock();
+		VMAreaHashTable::Iterator it = VMAreaHash::GetIterator();
+		while (VMArea* area = it.Next()) {
+			if ((area->protection & B_LARGE_PAGES_AREA) == 0
+				|| area->wiring != B_FULL_LOCK
+				|| area->address_space == VMAddressSpace::Kernel()
+				|| area->Size() < largePageSize || area->id <= lastArea) {
+				continue;
+			}
+
+			if (areaCount == kMaxAreasPerRun) {
+				if (area->id > areas[areaCount - 1])
+					continue;
+				areaCount--;
+			}
+
+			int32 index = areaCount++;
+			for (; index > 0 && areas[index - 1] > area->id; index--)
+				areas[index] = areas[index - 1];
+			areas[index] = area->id;
+		}
+		VMAreaHash::ReadUnlock();
+
+		// continue with the remaining areas next time
+		lastArea = areaCount == kMaxAreasPerRun ? areas[areaCount - 1] : -1;
+
+		for (int32 i = 0; i < areaCount; i++) {
+			for (uint32 index = 0;; index++) {
+				vm_page_reservation reservation;
+				if (!vm_page_try_reserve_pages(&reservation, pageCount,
+						VM_PRIORITY_USER)) {
+					break;
+				}
+
+				status_t status = collapse_large_page(areas[i], index,
+					largePageSize, &reservation);
+
+				vm_page_unreserve_pages(&reservation);
+
+				if (status == B_ENTRY_NOT_FOUND || status == B_NOT_ALLOWED
+					|| status == B_NO_MEMORY) {
+					break;
+				}
+			}
+		}
+	}
+
+	return B_OK;
+}
+
+
+//	#pragma mark -
+
+
 /*!	The main entrance point to initialize the VM. */
 status_t
 vm_init(kernel_args* args)
@@ -4154,6 +4495,14 @@ vm_init_post_thread(kernel_args* args)
 {
 	vm_page_init_post_thread(args);
 	slab_init_post_thread();
+
+	if (VMAddressSpace::Kernel()->TranslationMap()->LargePageSize() != 0) {
+		thread_id thread = spawn_kernel_thread(&large_page_collapser,
+			"large page collapser", B_LOWEST_ACTIVE_PRIORITY, NULL);
+		if (thread >= 0)
+			resume_thread(thread);
+	}
+
 	return heap_init_post_thread();
 }
 
@@ -4161,6 +4510,21 @@ vm_init_post_thread(kernel_args* args)
 status_t
 vm_init_post_modules(kernel_args* args)
 {
+	void* settings = load_driver_settings("virtual_memory");
+	if (settings != NULL) {
+		const char* faultAround = get_driver_parameter(settings,
+			"fault_around", NULL, NULL);
+		if (faultAround != NULL) {
+			// only powers of two are supported
+			uint32 pages = std::min((uint32)strtoul(faultAround, NULL, 0),
+				kMaxFaultAroundPages);
+			while ((pages & (pages - 1)) != 0)
+				pages &= pages - 1;
+			sFaultAroundPages = pages;
+		}
+		unload_driver_settings(settings);
+	}
+
 	return arch_vm_init_post_modules(args);
 }
 
@@ -4543,6 +4907,129 @@ fault_get_page(PageFaultContext& context)
 }
 
 
+/*!	Maps the pages around \a faultAddress that are already cached and not
+	mapped yet, after the page at \a faultAddress has been mapped for a read
+	fault. The locks acquired by fault_get_page() must still be held.
+	Only pages in the caches from the top cache down to the cache of the
+	faulting page are considered; like in fault_get_page(), a page is only
+	used, if no cache above it has or could page in the same page.
+*/
+static void
+fault_around(PageFaultContext& context, VMArea* area, addr_t faultAddress,
+	bool isUser)
+{
+	size_t windowSize = (size_t)sFaultAroundPages * B_PAGE_SIZE;
+	addr_t start = std::max(ROUNDDOWN(faultAddress, windowSize), area->Base());
+	addr_t last = std::min(start + (windowSize - 1),
+		area->Base() + (area->Size() - 1));
+
+	VMCache* bottomCache = context.page->Cache();
+	bool isKernelSpace = area->address_space == VMAddressSpace::Kernel();
+	uint32 readProtection = isUser ? B_READ_AREA : B_KERNEL_READ_AREA;
+
+	vm_page* pages[kMaxFaultAroundPages];
+	vm_page_mapping* mappings[kMaxFaultAroundPages];
+	addr_t addresses[kMaxFaultAroundPages];
+	uint32 protections[kMaxFaultAroundPages];
+	uint32 count = 0;
+
+	// collect the pages and allocate their mappings
+	uint32 pageCount = (last - start) / B_PAGE_SIZE + 1;
+	for (uint32 i = 0; i < pageCount; i++) {
+		addr_t address = start + i * B_PAGE_SIZE;
+		if (address == faultAddress)
+			continue;
+
+		uint32 protection = get_area_page_protection(area, address);
+		if ((protection & readProtection) == 0)
+			continue;
+
+		off_t cacheOffset = address - area->Base() + area->cache_offset;
+		vm_page* page = NULL;
+		for (VMCache* cache = context.topCache; cache != NULL;
+				cache = cache->source) {
+			page = cache->LookupPage(cacheOffset);
+			if (page != NULL || cache == bottomCache
+				|| cache->HasPage(cacheOffset)) {
+				break;
+			}
+		}
+
+		if (page == NULL || page->busy)
+			continue;
+
+		if (page->Cache() != context.topCache)
+			protection &= ~(B_WRITE_AREA | B_KERNEL_WRITE_AREA);
+
+		vm_page_mapping* mapping = (vm_page_mapping*)object_cache_alloc(
+			gPageMappingsObjectCache, CACHE_DONT_WAIT_FOR_MEMORY
+				| (isKernelSpace ? CACHE_DONT_LOCK_KERNEL_SPACE : 0));
+		if (mapping == NULL)
+			break;
+
+		DEBUG_PAGE_ACCESS_START(page);
+
+		mapping->page = page;
+		mapping->area = area;
+		pages[count] = page;
+		mappings[count] = mapping;
+		addresses[count] = address;
+		protections[count] = protection;
+		count++;
+	}
+
+	if (count == 0)
+		return;
+
+	// map all pages that aren't mapped yet with a single map lock
+	VMTranslationMap* map = context.map;
+	bool wasMapped[kMaxFaultAroundPages];
+
+	map->Lock();
+
+	for (uint32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+		addr_t address = addresses[i];
+
+		phys_addr_t physicalAddress;
+		uint32 flags;
+		if (map->Query(address, &physicalAddress, &flags) == B_OK
+			&& (flags & PAGE_PRESENT) != 0) {
+			continue;
+		}
+
+		wasMapped[i] = page->IsMapped();
+
+		map->Map(address, page->physical_page_number * B_PAGE_SIZE,
+			protections[i], area->MemoryType(), &context.reservation);
+
+		if (!wasMapped[i])
+			atomic_add(&gMappedPagesCount, 1);
+
+		page->mappings.Add(mappings[i]);
+		area->mappings.Add(mappings[i]);
+		mappings[i] = NULL;
+	}
+
+	map->Unlock();
+
+	for (uint32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+		if (mappings[i] != NULL) {
+			object_cache_free(gPageMappingsObjectCache, mappings[i],
+				CACHE_DONT_WAIT_FOR_MEMORY
+					| (isKernelSpace ? CACHE_DONT_LOCK_KERNEL_SPACE : 0));
+		} else if (!wasMapped[i]
+			&& (page->State() == PAGE_STATE_CACHED
+				|| page->State() == PAGE_STATE_INACTIVE)) {
+			vm_page_set_state(page, PAGE_STATE_ACTIVE);
+		}
+
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+}
+
+
 /*!	Makes sure the address in the given address space is mapped.
 
 	\param addressSpace The address space.
@@ -4567,6 +5054,12 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 	addr_t address = ROUNDDOWN(originalAddress, B_PAGE_SIZE);
 	status_t status = B_OK;
 
+	// file range to prefetch for sequential faults
+	dev_t prefetchDevice = -1;
+	ino_t prefetchNode = -1;
+	off_t prefetchOffset = 0;
+	size_t prefetchSize = 0;
+
 	addressSpace->IncrementFaultCount();
 
 	// We may need up to 2 pages plus pages needed for mapping them -- reserving
@@ -4574,6 +5067,13 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 	// page daemon/thief can do their job without problems.
 	size_t reservePages = 2 + context.map->MaxPagesNeededToMap(originalAddress,
 		originalAddress);
+	if (!isWrite && wirePage == NULL && sFaultAroundPages > 1) {
+		// fault_around() might need to map a whole window
+		size_t windowSize = (size_t)sFaultAroundPages * B_PAGE_SIZE;
+		addr_t windowStart = ROUNDDOWN(originalAddress, windowSize);
+		reservePages = 2 + context.map->MaxPagesNeededToMap(windowStart,
+			windowStart + (windowSize - 1));
+	}
 	context.addressSpaceLocker.Unlock();
 	vm_page_reserve_pages(&context.reservation, reservePages,
 		addressSpace == VMAddressSpace::Kernel()
@@ -4778,9 +5278,46 @@ vm_soft_fault(VMAddressSpace* addressSpace, addr_t originalAddress,
 
 		DEBUG_PAGE_ACCESS_END(context.page);
 
+		if (!isWrite && wirePage == NULL && area->wiring == B_NO_LOCK
+			&& area->access_advice != MADV_RANDOM) {
+			// Track sequential read faults. The area is only read locked,
+			// so concurrent faults may race here, but this is only a hint.
+			size_t windowSize = (size_t)std::max(sFaultAroundPages, (uint32)1)
+				* B_PAGE_SIZE;
+			if (address > area->last_fault_address
+				&& address - area->last_fault_address <= 2 * windowSize) {
+				area->sequential_faults++;
+			} else
+				area->sequential_faults = 0;
+			area->last_fault_address = address;
+
+			if (sFaultAroundPages > 1)
+				fault_around(context, area, address, isUser);
+
+			VMCache* pageCache = context.page->Cache();
+			bool sequential = area->access_advice == MADV_SEQUENTIAL;
+			if ((sequential
+					|| area->sequential_faults >= kSequentialFaultThreshold)
+				&& pageCache->type == CACHE_TYPE_VNODE) {
+				VMVnodeCache* vnodeCache = (VMVnodeCache*)pageCache;
+				prefetchDevice = vnodeCache->DeviceId();
+				prefetchNode = vnodeCache->InodeId();
+				prefetchOffset = context.cacheOffset + windowSize;
+				prefetchSize = sequential ? kMaxFaultReadAhead : std::min(
+					windowSize << std::min(area->sequential_faults, (uint32)8),
+					kMaxFaultReadAhead);
+			}
+		}
+
 		break;
 	}
 
+	if (prefetchSize > 0) {
+		context.UnlockAll();
+		cache_prefetch(prefetchDevice, prefetchNode, prefetchOffset,
+			prefetchSize);
+	}
+
 	return status;
 }
 
@@ -6673,10 +7210,153 @@ _user_sync_memory(void* _address, size_t size, uint32 flags)
 }
 
 
+/*!	Discards or marks discardable the pages of the given range of a
+	\c B_NO_LOCK area, depending on whether \a advice is \c MADV_DONTNEED or
+	\c MADV_FREE. The pages are always unmapped, but only those of a private
+	anonymous cache, or of the private copy of a file mapping, are actually
+	dropped, so that the range reverts to zeros, respectively the contents of
+	the file. The address space must be read locked via \a locker.
+	\return \c B_OK, or \c B_BUSY, if the function had to wait for a wired
+		range and the caller has to start over.
+*/
+static status_t
+discard_area_range(VMArea* area, addr_t address, size_t size, uint32 advice,
+	AddressSpaceReadLocker& locker)
+{
+	// We need to lock the complete cache chain, since we potentially unmap
+	// pages of lower caches.
+	VMCache* topCache = vm_area_get_locked_cache(area);
+	VMCacheChainLocker cacheChainLocker(topCache);
+	cacheChainLocker.LockAllSourceCaches();
+
+	if (wait_if_area_range_is_wired(area, address, size, &locker,
+			&cacheChainLocker)) {
+		return B_BUSY;
+	}
+
+	unmap_pages(area, address, size);
+
+	// Only drop pages no one else can see. If a lower cache is temporary,
+	// too, the memory is shared copy-on-write with another team, and the
+	// pages would revert to the state before the fork rather than to zeros.
+	bool discardable = topCache->temporary && topCache->areas == area
+		&& area->cache_next == NULL && topCache->consumers.IsEmpty()
+		&& (topCache->source == NULL || !topCache->source->temporary);
+	if (!discardable)
+		return B_OK;
+
+	off_t offset = address - area->Base() + area->cache_offset;
+
+	// VMCache::Discard() can temporarily drop the lock, so we must unlock all
+	// lower caches to prevent locking order inversion.
+	cacheChainLocker.Unlock(topCache);
+	if (advice == MADV_DONTNEED)
+		topCache->Discard(offset, size);
+	else
+		topCache->MarkDiscardable(offset, size);
+	topCache->ReleaseRefAndUnlock();
+
+	return B_OK;
+}
+
+
 status_t
-_user_memory_advice(void* address, size_t size, uint32 advice)
+_user_memory_advice(void* _address, size_t size, uint32 advice)
 {
-	// TODO: Implement!
+	addr_t address = (addr_t)_address;
+	size = PAGE_ALIGN(size);
+
+	// check params
+	if ((address % B_PAGE_SIZE) != 0)
+		return B_BAD_VALUE;
+	if ((addr_t)address + size < (addr_t)address || !IS_USER_ADDRESS(address)
+		|| !IS_USER_ADDRESS((addr_t)address + size)) {
+		// weird error code required by POSIX
+		return ENOMEM;
+	}
+
+	switch (advice) {
+		case MADV_NORMAL:
+		case MADV_SEQUENTIAL:
+		case MADV_RANDOM:
+		case MADV_WILLNEED:
+		case MADV_DONTNEED:
+		case MADV_FREE:
+			break;
+		default:
+			return B_BAD_VALUE;
+	}
+
+	// iterate through the range and apply the advice to all concerned areas
+	while (size > 0) {
+		// read lock the address space
+		AddressSpaceReadLocker locker;
+		status_t error = locker.SetTo(team_get_current_team_id());
+		if (error != B_OK)
+			return error;
+
+		VMArea* area = locker.AddressSpace()->LookupArea(address);
+		if (area == NULL)
+			return B_NO_MEMORY;
+
+		if ((area->protection & B_KERNEL_AREA) != 0)
+			return B_NOT_ALLOWED;
+
+		addr_t offset = address - area->Base();
+		size_t rangeSize = min_c(area->Size() - offset, size);
+
+		switch (advice) {
+			case MADV_NORMAL:
+			case MADV_SEQUENTIAL:
+			case MADV_RANDOM:
+				area->access_advice = advice;
+				area->sequential_faults = 0;
+				break;
+
+			case MADV_WILLNEED:
+			{
+				// Only file mappings can be read in ahead of time.
+				VMCache* topCache = vm_area_get_locked_cache(area);
+				VMCacheChainLocker cacheChainLocker(topCache);
+				cacheChainLocker.LockAllSourceCaches();
+
+				VMCache* bottomCache = topCache;
+				while (bottomCache->source != NULL)
+					bottomCache = bottomCache->source;
+
+				if (bottomCache->type != CACHE_TYPE_VNODE)
+					break;
+
+				VMVnodeCache* vnodeCache = (VMVnodeCache*)bottomCache;
+				dev_t device = vnodeCache->DeviceId();
+				ino_t node = vnodeCache->InodeId();
+				off_t cacheOffset = offset + area->cache_offset;
+
+				cacheChainLocker.Unlock();
+				locker.Unlock();
+
+				cache_prefetch(device, node, cacheOffset, rangeSize);
+				break;
+			}
+
+			case MADV_DONTNEED:
+			case MADV_FREE:
+				if (area->wiring != B_NO_LOCK)
+					return B_BAD_VALUE;
+
+				error = discard_area_range(area, address, rangeSize, advice,
+					locker);
+				if (error == B_BUSY) {
+					// we had to wait for a wired range, try again
+					continue;
+				}
+				break;
+		}
+
+		address += rangeSize;
+		size -= rangeSize;
+	}
+
 	return B_OK;
 }
 
@@ -6702,6 +7382,21 @@ _user_get_memory_properties(team_id teamID, const void* address,
 	if (area->page_protections != NULL)
 		protection = get_area_page_protection(area, (addr_t)address);
 
+	// B_LARGE_PAGES_AREA is only reported, if the address is actually mapped
+	// by a large page
+	protection &= ~B_LARGE_PAGES_AREA;
+
+	VMTranslationMap* map = locker.AddressSpace()->TranslationMap();
+	phys_addr_t physicalAddress;
+	uint32 flags;
+	map->Lock();
+	if (map->Query(ROUNDDOWN((addr_t)address, B_PAGE_SIZE), &physicalAddress,
+			&flags) == B_OK
+		&& (flags & PAGE_LARGE) != 0) {
+		protection |= B_LARGE_PAGES_AREA;
+	}
+	map->Unlock();
+
 	uint32 wiring = area->wiring;
 
 	locker.Unlock();
@@ -27,6 +27,8 @@
 #include <heap.h>
 #include <kernel.h>
 #include <low_resource_manager.h>
+#include <numa.h>
+#include <smp.h>
 #include <thread.h>
 #include <tracing.h>
 #include <util/AutoLock.h>
@@ -103,9 +105,13 @@ static const int32 kPageUsageDecline = 1;
 int32 gMappedPagesCount;
 
 static VMPageQueue sPageQueues[PAGE_STATE_COUNT];
+	// the entries for the free and clear states are unused
+
+// The free and clear pages are kept in one queue per NUMA node each.
+static VMPageQueue sFreePageQueues[MAX_NUMA_NODES];
+static VMPageQueue sClearPageQueues[MAX_NUMA_NODES];
+static int32 sNodeCount = 1;
 
-static VMPageQueue& sFreePageQueue = sPageQueues[PAGE_STATE_FREE];
-static VMPageQueue& sClearPageQueue = sPageQueues[PAGE_STATE_CLEAR];
 static VMPageQueue& sModifiedPageQueue = sPageQueues[PAGE_STATE_MODIFIED];
 static VMPageQueue& sInactivePageQueue = sPageQueues[PAGE_STATE_INACTIVE];
 static VMPageQueue& sActivePageQueue = sPageQueues[PAGE_STATE_ACTIVE];
@@ -133,6 +139,58 @@ static mutex sPageDeficitLock = MUTEX_INITIALIZER("page deficit");
 static rw_lock sFreePageQueuesLock
 	= RW_LOCK_INITIALIZER("free/clear page queues");
 
+// Per-CPU caches of free and clear pages, which allow allocating and freeing
+// pages without touching the global free/clear queues most of the time. They
+// are refilled from and drained to the global queues in batches, which
+// requires sFreePageQueuesLock to be held.
+// The pages in the caches are in the free or clear state, but not in the
+// global queues. Whoever looks for free pages by their state needs to disable
+// the caches (cf. PerCPUPagesDisabler) while holding the write lock.
+// A cache only holds pages of its CPU's NUMA node.
+struct PerCPUPages {
+	spinlock	lock;
+	int32		node;
+	VMPageQueue	freePages;
+	VMPageQueue	clearPages;
+} CACHE_LINE_ALIGN;
+
+static const uint32 kPerCPUPageBatch = 32;
+static const uint32 kPerCPUPageHigh = 4 * kPerCPUPageBatch;
+	// when a cache grows beyond this, a batch is returned to the global queues
+
+static PerCPUPages sPerCPUPages[SMP_MAX_CPUS];
+static int32 sPerCPUPagesDisabled = 1;
+	// enabled in vm_page_init_post_thread()
+
+static page_num_t count_per_cpu_pages();
+
+
+static inline VMPageQueue&
+free_page_queue_of_node(int32 node, bool clear)
+{
+	return (clear ? sClearPageQueues : sFreePageQueues)[node];
+}
+
+
+static inline VMPageQueue&
+free_page_queue(const vm_page* page, bool clear)
+{
+	return free_page_queue_of_node(page->numa_node, clear);
+}
+
+
+static page_num_t
+count_free_pages(bool clear)
+{
+	VMPageQueue* queues = clear ? sClearPageQueues : sFreePageQueues;
+
+	page_num_t count = 0;
+	for (int32 i = 0; i < sNodeCount; i++)
+		count += queues[i].Count();
+
+	return count;
+}
+
 #ifdef TRACK_PAGE_USAGE_STATS
 static page_num_t sPageUsageArrays[512];
 static page_num_t* sPageUsage = sPageUsageArrays;
@@ -771,9 +829,7 @@ find_page(int argc, char **argv)
 	struct {
 		const char*	name;
 		VMPageQueue*	queue;
-	} pageQueueInfos[] = {
-		{ "free",		&sFreePageQueue },
-		{ "clear",		&sClearPageQueue },
+	} pageQueueInfos[2 * MAX_NUMA_NODES + 5] = {
 		{ "modified",	&sModifiedPageQueue },
 		{ "active",		&sActivePageQueue },
 		{ "inactive",	&sInactivePageQueue },
@@ -792,6 +848,13 @@ find_page(int argc, char **argv)
 	address = strtoul(argv[index], NULL, 0);
 	page = (vm_page*)address;
 
+	for (int32 node = 0; node < sNodeCount; node++) {
+		pageQueueInfos[4 + 2 * node].name = "free";
+		pageQueueInfos[4 + 2 * node].queue = &sFreePageQueues[node];
+		pageQueueInfos[5 + 2 * node].name = "clear";
+		pageQueueInfos[5 + 2 * node].queue = &sClearPageQueues[node];
+	}
+
 	for (i = 0; pageQueueInfos[i].name; i++) {
 		VMPageQueue::Iterator it = pageQueueInfos[i].queue->GetIterator();
 		while (vm_page* p = it.Next()) {
@@ -965,6 +1028,27 @@ dump_page(int argc, char **argv)
 }
 
 
+static void
+dump_page_queue(VMPageQueue* queue, bool list)
+{
+	kprintf("queue = %p, queue->head = %p, queue->tail = %p, queue->count = %"
+		B_PRIuPHYSADDR "\n", queue, queue->Head(), queue->Tail(),
+		queue->Count());
+
+	if (list) {
+		struct vm_page *page = queue->Head();
+
+		kprintf("page        cache       type       state  wired  usage\n");
+		for (page_num_t i = 0; page; i++, page = queue->Next(page)) {
+			kprintf("%p  %p  %-7s %8s  %5d  %5d\n", page, page->Cache(),
+				vm_cache_type_to_string(page->Cache()->type),
+				page_state_to_string(page->State()),
+				page->WiredCount(), page->usage_count);
+		}
+	}
+}
+
+
 static int
 dump_page_queue(int argc, char **argv)
 {
@@ -975,13 +1059,21 @@ dump_page_queue(int argc, char **argv)
 		return 0;
 	}
 
+	bool list = argc == 3;
+
 	if (strlen(argv[1]) >= 2 && argv[1][0] == '0' && argv[1][1] == 'x')
 		queue = (VMPageQueue*)strtoul(argv[1], NULL, 16);
-	else if (!strcmp(argv[1], "free"))
-		queue = &sFreePageQueue;
-	else if (!strcmp(argv[1], "clear"))
-		queue = &sClearPageQueue;
-	else if (!strcmp(argv[1], "modified"))
+	else if (!strcmp(argv[1], "free") || !strcmp(argv[1], "clear")) {
+		// there is one queue per NUMA node
+		VMPageQueue* queues = !strcmp(argv[1], "free")
+			? sFreePageQueues : sClearPageQueues;
+		for (int32 i = 0; i < sNodeCount; i++) {
+			if (sNodeCount > 1)
+				kprintf("node %" B_PRId32 ": ", i);
+			dump_page_queue(&queues[i], list);
+		}
+		return 0;
+	} else if (!strcmp(argv[1], "modified"))
 		queue = &sModifiedPageQueue;
 	else if (!strcmp(argv[1], "active"))
 		queue = &sActivePageQueue;
@@ -994,21 +1086,7 @@ dump_page_queue(int argc, char **argv)
 		return 0;
 	}
 
-	kprintf("queue = %p, queue->head = %p, queue->tail = %p, queue->count = %"
-		B_PRIuPHYSADDR "\n", queue, queue->Head(), queue->Tail(),
-		queue->Count());
-
-	if (argc == 3) {
-		struct vm_page *page = queue->Head();
-
-		kprintf("page        cache       type       state  wired  usage\n");
-		for (page_num_t i = 0; page; i++, page = queue->Next(page)) {
-			kprintf("%p  %p  %-7s %8s  %5d  %5d\n", page, page->Cache(),
-				vm_cache_type_to_string(page->Cache()->type),
-				page_state_to_string(page->State()),
-				page->WiredCount(), page->usage_count);
-		}
-	}
+	dump_page_queue(queue, list);
 	return 0;
 }
 
@@ -1113,10 +1191,15 @@ dump_page_stats(int argc, char **argv)
 			waiter->missing, waiter->dontTouch);
 	}
 
-	kprintf("\nfree queue: %p, count = %" B_PRIuPHYSADDR "\n", &sFreePageQueue,
-		sFreePageQueue.Count());
-	kprintf("clear queue: %p, count = %" B_PRIuPHYSADDR "\n", &sClearPageQueue,
-		sClearPageQueue.Count());
+	kprintf("\n");
+	for (int32 i = 0; i < sNodeCount; i++) {
+		kprintf("node %" B_PRId32 " free queue: %p, count = %" B_PRIuPHYSADDR
+			"\n", i, &sFreePageQueues[i], sFreePageQueues[i].Count());
+		kprintf("node %" B_PRId32 " clear queue: %p, count = %" B_PRIuPHYSADDR
+			"\n", i, &sClearPageQueues[i], sClearPageQueues[i].Count());
+	}
+	kprintf("per-CPU caches: count = %" B_PRIuPHYSADDR "\n",
+		count_per_cpu_pages());
 	kprintf("modified queue: %p, count = %" B_PRIuPHYSADDR " (%" B_PRId32
 		" temporary, %" B_PRIuPHYSADDR " swappable, " "inactive: %"
 		B_PRIuPHYSADDR ")\n", &sModifiedPageQueue, sModifiedPageQueue.Count(),
@@ -1461,6 +1544,231 @@ unreserve_pages(uint32 count)
 }
 
 
+// #pragma mark - per-CPU page caches
+
+
+static inline void
+init_allocated_page(vm_page* page, uint32 flags)
+{
+	page->SetState(flags & VM_PAGE_ALLOC_STATE);
+	page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
+	page->usage_count = 0;
+	page->accessed = false;
+	page->modified = false;
+}
+
+
+/*!	Moves up to \a count pages from the tail of \a cacheQueue to the global
+	\a queue. The caller must hold the cache's lock and sFreePageQueuesLock.
+*/
+static void
+drain_per_cpu_queue(VMPageQueue& cacheQueue, VMPageQueue& queue, uint32 count)
+{
+	SpinLocker locker(queue.GetLock());
+
+	for (; count > 0; count--) {
+		vm_page* page = cacheQueue.Tail();
+		if (page == NULL)
+			break;
+
+		cacheQueue.Remove(page);
+		queue.Append(page);
+	}
+}
+
+
+/*!	Returns the pages of all per-CPU caches to the global queues. The caller
+	must hold sFreePageQueuesLock write locked.
+*/
+static void
+drain_all_per_cpu_pages()
+{
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		PerCPUPages& cache = sPerCPUPages[i];
+		InterruptsSpinLocker locker(cache.lock);
+
+		drain_per_cpu_queue(cache.freePages,
+			free_page_queue_of_node(cache.node, false), UINT32_MAX);
+		drain_per_cpu_queue(cache.clearPages,
+			free_page_queue_of_node(cache.node, true), UINT32_MAX);
+	}
+}
+
+
+static page_num_t
+count_per_cpu_pages()
+{
+	page_num_t count = 0;
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		count += sPerCPUPages[i].freePages.Count()
+			+ sPerCPUPages[i].clearPages.Count();
+	}
+
+	return count;
+}
+
+
+/*!	Disables the per-CPU caches and drains them, so that all free and clear
+	pages are in the global queues, until the object goes out of scope. The
+	caller must hold sFreePageQueuesLock write locked when creating it.
+*/
+struct PerCPUPagesDisabler {
+	PerCPUPagesDisabler(bool drain = true)
+	{
+		atomic_add(&sPerCPUPagesDisabled, 1);
+		if (drain)
+			drain_all_per_cpu_pages();
+	}
+
+	~PerCPUPagesDisabler()
+	{
+		atomic_add(&sPerCPUPagesDisabled, -1);
+	}
+};
+
+
+/*!	Locks and returns the current CPU's page cache, or returns \c NULL, if
+	the caches are disabled.
+*/
+static PerCPUPages*
+lock_per_cpu_pages(InterruptsSpinLocker& locker)
+{
+	if (atomic_get(&sPerCPUPagesDisabled) != 0)
+		return NULL;
+
+	// If we get migrated to another CPU in the meantime, we'll just use the
+	// cache of the previous one.
+	PerCPUPages* cache = &sPerCPUPages[smp_get_current_cpu()];
+	locker.SetTo(cache->lock, false);
+
+	if (sPerCPUPagesDisabled != 0) {
+		locker.Unlock();
+		return NULL;
+	}
+
+	return cache;
+}
+
+
+/*!	Allocates a page from the current CPU's cache. The page is initialized
+	according to \a flags before the cache is unlocked, so that it can never
+	be seen in a free state outside of any queue.
+*/
+static vm_page*
+allocate_per_cpu_page(bool clear, uint32 flags, int& _oldPageState)
+{
+	InterruptsSpinLocker locker;
+	PerCPUPages* cache = lock_per_cpu_pages(locker);
+	if (cache == NULL)
+		return NULL;
+
+	vm_page* page = (clear ? cache->clearPages : cache->freePages).RemoveHead();
+	if (page == NULL)
+		return NULL;
+
+	DEBUG_PAGE_ACCESS_START(page);
+
+	_oldPageState = page->State();
+	init_allocated_page(page, flags);
+	return page;
+}
+
+
+/*!	Moves a batch of pages from the free or clear queue of the current CPU's
+	node to the CPU's cache, and allocates one of them like
+	allocate_per_cpu_page().
+	The caller must hold sFreePageQueuesLock read locked.
+*/
+static vm_page*
+refill_per_cpu_pages(bool clear, uint32 flags, int& _oldPageState)
+{
+	InterruptsSpinLocker locker;
+	PerCPUPages* cache = lock_per_cpu_pages(locker);
+	if (cache == NULL)
+		return NULL;
+
+	VMPageQueue& queue = free_page_queue_of_node(cache->node, clear);
+	VMPageQueue& cacheQueue = clear ? cache->clearPages : cache->freePages;
+
+	SpinLocker queueLocker(queue.GetLock());
+
+	vm_page* page = queue.RemoveHead();
+	if (page == NULL)
+		return NULL;
+
+	for (uint32 i = 1; i < kPerCPUPageBatch; i++) {
+		vm_page* cachedPage = queue.RemoveHead();
+		if (cachedPage == NULL)
+			break;
+
+		cacheQueue.Append(cachedPage);
+	}
+
+	queueLocker.Unlock();
+
+	DEBUG_PAGE_ACCESS_START(page);
+
+	_oldPageState = page->State();
+	init_allocated_page(page, flags);
+	return page;
+}
+
+
+/*!	Frees \a page to the current CPU's cache. If the cache has grown too
+	large, a batch of pages is returned to the global queues.
+	Returns \c false, if the caches are disabled, or if the page belongs to
+	another NUMA node.
+*/
+static bool
+free_per_cpu_page(vm_page* page, bool clear)
+{
+	InterruptsSpinLocker locker;
+	PerCPUPages* cache = lock_per_cpu_pages(locker);
+	if (cache == NULL)
+		return false;
+
+	if (page->numa_node != cache->node)
+		return false;
+
+	DEBUG_PAGE_ACCESS_END(page);
+
+	if (clear) {
+		page->SetState(PAGE_STATE_CLEAR);
+		cache->clearPages.Prepend(page);
+	} else {
+		page->SetState(PAGE_STATE_FREE);
+		cache->freePages.Prepend(page);
+	}
+
+	if (cache->freePages.Count() + cache->clearPages.Count()
+			<= kPerCPUPageHigh) {
+		return true;
+	}
+
+	locker.Unlock();
+
+	// Return the coldest pages, preferring to keep the clear ones.
+	ReadLocker queuesLocker(sFreePageQueuesLock);
+	locker.SetTo(cache->lock, false);
+
+	uint32 count = kPerCPUPageBatch;
+	if (cache->freePages.Count() < count) {
+		drain_per_cpu_queue(cache->clearPages,
+			free_page_queue_of_node(cache->node, true),
+			count - cache->freePages.Count());
+	}
+	drain_per_cpu_queue(cache->freePages,
+		free_page_queue_of_node(cache->node, false), count);
+
+	return true;
+}
+
+
+// #pragma mark -
+
+
 static void
 free_page(vm_page* page, bool clear)
 {
@@ -1511,17 +1819,15 @@ free_page(vm_page* page, bool clear)
 	page->allocation_tracking_info.Clear();
 #endif
 
+	if (free_per_cpu_page(page, clear))
+		return;
+
 	ReadLocker locker(sFreePageQueuesLock);
 
 	DEBUG_PAGE_ACCESS_END(page);
 
-	if (clear) {
-		page->SetState(PAGE_STATE_CLEAR);
-		sClearPageQueue.PrependUnlocked(page);
-	} else {
-		page->SetState(PAGE_STATE_FREE);
-		sFreePageQueue.PrependUnlocked(page);
-	}
+	page->SetState(clear ? PAGE_STATE_CLEAR : PAGE_STATE_FREE);
+	free_page_queue(page, clear).PrependUnlocked(page);
 
 	locker.Unlock();
 }
@@ -1686,6 +1992,7 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 	}
 
 	WriteLocker locker(sFreePageQueuesLock);
+	PerCPUPagesDisabler perCPUPagesDisabler;
 
 	for (page_num_t i = 0; i < length; i++) {
 		vm_page *page = &sPages[startPage + i];
@@ -1697,9 +2004,8 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 // the free/clear queues without having reserved them before. This should happen
 // in the early boot process only, though.
 				DEBUG_PAGE_ACCESS_START(page);
-				VMPageQueue& queue = page->State() == PAGE_STATE_FREE
-					? sFreePageQueue : sClearPageQueue;
-				queue.Remove(page);
+				free_page_queue(page, page->State() == PAGE_STATE_CLEAR)
+					.Remove(page);
 				page->SetState(wired ? PAGE_STATE_WIRED : PAGE_STATE_UNUSED);
 				page->busy = false;
 				atomic_add(&sUnreservedFreePages, -1);
@@ -1741,7 +2047,7 @@ page_scrubber(void *unused)
 	for (;;) {
 		snooze(100000); // 100ms
 
-		if (sFreePageQueue.Count() == 0
+		if (count_free_pages(false) == 0
 				|| atomic_get(&sUnreservedFreePages)
 					< (int32)sFreePagesTarget) {
 			continue;
@@ -1757,21 +2063,24 @@ page_scrubber(void *unused)
 		if (reserved == 0)
 			continue;
 
-		// get some pages from the free queue
+		// get some pages from the free queues
 		ReadLocker locker(sFreePageQueuesLock);
 
 		vm_page *page[SCRUB_SIZE];
 		int32 scrubCount = 0;
-		for (int32 i = 0; i < reserved; i++) {
-			page[i] = sFreePageQueue.RemoveHeadUnlocked();
-			if (page[i] == NULL)
-				break;
+		int32 node = 0;
+		while (scrubCount < reserved && node < sNodeCount) {
+			vm_page* freePage = sFreePageQueues[node].RemoveHeadUnlocked();
+			if (freePage == NULL) {
+				node++;
+				continue;
+			}
 
-			DEBUG_PAGE_ACCESS_START(page[i]);
+			DEBUG_PAGE_ACCESS_START(freePage);
 
-			page[i]->SetState(PAGE_STATE_ACTIVE);
-			page[i]->busy = true;
-			scrubCount++;
+			freePage->SetState(PAGE_STATE_ACTIVE);
+			freePage->busy = true;
+			page[scrubCount++] = freePage;
 		}
 
 		locker.Unlock();
@@ -1794,7 +2103,7 @@ page_scrubber(void *unused)
 			page[i]->SetState(PAGE_STATE_CLEAR);
 			page[i]->busy = false;
 			DEBUG_PAGE_ACCESS_END(page[i]);
-			sClearPageQueue.PrependUnlocked(page[i]);
+			free_page_queue(page[i], true).PrependUnlocked(page[i]);
 		}
 
 		locker.Unlock();
@@ -2573,7 +2882,7 @@ free_cached_pages(uint32 pagesToFree, bool dontWait)
 			ReadLocker locker(sFreePageQueuesLock);
 			page->SetState(PAGE_STATE_FREE);
 			DEBUG_PAGE_ACCESS_END(page);
-			sFreePageQueue.PrependUnlocked(page);
+			free_page_queue(page, false).PrependUnlocked(page);
 			locker.Unlock();
 
 			TA(StolenPage());
@@ -3261,8 +3570,19 @@ vm_page_init(kernel_args *args)
 	sInactivePageQueue.Init("inactive pages queue");
 	sActivePageQueue.Init("active pages queue");
 	sCachedPageQueue.Init("cached pages queue");
-	sFreePageQueue.Init("free pages queue");
-	sClearPageQueue.Init("clear pages queue");
+	sNodeCount = numa_node_count();
+	for (int32 i = 0; i < sNodeCount; i++) {
+		sFreePageQueues[i].Init("free pages queue");
+		sClearPageQueues[i].Init("clear pages queue");
+	}
+
+	for (int32 i = 0; i < SMP_MAX_CPUS; i++) {
+		B_INITIALIZE_SPINLOCK(&sPerCPUPages[i].lock);
+		sPerCPUPages[i].node
+			= i < (int32)args->num_cpus ? numa_cpu_node(i) : 0;
+		sPerCPUPages[i].freePages.Init("per-CPU free pages");
+		sPerCPUPages[i].clearPages.Init("per-CPU clear pages");
+	}
 
 	new (&sPageReservationWaiters) PageReservationWaiterList;
 
@@ -3277,7 +3597,9 @@ vm_page_init(kernel_args *args)
 	// initialize the free page table
 	for (uint32 i = 0; i < sNumPages; i++) {
 		sPages[i].Init(sPhysicalPageOffset + i);
-		sFreePageQueue.Append(&sPages[i]);
+		sPages[i].numa_node
+			= numa_physical_page_node(sPhysicalPageOffset + i);
+		sFreePageQueues[sPages[i].numa_node].Append(&sPages[i]);
 
 #if VM_PAGE_ALLOCATION_TRACKING_AVAILABLE
 		sPages[i].allocation_tracking_info.Clear();
@@ -3401,7 +3723,10 @@ status_t
 vm_page_init_post_thread(kernel_args *args)
 {
 	new (&sFreePageCondition) ConditionVariable;
-	sFreePageCondition.Publish(&sFreePageQueue, "free page");
+	sFreePageCondition.Publish(&sFreePageQueues, "free page");
+
+	// now that we know the current CPU, the per-CPU page caches can be used
+	atomic_add(&sPerCPUPagesDisabled, -1);
 
 	// create a kernel thread to clear out pages
 
@@ -3503,6 +3828,30 @@ vm_page_try_reserve_pages(vm_page_reservation* reservation, uint32 count,
 }
 
 
+/*!	Removes a page from the free and clear queues, trying the queues of
+	\a node first, and then those of the other nodes by their distance. Within
+	a node, the clear queue is preferred, if \a clear is \c true, the free
+	queue otherwise. The caller must hold sFreePageQueuesLock.
+*/
+static vm_page*
+remove_free_page(int32 node, bool clear)
+{
+	const int32* nodes = numa_nodes_by_distance(node);
+	for (int32 i = 0; i < sNodeCount; i++) {
+		vm_page* page = free_page_queue_of_node(nodes[i], clear)
+			.RemoveHeadUnlocked();
+		if (page == NULL) {
+			page = free_page_queue_of_node(nodes[i], !clear)
+				.RemoveHeadUnlocked();
+		}
+		if (page != NULL)
+			return page;
+	}
+
+	return NULL;
+}
+
+
 vm_page *
 vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 {
@@ -3513,36 +3862,39 @@ vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 	ASSERT(reservation->count > 0);
 	reservation->count--;
 
-	VMPageQueue* queue;
-	VMPageQueue* otherQueue;
+	bool clear = (flags & VM_PAGE_ALLOC_CLEAR) != 0;
 
-	if ((flags & VM_PAGE_ALLOC_CLEAR) != 0) {
-		queue = &sClearPageQueue;
-		otherQueue = &sFreePageQueue;
-	} else {
-		queue = &sFreePageQueue;
-		otherQueue = &sClearPageQueue;
-	}
+	// try the current CPU's cache first, then refill it from the primary
+	// queue of the CPU's node
+	int oldPageState;
+	vm_page* page = allocate_per_cpu_page(clear, flags, oldPageState);
+	if (page == NULL) {
+		ReadLocker locker(sFreePageQueuesLock);
 
-	ReadLocker locker(sFreePageQueuesLock);
+		page = refill_per_cpu_pages(clear, flags, oldPageState);
+		if (page == NULL)
+			page = allocate_per_cpu_page(!clear, flags, oldPageState);
+	}
 
-	vm_page* page = queue->RemoveHeadUnlocked();
 	if (page == NULL) {
-		// if the primary queue was empty, grab the page from the
-		// secondary queue
-		page = otherQueue->RemoveHeadUnlocked();
+		// Prefer the local node, even if that means clearing the page.
+		// We might get migrated in the meantime, but this is only a hint.
+		int32 node = numa_cpu_node(smp_get_current_cpu());
+
+		ReadLocker locker(sFreePageQueuesLock);
 
+		page = remove_free_page(node, clear);
 		if (page == NULL) {
 			// Unlikely, but possible: the page we have reserved has moved
-			// between the queues after we checked the first queue. Grab the
-			// write locker to make sure this doesn't happen again.
+			// between the queues after we checked them, or it is in another
+			// CPU's cache. Grab the write locker to make sure this doesn't
+			// happen again.
 			locker.Unlock();
 			WriteLocker writeLocker(sFreePageQueuesLock);
 
-			page = queue->RemoveHead();
-			if (page == NULL)
-				otherQueue->RemoveHead();
+			drain_all_per_cpu_pages();
 
+			page = remove_free_page(node, clear);
 			if (page == NULL) {
 				panic("Had reserved page, but there is none!");
 				return NULL;
@@ -3551,22 +3903,16 @@ vm_page_allocate_page(vm_page_reservation* reservation, uint32 flags)
 			// downgrade to read lock
 			locker.Lock();
 		}
+
+		DEBUG_PAGE_ACCESS_START(page);
+
+		oldPageState = page->State();
+		init_allocated_page(page, flags);
 	}
 
 	if (page->CacheRef() != NULL)
 		panic("supposed to be free page %p has cache\n", page);
 
-	DEBUG_PAGE_ACCESS_START(page);
-
-	int oldPageState = page->State();
-	page->SetState(pageState);
-	page->busy = (flags & VM_PAGE_ALLOC_BUSY) != 0;
-	page->usage_count = 0;
-	page->accessed = false;
-	page->modified = false;
-
-	locker.Unlock();
-
 	if (pageState < PAGE_STATE_FIRST_UNQUEUED)
 		sPageQueues[pageState].AppendUnlocked(page);
 
@@ -3594,14 +3940,14 @@ allocate_page_run_cleanup(VMPageQueue::PageList& freePages,
 		page->busy = false;
 		page->SetState(PAGE_STATE_FREE);
 		DEBUG_PAGE_ACCESS_END(page);
-		sFreePageQueue.PrependUnlocked(page);
+		free_page_queue(page, false).PrependUnlocked(page);
 	}
 
 	while (vm_page* page = clearPages.RemoveHead()) {
 		page->busy = false;
 		page->SetState(PAGE_STATE_CLEAR);
 		DEBUG_PAGE_ACCESS_END(page);
-		sClearPageQueue.PrependUnlocked(page);
+		free_page_queue(page, true).PrependUnlocked(page);
 	}
 }
 
@@ -3648,12 +3994,12 @@ allocate_page_run(page_num_t start, page_num_t length, uint32 flags,
 		switch (page.State()) {
 			case PAGE_STATE_CLEAR:
 				DEBUG_PAGE_ACCESS_START(&page);
-				sClearPageQueue.Remove(&page);
+				free_page_queue(&page, true).Remove(&page);
 				clearPages.Add(&page);
 				break;
 			case PAGE_STATE_FREE:
 				DEBUG_PAGE_ACCESS_START(&page);
-				sFreePageQueue.Remove(&page);
+				free_page_queue(&page, false).Remove(&page);
 				freePages.Add(&page);
 				break;
 			case PAGE_STATE_CACHED:
@@ -3834,6 +4180,7 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 	vm_page_reserve_pages(&reservation, length, priority);
 
 	WriteLocker freeClearQueueLocker(sFreePageQueuesLock);
+	PerCPUPagesDisabler perCPUPagesDisabler;
 
 	// First we try to get a run with free pages only. If that fails, we also
 	// consider cached pages. If there are only few free pages and many cached
@@ -3906,6 +4253,150 @@ vm_page_allocate_page_run(uint32 flags, page_num_t length,
 }
 
 
+/*!	Returns whether any of the \a length pages starting at index \a start
+	sits in a per-CPU cache. The caches must be disabled, and the caller
+	must hold sFreePageQueuesLock write locked.
+*/
+static bool
+is_in_per_cpu_pages(page_num_t start, page_num_t length)
+{
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		PerCPUPages& cache = sPerCPUPages[i];
+		InterruptsSpinLocker locker(cache.lock);
+
+		VMPageQueue* queues[] = { &cache.freePages, &cache.clearPages };
+		for (int32 j = 0; j < 2; j++) {
+			VMPageQueue::Iterator it = queues[j]->GetIterator();
+			while (vm_page* page = it.Next()) {
+				page_num_t index = page - sPages;
+				if (index >= start && index < start + length)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+/*!	Looks for an aligned run of \a length free or clear pages, starting at
+	index \a start, and allocates it. Pages that sit in per-CPU caches are
+	not free as far as the global queues are concerned, so runs containing
+	any of them are skipped, unless \a perCPUPagesDrained.
+	\a _nextStart is set to where the next search shall continue.
+	The caller must hold sFreePageQueuesLock write locked, and the per-CPU
+	caches must be disabled.
+*/
+static vm_page*
+allocate_large_page_run(page_num_t start, page_num_t length, uint32 flags,
+	bool perCPUPagesDrained, page_num_t& _nextStart,
+	WriteLocker& freeClearQueueLocker)
+{
+	// limits the time we hold the write lock
+	static const uint32 kMaxRunsToCheck = 128;
+
+	page_num_t alignmentMask = length - 1;
+	bool wrapped = false;
+
+	for (uint32 runsChecked = 0; runsChecked < kMaxRunsToCheck;
+			runsChecked++) {
+		// enforce alignment
+		page_num_t offsetStart = start + sPhysicalPageOffset;
+		offsetStart = (offsetStart + alignmentMask) & ~alignmentMask;
+		start = offsetStart - sPhysicalPageOffset;
+
+		if (start + length > sNumPages) {
+			if (wrapped)
+				break;
+			wrapped = true;
+			start = 0;
+			continue;
+		}
+
+		page_num_t i;
+		for (i = 0; i < length; i++) {
+			uint32 pageState = sPages[start + i].State();
+			if (pageState != PAGE_STATE_FREE && pageState != PAGE_STATE_CLEAR)
+				break;
+		}
+
+		if (i == length && !perCPUPagesDrained
+			&& is_in_per_cpu_pages(start, length)) {
+			start += length;
+			continue;
+		}
+
+		if (i == length) {
+			i = allocate_page_run(start, length, flags, freeClearQueueLocker);
+			ASSERT(i == length);
+				// there are no cached pages in the run, so it can't fail
+
+			_nextStart = start + length;
+			return &sPages[start];
+		}
+
+		start += i + 1;
+	}
+
+	_nextStart = start;
+	return NULL;
+}
+
+
+/*!	Allocates a run of \a length free or clear pages, whose physical address
+	is aligned to the size of the run, as needed for mapping it as a large
+	page. The pages are taken from \a reservation.
+	Unlike vm_page_allocate_page_run() the function neither waits nor frees
+	cached pages, since large pages are only an optimization: if there is no
+	suitable run, the caller shall simply use small pages.
+	The per-CPU page caches are only drained, if no run could be found
+	without them.
+
+	\param reservation The reservation to take the pages from. It must
+		contain at least \a length pages.
+	\param flags Page allocation flags, like for vm_page_allocate_page_run().
+	\param length The number of pages of the run, must be a power of 2.
+	\return The first page of the allocated run, or \c NULL, if there is no
+		free run.
+*/
+vm_page*
+vm_page_allocate_large_page(vm_page_reservation* reservation, uint32 flags,
+	page_num_t length)
+{
+	// the next call continues where we stopped
+	static page_num_t sNextStart = 0;
+
+	ASSERT(((length - 1) & length) == 0);
+
+	if (reservation->count < length || sNumPages < length)
+		return NULL;
+
+	WriteLocker freeClearQueueLocker(sFreePageQueuesLock);
+	PerCPUPagesDisabler perCPUPagesDisabler(false);
+
+	if (count_free_pages(false) + count_free_pages(true)
+			+ count_per_cpu_pages() < length) {
+		return NULL;
+	}
+
+	page_num_t start = sNextStart;
+	vm_page* page = allocate_large_page_run(start, length, flags, false,
+		sNextStart, freeClearQueueLocker);
+	if (page == NULL) {
+		// check the same runs again, including the cached pages
+		drain_all_per_cpu_pages();
+		page = allocate_large_page_run(start, length, flags, true,
+			sNextStart, freeClearQueueLocker);
+	}
+
+	if (page != NULL)
+		reservation->count -= length;
+
+	return page;
+}
+
+
 vm_page *
 vm_page_at_index(int32 index)
 {
@@ -4094,8 +4585,8 @@ vm_page_get_stats(system_info *info)
 	//	active + inactive + unused + wired + modified + cached + free + clear
 	// So taking out the cached (including modified non-temporary), free and
 	// clear ones leaves us with all used pages.
-	uint32 subtractPages = info->cached_pages + sFreePageQueue.Count()
-		+ sClearPageQueue.Count();
+	uint32 subtractPages = info->cached_pages + count_free_pages(false)
+		+ count_free_pages(true) + count_per_cpu_pages();
 	info->used_pages = subtractPages > info->max_pages
 		? 0 : info->max_pages - subtractPages;
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <io_ring.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <syscalls.h>
+
+
+status_t
+io_ring_init(io_ring* ring, uint32 entries, uint32 flags)
+{
+	io_ring_info info;
+	int fd = _kern_io_ring_create(entries, 0, flags, &info);
+	if (fd < 0)
+		return fd;
+
+	area_info areaInfo;
+	status_t status = get_area_info(info.area, &areaInfo);
+	if (status != B_OK) {
+		_kern_close(fd);
+		_kern_delete_area(info.area);
+		return status;
+	}
+
+	uint8* address = (uint8*)areaInfo.address;
+
+	ring->fd = fd;
+	ring->area = info.area;
+	ring->flags = flags;
+	ring->shared = (io_ring_shared*)address;
+	ring->submissions
+		= (io_ring_submission*)(address + ring->shared->submission_offset);
+	ring->completions
+		= (io_ring_completion*)(address + ring->shared->completion_offset);
+	ring->submission_tail = ring->shared->submission.tail;
+	return B_OK;
+}
+
+
+void
+io_ring_uninit(io_ring* ring)
+{
+	_kern_close(ring->fd);
+	_kern_delete_area(ring->area);
+
+	ring->fd = -1;
+	ring->area = -1;
+}
+
+
+/*!	Returns the next free submission entry, zeroed, or \c NULL if the
+	submission ring is full. The entry is submitted by the next
+	io_ring_submit().
+*/
+io_ring_submission*
+io_ring_get_submission(io_ring* ring)
+{
+	io_ring_queue& queue = ring->shared->submission;
+	uint32 head = (uint32)atomic_get((int32*)&queue.head);
+	if (ring->submission_tail - head >= queue.entries)
+		return NULL;
+
+	io_ring_submission* submission
+		= &ring->submissions[ring->submission_tail++ & queue.mask];
+	memset(submission, 0, sizeof(io_ring_submission));
+	return submission;
+}
+
+
+/*!	Publishes the prepared submissions, and hands them to the kernel. In
+	polling mode, this only needs a syscall if the polling thread has gone
+	to sleep. Returns the number of submitted entries.
+*/
+int32
+io_ring_submit(io_ring* ring)
+{
+	return io_ring_submit_and_wait(ring, 0);
+}
+
+
+int32
+io_ring_submit_and_wait(io_ring* ring, uint32 waitCount)
+{
+	io_ring_queue& queue = ring->shared->submission;
+	uint32 count = ring->submission_tail - queue.tail;
+
+	// the entries must be visible before the new tail
+	atomic_set((int32*)&queue.tail, ring->submission_tail);
+
+	if ((ring->flags & IO_RING_POLL) != 0) {
+		uint32 flags = 0;
+		if ((atomic_get((int32*)&ring->shared->flags)
+				& IO_RING_NEED_WAKEUP) != 0) {
+			flags |= IO_RING_ENTER_WAKEUP;
+		} else if (waitCount == 0)
+			return count;
+
+		status_t status = _kern_io_ring_enter(ring->fd, 0, waitCount, flags,
+			B_INFINITE_TIMEOUT);
+		return status < 0 ? status : count;
+	}
+
+	if (count == 0 && waitCount == 0)
+		return 0;
+
+	return _kern_io_ring_enter(ring->fd, count, waitCount, 0,
+		B_INFINITE_TIMEOUT);
+}
+
+
+/*!	Returns the next completion, or \c NULL if there is none yet. */
+io_ring_completion*
+io_ring_peek_completion(io_ring* ring)
+{
+	io_ring_queue& queue = ring->shared->completion;
+	uint32 head = queue.head;
+	if ((uint32)atomic_get((int32*)&queue.tail) == head)
+		return NULL;
+
+	return &ring->completions[head & queue.mask];
+}
+
+
+/*!	Waits for the next completion. A \a timeout of \c B_INFINITE_TIMEOUT
+	waits forever, one of 0 does not wait at all.
+*/
+status_t
+io_ring_wait_completion(io_ring* ring, io_ring_completion** _completion,
+	bigtime_t timeout)
+{
+	while (true) {
+		io_ring_completion* completion = io_ring_peek_completion(ring);
+		if (completion != NULL) {
+			*_completion = completion;
+			return B_OK;
+		}
+
+		if (timeout == 0)
+			return B_WOULD_BLOCK;
+
+		int32 status = _kern_io_ring_enter(ring->fd, 0, 1, 0, timeout);
+		if (status < 0 && status != B_INTERRUPTED)
+			return status;
+	}
+}
+
+
+/*!	Releases the completion returned by io_ring_peek_completion() or
+	io_ring_wait_completion(), so that the kernel can reuse its entry.
+*/
+void
+io_ring_completion_done(io_ring* ring)
+{
+	io_ring_queue& queue = ring->shared->completion;
+	atomic_set((int32*)&queue.head, queue.head + 1);
+}
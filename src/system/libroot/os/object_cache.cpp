@@ -0,0 +1,748 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <object_cache.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <TLS.h>
+
+#include <libroot_private.h>
+#include <locks.h>
+#include <tls.h>
+#include <user_thread.h>
+#include <util/DoublyLinkedList.h>
+
+
+static const uint32 kMaxThreadCaches = 64;
+	// only that many caches get per-thread magazines, the others always
+	// use their slabs
+static const size_t kMinSlabSize = 16 * 1024;
+static const size_t kMaxSlabSize = 256 * 1024;
+static const uint32 kMinSlabObjects = 8;
+static const uint32 kMaxEmptySlabs = 2;
+static const uint32 kMaxFullMagazines = 16;
+
+
+struct object_link {
+	object_link*	next;
+};
+
+
+/*!	Lives at the end of the slab's memory, which is aligned to its size, so
+	the slab of an object can be computed from its address.
+*/
+struct Slab : DoublyLinkedListLinkImpl<Slab> {
+	uint8*			pages;
+	uint32			size;
+		// total number of objects
+	uint32			count;
+		// free objects
+	object_link*	free;
+};
+
+typedef DoublyLinkedList<Slab> SlabList;
+
+
+struct Magazine {
+	Magazine*		next;
+	uint32			count;
+	uint32			capacity;
+	void*			rounds[0];
+};
+
+
+struct object_cache : DoublyLinkedListLinkImpl<object_cache> {
+	char						name[32];
+	mutex						lock;
+	size_t						object_size;
+	size_t						slab_size;
+	uint32						objects_per_slab;
+	SlabList					empty;
+	SlabList					partial;
+	SlabList					full;
+	uint32						empty_count;
+
+	void*						cookie;
+	object_cache_constructor	constructor;
+	object_cache_destructor		destructor;
+
+	int32						slot;
+		// index in sThreadCaches, or -1
+	uint32						id;
+	uint32						magazine_capacity;
+	Magazine*					full_magazines;
+	uint32						full_magazine_count;
+	Magazine*					empty_magazines;
+};
+
+typedef DoublyLinkedList<object_cache> ObjectCacheList;
+
+
+/*!	The magazines of a thread for one cache. If \c id doesn't match the
+	cache's, the slot belonged to a cache that has been deleted since.
+*/
+struct thread_cache_entry {
+	uint32			id;
+	Magazine*		loaded;
+	Magazine*		previous;
+};
+
+struct thread_caches {
+	thread_cache_entry	entries[kMaxThreadCaches];
+};
+
+
+static mutex sCachesLock = MUTEX_INITIALIZER("object caches");
+static ObjectCacheList sCaches;
+static object_cache* sThreadCaches[kMaxThreadCaches];
+static uint32 sNextCacheID = 1;
+
+
+static inline Slab*
+slab_of(object_cache* cache, void* object)
+{
+	addr_t base = (addr_t)object & ~(addr_t)(cache->slab_size - 1);
+	return (Slab*)(base + cache->slab_size - sizeof(Slab));
+}
+
+
+static inline object_link*
+object_to_link(object_cache* cache, void* object)
+{
+	return (object_link*)((uint8*)object + cache->object_size
+		- sizeof(object_link));
+}
+
+
+static inline void*
+link_to_object(object_cache* cache, object_link* link)
+{
+	return (uint8*)link - (cache->object_size - sizeof(object_link));
+}
+
+
+// #pragma mark - slabs
+
+
+/*!	Maps memory for a slab that is aligned to the slab size, by mapping
+	twice as much, and unmapping the parts before and after the aligned
+	range again. Unlike aligned heap allocations, that doesn't waste any
+	memory, and returns the slab to the system when it's freed.
+*/
+static uint8*
+allocate_slab_pages(size_t slabSize)
+{
+	uint8* address = (uint8*)mmap(NULL, slabSize * 2, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (address == MAP_FAILED)
+		return NULL;
+
+	uint8* pages = (uint8*)(((addr_t)address + slabSize - 1)
+		& ~(addr_t)(slabSize - 1));
+	size_t before = pages - address;
+	if (before > 0)
+		munmap(address, before);
+	if (before < slabSize)
+		munmap(pages + slabSize, slabSize - before);
+
+	return pages;
+}
+
+
+static inline void
+free_slab_pages(object_cache* cache, uint8* pages)
+{
+	munmap(pages, cache->slab_size);
+}
+
+
+/*!	Creates a new slab, and constructs its objects. The cache must not be
+	locked.
+*/
+static Slab*
+create_slab(object_cache* cache)
+{
+	uint8* pages = allocate_slab_pages(cache->slab_size);
+	if (pages == NULL)
+		return NULL;
+
+	Slab* slab = slab_of(cache, pages);
+	slab->pages = pages;
+	slab->size = cache->objects_per_slab;
+	slab->count = slab->size;
+	slab->free = NULL;
+
+	// link the objects in reverse order, so they are handed out in order
+	for (uint32 i = slab->size; i-- > 0;) {
+		void* object = pages + i * cache->object_size;
+		if (cache->constructor != NULL
+			&& cache->constructor(cache->cookie, object) != B_OK) {
+			if (cache->destructor != NULL) {
+				for (uint32 j = i + 1; j < slab->size; j++) {
+					cache->destructor(cache->cookie,
+						pages + j * cache->object_size);
+				}
+			}
+			free_slab_pages(cache, pages);
+			return NULL;
+		}
+
+		object_link* link = object_to_link(cache, object);
+		link->next = slab->free;
+		slab->free = link;
+	}
+
+	return slab;
+}
+
+
+/*!	Destructs the objects of a slab, and frees it. The cache must not be
+	locked.
+*/
+static void
+delete_slab(object_cache* cache, Slab* slab)
+{
+	if (cache->destructor != NULL) {
+		for (uint32 i = 0; i < slab->size; i++) {
+			cache->destructor(cache->cookie,
+				slab->pages + i * cache->object_size);
+		}
+	}
+
+	free_slab_pages(cache, slab->pages);
+}
+
+
+static void
+delete_slabs(object_cache* cache, SlabList& slabs)
+{
+	while (Slab* slab = slabs.RemoveHead())
+		delete_slab(cache, slab);
+}
+
+
+/*!	Returns an object to its slab. Slabs that become empty while the cache
+	already has enough empty ones are moved to \a slabsToFree. The cache
+	must be locked.
+*/
+static void
+return_to_slab(object_cache* cache, void* object, SlabList& slabsToFree)
+{
+	Slab* slab = slab_of(cache, object);
+	object_link* link = object_to_link(cache, object);
+	link->next = slab->free;
+	slab->free = link;
+	slab->count++;
+
+	if (slab->count == slab->size) {
+		if (slab->size > 1)
+			cache->partial.Remove(slab);
+		else
+			cache->full.Remove(slab);
+
+		if (cache->empty_count < kMaxEmptySlabs) {
+			cache->empty.Add(slab);
+			cache->empty_count++;
+		} else
+			slabsToFree.Add(slab);
+	} else if (slab->count == 1) {
+		cache->full.Remove(slab);
+		cache->partial.Add(slab);
+	}
+}
+
+
+static void*
+alloc_from_slab(object_cache* cache)
+{
+	MutexLocker locker(cache->lock);
+
+	Slab* slab = cache->partial.Head();
+	if (slab == NULL) {
+		slab = cache->empty.RemoveHead();
+		if (slab != NULL)
+			cache->empty_count--;
+		else {
+			locker.Unlock();
+			slab = create_slab(cache);
+			if (slab == NULL)
+				return NULL;
+			locker.Lock();
+		}
+
+		cache->partial.Add(slab);
+	}
+
+	object_link* link = slab->free;
+	slab->free = link->next;
+	slab->count--;
+
+	if (slab->count == 0) {
+		cache->partial.Remove(slab);
+		cache->full.Add(slab);
+	}
+
+	return link_to_object(cache, link);
+}
+
+
+static void
+free_to_slab(object_cache* cache, void* object)
+{
+	SlabList slabsToFree;
+
+	MutexLocker locker(cache->lock);
+	return_to_slab(cache, object, slabsToFree);
+	locker.Unlock();
+
+	delete_slabs(cache, slabsToFree);
+}
+
+
+// #pragma mark - magazines
+
+
+static Magazine*
+alloc_magazine(object_cache* cache)
+{
+	Magazine* magazine = (Magazine*)malloc(sizeof(Magazine)
+		+ cache->magazine_capacity * sizeof(void*));
+	if (magazine != NULL) {
+		magazine->next = NULL;
+		magazine->count = 0;
+		magazine->capacity = cache->magazine_capacity;
+	}
+
+	return magazine;
+}
+
+
+/*!	Hands a magazine that still contains objects over to the cache's depot.
+	If the depot already holds enough of them, the objects are returned to
+	their slabs instead. The cache must be locked.
+*/
+static void
+store_magazine(object_cache* cache, Magazine* magazine,
+	SlabList& slabsToFree, Magazine*& magazinesToFree)
+{
+	if (magazine->count == 0) {
+		magazine->next = cache->empty_magazines;
+		cache->empty_magazines = magazine;
+		return;
+	}
+
+	if (cache->full_magazine_count < kMaxFullMagazines) {
+		magazine->next = cache->full_magazines;
+		cache->full_magazines = magazine;
+		cache->full_magazine_count++;
+		return;
+	}
+
+	for (uint32 i = 0; i < magazine->count; i++)
+		return_to_slab(cache, magazine->rounds[i], slabsToFree);
+
+	magazine->next = magazinesToFree;
+	magazinesToFree = magazine;
+}
+
+
+static void
+free_magazines(Magazine* magazines)
+{
+	while (magazines != NULL) {
+		Magazine* next = magazines->next;
+		free(magazines);
+		magazines = next;
+	}
+}
+
+
+static thread_cache_entry*
+thread_cache_entry_for(object_cache* cache)
+{
+	if (cache->slot < 0)
+		return NULL;
+
+	thread_caches* caches = (thread_caches*)tls_get(TLS_OBJECT_CACHE_SLOT);
+	if (caches == NULL) {
+		caches = (thread_caches*)calloc(1, sizeof(thread_caches));
+		if (caches == NULL)
+			return NULL;
+		tls_set(TLS_OBJECT_CACHE_SLOT, caches);
+	}
+
+	thread_cache_entry* entry = &caches->entries[cache->slot];
+	if (entry->id != cache->id) {
+		// The slot's previous cache is gone, and so are the objects in the
+		// magazines.
+		free(entry->loaded);
+		free(entry->previous);
+		entry->loaded = NULL;
+		entry->previous = NULL;
+		entry->id = cache->id;
+	}
+
+	return entry;
+}
+
+
+/*!	Bonwick's magazine layer: the loaded magazine is used until it's empty,
+	then the previous one, if it's full, and only then the depot is asked
+	for a full magazine.
+*/
+static void*
+alloc_from_magazines(object_cache* cache, thread_cache_entry* entry)
+{
+	if (entry->loaded == NULL)
+		return NULL;
+
+	while (true) {
+		Magazine* loaded = entry->loaded;
+		if (loaded->count > 0)
+			return loaded->rounds[--loaded->count];
+
+		if (entry->previous != NULL && entry->previous->count > 0) {
+			entry->loaded = entry->previous;
+			entry->previous = loaded;
+			continue;
+		}
+
+		// exchange the empty previous magazine for a full one
+		MutexLocker locker(cache->lock);
+
+		Magazine* magazine = cache->full_magazines;
+		if (magazine == NULL)
+			return NULL;
+
+		cache->full_magazines = magazine->next;
+		cache->full_magazine_count--;
+
+		if (entry->previous != NULL) {
+			entry->previous->next = cache->empty_magazines;
+			cache->empty_magazines = entry->previous;
+		}
+
+		entry->previous = magazine;
+	}
+}
+
+
+static bool
+free_to_magazines(object_cache* cache, thread_cache_entry* entry,
+	void* object)
+{
+	while (true) {
+		Magazine* loaded = entry->loaded;
+		if (loaded != NULL && loaded->count < loaded->capacity) {
+			loaded->rounds[loaded->count++] = object;
+			return true;
+		}
+
+		if (entry->previous != NULL && entry->previous->count == 0) {
+			entry->loaded = entry->previous;
+			entry->previous = loaded;
+			continue;
+		}
+
+		// exchange the full previous magazine for an empty one
+		MutexLocker locker(cache->lock);
+
+		Magazine* magazine = cache->empty_magazines;
+		if (magazine != NULL)
+			cache->empty_magazines = magazine->next;
+		locker.Unlock();
+
+		if (magazine == NULL) {
+			magazine = alloc_magazine(cache);
+			if (magazine == NULL)
+				return false;
+		}
+
+		if (entry->previous != NULL) {
+			SlabList slabsToFree;
+			Magazine* magazinesToFree = NULL;
+
+			locker.Lock();
+			store_magazine(cache, entry->previous, slabsToFree,
+				magazinesToFree);
+			locker.Unlock();
+
+			delete_slabs(cache, slabsToFree);
+			free_magazines(magazinesToFree);
+		}
+
+		entry->previous = magazine;
+	}
+}
+
+
+// #pragma mark - private hooks
+
+
+/*!	Returns the magazines of the exiting thread to the depots of their
+	caches.
+*/
+void
+__object_caches_thread_exit(void)
+{
+	thread_caches* caches = (thread_caches*)tls_get(TLS_OBJECT_CACHE_SLOT);
+	if (caches == NULL)
+		return;
+
+	defer_signals();
+	tls_set(TLS_OBJECT_CACHE_SLOT, NULL);
+
+	for (uint32 i = 0; i < kMaxThreadCaches; i++) {
+		thread_cache_entry& entry = caches->entries[i];
+		if (entry.loaded == NULL && entry.previous == NULL)
+			continue;
+
+		MutexLocker listLocker(sCachesLock);
+
+		object_cache* cache = sThreadCaches[i];
+		if (cache == NULL || cache->id != entry.id) {
+			listLocker.Unlock();
+			free(entry.loaded);
+			free(entry.previous);
+			continue;
+		}
+
+		// the cache can't be deleted while we hold its lock
+		MutexLocker locker(cache->lock);
+		listLocker.Unlock();
+
+		SlabList slabsToFree;
+		Magazine* magazinesToFree = NULL;
+		if (entry.loaded != NULL) {
+			store_magazine(cache, entry.loaded, slabsToFree,
+				magazinesToFree);
+		}
+		if (entry.previous != NULL) {
+			store_magazine(cache, entry.previous, slabsToFree,
+				magazinesToFree);
+		}
+
+		locker.Unlock();
+
+		delete_slabs(cache, slabsToFree);
+		free_magazines(magazinesToFree);
+	}
+
+	free(caches);
+	undefer_signals();
+}
+
+
+void
+__object_caches_before_fork(void)
+{
+	mutex_lock(&sCachesLock);
+
+	for (ObjectCacheList::Iterator it = sCaches.GetIterator();
+			object_cache* cache = it.Next();) {
+		mutex_lock(&cache->lock);
+	}
+}
+
+
+void
+__object_caches_after_fork_child(void)
+{
+	// The magazines of the other threads are lost, their objects are never
+	// returned to the slabs.
+	mutex_init(&sCachesLock, "object caches");
+
+	for (ObjectCacheList::Iterator it = sCaches.GetIterator();
+			object_cache* cache = it.Next();) {
+		mutex_init(&cache->lock, cache->name);
+	}
+}
+
+
+void
+__object_caches_after_fork_parent(void)
+{
+	for (ObjectCacheList::Iterator it = sCaches.GetIterator();
+			object_cache* cache = it.Next();) {
+		mutex_unlock(&cache->lock);
+	}
+
+	mutex_unlock(&sCachesLock);
+}
+
+
+// #pragma mark - public API
+
+
+object_cache*
+create_object_cache(const char* name, size_t objectSize, size_t alignment,
+	void* cookie, object_cache_constructor constructor,
+	object_cache_destructor destructor)
+{
+	if (objectSize == 0 || (alignment & (alignment - 1)) != 0)
+		return NULL;
+
+	if (objectSize < sizeof(object_link))
+		objectSize = sizeof(object_link);
+	if (alignment < sizeof(void*))
+		alignment = sizeof(void*);
+	objectSize = (objectSize + alignment - 1) & ~(alignment - 1);
+
+	// use the smallest slab that holds enough objects
+	size_t slabSize = kMinSlabSize;
+	while (slabSize < kMaxSlabSize
+		&& (slabSize - sizeof(Slab)) / objectSize < kMinSlabObjects) {
+		slabSize *= 2;
+	}
+
+	if (alignment > slabSize || (slabSize - sizeof(Slab)) / objectSize == 0)
+		return NULL;
+
+	defer_signals();
+	object_cache* cache = (object_cache*)calloc(1, sizeof(object_cache));
+	undefer_signals();
+	if (cache == NULL)
+		return NULL;
+
+	new((void*)cache) object_cache;
+	strlcpy(cache->name, name, sizeof(cache->name));
+	mutex_init(&cache->lock, cache->name);
+	cache->object_size = objectSize;
+	cache->slab_size = slabSize;
+	cache->objects_per_slab = (slabSize - sizeof(Slab)) / objectSize;
+	cache->cookie = cookie;
+	cache->constructor = constructor;
+	cache->destructor = destructor;
+	cache->magazine_capacity = objectSize < 256
+		? 32 : (objectSize < 512 ? 16 : 8);
+	cache->slot = -1;
+
+	defer_signals();
+	mutex_lock(&sCachesLock);
+
+	cache->id = sNextCacheID++;
+	if (sNextCacheID == 0)
+		sNextCacheID = 1;
+
+	for (uint32 i = 0; i < kMaxThreadCaches; i++) {
+		if (sThreadCaches[i] == NULL) {
+			sThreadCaches[i] = cache;
+			cache->slot = i;
+			break;
+		}
+	}
+
+	sCaches.Add(cache);
+
+	mutex_unlock(&sCachesLock);
+	undefer_signals();
+
+	return cache;
+}
+
+
+/*!	Deletes the cache and all of its slabs. All objects must have been freed
+	before. Objects that other threads still keep in their magazines are
+	simply forgotten.
+*/
+void
+delete_object_cache(object_cache* cache)
+{
+	if (cache == NULL)
+		return;
+
+	defer_signals();
+
+	mutex_lock(&sCachesLock);
+	if (cache->slot >= 0)
+		sThreadCaches[cache->slot] = NULL;
+	sCaches.Remove(cache);
+	mutex_unlock(&sCachesLock);
+
+	// wait for exiting threads that still return magazines
+	mutex_lock(&cache->lock);
+	mutex_destroy(&cache->lock);
+
+	// the current thread's magazines go back to the depot right away
+	thread_caches* caches = (thread_caches*)tls_get(TLS_OBJECT_CACHE_SLOT);
+	if (caches != NULL && cache->slot >= 0) {
+		thread_cache_entry& entry = caches->entries[cache->slot];
+		if (entry.id == cache->id) {
+			Magazine* magazines[] = { entry.loaded, entry.previous };
+			for (int32 i = 0; i < 2; i++) {
+				if (magazines[i] == NULL)
+					continue;
+				magazines[i]->next = cache->full_magazines;
+				cache->full_magazines = magazines[i];
+			}
+			entry.loaded = NULL;
+			entry.previous = NULL;
+			entry.id = 0;
+		}
+	}
+
+	// return the objects in the depot to their slabs
+	SlabList slabsToFree;
+	for (Magazine* magazine = cache->full_magazines; magazine != NULL;
+			magazine = magazine->next) {
+		for (uint32 i = 0; i < magazine->count; i++)
+			return_to_slab(cache, magazine->rounds[i], slabsToFree);
+	}
+
+	free_magazines(cache->full_magazines);
+	free_magazines(cache->empty_magazines);
+	delete_slabs(cache, slabsToFree);
+
+	if (!cache->full.IsEmpty() || !cache->partial.IsEmpty()) {
+		debug_printf("delete_object_cache(): cache \"%s\" still has "
+			"allocated objects\n", cache->name);
+	}
+
+	delete_slabs(cache, cache->full);
+	delete_slabs(cache, cache->partial);
+	delete_slabs(cache, cache->empty);
+
+	cache->~object_cache();
+	free(cache);
+
+	undefer_signals();
+}
+
+
+void*
+object_cache_alloc(object_cache* cache)
+{
+	defer_signals();
+
+	void* object = NULL;
+	thread_cache_entry* entry = thread_cache_entry_for(cache);
+	if (entry != NULL)
+		object = alloc_from_magazines(cache, entry);
+	if (object == NULL)
+		object = alloc_from_slab(cache);
+
+	undefer_signals();
+	return object;
+}
+
+
+void
+object_cache_free(object_cache* cache, void* object)
+{
+	if (object == NULL)
+		return;
+
+	defer_signals();
+
+	thread_cache_entry* entry = thread_cache_entry_for(cache);
+	if (entry == NULL || !free_to_magazines(cache, entry, object))
+		free_to_slab(cache, object);
+
+	undefer_signals();
+}
@@ -74,6 +74,9 @@ _thread_do_exit_work(void)
 	__gRuntimeLoader->destroy_thread_tls();
 
 	__pthread_destroy_thread();
+
+	__object_caches_thread_exit();
+	__heap_thread_exit();
 }
 
 
@@ -121,6 +121,13 @@ __heap_terminate_after()
 }
 
 
+extern "C" void
+__heap_thread_exit(void)
+{
+	// nothing to do
+}
+
+
 static void
 insert_chunk(free_chunk *newChunk)
 {
@@ -202,6 +202,12 @@ __heap_terminate_after()
 }
 
 
+extern "C" void
+__heap_thread_exit(void)
+{
+}
+
+
 extern "C" void
 __heap_before_fork(void)
 {
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The page heap hands out runs of spans from arenas, areas of kArenaSize
+	bytes aligned to their size. Free runs are coalesced with their neighbors
+	and kept in lists by length. Runs that stayed free for a while are given
+	back to the kernel via madvise(), empty arenas are deleted.
+*/
+
+
+#include "PageHeap.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include <locks.h>
+#include <syscalls.h>
+
+#include <libroot_private.h>
+
+
+//#define TRACE_PAGE_HEAP
+#ifdef TRACE_PAGE_HEAP
+#	define TRACE(x...) debug_printf("page heap: " x)
+#else
+#	define TRACE(x...) do {} while (false)
+#endif
+
+
+using namespace BPrivate;
+
+
+static const uint32 kMaxCommittedFreeSpans = 64;
+	// free spans that are kept committed without delay
+static const bigtime_t kDecommitDelay = 1000000;
+	// how long a run has to be free before it is decommitted
+static const uint32 kMaxEmptyArenas = 1;
+	// empty arenas that are kept instead of being deleted
+
+
+addr_t* PageHeap::sMap[PageHeap::kMapRootSize];
+
+static mutex sLock;
+static SpanList sFreeRuns[kSpansPerArena];
+static uint32 sCommittedFreeSpans;
+static bigtime_t sLastDecommit;
+static uint32 sEmptyArenas;
+
+static size_t sArenaCount;
+static size_t sUsedSpans;
+static size_t sUsedRuns;
+static size_t sHugeSize;
+static size_t sHugeCount;
+
+
+static uint32
+area_protection()
+{
+	uint32 protection = B_READ_AREA | B_WRITE_AREA;
+	if (__gABIVersion < B_HAIKU_ABI_GCC_2_HAIKU)
+		protection |= B_EXECUTE_AREA;
+	return protection;
+}
+
+
+/*!	Creates an area of \a size bytes that starts at a multiple of
+	\a alignment, which must be a multiple of kArenaSize, so that no two
+	areas share an entry of the arena map.
+*/
+static area_id
+create_aligned_area(const char* name, size_t size, size_t alignment,
+	void** _address)
+{
+	size_t reservationSize = size + alignment;
+	if (reservationSize < size)
+		return B_NO_MEMORY;
+
+	addr_t base;
+	status_t status = _kern_reserve_address_range(&base,
+		B_RANDOMIZED_ANY_ADDRESS, reservationSize);
+	if (status != B_OK)
+		return status;
+
+	void* address = (void*)((base + alignment - 1)
+		& ~(addr_t)(alignment - 1));
+	area_id area = create_area(name, &address, B_EXACT_ADDRESS, size,
+		B_NO_LOCK, area_protection());
+
+	_kern_unreserve_address_range(base, reservationSize);
+
+	if (area >= 0)
+		*_address = address;
+	return area;
+}
+
+
+// #pragma mark - PageHeap
+
+
+/*static*/ status_t
+PageHeap::Init()
+{
+	mutex_init_etc(&sLock, "malloc page heap", MUTEX_FLAG_ADAPTIVE);
+	sLastDecommit = system_time();
+	return B_OK;
+}
+
+
+/*!	Allocates a run of \a count spans. If \a state is \c SPAN_SLAB, the
+	caller has to initialize the slab fields.
+*/
+/*static*/ Span*
+PageHeap::AllocateRun(uint32 count, uint8 state)
+{
+	if (count == 0 || count >= kSpansPerArena)
+		return NULL;
+
+	MutexLocker locker(sLock);
+
+	Span* span = NULL;
+	for (uint32 i = count; i < kSpansPerArena; i++) {
+		span = sFreeRuns[i].Head();
+		if (span != NULL)
+			break;
+	}
+
+	if (span == NULL) {
+		if (_CreateArena() == NULL)
+			return NULL;
+		span = sFreeRuns[kSpansPerArena - 1].Head();
+	}
+
+	Arena* arena = _ArenaOf(span);
+	if (arena->freeSpans == kSpansPerArena - 1)
+		sEmptyArenas--;
+
+	_RemoveFreeRun(span);
+
+	if (span->count > count) {
+		// return the rest of the run
+		Span* rest = span + count;
+		rest->count = span->count - count;
+		rest->committed = span->committed;
+		rest->freeTime = span->freeTime;
+		_InsertFreeRun(arena, rest);
+	}
+
+	span->count = count;
+	span->state = state;
+
+	uint32 index = span - arena->spans;
+	for (uint32 i = 0; i < count; i++)
+		arena->runStart[index + i] = index;
+
+	arena->freeSpans -= count;
+	sUsedSpans += count;
+	sUsedRuns++;
+
+	TRACE("allocated run %p (%" B_PRIu32 " spans)\n", RunAddress(span),
+		count);
+	return span;
+}
+
+
+/*static*/ void
+PageHeap::FreeRun(Span* span)
+{
+	MutexLocker locker(sLock);
+
+	TRACE("free run %p (%" B_PRIu16 " spans)\n", RunAddress(span),
+		span->count);
+
+	Arena* arena = _ArenaOf(span);
+
+	arena->freeSpans += span->count;
+	sUsedSpans -= span->count;
+	sUsedRuns--;
+
+	span->state = SPAN_FREE;
+	span->committed = true;
+	span->freeTime = system_time();
+	span = _Coalesce(arena, span);
+
+	if (arena->freeSpans == kSpansPerArena - 1) {
+		if (sEmptyArenas >= kMaxEmptyArenas) {
+			// the arena may still consist of several free runs
+			for (uint32 i = 1; i < kSpansPerArena;
+					i += arena->spans[i].count) {
+				if (&arena->spans[i] != span)
+					_RemoveFreeRun(&arena->spans[i]);
+			}
+
+			_DeleteArena(arena);
+			return;
+		}
+		sEmptyArenas++;
+	}
+
+	_InsertFreeRun(arena, span);
+	_Decommit();
+}
+
+
+/*static*/ void*
+PageHeap::AllocateHuge(size_t size, size_t alignment)
+{
+	size_t dataOffset = (sizeof(HugeAllocation) + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+	if (alignment > B_PAGE_SIZE)
+		dataOffset = (dataOffset + alignment - 1) & ~(alignment - 1);
+
+	size_t areaSize = (dataOffset + size + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+	if (areaSize < size)
+		return NULL;
+
+	void* address;
+	area_id area = create_aligned_area("malloc huge", areaSize,
+		alignment > kArenaSize ? alignment : kArenaSize, &address);
+	if (area < 0)
+		return NULL;
+
+	HugeAllocation* allocation = (HugeAllocation*)address;
+	allocation->area = area;
+	allocation->areaSize = areaSize;
+	allocation->data = (uint8*)address + dataOffset;
+	allocation->size = areaSize - dataOffset;
+
+	MutexLocker locker(sLock);
+
+	if (_SetMapEntries((addr_t)address, areaSize, (addr_t)allocation | 1)
+			!= B_OK) {
+		locker.Unlock();
+		delete_area(area);
+		return NULL;
+	}
+
+	sHugeSize += areaSize;
+	sHugeCount++;
+
+	return allocation->data;
+}
+
+
+/*static*/ void
+PageHeap::FreeHuge(HugeAllocation* allocation)
+{
+	MutexLocker locker(sLock);
+
+	_SetMapEntries((addr_t)allocation, allocation->areaSize, 0);
+	sHugeSize -= allocation->areaSize;
+	sHugeCount--;
+
+	locker.Unlock();
+
+	delete_area(allocation->area);
+}
+
+
+/*!	Tries to resize the area of a huge allocation in place. Returns its data,
+	or \c NULL, if the area could not be resized.
+*/
+/*static*/ void*
+PageHeap::ResizeHuge(HugeAllocation* allocation, size_t size)
+{
+	size_t dataOffset = allocation->data - (uint8*)allocation;
+	size_t areaSize = (dataOffset + size + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+	if (areaSize < size)
+		return NULL;
+
+	MutexLocker locker(sLock);
+
+	size_t oldSize = allocation->areaSize;
+	if (areaSize > oldSize) {
+		if (resize_area(allocation->area, areaSize) != B_OK)
+			return NULL;
+
+		if (_SetMapEntries((addr_t)allocation, areaSize,
+				(addr_t)allocation | 1) != B_OK) {
+			resize_area(allocation->area, oldSize);
+			return NULL;
+		}
+	} else if (areaSize < oldSize) {
+		if (resize_area(allocation->area, areaSize) != B_OK)
+			return allocation->data;
+
+		// clear the entries the area doesn't cover anymore
+		addr_t end = (addr_t)allocation + areaSize;
+		addr_t mapEnd = (end + kArenaSize - 1) & ~(addr_t)(kArenaSize - 1);
+		if (mapEnd < (addr_t)allocation + oldSize) {
+			_SetMapEntries(mapEnd, (addr_t)allocation + oldSize - mapEnd,
+				0);
+		}
+	}
+
+	allocation->areaSize = areaSize;
+	allocation->size = areaSize - dataOffset;
+	sHugeSize += areaSize - oldSize;
+
+	return allocation->data;
+}
+
+
+/*static*/ void
+PageHeap::GetStats(size_t& totalSize, size_t& usedSize, size_t& usedRuns)
+{
+	MutexLocker locker(sLock);
+
+	totalSize = sArenaCount * kArenaSize + sHugeSize;
+	usedSize = sUsedSpans * kSpanSize + sHugeSize;
+	usedRuns = sUsedRuns + sHugeCount;
+}
+
+
+/*static*/ void
+PageHeap::LockForFork()
+{
+	mutex_lock(&sLock);
+}
+
+
+/*static*/ void
+PageHeap::UnlockAfterFork(bool child)
+{
+	if (child)
+		mutex_init_etc(&sLock, "malloc page heap", MUTEX_FLAG_ADAPTIVE);
+	else
+		mutex_unlock(&sLock);
+}
+
+
+/*static*/ Arena*
+PageHeap::_CreateArena()
+{
+	void* address;
+	area_id area = create_aligned_area("malloc arena", kArenaSize, kArenaSize,
+		&address);
+	if (area < 0)
+		return NULL;
+
+	if (_SetMapEntries((addr_t)address, kArenaSize, (addr_t)address)
+			!= B_OK) {
+		delete_area(area);
+		return NULL;
+	}
+
+	Arena* arena = (Arena*)address;
+	arena->area = area;
+	arena->freeSpans = kSpansPerArena - 1;
+	memset(arena->spans, 0, sizeof(arena->spans));
+
+	Span* header = &arena->spans[0];
+	header->count = 1;
+	header->state = SPAN_HEADER;
+	arena->runStart[0] = 0;
+
+	// the new area has no pages yet
+	Span* span = &arena->spans[1];
+	span->count = kSpansPerArena - 1;
+	span->committed = false;
+	_InsertFreeRun(arena, span);
+
+	sArenaCount++;
+	sEmptyArenas++;
+
+	TRACE("created arena %p\n", arena);
+	return arena;
+}
+
+
+/*static*/ void
+PageHeap::_DeleteArena(Arena* arena)
+{
+	TRACE("delete arena %p\n", arena);
+
+	_SetMapEntries((addr_t)arena, kArenaSize, 0);
+	sArenaCount--;
+
+	delete_area(arena->area);
+}
+
+
+/*!	Points the arena map entries of the given range to \a value. Creates
+	missing map leaves, which can fail.
+*/
+/*static*/ status_t
+PageHeap::_SetMapEntries(addr_t address, size_t size, addr_t value)
+{
+	addr_t first = address >> kArenaShift;
+	addr_t last = (address + size - 1) >> kArenaShift;
+	if (last >= ((addr_t)1 << kMapBits))
+		return B_BAD_ADDRESS;
+
+	for (addr_t index = first; index <= last; index++) {
+		addr_t*& leaf = sMap[index >> kMapLeafBits];
+		if (leaf == NULL) {
+			if (value == 0)
+				continue;
+
+			void* leafAddress;
+			area_id area = create_area("malloc arena map", &leafAddress,
+				B_ANY_ADDRESS, (kMapLeafSize * sizeof(addr_t) + B_PAGE_SIZE - 1)
+					& ~(size_t)(B_PAGE_SIZE - 1),
+				B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+			if (area < 0) {
+				// undo what we already did
+				if (index > first)
+					_SetMapEntries(address, (index - first) << kArenaShift, 0);
+				return area;
+			}
+
+			leaf = (addr_t*)leafAddress;
+		}
+
+		leaf[index & (kMapLeafSize - 1)] = value;
+	}
+
+	return B_OK;
+}
+
+
+/*static*/ void
+PageHeap::_InsertFreeRun(Arena* arena, Span* span)
+{
+	uint32 index = span - arena->spans;
+	span->state = SPAN_FREE;
+	arena->runStart[index] = index;
+	arena->runStart[index + span->count - 1] = index;
+
+	if (span->committed)
+		sCommittedFreeSpans += span->count;
+
+	// recently freed runs are reused first, their pages are still there
+	sFreeRuns[span->count].Add(span, false);
+}
+
+
+/*static*/ void
+PageHeap::_RemoveFreeRun(Span* span)
+{
+	if (span->committed)
+		sCommittedFreeSpans -= span->count;
+
+	sFreeRuns[span->count].Remove(span);
+}
+
+
+/*!	Merges the free run \a span, which must not be in a free list, with the
+	free runs next to it that are in the same committed state. Runs are only
+	ever committed or decommitted as a whole, so that sCommittedFreeSpans
+	stays exact.
+	Returns the merged run, which still has to be inserted.
+*/
+/*static*/ Span*
+PageHeap::_Coalesce(Arena* arena, Span* span)
+{
+	uint32 index = span - arena->spans;
+
+	// coalesce with the following run
+	uint32 nextIndex = index + span->count;
+	if (nextIndex < kSpansPerArena) {
+		Span* next = &arena->spans[nextIndex];
+		if (next->state == SPAN_FREE && next->committed == span->committed) {
+			_RemoveFreeRun(next);
+			span->count += next->count;
+		}
+	}
+
+	// coalesce with the preceding run
+	Span* previous = &arena->spans[arena->runStart[index - 1]];
+	if (previous->state == SPAN_FREE
+		&& previous->committed == span->committed) {
+		_RemoveFreeRun(previous);
+		previous->count += span->count;
+		previous->freeTime = span->freeTime;
+		span = previous;
+	}
+
+	return span;
+}
+
+
+/*!	Gives the pages of free runs back to the kernel. This happens once in
+	a while for runs that have been free for kDecommitDelay, and right away
+	when too many free spans are committed.
+*/
+/*static*/ void
+PageHeap::_Decommit()
+{
+	if (sCommittedFreeSpans == 0)
+		return;
+
+	bigtime_t now = system_time();
+	bool tooMany = sCommittedFreeSpans > kMaxCommittedFreeSpans;
+	if (!tooMany && now - sLastDecommit < kDecommitDelay)
+		return;
+
+	sLastDecommit = now;
+
+	// start with the largest runs, they are the least likely to be reused
+	for (int32 i = kSpansPerArena - 1; i > 0; i--) {
+		SpanList::Iterator iterator = sFreeRuns[i].GetIterator();
+		while (Span* span = iterator.Next()) {
+			if (!span->committed)
+				continue;
+
+			if (!tooMany && now - span->freeTime < kDecommitDelay)
+				continue;
+
+			_RemoveFreeRun(span);
+			_kern_memory_advice(RunAddress(span), RunSize(span), MADV_FREE);
+			span->committed = false;
+
+			// join the decommitted runs next to it
+			Arena* arena = _ArenaOf(span);
+			_InsertFreeRun(arena, _Coalesce(arena, span));
+
+			tooMany = sCommittedFreeSpans > kMaxCommittedFreeSpans / 2;
+			if (sCommittedFreeSpans == 0)
+				return;
+
+			// the list may have changed, start over
+			iterator = sFreeRuns[i].GetIterator();
+		}
+	}
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MALLOC_TCACHE_PAGE_HEAP_H
+#define MALLOC_TCACHE_PAGE_HEAP_H
+
+
+#include <OS.h>
+
+#include <util/DoublyLinkedList.h>
+
+
+namespace BPrivate {
+
+
+struct ThreadCache;
+
+
+static const size_t kAlignment = 16;
+
+static const uint32 kSpanShift = 16;
+static const size_t kSpanSize = (size_t)1 << kSpanShift;
+static const uint32 kArenaShift = 22;
+static const size_t kArenaSize = (size_t)1 << kArenaShift;
+static const uint32 kSpansPerArena = kArenaSize / kSpanSize;
+
+// the first span of every arena holds its header
+static const size_t kMaxLargeSize = kArenaSize - kSpanSize;
+
+
+enum {
+	SPAN_FREE = 0,
+	SPAN_HEADER,
+	SPAN_INTERNAL,
+	SPAN_SLAB,
+	SPAN_LARGE
+};
+
+
+/*!	Describes a run of spans within an arena. The descriptors live in the
+	arena header, the one of the first span describes the whole run.
+*/
+struct Span : DoublyLinkedListLinkImpl<Span> {
+	uint16			count;
+	uint8			state;
+
+	// free runs
+	bool			committed;
+	bigtime_t		freeTime;
+
+	// slabs
+	uint8			sizeClass;
+	uint8			list;
+	uint16			usedCount;
+	uint16			freshCount;
+	uint8*			fresh;
+	void*			freeList;
+	void*			remoteFreeList;
+		// objects freed by other threads, accessed atomically
+	ThreadCache*	owner;
+};
+
+typedef DoublyLinkedList<Span> SpanList;
+
+
+struct Arena {
+	area_id			area;
+	uint16			freeSpans;
+	uint8			runStart[kSpansPerArena];
+		// index of the first span of the run each span belongs to
+	Span			spans[kSpansPerArena];
+
+	inline	uint8*		AddressOf(const Span* span)
+							{ return (uint8*)this
+								+ ((span - spans) << kSpanShift); }
+};
+
+
+/*!	Allocations too large for an arena get an area of their own, starting
+	with this header.
+*/
+struct HugeAllocation {
+	area_id			area;
+	size_t			areaSize;
+	uint8*			data;
+	size_t			size;
+};
+
+
+class PageHeap {
+public:
+	static	status_t			Init();
+
+	static	Span*				AllocateRun(uint32 count, uint8 state);
+	static	void				FreeRun(Span* span);
+
+	static	void*				AllocateHuge(size_t size, size_t alignment);
+	static	void				FreeHuge(HugeAllocation* allocation);
+	static	void*				ResizeHuge(HugeAllocation* allocation,
+									size_t size);
+
+	static	inline uint8*		RunAddress(const Span* span);
+	static	inline size_t		RunSize(const Span* span)
+									{ return (size_t)span->count
+										<< kSpanShift; }
+	static	inline bool			Lookup(const void* address, Span*& _span,
+									HugeAllocation*& _huge);
+
+	static	void				GetStats(size_t& totalSize,
+									size_t& usedSize, size_t& usedRuns);
+
+	static	void				LockForFork();
+	static	void				UnlockAfterFork(bool child);
+
+private:
+#if B_HAIKU_64_BIT
+	static	const uint32		kAddressBits = 48;
+	static	const uint32		kMapLeafBits = 13;
+#else
+	static	const uint32		kAddressBits = 32;
+	static	const uint32		kMapLeafBits = 5;
+#endif
+	static	const uint32		kMapBits = kAddressBits - kArenaShift;
+	static	const uint32		kMapRootSize
+									= (uint32)1 << (kMapBits - kMapLeafBits);
+	static	const uint32		kMapLeafSize = (uint32)1 << kMapLeafBits;
+
+	static	Arena*				_CreateArena();
+	static	void				_DeleteArena(Arena* arena);
+	static	status_t			_SetMapEntries(addr_t address, size_t size,
+									addr_t value);
+
+	static	void				_InsertFreeRun(Arena* arena, Span* span);
+	static	void				_RemoveFreeRun(Span* span);
+	static	Span*				_Coalesce(Arena* arena, Span* span);
+	static	void				_Decommit();
+
+	static	inline Arena*		_ArenaOf(const Span* span)
+									{ return (Arena*)((addr_t)span
+										& ~(addr_t)(kArenaSize - 1)); }
+
+	static	addr_t*				sMap[kMapRootSize];
+};
+
+
+/*static*/ inline uint8*
+PageHeap::RunAddress(const Span* span)
+{
+	return _ArenaOf(span)->AddressOf(span);
+}
+
+
+/*!	Finds the run or huge allocation \a address belongs to. Returns \c false,
+	if it wasn't allocated by us.
+*/
+/*static*/ inline bool
+PageHeap::Lookup(const void* address, Span*& _span, HugeAllocation*& _huge)
+{
+	addr_t index = (addr_t)address >> kArenaShift;
+	if (index >= ((addr_t)1 << kMapBits))
+		return false;
+
+	addr_t* leaf = sMap[index >> kMapLeafBits];
+	if (leaf == NULL)
+		return false;
+
+	addr_t entry = leaf[index & (kMapLeafSize - 1)];
+	if (entry == 0)
+		return false;
+
+	if ((entry & 1) != 0) {
+		_span = NULL;
+		_huge = (HugeAllocation*)(entry & ~(addr_t)1);
+		return true;
+	}
+
+	Arena* arena = (Arena*)entry;
+	uint32 spanIndex = ((addr_t)address - entry) >> kSpanShift;
+	Span* span = &arena->spans[arena->runStart[spanIndex]];
+	if (span->state != SPAN_SLAB && span->state != SPAN_LARGE)
+		return false;
+
+	_span = span;
+	_huge = NULL;
+	return true;
+}
+
+
+}	// namespace BPrivate
+
+
+#endif	// MALLOC_TCACHE_PAGE_HEAP_H
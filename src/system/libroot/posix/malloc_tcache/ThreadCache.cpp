@@ -0,0 +1,360 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "ThreadCache.h"
+
+#include <new>
+
+#include <locks.h>
+
+
+using namespace BPrivate;
+
+
+static const uint32 kMaxSlabSpans = 8;
+static const uint32 kMinSlabObjects = 8;
+static const uint32 kMaxFullSlabScan = 4;
+	// full slabs checked for remote frees before a new slab is used
+
+
+SizeClass BPrivate::gSizeClasses[kSizeClassCount];
+uint8 BPrivate::gSmallSizeClassIndex[1024 / 16 + 1];
+uint8 BPrivate::gLargeSizeClassIndex[kMaxSmallSize / 128 + 1];
+
+static mutex sCacheLock;
+static DoublyLinkedList<ThreadCache> sCaches;
+static DoublyLinkedList<ThreadCache> sFreeCaches;
+
+static mutex sAbandonedLock;
+static SpanList sAbandonedSlabs[kSizeClassCount];
+
+
+static inline void*
+swap_pointer(void** pointer, void* value)
+{
+#if B_HAIKU_64_BIT
+	return (void*)atomic_get_and_set64((int64*)pointer, (int64)value);
+#else
+	return (void*)atomic_get_and_set((int32*)pointer, (int32)value);
+#endif
+}
+
+
+static inline void*
+test_and_set_pointer(void** pointer, void* value, void* test)
+{
+#if B_HAIKU_64_BIT
+	return (void*)atomic_test_and_set64((int64*)pointer, (int64)value,
+		(int64)test);
+#else
+	return (void*)atomic_test_and_set((int32*)pointer, (int32)value,
+		(int32)test);
+#endif
+}
+
+
+static void
+add_size_class(uint32& index, uint32 size)
+{
+	SizeClass& sizeClass = gSizeClasses[index++];
+	sizeClass.size = size;
+
+	// use the smallest slab that wastes less than 1/16 of its size
+	uint32 spanCount = 1;
+	for (; spanCount < kMaxSlabSpans; spanCount++) {
+		size_t slabSize = spanCount * kSpanSize;
+		size_t objectCount = slabSize / size;
+		if (objectCount >= kMinSlabObjects
+			&& (slabSize - objectCount * size) * 16 <= slabSize) {
+			break;
+		}
+	}
+
+	sizeClass.spanCount = spanCount;
+	sizeClass.objectCount = spanCount * kSpanSize / size;
+}
+
+
+static void
+init_size_classes()
+{
+	// 16 byte steps up to 128 bytes, then four steps per power of two
+	uint32 index = 0;
+	for (uint32 size = 16; size <= 128; size += 16)
+		add_size_class(index, size);
+
+	for (uint32 base = 128; base < kMaxSmallSize; base *= 2) {
+		for (uint32 step = 1; step <= 4; step++)
+			add_size_class(index, base + base / 4 * step);
+	}
+
+	uint32 sizeClass = 0;
+	for (uint32 i = 0; i < sizeof(gSmallSizeClassIndex); i++) {
+		while (gSizeClasses[sizeClass].size < i * 16)
+			sizeClass++;
+		gSmallSizeClassIndex[i] = sizeClass;
+	}
+
+	sizeClass = 0;
+	for (uint32 i = 0; i < sizeof(gLargeSizeClassIndex); i++) {
+		while (gSizeClasses[sizeClass].size < i * 128)
+			sizeClass++;
+		gLargeSizeClassIndex[i] = sizeClass;
+	}
+}
+
+
+// #pragma mark - ThreadCache
+
+
+/*static*/ status_t
+ThreadCache::Init()
+{
+	mutex_init_etc(&sCacheLock, "malloc thread caches", MUTEX_FLAG_ADAPTIVE);
+	mutex_init_etc(&sAbandonedLock, "malloc abandoned slabs",
+		MUTEX_FLAG_ADAPTIVE);
+
+	init_size_classes();
+	return B_OK;
+}
+
+
+/*!	Abandons the slabs of the current thread, called when it exits.
+*/
+/*static*/ void
+ThreadCache::ThreadExit()
+{
+	ThreadCache* cache = Current();
+	if (cache == NULL)
+		return;
+
+	cache->_Abandon();
+	tls_set(TLS_MALLOC_SLOT, NULL);
+
+	MutexLocker locker(sCacheLock);
+	sCaches.Remove(cache);
+	sFreeCaches.Add(cache);
+}
+
+
+/*static*/ void
+ThreadCache::LockForFork()
+{
+	mutex_lock(&sCacheLock);
+	mutex_lock(&sAbandonedLock);
+}
+
+
+/*!	In the child, the caches of all other threads are orphaned, their slabs
+	are abandoned.
+*/
+/*static*/ void
+ThreadCache::UnlockAfterFork(bool child)
+{
+	if (!child) {
+		mutex_unlock(&sAbandonedLock);
+		mutex_unlock(&sCacheLock);
+		return;
+	}
+
+	mutex_init_etc(&sCacheLock, "malloc thread caches", MUTEX_FLAG_ADAPTIVE);
+	mutex_init_etc(&sAbandonedLock, "malloc abandoned slabs",
+		MUTEX_FLAG_ADAPTIVE);
+
+	ThreadCache* current = Current();
+	ThreadCache* cache = sCaches.Head();
+	while (cache != NULL) {
+		ThreadCache* next = sCaches.GetNext(cache);
+		if (cache != current) {
+			cache->_Abandon();
+			sCaches.Remove(cache);
+			sFreeCaches.Add(cache);
+		}
+		cache = next;
+	}
+}
+
+
+/*!	Frees an object of a slab owned by another thread, or abandoned.
+*/
+/*static*/ void
+ThreadCache::FreeRemote(Span* slab, void* object)
+{
+	void* head;
+	do {
+		head = slab->remoteFreeList;
+		*(void**)object = head;
+	} while (test_and_set_pointer(&slab->remoteFreeList, object, head)
+		!= head);
+}
+
+
+/*static*/ ThreadCache*
+ThreadCache::_Create()
+{
+	MutexLocker locker(sCacheLock);
+
+	if (sFreeCaches.IsEmpty()) {
+		Span* span = PageHeap::AllocateRun(1, SPAN_INTERNAL);
+		if (span == NULL)
+			return NULL;
+
+		uint8* address = PageHeap::RunAddress(span);
+		for (size_t i = 0; i < kSpanSize / sizeof(ThreadCache); i++)
+			sFreeCaches.Add(new(address + i * sizeof(ThreadCache)) ThreadCache);
+	}
+
+	ThreadCache* cache = sFreeCaches.RemoveHead();
+	sCaches.Add(cache);
+	locker.Unlock();
+
+	tls_set(TLS_MALLOC_SLOT, cache);
+	return cache;
+}
+
+
+void*
+ThreadCache::_AllocateSlow(uint32 sizeClass)
+{
+	ClassCache& cache = fClasses[sizeClass];
+
+	// look for remote frees in full slabs
+	for (uint32 i = 0; i < kMaxFullSlabScan; i++) {
+		Span* slab = cache.full.RemoveHead();
+		if (slab == NULL)
+			break;
+
+		if (_CollectRemoteFrees(slab)) {
+			cache.available.Add(slab);
+			slab->list = SLAB_LIST_AVAILABLE;
+			return Allocate(sizeClass);
+		}
+
+		cache.full.Add(slab);
+	}
+
+	// adopt an abandoned slab
+	if (!sAbandonedSlabs[sizeClass].IsEmpty()) {
+		MutexLocker locker(sAbandonedLock);
+		while (Span* slab = sAbandonedSlabs[sizeClass].RemoveHead()) {
+			locker.Unlock();
+
+			slab->owner = this;
+			_CollectRemoteFrees(slab);
+			if (slab->freeList != NULL || slab->freshCount > 0) {
+				cache.available.Add(slab);
+				slab->list = SLAB_LIST_AVAILABLE;
+				return Allocate(sizeClass);
+			}
+
+			cache.full.Add(slab);
+			slab->list = SLAB_LIST_FULL;
+
+			locker.Lock();
+		}
+	}
+
+	// get a new slab
+	const SizeClass& info = gSizeClasses[sizeClass];
+	Span* slab = PageHeap::AllocateRun(info.spanCount, SPAN_SLAB);
+	if (slab == NULL)
+		return NULL;
+
+	slab->sizeClass = sizeClass;
+	slab->list = SLAB_LIST_AVAILABLE;
+	slab->usedCount = 0;
+	slab->freshCount = info.objectCount;
+	slab->fresh = PageHeap::RunAddress(slab);
+	slab->freeList = NULL;
+	slab->remoteFreeList = NULL;
+	slab->owner = this;
+
+	cache.available.Add(slab);
+	return Allocate(sizeClass);
+}
+
+
+/*!	Called when the last object of \a slab has been allocated.
+*/
+void
+ThreadCache::_SlabFull(Span* slab)
+{
+	if (_CollectRemoteFrees(slab))
+		return;
+
+	ClassCache& cache = fClasses[slab->sizeClass];
+	cache.available.Remove(slab);
+	cache.full.Add(slab);
+	slab->list = SLAB_LIST_FULL;
+}
+
+
+/*!	Called when the last object of \a slab has been freed. The slab is
+	returned to the page heap, unless it's the only one left to allocate
+	from.
+*/
+void
+ThreadCache::_SlabEmpty(Span* slab)
+{
+	ClassCache& cache = fClasses[slab->sizeClass];
+	if (cache.available.Head() == slab && cache.available.GetNext(slab) == NULL)
+		return;
+
+	cache.available.Remove(slab);
+	PageHeap::FreeRun(slab);
+}
+
+
+void
+ThreadCache::_Abandon()
+{
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		ClassCache& cache = fClasses[i];
+		for (int32 list = 0; list < 2; list++) {
+			SpanList& slabs = list == 0 ? cache.available : cache.full;
+			while (Span* slab = slabs.RemoveHead()) {
+				_CollectRemoteFrees(slab);
+				if (slab->usedCount == 0) {
+					PageHeap::FreeRun(slab);
+					continue;
+				}
+
+				slab->owner = NULL;
+				slab->list = SLAB_LIST_ABANDONED;
+
+				MutexLocker locker(sAbandonedLock);
+				sAbandonedSlabs[i].Add(slab);
+			}
+		}
+	}
+}
+
+
+/*!	Moves the objects other threads have freed to the slab's free list.
+	Returns whether there were any.
+*/
+/*static*/ bool
+ThreadCache::_CollectRemoteFrees(Span* slab)
+{
+	if (slab->remoteFreeList == NULL)
+		return false;
+
+	void* list = swap_pointer(&slab->remoteFreeList, NULL);
+	if (list == NULL)
+		return false;
+
+	void* last = list;
+	uint32 count = 1;
+	while (*(void**)last != NULL) {
+		last = *(void**)last;
+		count++;
+	}
+
+	*(void**)last = slab->freeList;
+	slab->freeList = list;
+	slab->usedCount -= count;
+	return true;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MALLOC_TCACHE_THREAD_CACHE_H
+#define MALLOC_TCACHE_THREAD_CACHE_H
+
+
+#include <TLS.h>
+
+#include <tls.h>
+
+#include "PageHeap.h"
+
+
+namespace BPrivate {
+
+
+static const size_t kMaxSmallSize = 32768;
+static const uint32 kSizeClassCount = 40;
+
+
+struct SizeClass {
+	uint32			size;
+	uint16			spanCount;
+	uint16			objectCount;
+};
+
+
+enum {
+	SLAB_LIST_AVAILABLE = 0,
+	SLAB_LIST_FULL,
+	SLAB_LIST_ABANDONED
+};
+
+
+extern SizeClass gSizeClasses[kSizeClassCount];
+extern uint8 gSmallSizeClassIndex[1024 / 16 + 1];
+extern uint8 gLargeSizeClassIndex[kMaxSmallSize / 128 + 1];
+
+
+static inline uint32
+size_class_for(size_t size)
+{
+	if (size <= 1024)
+		return gSmallSizeClassIndex[(size + 15) >> 4];
+	return gLargeSizeClassIndex[(size + 127) >> 7];
+}
+
+
+/*!	The slabs a thread allocates small objects from. Every slab is owned by
+	one thread cache: only its thread allocates from it, and only frees of
+	that thread go to the slab's free list directly. Other threads push the
+	objects they free onto the slab's remote free list without locking,
+	the owner collects them when it runs out of objects.
+	When a thread exits, its slabs are abandoned, and adopted by the next
+	thread that needs a slab of their size class.
+*/
+struct ThreadCache : DoublyLinkedListLinkImpl<ThreadCache> {
+public:
+	static	status_t			Init();
+
+	static	inline ThreadCache*	Current();
+	static	inline ThreadCache*	Get();
+
+	static	void				ThreadExit();
+
+	static	void				LockForFork();
+	static	void				UnlockAfterFork(bool child);
+
+	inline	void*				Allocate(uint32 sizeClass);
+	inline	void				Free(Span* slab, void* object);
+	static	void				FreeRemote(Span* slab, void* object);
+
+private:
+			struct ClassCache {
+				SpanList		available;
+				SpanList		full;
+			};
+
+	static	ThreadCache*		_Create();
+
+			void*				_AllocateSlow(uint32 sizeClass);
+			void				_SlabFull(Span* slab);
+			void				_SlabEmpty(Span* slab);
+			void				_Abandon();
+
+	static	bool				_CollectRemoteFrees(Span* slab);
+
+private:
+			ClassCache			fClasses[kSizeClassCount];
+};
+
+
+/*static*/ inline ThreadCache*
+ThreadCache::Current()
+{
+	return (ThreadCache*)tls_get(TLS_MALLOC_SLOT);
+}
+
+
+/*static*/ inline ThreadCache*
+ThreadCache::Get()
+{
+	ThreadCache* cache = Current();
+	if (cache == NULL)
+		cache = _Create();
+	return cache;
+}
+
+
+inline void*
+ThreadCache::Allocate(uint32 sizeClass)
+{
+	Span* slab = fClasses[sizeClass].available.Head();
+	if (slab == NULL)
+		return _AllocateSlow(sizeClass);
+
+	void* object = slab->freeList;
+	if (object != NULL)
+		slab->freeList = *(void**)object;
+	else {
+		object = slab->fresh;
+		slab->fresh += gSizeClasses[sizeClass].size;
+		slab->freshCount--;
+	}
+
+	slab->usedCount++;
+
+	if (slab->freeList == NULL && slab->freshCount == 0)
+		_SlabFull(slab);
+
+	return object;
+}
+
+
+/*!	Frees an object of a slab the cache owns.
+*/
+inline void
+ThreadCache::Free(Span* slab, void* object)
+{
+	*(void**)object = slab->freeList;
+	slab->freeList = object;
+	slab->usedCount--;
+
+	if (slab->list == SLAB_LIST_FULL) {
+		ClassCache& cache = fClasses[slab->sizeClass];
+		cache.full.Remove(slab);
+		cache.available.Add(slab);
+		slab->list = SLAB_LIST_AVAILABLE;
+	}
+
+	if (slab->usedCount == 0)
+		_SlabEmpty(slab);
+}
+
+
+}	// namespace BPrivate
+
+
+#endif	// MALLOC_TCACHE_THREAD_CACHE_H
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The malloc() implementation of libroot.so. Small allocations come from
+	size class slabs owned by per-thread caches, see ThreadCache.h; larger
+	ones are runs of spans from the page heap, and those that don't fit an
+	arena get an area of their own.
+	The Hoard based allocator this one replaced is still available as
+	libroot_hoard.so, which can be linked against or preloaded instead.
+*/
+
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno_private.h>
+#include <libroot_private.h>
+#include <user_thread.h>
+
+#include "PageHeap.h"
+#include "ThreadCache.h"
+
+#include "tracing_config.h"
+
+
+using namespace BPrivate;
+
+
+#if USER_MALLOC_TRACING
+#	define KTRACE(format...)	ktrace_printf(format)
+#else
+#	define KTRACE(format...)	do {} while (false)
+#endif
+
+
+static void*
+allocate(size_t size)
+{
+	if (size <= kMaxSmallSize) {
+		ThreadCache* cache = ThreadCache::Get();
+		if (cache == NULL)
+			return NULL;
+		return cache->Allocate(size_class_for(size));
+	}
+
+	if (size <= kMaxLargeSize) {
+		Span* span = PageHeap::AllocateRun(
+			(size + kSpanSize - 1) >> kSpanShift, SPAN_LARGE);
+		return span != NULL ? PageHeap::RunAddress(span) : NULL;
+	}
+
+	return PageHeap::AllocateHuge(size, B_PAGE_SIZE);
+}
+
+
+static void*
+allocate_aligned(size_t alignment, size_t size)
+{
+	if (alignment <= kAlignment)
+		return allocate(size);
+
+	size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+	if (alignedSize < size)
+		return NULL;
+	if (alignedSize == 0)
+		alignedSize = alignment;
+
+	// Objects are aligned to the largest power of two their size class is a
+	// multiple of, since slabs are span aligned.
+	if (alignedSize <= kMaxSmallSize) {
+		ThreadCache* cache = ThreadCache::Get();
+		if (cache == NULL)
+			return NULL;
+
+		uint32 sizeClass = size_class_for(alignedSize);
+		while (gSizeClasses[sizeClass].size % alignment != 0)
+			sizeClass++;
+		return cache->Allocate(sizeClass);
+	}
+
+	// runs are span aligned
+	size_t runSize = alignedSize;
+	if (alignment > kSpanSize)
+		runSize += alignment - kSpanSize;
+
+	if (runSize >= alignedSize && runSize <= kMaxLargeSize) {
+		Span* span = PageHeap::AllocateRun(
+			(runSize + kSpanSize - 1) >> kSpanShift, SPAN_LARGE);
+		if (span == NULL)
+			return NULL;
+
+		addr_t address = (addr_t)PageHeap::RunAddress(span);
+		return (void*)((address + alignment - 1) & ~(addr_t)(alignment - 1));
+	}
+
+	return PageHeap::AllocateHuge(size, alignment);
+}
+
+
+static void
+deallocate(void* address)
+{
+	Span* span;
+	HugeAllocation* huge;
+	if (!PageHeap::Lookup(address, span, huge)) {
+		debug_printf("free(): invalid pointer %p\n", address);
+		debugger("free(): invalid pointer");
+		return;
+	}
+
+	if (huge != NULL)
+		PageHeap::FreeHuge(huge);
+	else if (span->state == SPAN_LARGE)
+		PageHeap::FreeRun(span);
+	else {
+		ThreadCache* cache = ThreadCache::Current();
+		if (cache != NULL && span->owner == cache)
+			cache->Free(span, address);
+		else
+			ThreadCache::FreeRemote(span, address);
+	}
+}
+
+
+/*!	Returns how many bytes can be used at \a address, or 0, if it wasn't
+	allocated by us.
+*/
+static size_t
+usable_size(void* address)
+{
+	Span* span;
+	HugeAllocation* huge;
+	if (!PageHeap::Lookup(address, span, huge))
+		return 0;
+
+	if (huge != NULL)
+		return huge->data + huge->size - (uint8*)address;
+	if (span->state == SPAN_LARGE)
+		return PageHeap::RunAddress(span) + PageHeap::RunSize(span)
+			- (uint8*)address;
+
+	return gSizeClasses[span->sizeClass].size;
+}
+
+
+// #pragma mark - private hooks
+
+
+extern "C" status_t
+__init_heap(void)
+{
+	status_t status = PageHeap::Init();
+	if (status != B_OK)
+		return status;
+
+	return ThreadCache::Init();
+}
+
+
+extern "C" void
+__heap_terminate_after()
+{
+	// nothing to do
+}
+
+
+extern "C" void
+__heap_thread_exit(void)
+{
+	defer_signals();
+	ThreadCache::ThreadExit();
+	undefer_signals();
+}
+
+
+extern "C" void
+__heap_before_fork(void)
+{
+	ThreadCache::LockForFork();
+	PageHeap::LockForFork();
+}
+
+
+extern "C" void
+__heap_after_fork_child(void)
+{
+	PageHeap::UnlockAfterFork(true);
+	ThreadCache::UnlockAfterFork(true);
+}
+
+
+extern "C" void
+__heap_after_fork_parent(void)
+{
+	PageHeap::UnlockAfterFork(false);
+	ThreadCache::UnlockAfterFork(false);
+}
+
+
+// #pragma mark - public functions
+
+
+extern "C" void*
+malloc(size_t size)
+{
+	defer_signals();
+	void* address = allocate(size);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("malloc(%lu) -> NULL", size);
+		return NULL;
+	}
+
+	KTRACE("malloc(%lu) -> %p", size, address);
+	return address;
+}
+
+
+extern "C" void*
+calloc(size_t elementCount, size_t elementSize)
+{
+	size_t size = elementCount * elementSize;
+	if (elementSize != 0 && size / elementSize != elementCount) {
+		__set_errno(B_NO_MEMORY);
+		return NULL;
+	}
+
+	defer_signals();
+	void* address = allocate(size);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("calloc(%lu, %lu) -> NULL", elementCount, elementSize);
+		return NULL;
+	}
+
+	memset(address, 0, size);
+	KTRACE("calloc(%lu, %lu) -> %p", elementCount, elementSize, address);
+	return address;
+}
+
+
+extern "C" void
+free(void* address)
+{
+	KTRACE("free(%p)", address);
+
+	if (address == NULL)
+		return;
+
+	defer_signals();
+	deallocate(address);
+	undefer_signals();
+}
+
+
+extern "C" void*
+memalign(size_t alignment, size_t size)
+{
+	if ((alignment & (alignment - 1)) != 0) {
+		__set_errno(B_BAD_VALUE);
+		return NULL;
+	}
+
+	defer_signals();
+	void* address = allocate_aligned(alignment, size);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("memalign(%lu, %lu) -> NULL", alignment, size);
+		return NULL;
+	}
+
+	KTRACE("memalign(%lu, %lu) -> %p", alignment, size, address);
+	return address;
+}
+
+
+extern "C" int
+posix_memalign(void** _pointer, size_t alignment, size_t size)
+{
+	if ((alignment & (sizeof(void*) - 1)) != 0
+		|| (alignment & (alignment - 1)) != 0 || _pointer == NULL) {
+		return B_BAD_VALUE;
+	}
+
+	defer_signals();
+	void* pointer = allocate_aligned(alignment, size);
+	undefer_signals();
+
+	if (pointer == NULL) {
+		KTRACE("posix_memalign(%p, %lu, %lu) -> NULL", _pointer, alignment,
+			size);
+		return B_NO_MEMORY;
+	}
+
+	*_pointer = pointer;
+	KTRACE("posix_memalign(%p, %lu, %lu) -> %p", _pointer, alignment, size,
+		pointer);
+	return 0;
+}
+
+
+extern "C" void*
+valloc(size_t size)
+{
+	return memalign(B_PAGE_SIZE, size);
+}
+
+
+extern "C" void*
+realloc(void* address, size_t size)
+{
+	if (address == NULL)
+		return malloc(size);
+
+	if (size == 0) {
+		free(address);
+		return NULL;
+	}
+
+	defer_signals();
+
+	size_t oldSize = usable_size(address);
+	if (oldSize == 0) {
+		undefer_signals();
+		debug_printf("realloc(): invalid pointer %p\n", address);
+		debugger("realloc(): invalid pointer");
+		return NULL;
+	}
+
+	// keep the allocation, if it's large enough and not far too large
+	if (size <= oldSize && size >= oldSize / 2) {
+		undefer_signals();
+		KTRACE("realloc(%p, %lu) -> %p", address, size, address);
+		return address;
+	}
+
+	// huge allocations are resized in place, if possible
+	Span* span;
+	HugeAllocation* huge;
+	if (size > kMaxLargeSize && PageHeap::Lookup(address, span, huge)
+		&& huge != NULL && (uint8*)address == huge->data
+		&& PageHeap::ResizeHuge(huge, size) != NULL) {
+		undefer_signals();
+		KTRACE("realloc(%p, %lu) -> %p", address, size, address);
+		return address;
+	}
+
+	void* newAddress = allocate(size);
+	if (newAddress == NULL) {
+		undefer_signals();
+		__set_errno(B_NO_MEMORY);
+		KTRACE("realloc(%p, %lu) -> NULL", address, size);
+		return NULL;
+	}
+
+	memcpy(newAddress, address, oldSize < size ? oldSize : size);
+	deallocate(address);
+
+	undefer_signals();
+
+	KTRACE("realloc(%p, %lu) -> %p", address, size, newAddress);
+	return newAddress;
+}
+
+
+extern "C" size_t
+malloc_usable_size(void* address)
+{
+	if (address == NULL)
+		return 0;
+
+	defer_signals();
+	size_t size = usable_size(address);
+	undefer_signals();
+
+	return size;
+}
+
+
+//	#pragma mark - BeOS specific extensions
+
+
+struct mstats {
+	size_t bytes_total;
+	size_t chunks_used;
+	size_t bytes_used;
+	size_t chunks_free;
+	size_t bytes_free;
+};
+
+
+extern "C" struct mstats mstats(void);
+
+extern "C" struct mstats
+mstats(void)
+{
+	// the object counts of the slabs are not tracked, so this only shows
+	// how much memory the page heap has handed out
+	static struct mstats stats;
+
+	size_t totalSize, usedSize, usedRuns;
+	defer_signals();
+	PageHeap::GetStats(totalSize, usedSize, usedRuns);
+	undefer_signals();
+
+	stats.bytes_total = totalSize;
+	stats.chunks_used = usedRuns;
+	stats.bytes_used = usedSize;
+	stats.chunks_free = 0;
+	stats.bytes_free = totalSize - usedSize;
+
+	return stats;
+}
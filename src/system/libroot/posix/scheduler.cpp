@@ -1,4 +1,5 @@
 /*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
  * Copyright 2009, Michael Franz
  * Copyright 2008, Andreas Färber, andreas.faerber@web.de
  * Distributed under the terms of the MIT license.
@@ -54,3 +55,35 @@ sched_get_priority_max(int policy)
 			return -1;
 	}
 }
+
+
+int
+sched_getaffinity(pid_t thread, size_t setSize, cpuset_t* set)
+{
+	if (thread == 0)
+		thread = find_thread(NULL);
+
+	status_t status = _kern_get_thread_affinity(thread, set, setSize);
+	if (status != B_OK) {
+		__set_errno(status);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int
+sched_setaffinity(pid_t thread, size_t setSize, const cpuset_t* set)
+{
+	if (thread == 0)
+		thread = find_thread(NULL);
+
+	status_t status = _kern_set_thread_affinity(thread, set, setSize);
+	if (status != B_OK) {
+		__set_errno(status);
+		return -1;
+	}
+
+	return 0;
+}
@@ -165,6 +165,19 @@ msync(void* address, size_t length, int flags)
 
 int
 posix_madvise(void* address, size_t length, int advice)
+{
+	// POSIX_MADV_DONTNEED must not discard any data, while the kernel's
+	// MADV_DONTNEED does.
+	if (advice == POSIX_MADV_DONTNEED)
+		return 0;
+
+	status_t error = _kern_memory_advice(address, length, advice);
+	return error < 0 ? error : 0;
+}
+
+
+int
+madvise(void* address, size_t length, int advice)
 {
 	RETURN_AND_SET_ERRNO(_kern_memory_advice(address, length, advice));
 }
@@ -149,6 +149,7 @@ fork(void)
 
 	// call preparation hooks
 	call_fork_hooks(sPrepareHooks);
+	__object_caches_before_fork();
 	__heap_before_fork();
 
 	thread = _kern_fork();
@@ -164,12 +165,14 @@ fork(void)
 			// calling the kernel.
 		__gRuntimeLoader->reinit_after_fork();
 		__heap_after_fork_child();
+		__object_caches_after_fork_child();
 		__reinit_pwd_backend_after_fork();
 
 		call_fork_hooks(sChildHooks);
 	} else {
 		// we are the parent
 		__heap_after_fork_parent();
+		__object_caches_after_fork_parent();
 		call_fork_hooks(sParentHooks);
 		mutex_unlock(&sForkLock);
 	}
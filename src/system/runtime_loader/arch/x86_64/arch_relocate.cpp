@@ -12,6 +12,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <syscalls.h>
+
+#include "images.h"
+
+
+extern "C" void x86_64_lazy_binding_entry();
+
 
 static status_t
 relocate_rela(image_t* rootImage, image_t* image, Elf64_Rela* rel,
@@ -77,6 +84,72 @@ relocate_rela(image_t* rootImage, image_t* image, Elf64_Rela* rel,
 }
 
 
+/*!	Called by x86_64_lazy_binding_entry() when a PLT entry is used for the
+	first time. Resolves the symbol, and lets the GOT entry point to it, so
+	that subsequent calls go there directly.
+*/
+extern "C" Elf64_Addr
+x86_64_resolve_lazy_binding(image_t* image, uint64 relocationIndex)
+{
+	Elf64_Rela* rel = (Elf64_Rela*)image->pltrel + relocationIndex;
+	Elf64_Sym* sym = SYMBOL(image, ELF64_R_SYM(rel->r_info));
+
+	Elf64_Addr symAddr;
+	if (resolve_lazy_symbol(image, sym, &symAddr) != B_OK) {
+		FATAL("%s: Lazy binding of symbol \"%s\" failed\n", image->path,
+			SYMNAME(image, sym));
+		_kern_exit_team(1);
+	}
+
+	Elf64_Addr relocValue = symAddr + rel->r_addend;
+	*(Elf64_Addr*)(image->regions[0].delta + rel->r_offset) = relocValue;
+	return relocValue;
+}
+
+
+/*!	Prepares the PLT of \a image for lazy binding: the GOT entries still
+	point into the PLT, and only need to be adjusted by the load address.
+	Other relocation types are done immediately.
+*/
+static status_t
+relocate_plt_lazily(image_t* rootImage, image_t* image,
+	SymbolLookupCache* cache)
+{
+	Elf64_Addr* got = NULL;
+	for (elf_dyn* d = (elf_dyn*)image->dynamic_ptr; d->d_tag != DT_NULL;
+			d++) {
+		if (d->d_tag == DT_PLTGOT) {
+			got = (Elf64_Addr*)(d->d_un.d_ptr + image->regions[0].delta);
+			break;
+		}
+	}
+
+	if (got == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	// GOT[1] and GOT[2] are reserved for the dynamic linker: the first PLT
+	// entry pushes the former, and jumps to the latter.
+	got[1] = (Elf64_Addr)image;
+	got[2] = (Elf64_Addr)&x86_64_lazy_binding_entry;
+
+	Elf64_Rela* rel = (Elf64_Rela*)image->pltrel;
+	for (size_t i = 0; i < image->pltrel_len / sizeof(Elf64_Rela); i++) {
+		if (ELF64_R_TYPE(rel[i].r_info) == R_X86_64_JUMP_SLOT) {
+			*(Elf64_Addr*)(image->regions[0].delta + rel[i].r_offset)
+				+= image->regions[0].delta;
+			continue;
+		}
+
+		status_t status = relocate_rela(rootImage, image, &rel[i],
+			sizeof(Elf64_Rela), cache);
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
 status_t
 arch_relocate_image(image_t* rootImage, image_t* image,
 	SymbolLookupCache* cache)
@@ -95,8 +168,14 @@ arch_relocate_image(image_t* rootImage, image_t* image,
 
 	// PLT relocations (they are RELA on x86_64).
 	if (image->pltrel) {
-		status = relocate_rela(rootImage, image, (Elf64_Rela*)image->pltrel,
-			image->pltrel_len, cache);
+		status = B_ENTRY_NOT_FOUND;
+		if ((image->flags & RFLAG_LAZY_BINDING) != 0)
+			status = relocate_plt_lazily(rootImage, image, cache);
+		if (status == B_ENTRY_NOT_FOUND) {
+			image->flags &= ~RFLAG_LAZY_BINDING;
+			status = relocate_rela(rootImage, image,
+				(Elf64_Rela*)image->pltrel, image->pltrel_len, cache);
+		}
 		if (status != B_OK)
 			return status;
 	}
@@ -25,6 +25,7 @@
 
 #include "add_ons.h"
 #include "elf_load_image.h"
+#include "elf_symbol_cache.h"
 #include "elf_symbol_lookup.h"
 #include "elf_tls.h"
 #include "elf_versioning.h"
@@ -33,7 +34,6 @@
 
 
 // TODO: implement better locking strategy
-// TODO: implement lazy binding
 
 // a handle returned by load_library() (dlopen())
 #define RLD_GLOBAL_SCOPE	((void*)-2l)
@@ -195,10 +195,26 @@ load_dependencies(image_t* image)
 }
 
 
+/*!	Only the images loaded with the program are bound lazily: they stay
+	loaded until the program exits, and their symbols can be resolved
+	later just like they would have been during load_program().
+*/
+static bool
+lazy_binding_enabled()
+{
+	const char* bindNow = getenv("LD_BIND_NOW");
+	return bindNow == NULL || bindNow[0] == '\0';
+}
+
+
 static status_t
-relocate_image(image_t *rootImage, image_t *image)
+relocate_image(image_t *rootImage, image_t *image, bool lazy)
 {
+	if (lazy && (image->flags & RFLAG_BIND_NOW) == 0)
+		image->flags |= RFLAG_LAZY_BINDING;
+
 	SymbolLookupCache cache(image);
+	symbol_cache_prefill(image, &cache);
 
 	status_t status = arch_relocate_image(rootImage, image, &cache);
 	if (status < B_OK) {
@@ -206,6 +222,8 @@ relocate_image(image_t *rootImage, image_t *image)
 		return status;
 	}
 
+	symbol_cache_record(image, &cache);
+
 	_kern_image_relocated(image->id);
 	image_event(image, IMAGE_EVENT_RELOCATED);
 	return B_OK;
@@ -213,7 +231,7 @@ relocate_image(image_t *rootImage, image_t *image)
 
 
 static status_t
-relocate_dependencies(image_t *image)
+relocate_dependencies(image_t *image, bool lazy)
 {
 	// get the images that still have to be relocated
 	image_t **list;
@@ -223,7 +241,7 @@ relocate_dependencies(image_t *image)
 
 	// relocate
 	for (ssize_t i = 0; i < count; i++) {
-		status_t status = relocate_image(image, list[i]);
+		status_t status = relocate_image(image, list[i], lazy);
 		if (status < B_OK) {
 			free(list);
 			return status;
@@ -337,7 +355,7 @@ preload_image(char const* path)
 
 	set_image_flags_recursively(image, RTLD_GLOBAL);
 
-	status = relocate_dependencies(image);
+	status = relocate_dependencies(image, false);
 	if (status < B_OK)
 		goto err;
 
@@ -438,7 +456,9 @@ load_program(char const *path, void **_entry)
 	// This results in the desired symbol resolution for dlopen()ed libraries.
 	set_image_flags_recursively(gProgramImage, RTLD_GLOBAL);
 
-	status = relocate_dependencies(gProgramImage);
+	symbol_cache_init(gProgramImage);
+	status = relocate_dependencies(gProgramImage, lazy_binding_enabled());
+	symbol_cache_finish(status == B_OK);
 	if (status < B_OK)
 		goto err;
 
@@ -557,7 +577,7 @@ load_library(char const *path, uint32 flags, bool addOn, void** _handle)
 	else
 		set_image_flags_recursively(image, RFLAG_USE_FOR_RESOLVING);
 
-	status = relocate_dependencies(image);
+	status = relocate_dependencies(image, false);
 	if (status < B_OK)
 		goto err;
 
@@ -1012,6 +1032,22 @@ elf_verify_header(void *header, size_t length)
 }
 
 
+/*!	Resolves a symbol referenced by a PLT entry of \a image that is used for
+	the first time. The image must have been relocated with
+	RFLAG_LAZY_BINDING, i.e. as part of load_program().
+*/
+status_t
+resolve_lazy_symbol(image_t* image, elf_sym* symbol, addr_t* _address)
+{
+	rld_lock();
+	status_t status = resolve_symbol(gProgramImage, image, symbol, NULL,
+		_address);
+	rld_unlock();
+
+	return status;
+}
+
+
 void
 terminate_program(void)
 {
@@ -328,11 +328,16 @@ parse_dynamic_segment(image_t* image)
 			case DT_SYMBOLIC:
 				image->flags |= RFLAG_SYMBOLIC;
 				break;
+			case DT_BIND_NOW:
+				image->flags |= RFLAG_BIND_NOW;
+				break;
 			case DT_FLAGS:
 			{
 				uint32 flags = d[i].d_un.d_val;
 				if ((flags & DF_SYMBOLIC) != 0)
 					image->flags |= RFLAG_SYMBOLIC;
+				if ((flags & DF_BIND_NOW) != 0)
+					image->flags |= RFLAG_BIND_NOW;
 				if ((flags & DF_STATIC_TLS) != 0) {
 					FATAL("Static TLS model is not supported.\n");
 					return false;
@@ -374,7 +379,6 @@ parse_dynamic_segment(image_t* image)
 			// DT_RELAENT: The size of a DT_RELA entry.
 			// DT_SYMENT: The size of a symbol table entry.
 			// DT_PLTREL: The type of the PLT relocation entries (DT_JMPREL).
-			// DT_BIND_NOW/DF_BIND_NOW: No lazy binding allowed.
 			// DT_RUNPATH: Library search path (supersedes DT_RPATH).
 			// DT_TEXTREL/DF_TEXTREL: Indicates whether text relocations are
 			//		required (for optimization purposes only).
@@ -0,0 +1,492 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A persistent cache of the symbol resolutions done while loading a
+	program.
+
+	When enabled via the LD_SYMBOL_CACHE environment variable, the symbols
+	resolved while relocating the program and its dependencies are written
+	to a file in the user's cache directory. On the next launch the file is
+	used to fill the SymbolLookupCache of each image before it is relocated,
+	so that most relocations don't need to look up their symbols anymore.
+
+	The file is only used if all loaded images are the same as when it was
+	written: it contains a hash over the paths and the dynamic linking
+	information (dynamic section, symbol, string, and version tables) of all
+	images in load order, which is all the symbol resolution depends on.
+	Symbol values are stored relative to the image defining them, so the
+	cache stays valid when the images are loaded at other addresses;
+	absolute (SHN_ABS) symbols are not stored at all.
+
+	The cache is not used when symbol patchers are installed, since their
+	results may change at any time.
+*/
+
+
+#include "elf_symbol_cache.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <FindDirectory.h>
+
+#include <find_directory_private.h>
+#include <syscalls.h>
+
+#include "elf_symbol_lookup.h"
+#include "images.h"
+
+
+// Must be changed whenever the format, or the symbol resolution changes.
+static const uint32 kSymbolCacheMagic = 'rlsc';
+static const uint32 kSymbolCacheVersion = 2;
+
+static const char* const kSymbolCacheDirectory = "runtime_loader";
+
+
+struct symbol_cache_header {
+	uint32	magic;
+	uint32	version;
+	uint64	graph_hash;
+	uint32	image_count;
+	uint32	entry_count;
+	// followed by image_count symbol_cache_image structures, and
+	// entry_count symbol_cache_entry structures
+};
+
+struct symbol_cache_image {
+	uint32	first_entry;
+	uint32	entry_count;
+};
+
+struct symbol_cache_entry {
+	uint32	symbol;
+	uint32	defining_image;
+	uint64	value;
+		// relative to the defining image, unless it's a TLS symbol
+};
+
+struct image_index {
+	image_t*	image;
+	uint32		index;
+};
+
+enum {
+	SYMBOL_CACHE_DISABLED,
+	SYMBOL_CACHE_LOADED,
+	SYMBOL_CACHE_RECORDING
+};
+
+
+static uint32 sState = SYMBOL_CACHE_DISABLED;
+static char sPath[B_PATH_NAME_LENGTH];
+static uint64 sGraphHash;
+
+static image_t** sImages;
+static image_index* sImageIndices;
+	// sorted by image address
+static uint32 sImageCount;
+
+static uint8* sBuffer;
+static symbol_cache_image* sCachedImages;
+static symbol_cache_entry* sCachedEntries;
+
+static symbol_cache_image* sRecordedImages;
+static symbol_cache_entry* sRecordedEntries;
+static uint32 sRecordedEntryCount;
+static uint32 sRecordedEntryCapacity;
+
+
+static inline uint64
+hash_bytes(uint64 hash, const void* _data, size_t size)
+{
+	// FNV-1a, on 64 bit words where possible
+	static const uint64 kPrime = 0x100000001b3ULL;
+
+	const uint8* data = (const uint8*)_data;
+	for (; size >= sizeof(uint64); size -= sizeof(uint64)) {
+		uint64 word;
+		memcpy(&word, data, sizeof(word));
+		hash = (hash ^ word) * kPrime;
+		data += sizeof(uint64);
+	}
+
+	while (size-- > 0)
+		hash = (hash ^ *data++) * kPrime;
+
+	return hash;
+}
+
+
+static uint64
+hash_image(uint64 hash, image_t* image)
+{
+	hash = hash_bytes(hash, image->path, strlen(image->path));
+
+	uint32 flags = image->flags & (RTLD_GLOBAL | RFLAG_SYMBOLIC);
+	hash = hash_bytes(hash, &flags, sizeof(flags));
+	hash = hash_bytes(hash, &image->type, sizeof(image->type));
+
+	if (image->dynamic_ptr == 0)
+		return hash;
+
+	// The dynamic section is not relocated in memory, so it's the same on
+	// every launch.
+	size_t stringTableSize = 0;
+	elf_dyn* dynamic = (elf_dyn*)image->dynamic_ptr;
+	uint32 count = 0;
+	for (; dynamic[count].d_tag != DT_NULL; count++) {
+		if (dynamic[count].d_tag == DT_STRSZ)
+			stringTableSize = dynamic[count].d_un.d_val;
+	}
+	hash = hash_bytes(hash, dynamic, count * sizeof(elf_dyn));
+
+	uint32 symbolCount = image->symhash[1];
+	hash = hash_bytes(hash, image->symhash,
+		(2 + HASHTABSIZE(image) + symbolCount) * sizeof(uint32));
+	hash = hash_bytes(hash, image->syms, symbolCount * sizeof(elf_sym));
+	hash = hash_bytes(hash, image->strtab, stringTableSize);
+	if (image->symbol_versions != NULL) {
+		hash = hash_bytes(hash, image->symbol_versions,
+			symbolCount * sizeof(elf_versym));
+	}
+
+	return hash;
+}
+
+
+static int32
+index_of_image(image_t* image)
+{
+	uint32 lower = 0;
+	uint32 upper = sImageCount;
+	while (lower < upper) {
+		uint32 middle = (lower + upper) / 2;
+		if (sImageIndices[middle].image == image)
+			return sImageIndices[middle].index;
+
+		if ((addr_t)sImageIndices[middle].image < (addr_t)image)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	return -1;
+}
+
+
+static bool
+load_cache_file()
+{
+	int fd = _kern_open(-1, sPath, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat stat;
+	symbol_cache_header header;
+	if (_kern_read_stat(fd, NULL, false, &stat, sizeof(struct stat)) != B_OK
+		|| _kern_read(fd, 0, &header, sizeof(header)) != sizeof(header)
+		|| header.magic != kSymbolCacheMagic
+		|| header.version != kSymbolCacheVersion
+		|| header.graph_hash != sGraphHash
+		|| header.image_count != sImageCount
+		|| (uint64)stat.st_size != sizeof(header)
+			+ (uint64)header.image_count * sizeof(symbol_cache_image)
+			+ (uint64)header.entry_count * sizeof(symbol_cache_entry)) {
+		_kern_close(fd);
+		return false;
+	}
+
+	sBuffer = (uint8*)malloc(stat.st_size);
+	if (sBuffer == NULL
+		|| _kern_read(fd, 0, sBuffer, stat.st_size) != stat.st_size) {
+		_kern_close(fd);
+		return false;
+	}
+
+	_kern_close(fd);
+
+	sCachedImages = (symbol_cache_image*)(sBuffer + sizeof(header));
+	sCachedEntries = (symbol_cache_entry*)(sCachedImages + sImageCount);
+
+	for (uint32 i = 0; i < sImageCount; i++) {
+		if (sCachedImages[i].first_entry > header.entry_count
+			|| sCachedImages[i].entry_count
+				> header.entry_count - sCachedImages[i].first_entry) {
+			return false;
+		}
+	}
+
+	for (uint32 i = 0; i < header.entry_count; i++) {
+		if (sCachedEntries[i].defining_image >= sImageCount)
+			return false;
+	}
+
+	return true;
+}
+
+
+static void
+write_cache_file()
+{
+	char tempPath[B_PATH_NAME_LENGTH];
+	if (snprintf(tempPath, sizeof(tempPath), "%s.%" B_PRId32, sPath,
+			find_thread(NULL)) >= (int)sizeof(tempPath)) {
+		return;
+	}
+
+	int fd = _kern_open(-1, tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return;
+
+	symbol_cache_header header;
+	header.magic = kSymbolCacheMagic;
+	header.version = kSymbolCacheVersion;
+	header.graph_hash = sGraphHash;
+	header.image_count = sImageCount;
+	header.entry_count = sRecordedEntryCount;
+
+	size_t imagesSize = sImageCount * sizeof(symbol_cache_image);
+	size_t entriesSize = sRecordedEntryCount * sizeof(symbol_cache_entry);
+
+	bool success = _kern_write(fd, 0, &header, sizeof(header))
+			== (ssize_t)sizeof(header)
+		&& _kern_write(fd, sizeof(header), sRecordedImages, imagesSize)
+			== (ssize_t)imagesSize
+		&& _kern_write(fd, sizeof(header) + imagesSize, sRecordedEntries,
+			entriesSize) == (ssize_t)entriesSize;
+
+	_kern_close(fd);
+
+	// rename the file in place, so that other teams never see partial files
+	if (!success || _kern_rename(-1, tempPath, -1, sPath) != B_OK)
+		_kern_unlink(-1, tempPath);
+}
+
+
+static bool
+init_cache_path(image_t* programImage)
+{
+	char directory[B_PATH_NAME_LENGTH];
+	if (__find_directory(B_USER_CACHE_DIRECTORY, -1, true, directory,
+			sizeof(directory)) != B_OK
+		|| strlcat(directory, "/", sizeof(directory)) >= sizeof(directory)
+		|| strlcat(directory, kSymbolCacheDirectory, sizeof(directory))
+			>= sizeof(directory)) {
+		return false;
+	}
+
+	status_t status = _kern_create_dir(-1, directory, 0755);
+	if (status != B_OK && status != B_FILE_EXISTS)
+		return false;
+
+	// one file per program
+	uint64 hash = hash_bytes(0xcbf29ce484222325ULL, programImage->path,
+		strlen(programImage->path));
+	return snprintf(sPath, sizeof(sPath), "%s/%016" B_PRIx64, directory,
+		hash) < (int)sizeof(sPath);
+}
+
+
+static void
+free_cache()
+{
+	free(sImages);
+	free(sImageIndices);
+	free(sBuffer);
+	free(sRecordedImages);
+	free(sRecordedEntries);
+
+	sImages = NULL;
+	sImageIndices = NULL;
+	sImageCount = 0;
+	sBuffer = NULL;
+	sCachedImages = NULL;
+	sCachedEntries = NULL;
+	sRecordedImages = NULL;
+	sRecordedEntries = NULL;
+	sRecordedEntryCount = 0;
+	sRecordedEntryCapacity = 0;
+
+	sState = SYMBOL_CACHE_DISABLED;
+}
+
+
+// #pragma mark -
+
+
+/*!	Must be called after the program and all of its dependencies have been
+	loaded, and before they are relocated. Either loads the program's cache
+	file, if it's still valid, or prepares recording a new one.
+*/
+void
+symbol_cache_init(image_t* programImage)
+{
+	if (getenv("LD_SYMBOL_CACHE") == NULL)
+		return;
+
+	uint32 count = count_loaded_images();
+	sImages = (image_t**)malloc(count * sizeof(image_t*));
+	sImageIndices = (image_index*)malloc(count * sizeof(image_index));
+	if (sImages == NULL || sImageIndices == NULL) {
+		free_cache();
+		return;
+	}
+
+	uint64 hash = 0xcbf29ce484222325ULL;
+	for (image_t* image = get_loaded_images().head; image != NULL;
+			image = image->next) {
+		if (sImageCount == count
+			|| image->defined_symbol_patchers != NULL
+			|| image->undefined_symbol_patchers != NULL) {
+			free_cache();
+			return;
+		}
+
+		hash = hash_image(hash, image);
+
+		// insert sorted by address
+		uint32 index = sImageCount++;
+		sImages[index] = image;
+
+		uint32 position = index;
+		while (position > 0
+			&& (addr_t)sImageIndices[position - 1].image > (addr_t)image) {
+			sImageIndices[position] = sImageIndices[position - 1];
+			position--;
+		}
+		sImageIndices[position].image = image;
+		sImageIndices[position].index = index;
+	}
+	sGraphHash = hash;
+
+	if (!init_cache_path(programImage)) {
+		free_cache();
+		return;
+	}
+
+	if (load_cache_file()) {
+		sState = SYMBOL_CACHE_LOADED;
+		return;
+	}
+
+	free(sBuffer);
+	sBuffer = NULL;
+	sCachedImages = NULL;
+	sCachedEntries = NULL;
+
+	sRecordedImages = (symbol_cache_image*)calloc(sImageCount,
+		sizeof(symbol_cache_image));
+	if (sRecordedImages == NULL) {
+		free_cache();
+		return;
+	}
+
+	sState = SYMBOL_CACHE_RECORDING;
+}
+
+
+/*!	Fills \a cache with the symbol values the cache file contains for
+	\a image.
+*/
+void
+symbol_cache_prefill(image_t* image, SymbolLookupCache* cache)
+{
+	if (sState != SYMBOL_CACHE_LOADED)
+		return;
+
+	int32 index = index_of_image(image);
+	if (index < 0)
+		return;
+
+	uint32 symbolCount = image->symhash[1];
+	const symbol_cache_image& cachedImage = sCachedImages[index];
+	for (uint32 i = 0; i < cachedImage.entry_count; i++) {
+		const symbol_cache_entry& entry
+			= sCachedEntries[cachedImage.first_entry + i];
+		if (entry.symbol >= symbolCount)
+			continue;
+
+		image_t* definingImage = sImages[entry.defining_image];
+		addr_t value = entry.value;
+		if (image->syms[entry.symbol].Type() != STT_TLS)
+			value += definingImage->regions[0].delta;
+
+		cache->SetSymbolValueAt(entry.symbol, value, definingImage);
+	}
+}
+
+
+/*!	Adds the symbols resolved while relocating \a image to the cache file to
+	be written.
+*/
+void
+symbol_cache_record(image_t* image, const SymbolLookupCache* cache)
+{
+	if (sState != SYMBOL_CACHE_RECORDING)
+		return;
+
+	int32 index = index_of_image(image);
+	if (index < 0)
+		return;
+
+	uint32 firstEntry = sRecordedEntryCount;
+
+	for (size_t i = 0; i < cache->TableSize(); i++) {
+		// Absolute symbols can't be stored relative to their image, they are
+		// just looked up again.
+		if (!cache->IsSymbolValueCached(i) || cache->IsSymbolValueAbsolute(i))
+			continue;
+
+		image_t* definingImage;
+		addr_t value = cache->SymbolValueAt(i, &definingImage);
+		int32 definingIndex = definingImage != NULL
+			? index_of_image(definingImage) : -1;
+		if (definingIndex < 0)
+			continue;
+
+		if (sRecordedEntryCount == sRecordedEntryCapacity) {
+			uint32 capacity = sRecordedEntryCapacity > 0
+				? sRecordedEntryCapacity * 2 : 1024;
+			symbol_cache_entry* entries = (symbol_cache_entry*)realloc(
+				sRecordedEntries, capacity * sizeof(symbol_cache_entry));
+			if (entries == NULL) {
+				free_cache();
+				return;
+			}
+
+			sRecordedEntries = entries;
+			sRecordedEntryCapacity = capacity;
+		}
+
+		symbol_cache_entry& entry = sRecordedEntries[sRecordedEntryCount++];
+		entry.symbol = i;
+		entry.defining_image = definingIndex;
+		entry.value = value;
+		if (image->syms[i].Type() != STT_TLS)
+			entry.value -= definingImage->regions[0].delta;
+	}
+
+	sRecordedImages[index].first_entry = firstEntry;
+	sRecordedImages[index].entry_count = sRecordedEntryCount - firstEntry;
+}
+
+
+/*!	Must be called when the program has been relocated. If \a success is
+	\c true, and a new cache file was recorded, it's written now.
+*/
+void
+symbol_cache_finish(bool success)
+{
+	if (success && sState == SYMBOL_CACHE_RECORDING)
+		write_cache_file();
+
+	free_cache();
+}
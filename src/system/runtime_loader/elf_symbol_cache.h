@@ -0,0 +1,17 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef ELF_SYMBOL_CACHE_H
+#define ELF_SYMBOL_CACHE_H
+
+#include "runtime_loader_private.h"
+
+
+void	symbol_cache_init(image_t* programImage);
+void	symbol_cache_prefill(image_t* image, SymbolLookupCache* cache);
+void	symbol_cache_record(image_t* image, const SymbolLookupCache* cache);
+void	symbol_cache_finish(bool success);
+
+
+#endif	// ELF_SYMBOL_CACHE_H
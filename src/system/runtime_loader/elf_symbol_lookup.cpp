@@ -489,7 +489,7 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 	uint32 index = sym - image->syms;
 
 	// check the cache first
-	if (cache->IsSymbolValueCached(index)) {
+	if (cache != NULL && cache->IsSymbolValueCached(index)) {
 		*symAddress = cache->SymbolValueAt(index, symbolImage);
 		return B_OK;
 	}
@@ -589,7 +589,10 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 		return B_MISSING_SYMBOL;
 	}
 
-	cache->SetSymbolValueAt(index, (addr_t)location, sharedImage);
+	if (cache != NULL) {
+		cache->SetSymbolValueAt(index, (addr_t)location, sharedImage,
+			sharedSym != NULL && sharedSym->st_shndx == SHN_ABS);
+	}
 
 	if (symbolImage)
 		*symbolImage = sharedImage;
@@ -61,21 +61,26 @@ struct SymbolLookupCache {
 		fTableSize(image->symhash != NULL ? image->symhash[1] : 0),
 		fValues(NULL),
 		fDSOs(NULL),
-		fValuesResolved(NULL)
+		fValuesResolved(NULL),
+		fValuesAbsolute(NULL)
 	{
 		if (fTableSize > 0) {
 			fValues = (addr_t*)malloc(sizeof(addr_t) * fTableSize);
 			fDSOs = (image_t**)malloc(sizeof(image_t*) * fTableSize);
 
+			// the resolved and the absolute bits share an allocation
 			size_t elementCount = (fTableSize + 31) / 32;
-			fValuesResolved = (uint32*)malloc(4 * elementCount);
-			memset(fValuesResolved, 0, 4 * elementCount);
+			fValuesResolved = (uint32*)malloc(2 * 4 * elementCount);
 
 			if (fValues == NULL || fDSOs == NULL || fValuesResolved == NULL) {
 				free(fValuesResolved);
 				free(fValues);
 				free(fDSOs);
+				fValuesResolved = NULL;
 				fTableSize = 0;
+			} else {
+				memset(fValuesResolved, 0, 2 * 4 * elementCount);
+				fValuesAbsolute = fValuesResolved + elementCount;
 			}
 		}
 	}
@@ -87,12 +92,22 @@ struct SymbolLookupCache {
 		free(fDSOs);
 	}
 
+	size_t TableSize() const
+	{
+		return fTableSize;
+	}
+
 	bool IsSymbolValueCached(size_t index) const
 	{
 		return index < fTableSize
 			&& (fValuesResolved[index / 32] & (1 << (index % 32))) != 0;
 	}
 
+	bool IsSymbolValueAbsolute(size_t index) const
+	{
+		return (fValuesAbsolute[index / 32] & (1 << (index % 32))) != 0;
+	}
+
 	addr_t SymbolValueAt(size_t index) const
 	{
 		return fValues[index];
@@ -105,12 +120,15 @@ struct SymbolLookupCache {
 		return fValues[index];
 	}
 
-	void SetSymbolValueAt(size_t index, addr_t value, image_t* image)
+	void SetSymbolValueAt(size_t index, addr_t value, image_t* image,
+		bool absolute = false)
 	{
 		if (index < fTableSize) {
 			fValues[index] = value;
 			fDSOs[index] = image;
 			fValuesResolved[index / 32] |= 1 << (index % 32);
+			if (absolute)
+				fValuesAbsolute[index / 32] |= 1 << (index % 32);
 		}
 	}
 
@@ -119,6 +137,8 @@ private:
 	addr_t*		fValues;
 	image_t**	fDSOs;
 	uint32*		fValuesResolved;
+	uint32*		fValuesAbsolute;
+		// defined by an SHN_ABS symbol
 };
 
 
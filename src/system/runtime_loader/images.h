@@ -28,8 +28,12 @@ enum {
 	RFLAG_REMAPPED				= 0x8000,
 
 	RFLAG_VISITED				= 0x10000,
-	RFLAG_USE_FOR_RESOLVING		= 0x20000
+	RFLAG_USE_FOR_RESOLVING		= 0x20000,
 		// temporarily set in the symbol resolution code
+	RFLAG_BIND_NOW				= 0x40000,
+		// the image doesn't allow lazy binding (DT_BIND_NOW)
+	RFLAG_LAZY_BINDING			= 0x80000
+		// the PLT relocations may be resolved on first use
 };
 
 
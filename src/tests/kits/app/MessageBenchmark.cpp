@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures adding, finding, flattening, and unflattening messages with
+	many fields, like settings messages or scripting replies, and with many
+	items in a single field.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Message.h>
+#include <OS.h>
+
+
+static const int32 kFieldCounts[] = { 5, 50, 500, 5000 };
+static const int32 kDefaultRuns = 20;
+
+
+static void
+print_result(const char* name, int32 count, int32 runs, bigtime_t time)
+{
+	printf("%-24s %5" B_PRId32 ": %10.2f us\n", name, count,
+		(double)time / runs);
+}
+
+
+static void
+fill_fields(BMessage& message, int32 count)
+{
+	char name[32];
+	for (int32 i = 0; i < count; i++) {
+		snprintf(name, sizeof(name), "field %" B_PRId32, i);
+		message.AddInt32(name, i);
+	}
+}
+
+
+static void
+benchmark_fields(int32 count, int32 runs)
+{
+	char name[32];
+	bigtime_t addTime = 0;
+	bigtime_t findTime = 0;
+	bigtime_t flattenTime = 0;
+	bigtime_t unflattenTime = 0;
+
+	for (int32 run = 0; run < runs; run++) {
+		BMessage message('test');
+
+		bigtime_t start = system_time();
+		fill_fields(message, count);
+		addTime += system_time() - start;
+
+		start = system_time();
+		for (int32 i = 0; i < count; i++) {
+			snprintf(name, sizeof(name), "field %" B_PRId32, count - i - 1);
+			int32 value;
+			if (message.FindInt32(name, &value) != B_OK) {
+				fprintf(stderr, "Field \"%s\" not found!\n", name);
+				exit(1);
+			}
+		}
+		findTime += system_time() - start;
+
+		ssize_t size = message.FlattenedSize();
+		char* buffer = (char*)malloc(size);
+
+		start = system_time();
+		message.Flatten(buffer, size);
+		flattenTime += system_time() - start;
+
+		BMessage copy;
+		start = system_time();
+		copy.Unflatten(buffer);
+		unflattenTime += system_time() - start;
+
+		free(buffer);
+
+		if (copy.CountNames(B_ANY_TYPE) != count) {
+			fprintf(stderr, "Unflattened message has %" B_PRId32 " fields "
+				"instead of %" B_PRId32 "!\n", copy.CountNames(B_ANY_TYPE),
+				count);
+			exit(1);
+		}
+	}
+
+	print_result("add fields", count, runs, addTime);
+	print_result("find fields", count, runs, findTime);
+	print_result("flatten fields", count, runs, flattenTime);
+	print_result("unflatten fields", count, runs, unflattenTime);
+}
+
+
+static void
+benchmark_items(int32 count, int32 runs)
+{
+	bigtime_t addTime = 0;
+	bigtime_t findTime = 0;
+
+	for (int32 run = 0; run < runs; run++) {
+		// Adding the items to the first of two fields moves the data of the
+		// second one each time.
+		BMessage message('test');
+		message.AddString("first", "item");
+		message.AddString("second", "item");
+
+		bigtime_t start = system_time();
+		for (int32 i = 0; i < count; i++)
+			message.AddString("first", "item");
+		addTime += system_time() - start;
+
+		start = system_time();
+		for (int32 i = 0; i < count; i++) {
+			const char* value;
+			message.FindString("first", i, &value);
+		}
+		findTime += system_time() - start;
+	}
+
+	print_result("add items", count, runs, addTime);
+	print_result("find items", count, runs, findTime);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 runs = kDefaultRuns;
+	if (argc > 1)
+		runs = atoi(argv[1]);
+	if (runs <= 0) {
+		fprintf(stderr, "Usage: %s [<runs>]\n", argv[0]);
+		return 1;
+	}
+
+	const int32 countCount = sizeof(kFieldCounts) / sizeof(kFieldCounts[0]);
+	for (int32 i = 0; i < countCount; i++)
+		benchmark_fields(kFieldCounts[i], runs);
+	for (int32 i = 0; i < countCount; i++)
+		benchmark_items(kFieldCounts[i], runs);
+
+	return 0;
+}
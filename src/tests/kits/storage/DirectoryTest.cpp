@@ -1276,6 +1276,41 @@ DirectoryTest::EntryIterationTest()
 	CPPUNIT_ASSERT( dir.GetNextRef(&ref) == B_OK );
 	CPPUNIT_ASSERT( dir.CountEntries() == 9 );
 	dir.Unset();
+#if !TEST_R5
+	// GetNextDirentsPlus
+	NextSubTest();
+	{
+		size_t plusBufSize = 4096;
+		char plusBuffer[plusBufSize];
+		dirent_plus *plusEnts = (dirent_plus *)plusBuffer;
+		CPPUNIT_ASSERT( dir.SetTo(testDir1) == B_OK );
+		int32 count;
+		while ((count = dir.GetNextDirentsPlus(plusEnts, plusBufSize)) > 0) {
+			dirent_plus *plusEnt = plusEnts;
+			for (int32 i = 0; i < count; i++) {
+				const char *name = plusEnt->dp_dirent.d_name;
+				CPPUNIT_ASSERT( testSet.test(name) == true );
+				struct stat st;
+				CPPUNIT_ASSERT( lstat((dirPathName + name).c_str(), &st)
+								== 0 );
+				CPPUNIT_ASSERT( plusEnt->dp_stat_status == B_OK );
+				CPPUNIT_ASSERT( plusEnt->dp_stat.st_ino == st.st_ino );
+				CPPUNIT_ASSERT( plusEnt->dp_stat.st_mode == st.st_mode );
+				CPPUNIT_ASSERT( plusEnt->dp_stat.st_size == st.st_size );
+				plusEnt = (dirent_plus *)((char *)plusEnt
+										  + plusEnt->dp_reclen);
+			}
+		}
+		CPPUNIT_ASSERT( count == 0 );
+		CPPUNIT_ASSERT( testSet.testDone() == true );
+		// too small a buffer
+		CPPUNIT_ASSERT( dir.Rewind() == B_OK );
+		CPPUNIT_ASSERT( dir.GetNextDirentsPlus(plusEnts, sizeof(dirent_plus))
+						== B_BUFFER_OVERFLOW );
+		dir.Unset();
+		testSet.rewind();
+	}
+#endif
 
 	// 3. interleaving use of the different methods
 	NextSubTest();
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how block_cache_get()/block_cache_put() of already cached blocks
+	scale with the number of threads accessing the same cache.
+*/
+
+
+#define read_pos	block_cache_read_pos
+#define readv_pos	block_cache_readv_pos
+
+#include "block_cache.cpp"
+
+#undef read_pos
+#undef readv_pos
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static const size_t kBlockSize = 2048;
+static const off_t kNumBlocks = 4096;
+static const bigtime_t kRunTime = 1000000;
+
+static void* sCache;
+static off_t sWorkingSet;
+static volatile bool sStart;
+static volatile bool sStop;
+
+
+ssize_t
+block_cache_read_pos(int fd, off_t offset, void* buffer, size_t size)
+{
+	memset(buffer, offset / kBlockSize, size);
+	return size;
+}
+
+
+ssize_t
+block_cache_readv_pos(int fd, off_t offset, const iovec* vecs, size_t count)
+{
+	ssize_t bytesRead = 0;
+	for (size_t i = 0; i < count; i++) {
+		bytesRead += block_cache_read_pos(fd, offset + bytesRead,
+			vecs[i].iov_base, vecs[i].iov_len);
+	}
+
+	return bytesRead;
+}
+
+
+static status_t
+reader_thread(void* _count)
+{
+	uint64* count = (uint64*)_count;
+	uint32 seed = find_thread(NULL);
+
+	while (!sStart)
+		snooze(100);
+
+	while (!sStop) {
+		for (int32 i = 0; i < 1000; i++) {
+			seed = seed * 1103515245 + 12345;
+			off_t blockNumber = (seed >> 8) % sWorkingSet;
+
+			const uint8* block = (const uint8*)block_cache_get(sCache,
+				blockNumber);
+			if (block == NULL || block[0] != (uint8)blockNumber) {
+				fprintf(stderr, "block %" B_PRIdOFF " has wrong contents!\n",
+					blockNumber);
+				exit(1);
+			}
+			block_cache_put(sCache, blockNumber);
+		}
+		*count += 1000;
+	}
+
+	return B_OK;
+}
+
+
+static uint64
+run_test(int32 threadCount)
+{
+	thread_id threads[threadCount];
+	uint64 counts[threadCount];
+
+	sStart = false;
+	sStop = false;
+
+	for (int32 i = 0; i < threadCount; i++) {
+		counts[i] = 0;
+		threads[i] = spawn_thread(&reader_thread, "block cache reader",
+			B_NORMAL_PRIORITY, &counts[i]);
+		resume_thread(threads[i]);
+	}
+
+	sStart = true;
+	snooze(kRunTime);
+	sStop = true;
+
+	uint64 total = 0;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t status;
+		wait_for_thread(threads[i], &status);
+		total += counts[i];
+	}
+
+	return total;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 maxThreads = 0;
+	if (argc > 1)
+		maxThreads = strtol(argv[1], NULL, 0);
+	if (maxThreads <= 0) {
+		system_info info;
+		get_system_info(&info);
+		maxThreads = info.cpu_count * 2;
+	}
+
+	sWorkingSet = argc > 2 ? strtoll(argv[2], NULL, 0) : 1024;
+	if (sWorkingSet <= 0 || sWorkingSet > kNumBlocks)
+		sWorkingSet = kNumBlocks;
+
+	block_cache_init();
+
+	sCache = block_cache_create(-1, kNumBlocks, kBlockSize, true);
+	if (sCache == NULL) {
+		fprintf(stderr, "Could not create block cache\n");
+		return 1;
+	}
+
+	// populate the cache
+	for (off_t i = 0; i < sWorkingSet; i++) {
+		block_cache_get(sCache, i);
+		block_cache_put(sCache, i);
+	}
+
+	printf("%" B_PRIdOFF " blocks, %zu bytes each\n", sWorkingSet, kBlockSize);
+	printf("threads  gets/s        speedup\n");
+
+	uint64 single = 0;
+	for (int32 threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		uint64 count = run_test(threadCount) * 1000000 / kRunTime;
+		if (threadCount == 1)
+			single = count;
+
+		printf("%7" B_PRId32 "  %12" B_PRIu64 "  %6.2f\n", threadCount, count,
+			single != 0 ? (double)count / single : 0.0);
+	}
+
+	block_cache_delete(sCache, false);
+	return 0;
+}
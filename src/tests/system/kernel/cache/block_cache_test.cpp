@@ -6,11 +6,15 @@
 
 #define write_pos	block_cache_write_pos
 #define read_pos	block_cache_read_pos
+#define writev_pos	block_cache_writev_pos
+#define readv_pos	block_cache_readv_pos
 
 #include "block_cache.cpp"
 
 #undef write_pos
 #undef read_pos
+#undef writev_pos
+#undef readv_pos
 
 
 #define MAX_BLOCKS					100
@@ -62,6 +66,10 @@ size_t gBlockSize;
 int32 gTest;
 int32 gSubTest;
 const char* gTestName;
+int32 gReadCalls;
+int32 gBlocksRead;
+int32 gWriteCalls;
+int32 gBlocksWritten;
 
 
 void
@@ -120,33 +128,79 @@ reset_block(void* block, int32 index)
 }
 
 
-ssize_t
-block_cache_write_pos(int fd, off_t offset, const void* buffer, size_t size)
+void
+write_block(off_t offset)
 {
 	int32 index = offset / gBlockSize;
 
 	gBlocks[index].written = true;
+	gBlocksWritten++;
 	if (!gBlocks[index].write)
 		error(__LINE__, "Block %ld should not be written!\n", index);
-
-	return size;
 }
 
 
-ssize_t
-block_cache_read_pos(int fd, off_t offset, void* buffer, size_t size)
+void
+read_block(off_t offset, void* buffer, size_t size)
 {
 	int32 index = offset / gBlockSize;
 
 	memset(buffer, 0xcc, size);
 	reset_block(buffer, index);
+	gBlocksRead++;
 	if (!gBlocks[index].read)
 		error(__LINE__, "Block %ld should not be read!\n", index);
+}
+
+
+ssize_t
+block_cache_write_pos(int fd, off_t offset, const void* buffer, size_t size)
+{
+	gWriteCalls++;
+	write_block(offset);
+	return size;
+}
+
 
+ssize_t
+block_cache_read_pos(int fd, off_t offset, void* buffer, size_t size)
+{
+	gReadCalls++;
+	read_block(offset, buffer, size);
 	return size;
 }
 
 
+ssize_t
+block_cache_writev_pos(int fd, off_t offset, const iovec* vecs, size_t count)
+{
+	gWriteCalls++;
+
+	ssize_t written = 0;
+	for (size_t i = 0; i < count; i++) {
+		write_block(offset + written);
+		written += vecs[i].iov_len;
+	}
+
+	return written;
+}
+
+
+ssize_t
+block_cache_readv_pos(int fd, off_t offset, const iovec* vecs, size_t count)
+{
+	gReadCalls++;
+
+	ssize_t bytesRead = 0;
+	for (size_t i = 0; i < count; i++) {
+		read_block(offset + bytesRead, vecs[i].iov_base, vecs[i].iov_len);
+		bytesRead += vecs[i].iov_len;
+	}
+
+	return bytesRead;
+}
+
+
 void
 init_test_blocks()
 {
@@ -189,7 +243,7 @@ test_blocks(off_t number, int32 count, int32 line)
 	for (int32 i = 0; i < count; i++, number++) {
 		MutexLocker locker(&gCache->lock);
 
-		cached_block* block = (cached_block*)hash_lookup(gCache->hash, &number);
+		cached_block* block = gCache->LookupBlock(number);
 		if (block == NULL) {
 			if (gBlocks[number].present)
 				error(line, "Block %Ld not found!", number);
@@ -235,7 +289,7 @@ stop_test(void)
 
 
 void
-start_test(const char* name, bool init = true)
+start_test(const char* name, bool init = true, bool clustered = false)
 {
 	if (init) {
 		stop_test();
@@ -243,8 +297,16 @@ start_test(const char* name, bool init = true)
 		gBlockSize = 2048;
 		gCache = (block_cache*)block_cache_create(-1, MAX_BLOCKS, gBlockSize,
 			false);
+		if (!clustered) {
+			gCache->max_cluster_blocks = 1;
+				// the tests expect exactly the requested blocks to be read
+		}
 
 		init_test_blocks();
+		gReadCalls = 0;
+		gBlocksRead = 0;
+		gWriteCalls = 0;
+		gBlocksWritten = 0;
 	}
 
 	gTest++;
@@ -321,6 +383,29 @@ basic_test_discard_in_sub(int32 id, bool touchedInMain)
 }
 
 
+/*!	Marks the \a count blocks starting at \a number to be read into the
+	cache.
+*/
+void
+expect_read(off_t number, int32 count)
+{
+	for (int32 i = 0; i < count; i++, number++) {
+		gBlocks[number].present = true;
+		gBlocks[number].read = true;
+	}
+}
+
+
+void
+get_block(off_t number)
+{
+	const void* block = block_cache_get(gCache, number);
+	if (block == NULL)
+		error(__LINE__, "Could not get block %Ld!", number);
+	block_cache_put(gCache, number);
+}
+
+
 // #pragma mark - Tests
 
 
@@ -628,6 +713,138 @@ test_block_cache_discard()
 }
 
 
+void
+test_read_ahead()
+{
+	start_test("Sequential read-ahead", true, true);
+
+	// The first miss only reads the requested block
+	expect_read(0, 1);
+	get_block(0);
+	TEST_ASSERT(gReadCalls == 1 && gBlocksRead == 1);
+
+	// The second sequential miss starts reading ahead with the minimum window
+	expect_read(1, 1 + kMinReadAheadBlocks);
+	get_block(1);
+	TEST_ASSERT(gReadCalls == 2);
+	TEST_ASSERT(gBlocksRead == 2 + (int32)kMinReadAheadBlocks);
+	TEST_BLOCKS(0, 10);
+
+	// The blocks read ahead are served from the cache
+	for (off_t i = 2; i < 2 + (off_t)kMinReadAheadBlocks; i++)
+		get_block(i);
+	TEST_ASSERT(gReadCalls == 2);
+
+	// The next miss doubles the window
+	off_t next = 2 + kMinReadAheadBlocks;
+	expect_read(next, 1 + 2 * kMinReadAheadBlocks);
+	get_block(next);
+	TEST_ASSERT(gReadCalls == 3);
+	TEST_ASSERT(gBlocksRead == 3 + 3 * (int32)kMinReadAheadBlocks);
+	TEST_BLOCKS(0, 20);
+
+	start_test("Random access", true, true);
+
+	// Misses that are not sequential never read ahead
+	expect_read(50, 1);
+	get_block(50);
+	expect_read(20, 1);
+	get_block(20);
+	expect_read(40, 1);
+	get_block(40);
+	expect_read(30, 1);
+	get_block(30);
+	TEST_ASSERT(gReadCalls == 4 && gBlocksRead == 4);
+
+	// Neither does a sequential miss that follows random ones
+	expect_read(31, 1);
+	get_block(31);
+	TEST_ASSERT(gReadCalls == 5 && gBlocksRead == 5);
+
+	start_test("Read-ahead stops at cached blocks", true, true);
+
+	expect_read(3, 1);
+	get_block(3);
+	expect_read(0, 2);
+	get_block(0);
+	get_block(1);
+	TEST_ASSERT(gReadCalls == 3 && gBlocksRead == 3);
+
+	// Block 2 is sequential, but block 3 is already cached
+	expect_read(2, 1);
+	get_block(2);
+	TEST_ASSERT(gReadCalls == 4 && gBlocksRead == 4);
+
+	stop_test();
+}
+
+
+void
+test_clustered_write_back()
+{
+	start_test("Clustered write-back", true, true);
+
+	int32 id = cache_start_transaction(gCache);
+
+	// Blocks 10 - 13 are adjacent on disk, block 20 is not
+	static const off_t kBlocks[] = { 13, 20, 11, 10, 12 };
+	const int32 blockCount = sizeof(kBlocks) / sizeof(kBlocks[0]);
+	for (int32 i = 0; i < blockCount; i++) {
+		off_t number = kBlocks[i];
+		gBlocks[number].present = true;
+		gBlocks[number].is_dirty = true;
+
+		void* block = block_cache_get_empty(gCache, number, id);
+		reset_block(block, number);
+		block_cache_put(gCache, number);
+	}
+
+	cache_end_transaction(gCache, id, NULL, NULL);
+	TEST_BLOCKS(0, 25);
+	TEST_ASSERT(gWriteCalls == 0);
+
+	for (int32 i = 0; i < blockCount; i++) {
+		gBlocks[kBlocks[i]].is_dirty = false;
+		gBlocks[kBlocks[i]].write = true;
+	}
+
+	cache_sync_transaction(gCache, id);
+	TEST_BLOCKS(0, 25);
+
+	// One vectored write for blocks 10 - 13, and one for block 20
+	TEST_ASSERT(gWriteCalls == 2 && gBlocksWritten == 5);
+	TEST_ASSERT(gReadCalls == 0);
+
+	start_test("Clustered write-back size limit", true, true);
+
+	id = cache_start_transaction(gCache);
+
+	// More adjacent blocks than fit into a single write
+	int32 count = gCache->max_cluster_blocks + 2;
+	for (int32 number = 0; number < count; number++) {
+		gBlocks[number].present = true;
+		gBlocks[number].is_dirty = true;
+
+		void* block = block_cache_get_empty(gCache, number, id);
+		reset_block(block, number);
+		block_cache_put(gCache, number);
+	}
+
+	cache_end_transaction(gCache, id, NULL, NULL);
+
+	for (int32 number = 0; number < count; number++) {
+		gBlocks[number].is_dirty = false;
+		gBlocks[number].write = true;
+	}
+
+	cache_sync_transaction(gCache, id);
+	TEST_BLOCKS(0, MAX_BLOCKS);
+	TEST_ASSERT(gWriteCalls == 2 && gBlocksWritten == count);
+
+	stop_test();
+}
+
+
 // #pragma mark -
 
 
@@ -641,5 +858,7 @@ main(int argc, char** argv)
 	test_abort_transaction();
 	test_abort_sub_transaction();
 	test_block_cache_discard();
+	test_read_ahead();
+	test_clustered_write_back();
 	return 0;
 }
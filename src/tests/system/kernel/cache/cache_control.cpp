@@ -11,6 +11,7 @@
 #include <file_cache.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -20,7 +21,8 @@ extern const char *__progname;
 void
 usage()
 {
-	fprintf(stderr, "usage: %s [clear | unset | set <module-name>]\n", __progname);
+	fprintf(stderr, "usage: %s [clear | unset | set <module-name> | stats "
+		"| read-ahead <max-bytes>]\n", __progname);
 	exit(0);
 }
 
@@ -50,6 +52,27 @@ main(int argc, char **argv)
 		status = _kern_generic_syscall(CACHE_SYSCALLS, CACHE_SET_MODULE, argv[2], strlen(argv[2]));
 		if (status != B_OK)
 			fprintf(stderr, "%s: setting the module failed: %s\n", __progname, strerror(status));
+	} else if (!strcmp(argv[1], "stats")) {
+		file_cache_read_ahead_stats stats;
+		status = _kern_generic_syscall(CACHE_SYSCALLS, CACHE_GET_READ_AHEAD_STATS, &stats, sizeof(stats));
+		if (status != B_OK) {
+			fprintf(stderr, "%s: getting the statistics failed: %s\n", __progname, strerror(status));
+			return 1;
+		}
+
+		printf("read pages:       %" B_PRIu64 "\n", stats.read_pages);
+		printf("hit pages:        %" B_PRIu64 " (%.1f%%)\n", stats.hit_pages,
+			stats.read_pages != 0 ? 100.0 * stats.hit_pages / stats.read_pages : 0.0);
+		printf("read-ahead pages: %" B_PRIu64 "\n", stats.read_ahead_pages);
+		printf("sequential reads: %" B_PRIu64 "\n", stats.sequential_reads);
+		printf("strided reads:    %" B_PRIu64 "\n", stats.strided_reads);
+		printf("random reads:     %" B_PRIu64 "\n", stats.random_reads);
+		printf("max. window:      %" B_PRIu32 " bytes\n", stats.max_window);
+	} else if (!strcmp(argv[1], "read-ahead") && argc > 2) {
+		uint32 window = strtoul(argv[2], NULL, 0);
+		status = _kern_generic_syscall(CACHE_SYSCALLS, CACHE_SET_READ_AHEAD_LIMIT, &window, sizeof(window));
+		if (status != B_OK)
+			fprintf(stderr, "%s: setting the read-ahead limit failed: %s\n", __progname, strerror(status));
 	} else
 		usage();
 
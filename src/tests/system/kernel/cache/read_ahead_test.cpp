@@ -0,0 +1,129 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Reads a file with a given access pattern, and reports the throughput as
+	well as the file cache hit rate achieved by the read-ahead.
+	For meaningful numbers, the file should not be in the file cache already.
+*/
+
+
+#include <OS.h>
+#include <syscalls.h>
+#include <generic_syscall.h>
+
+#include <file_cache.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+extern const char *__progname;
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: %s <file> [sequential | stride <bytes> | random] "
+		"[read-size]\n", __progname);
+	exit(1);
+}
+
+
+static status_t
+get_stats(file_cache_read_ahead_stats& stats)
+{
+	return _kern_generic_syscall(CACHE_SYSCALLS, CACHE_GET_READ_AHEAD_STATS,
+		&stats, sizeof(stats));
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc < 2)
+		usage();
+
+	const char* mode = argc > 2 ? argv[2] : "sequential";
+	off_t stride = 0;
+	int sizeArgument = 3;
+
+	if (!strcmp(mode, "stride")) {
+		if (argc < 4)
+			usage();
+		stride = strtoll(argv[3], NULL, 0);
+		sizeArgument = 4;
+	} else if (strcmp(mode, "sequential") && strcmp(mode, "random"))
+		usage();
+
+	size_t readSize = argc > sizeArgument
+		? strtoul(argv[sizeArgument], NULL, 0) : 4096;
+	if (readSize == 0)
+		usage();
+	if (stride == 0)
+		stride = readSize;
+
+	int fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: could not open %s: %s\n", __progname, argv[1],
+			strerror(errno));
+		return 1;
+	}
+
+	off_t fileSize = lseek(fd, 0, SEEK_END);
+	char* buffer = (char*)malloc(readSize);
+	if (buffer == NULL)
+		return 1;
+
+	file_cache_read_ahead_stats before;
+	if (get_stats(before) != B_OK) {
+		fprintf(stderr, "%s: The cache syscalls are not available on this "
+			"system.\n", __progname);
+		return 1;
+	}
+
+	bool random = !strcmp(mode, "random");
+	off_t count = fileSize / stride;
+	off_t bytesRead = 0;
+	srand(fileSize);
+
+	bigtime_t start = system_time();
+
+	for (off_t i = 0; i < count; i++) {
+		off_t offset = random ? (off_t)(rand() % count) * stride : i * stride;
+		ssize_t bytes = pread(fd, buffer, readSize, offset);
+		if (bytes < 0) {
+			fprintf(stderr, "%s: read failed: %s\n", __progname,
+				strerror(errno));
+			return 1;
+		}
+		bytesRead += bytes;
+	}
+
+	bigtime_t time = system_time() - start;
+
+	file_cache_read_ahead_stats after;
+	get_stats(after);
+	close(fd);
+
+	uint64 readPages = after.read_pages - before.read_pages;
+	uint64 hitPages = after.hit_pages - before.hit_pages;
+
+	printf("%s, %" B_PRIdOFF " reads of %zu bytes: %" B_PRIdOFF " bytes in "
+		"%g s, %g MB/s\n", mode, count, readSize, bytesRead, time / 1000000.0,
+		time != 0 ? bytesRead / (double)time : 0.0);
+	printf("hit rate: %.1f%% (%" B_PRIu64 " of %" B_PRIu64 " pages), "
+		"%" B_PRIu64 " pages read ahead, window limit %" B_PRIu32 " bytes\n",
+		readPages != 0 ? 100.0 * hitPages / readPages : 0.0, hitPages,
+		readPages, after.read_ahead_pages - before.read_ahead_pages,
+		after.max_window);
+
+	free(buffer);
+	return 0;
+}
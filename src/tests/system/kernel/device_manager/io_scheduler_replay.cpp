@@ -0,0 +1,431 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Replays a mixed workload -- several streams of large sequential writes
+	next to small synchronous random reads -- against each I/O scheduler on a
+	simulated disk, and compares the resulting request latencies.
+
+	The disk charges a seek penalty that grows with the head movement plus a
+	fixed transfer rate, and serves one operation at a time.
+
+	Usage: cat /dev/misc/io_scheduler_replay
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <Drivers.h>
+#include <KernelExport.h>
+
+#include <kernel.h>
+
+#include "IORequest.h"
+#include "IOSchedulerDeadline.h"
+#include "IOSchedulerSimple.h"
+
+
+int32 api_version = B_CUR_DRIVER_API_VERSION;
+
+static const char* sDeviceNames[] = {
+	"misc/io_scheduler_replay",
+	NULL
+};
+
+static const off_t kDiskSize = 1024LL * 1024 * 1024;
+static const off_t kWriterRegionSize = 64 * 1024 * 1024;
+static const bigtime_t kMinSeekTime = 500;
+static const bigtime_t kMaxSeekTime = 8000;
+static const off_t kBytesPerMicrosecond = 100;
+	// 100 MB/s
+
+static const int32 kWriterCount = 4;
+static const int32 kWritesPerWriter = 64;
+static const size_t kWriteSize = 256 * 1024;
+static const int32 kReadCount = 256;
+static const size_t kReadSize = 4096;
+static const bigtime_t kReadThinkTime = 2000;
+
+static const size_t kReportSize = 4096;
+
+
+struct simulated_disk {
+	IOScheduler*	scheduler;
+	off_t			head;
+};
+
+struct replay_stream {
+	IOScheduler*	scheduler;
+	off_t*			offsets;
+	int32			count;
+	size_t			length;
+	bool			write;
+	bigtime_t		think_time;
+	bigtime_t*		latencies;
+	uint8*			buffer;
+};
+
+struct replay_result {
+	bigtime_t		read_average;
+	bigtime_t		read_p99;
+	bigtime_t		read_max;
+	bigtime_t		write_average;
+	bigtime_t		write_max;
+	bigtime_t		total_time;
+};
+
+
+static off_t sReadOffsets[kReadCount];
+static off_t sWriteOffsets[kWriterCount][kWritesPerWriter];
+
+
+/*!	Generates the trace to replay. It uses a fixed seed, so that all
+	schedulers see the very same requests.
+*/
+static void
+generate_trace()
+{
+	uint32 seed = 0x10ad;
+	for (int32 i = 0; i < kReadCount; i++) {
+		seed = seed * 1103515245 + 12345;
+		off_t block = (seed >> 8) % (kDiskSize / kReadSize);
+		sReadOffsets[i] = block * kReadSize;
+	}
+
+	for (int32 writer = 0; writer < kWriterCount; writer++) {
+		off_t base = kDiskSize / kWriterCount * writer;
+		for (int32 i = 0; i < kWritesPerWriter; i++) {
+			sWriteOffsets[writer][i]
+				= base + (i * kWriteSize) % kWriterRegionSize;
+		}
+	}
+}
+
+
+static status_t
+do_io(void* data, IOOperation* operation)
+{
+	simulated_disk* disk = (simulated_disk*)data;
+
+	off_t distance = operation->Offset() - disk->head;
+	if (distance < 0)
+		distance = -distance;
+
+	bigtime_t serviceTime = operation->Length() / kBytesPerMicrosecond;
+	if (distance != 0) {
+		serviceTime += kMinSeekTime
+			+ (kMaxSeekTime - kMinSeekTime) * distance / kDiskSize;
+	}
+
+	snooze(serviceTime);
+	disk->head = operation->Offset() + operation->Length();
+
+	disk->scheduler->OperationCompleted(operation, B_OK,
+		operation->Length());
+	return B_OK;
+}
+
+
+static status_t
+replay_stream_thread(void* _stream)
+{
+	replay_stream* stream = (replay_stream*)_stream;
+
+	for (int32 i = 0; i < stream->count; i++) {
+		IORequest request;
+		status_t status = request.Init(stream->offsets[i],
+			(addr_t)stream->buffer, stream->length, stream->write, 0);
+		if (status != B_OK)
+			return status;
+
+		bigtime_t start = system_time();
+		status = stream->scheduler->ScheduleRequest(&request);
+		if (status == B_OK)
+			status = request.Wait(0, 0);
+		if (status != B_OK)
+			return status;
+
+		stream->latencies[i] = system_time() - start;
+
+		if (stream->think_time > 0)
+			snooze(stream->think_time);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+replay(IOScheduler* scheduler, replay_result& result)
+{
+	simulated_disk disk;
+	disk.scheduler = scheduler;
+	disk.head = 0;
+
+	scheduler->SetCallback(&do_io, &disk);
+
+	replay_stream streams[kWriterCount + 1];
+	bigtime_t readLatencies[kReadCount];
+	bigtime_t writeLatencies[kWriterCount][kWritesPerWriter];
+	thread_id threads[kWriterCount + 1];
+	status_t status = B_OK;
+
+	uint8* writeBuffer = (uint8*)malloc(kWriteSize);
+	uint8* readBuffer = (uint8*)malloc(kReadSize);
+	if (writeBuffer == NULL || readBuffer == NULL) {
+		free(writeBuffer);
+		free(readBuffer);
+		return B_NO_MEMORY;
+	}
+	memset(writeBuffer, 0, kWriteSize);
+
+	for (int32 i = 0; i <= kWriterCount; i++) {
+		replay_stream& stream = streams[i];
+		stream.scheduler = scheduler;
+		stream.write = i < kWriterCount;
+		if (stream.write) {
+			stream.offsets = sWriteOffsets[i];
+			stream.count = kWritesPerWriter;
+			stream.length = kWriteSize;
+			stream.think_time = 0;
+			stream.latencies = writeLatencies[i];
+			stream.buffer = writeBuffer;
+				// the data written does not matter
+		} else {
+			stream.offsets = sReadOffsets;
+			stream.count = kReadCount;
+			stream.length = kReadSize;
+			stream.think_time = kReadThinkTime;
+			stream.latencies = readLatencies;
+			stream.buffer = readBuffer;
+		}
+	}
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i <= kWriterCount; i++) {
+		threads[i] = spawn_kernel_thread(&replay_stream_thread,
+			i < kWriterCount ? "replay writer" : "replay reader",
+			B_NORMAL_PRIORITY, &streams[i]);
+		if (threads[i] < 0)
+			status = threads[i];
+		else
+			resume_thread(threads[i]);
+	}
+
+	for (int32 i = 0; i <= kWriterCount; i++) {
+		if (threads[i] < 0)
+			continue;
+
+		status_t threadStatus;
+		wait_for_thread(threads[i], &threadStatus);
+		if (threadStatus != B_OK)
+			status = threadStatus;
+	}
+
+	result.total_time = system_time() - start;
+
+	free(writeBuffer);
+	free(readBuffer);
+
+	if (status != B_OK)
+		return status;
+
+	std::sort(readLatencies, readLatencies + kReadCount);
+	bigtime_t sum = 0;
+	for (int32 i = 0; i < kReadCount; i++)
+		sum += readLatencies[i];
+	result.read_average = sum / kReadCount;
+	result.read_p99 = readLatencies[kReadCount * 99 / 100];
+	result.read_max = readLatencies[kReadCount - 1];
+
+	sum = 0;
+	result.write_max = 0;
+	for (int32 writer = 0; writer < kWriterCount; writer++) {
+		for (int32 i = 0; i < kWritesPerWriter; i++) {
+			sum += writeLatencies[writer][i];
+			result.write_max = std::max(result.write_max,
+				writeLatencies[writer][i]);
+		}
+	}
+	result.write_average = sum / (kWriterCount * kWritesPerWriter);
+
+	return B_OK;
+}
+
+
+static status_t
+run_replay(const char* name, IOScheduler* scheduler, char* report,
+	size_t& length)
+{
+	if (scheduler == NULL)
+		return B_NO_MEMORY;
+
+	replay_result result;
+	status_t status = scheduler->Init(name);
+	if (status == B_OK)
+		status = replay(scheduler, result);
+
+	delete scheduler;
+
+	if (status != B_OK) {
+		length += snprintf(report + length, kReportSize - length,
+			"%-10s failed: %s\n", name, strerror(status));
+		return status;
+	}
+
+	length += snprintf(report + length, kReportSize - length,
+		"%-10s %9" B_PRIdBIGTIME " %9" B_PRIdBIGTIME " %9" B_PRIdBIGTIME
+		" %11" B_PRIdBIGTIME " %9" B_PRIdBIGTIME " %9" B_PRIdBIGTIME "\n",
+		name, result.read_average, result.read_p99, result.read_max,
+		result.write_average, result.write_max, result.total_time / 1000);
+	return B_OK;
+}
+
+
+static char*
+run_replays()
+{
+	char* report = (char*)malloc(kReportSize);
+	if (report == NULL)
+		return NULL;
+
+	generate_trace();
+
+	size_t length = snprintf(report, kReportSize,
+		"%" B_PRId32 " writers x %" B_PRId32 " x %zu KB sequential writes, "
+		"%" B_PRId32 " x %zu KB random reads\n\n"
+		"scheduler  read avg   read p99  read max   write avg "
+		"write max  total ms\n",
+		kWriterCount, kWritesPerWriter, kWriteSize / 1024, kReadCount,
+		kReadSize / 1024);
+
+	run_replay("simple", new(std::nothrow) IOSchedulerSimple(NULL), report,
+		length);
+	run_replay("deadline", new(std::nothrow) IOSchedulerDeadline(NULL),
+		report, length);
+
+	length += snprintf(report + length, kReportSize - length,
+		"\n(latencies in microseconds)\n");
+	return report;
+}
+
+
+// #pragma mark - device hooks
+
+
+static status_t
+device_open(const char* name, uint32 openMode, void** _cookie)
+{
+	// The cookie holds the report, which is created on the first read.
+	char** report = (char**)calloc(1, sizeof(char*));
+	if (report == NULL)
+		return B_NO_MEMORY;
+
+	*_cookie = report;
+	return B_OK;
+}
+
+
+static status_t
+device_close(void* cookie)
+{
+	return B_OK;
+}
+
+
+static status_t
+device_free(void* cookie)
+{
+	free(*(char**)cookie);
+	free(cookie);
+	return B_OK;
+}
+
+
+static status_t
+device_control(void* cookie, uint32 op, void* arg, size_t length)
+{
+	return B_BAD_VALUE;
+}
+
+
+static status_t
+device_read(void* cookie, off_t position, void* data, size_t* numBytes)
+{
+	char** report = (char**)cookie;
+	if (*report == NULL) {
+		*report = run_replays();
+		if (*report == NULL)
+			return B_NO_MEMORY;
+	}
+
+	size_t length = strlen(*report);
+	if (position >= (off_t)length) {
+		*numBytes = 0;
+		return B_OK;
+	}
+
+	*numBytes = std::min(*numBytes, length - (size_t)position);
+	return user_memcpy(data, *report + position, *numBytes);
+}
+
+
+static status_t
+device_write(void* cookie, off_t position, const void* data, size_t* numBytes)
+{
+	return B_NOT_ALLOWED;
+}
+
+
+// #pragma mark - driver interface
+
+
+static device_hooks sDeviceHooks = {
+	device_open,
+	device_close,
+	device_free,
+	device_control,
+	device_read,
+	device_write
+};
+
+
+status_t
+init_hardware(void)
+{
+	return B_OK;
+}
+
+
+status_t
+init_driver(void)
+{
+	return B_OK;
+}
+
+
+void
+uninit_driver(void)
+{
+}
+
+
+const char**
+publish_devices(void)
+{
+	return sDeviceNames;
+}
+
+
+device_hooks*
+find_device(const char* name)
+{
+	return strcmp(name, sDeviceNames[0]) == 0 ? &sDeviceHooks : NULL;
+}
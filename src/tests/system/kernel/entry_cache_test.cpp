@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks that the entry cache does not answer lookups the file system
+	would answer differently, in particular on case-insensitive volumes
+	like FAT or NTFS. Run it on a directory of the volume to test.
+
+	It also probes missing names in the system's library directory like the
+	runtime loader does, which lives on a packagefs volume.
+*/
+
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fs_info.h>
+#include <OS.h>
+
+
+static int sFailures = 0;
+
+
+static void
+check(bool condition, const char* what)
+{
+	if (condition)
+		return;
+
+	fprintf(stderr, "FAILED: %s\n", what);
+	sFailures++;
+}
+
+
+static bool
+exists(const char* path)
+{
+	struct stat st;
+	return lstat(path, &st) == 0;
+}
+
+
+static void
+create_file(const char* path)
+{
+	int fd = open(path, O_CREAT | O_WRONLY | O_EXCL, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Could not create \"%s\": %s\n", path,
+			strerror(errno));
+		exit(1);
+	}
+	close(fd);
+}
+
+
+static void
+read_directory(const char* path)
+{
+	DIR* dir = opendir(path);
+	if (dir == NULL) {
+		fprintf(stderr, "Could not open \"%s\": %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	while (readdir(dir) != NULL)
+		;
+
+	closedir(dir);
+}
+
+
+static void
+test_packagefs(const char* directory)
+{
+	struct stat st;
+	fs_info info;
+	if (stat(directory, &st) != 0 || fs_stat_dev(st.st_dev, &info) != 0
+		|| strcmp(info.fsh_name, "packagefs") != 0) {
+		printf("\"%s\" is not on a packagefs volume, skipping it.\n",
+			directory);
+		return;
+	}
+
+	// packagefs reports entry changes when packages are (de)activated, so
+	// its lookup misses may be cached.
+	check((info.flags & (B_FS_IS_SHARED | B_FS_IS_CASE_SENSITIVE))
+			== B_FS_IS_CASE_SENSITIVE,
+		"packagefs volume allows caching missing entries");
+
+	// find an existing entry to compare with
+	char existing[B_PATH_NAME_LENGTH];
+	existing[0] = '\0';
+	DIR* dir = opendir(directory);
+	if (dir != NULL) {
+		while (struct dirent* entry = readdir(dir)) {
+			if (strcmp(entry->d_name, ".") != 0
+				&& strcmp(entry->d_name, "..") != 0) {
+				snprintf(existing, sizeof(existing), "%s/%s", directory,
+					entry->d_name);
+				break;
+			}
+		}
+		closedir(dir);
+	}
+
+	// Probe a missing library twice, like the runtime loader does for every
+	// directory of its search path.
+	char path[B_PATH_NAME_LENGTH];
+	snprintf(path, sizeof(path), "%s/libentry_cache_test.%" B_PRId32 ".so",
+		directory, find_thread(NULL));
+	check(!exists(path), "missing library is not found on packagefs");
+	check(!exists(path), "missing library is not found again on packagefs");
+
+	if (existing[0] == '\0')
+		return;
+
+	check(exists(existing), "existing entry is found after failed lookups");
+
+	// packagefs is case-sensitive, a case variant must not be found
+	char* name = strrchr(existing, '/') + 1;
+	snprintf(path, sizeof(path), "%s", existing);
+	char* variant = path + (name - existing);
+	for (; *variant != '\0'; variant++) {
+		if (*variant >= 'a' && *variant <= 'z') {
+			*variant -= 'a' - 'A';
+			break;
+		}
+		if (*variant >= 'A' && *variant <= 'Z') {
+			*variant += 'a' - 'A';
+			break;
+		}
+	}
+	if (*variant != '\0') {
+		check(!exists(path), "case variant is not found on packagefs");
+		check(!exists(path), "case variant is not found again on packagefs");
+	}
+
+	read_directory(directory);
+	check(exists(existing),
+		"existing entry is found in a completely read packagefs directory");
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+		fprintf(stderr, "Usage: %s [<directory>]\n", argv[0]);
+		return 1;
+	}
+
+	char base[B_PATH_NAME_LENGTH];
+	snprintf(base, sizeof(base), "%s/entry_cache_test.%" B_PRId32,
+		argc == 2 ? argv[1] : ".", find_thread(NULL));
+	if (mkdir(base, 0755) != 0) {
+		fprintf(stderr, "Could not create \"%s\": %s\n", base,
+			strerror(errno));
+		return 1;
+	}
+
+	char path[B_PATH_NAME_LENGTH];
+	char created[B_PATH_NAME_LENGTH];
+
+	// A failed lookup must not hide an entry created afterwards.
+	snprintf(created, sizeof(created), "%s/Missing", base);
+	check(!exists(created), "missing entry is not found");
+	create_file(created);
+	check(exists(created), "missing entry is found after creating it");
+
+	// Look up a name that does not exist yet, then create it with a
+	// different case.
+	snprintf(path, sizeof(path), "%s/casetest", base);
+	check(!exists(path), "lower case name is not found before creation");
+
+	snprintf(created, sizeof(created), "%s/CaseTest", base);
+	create_file(created);
+	check(exists(created), "created file is found");
+
+	// A variant of the name that has never been looked up tells us whether
+	// the volume ignores the case.
+	snprintf(path, sizeof(path), "%s/CASETEST", base);
+	bool caseInsensitive = exists(path);
+	printf("The volume is case-%s.\n",
+		caseInsensitive ? "insensitive" : "sensitive");
+
+	snprintf(path, sizeof(path), "%s/casetest", base);
+	check(exists(path) == caseInsensitive,
+		"earlier failed lookup is not answered from the cache");
+
+	// A directory that has been read completely must not answer lookups of
+	// other names on its own either.
+	read_directory(base);
+
+	snprintf(path, sizeof(path), "%s/cAsEtEsT", base);
+	check(exists(path) == caseInsensitive,
+		"lookup in a completely read directory matches the file system");
+	snprintf(path, sizeof(path), "%s/CaseTest", base);
+	check(exists(path), "created file is found in a completely read directory");
+	snprintf(path, sizeof(path), "%s/Other", base);
+	check(!exists(path), "other name is not found");
+
+	// clean up
+	snprintf(path, sizeof(path), "%s/Missing", base);
+	unlink(path);
+	unlink(created);
+	rmdir(base);
+
+	test_packagefs("/boot/system/lib");
+
+	if (sFailures > 0) {
+		fprintf(stderr, "%d checks failed.\n", sFailures);
+		return 1;
+	}
+
+	puts("All tests passed.");
+	return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares random reads from a file done by a number of threads using
+	pread() with the same reads submitted through an I/O ring.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <io_ring.h>
+
+
+static const size_t kBlockSize = 4096;
+static const off_t kDefaultFileSize = 64 * 1024 * 1024;
+static const int32 kDefaultOperations = 100000;
+static const int32 kDefaultDepth = 32;
+
+
+struct thread_args {
+	int		fd;
+	int32	operations;
+	off_t	blocks;
+};
+
+
+static off_t
+random_offset(off_t blocks, uint32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return (off_t)(seed % blocks) * kBlockSize;
+}
+
+
+static void
+print_result(const char* name, int32 operations, bigtime_t time)
+{
+	double seconds = time / 1000000.0;
+	printf("%-28s %10.0f ops/s %8.2f MB/s\n", name, operations / seconds,
+		operations * (double)kBlockSize / seconds / (1024 * 1024));
+}
+
+
+static status_t
+pread_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+	uint32 seed = find_thread(NULL);
+	char buffer[kBlockSize];
+
+	for (int32 i = 0; i < args->operations; i++) {
+		off_t offset = random_offset(args->blocks, seed);
+		if (pread(args->fd, buffer, kBlockSize, offset) != (ssize_t)kBlockSize)
+			return errno;
+	}
+
+	return B_OK;
+}
+
+
+static void
+run_pread(int fd, off_t blocks, int32 operations, int32 threadCount)
+{
+	thread_args args;
+	args.fd = fd;
+	args.operations = operations / threadCount;
+	args.blocks = blocks;
+
+	thread_id threads[threadCount];
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&pread_thread, "pread", B_NORMAL_PRIORITY,
+			&args);
+		resume_thread(threads[i]);
+	}
+
+	status_t result = B_OK;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t threadResult;
+		wait_for_thread(threads[i], &threadResult);
+		if (threadResult != B_OK)
+			result = threadResult;
+	}
+
+	bigtime_t totalTime = system_time() - startTime;
+	if (result != B_OK) {
+		printf("pread failed: %s\n", strerror(result));
+		return;
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "pread, %" B_PRId32 " threads", threadCount);
+	print_result(name, args.operations * threadCount, totalTime);
+}
+
+
+static void
+run_io_ring(int fd, off_t blocks, int32 operations, int32 depth,
+	uint32 flags)
+{
+	io_ring ring;
+	status_t status = io_ring_init(&ring, depth, flags);
+	if (status != B_OK) {
+		printf("Creating the I/O ring failed: %s\n", strerror(status));
+		return;
+	}
+
+	char* buffers = (char*)malloc(depth * kBlockSize);
+	int32* freeSlots = (int32*)malloc(depth * sizeof(int32));
+	if (buffers == NULL || freeSlots == NULL) {
+		free(buffers);
+		free(freeSlots);
+		io_ring_uninit(&ring);
+		return;
+	}
+	for (int32 i = 0; i < depth; i++)
+		freeSlots[i] = i;
+
+	uint32 seed = find_thread(NULL);
+	int32 submitted = 0;
+	int32 completed = 0;
+	int32 inFlight = 0;
+	bigtime_t startTime = system_time();
+
+	while (completed < operations) {
+		// keep the ring filled up to the queue depth
+		while (inFlight < depth && submitted < operations) {
+			io_ring_submission* submission = io_ring_get_submission(&ring);
+			if (submission == NULL)
+				break;
+
+			int32 slot = freeSlots[depth - 1 - inFlight];
+			io_ring_prep_read(submission, fd, buffers + slot * kBlockSize,
+				kBlockSize, random_offset(blocks, seed));
+			submission->user_data = slot;
+			submitted++;
+			inFlight++;
+		}
+
+		io_ring_submit_and_wait(&ring, 1);
+
+		io_ring_completion* completion;
+		while ((completion = io_ring_peek_completion(&ring)) != NULL) {
+			if (completion->result != (int64)kBlockSize) {
+				printf("I/O ring read failed: %s\n",
+					strerror((status_t)completion->result));
+				completed = operations;
+				break;
+			}
+			inFlight--;
+			freeSlots[depth - 1 - inFlight] = (int32)completion->user_data;
+			io_ring_completion_done(&ring);
+			completed++;
+		}
+	}
+
+	bigtime_t totalTime = system_time() - startTime;
+
+	free(buffers);
+	free(freeSlots);
+	io_ring_uninit(&ring);
+
+	char name[64];
+	snprintf(name, sizeof(name), "io_ring%s, depth %" B_PRId32,
+		(flags & IO_RING_POLL) != 0 ? " (poll)" : "", depth);
+	print_result(name, operations, totalTime);
+}
+
+
+static bool
+prepare_file(const char* path, off_t size)
+{
+	int fd = open(path, O_CREAT | O_WRONLY, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create \"%s\": %s\n", path,
+			strerror(errno));
+		return false;
+	}
+
+	struct stat stat;
+	if (fstat(fd, &stat) == 0 && stat.st_size >= size) {
+		close(fd);
+		return true;
+	}
+
+	char buffer[kBlockSize];
+	memset(buffer, 0x55, sizeof(buffer));
+
+	for (off_t offset = 0; offset < size; offset += kBlockSize) {
+		if (write(fd, buffer, kBlockSize) != (ssize_t)kBlockSize) {
+			fprintf(stderr, "Failed to write \"%s\": %s\n", path,
+				strerror(errno));
+			close(fd);
+			return false;
+		}
+	}
+
+	close(fd);
+	return true;
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	if (argc < 2 || strcmp(argv[1], "-h") == 0
+		|| strcmp(argv[1], "--help") == 0) {
+		printf("Usage: %s <file> [<size in MB> [<operations> [<depth>]]]\n"
+			"Creates <file> if needed, and times random %zu byte reads from "
+			"it using\npread() threads and an I/O ring.\n", argv[0],
+			kBlockSize);
+		return argc < 2 ? 1 : 0;
+	}
+
+	const char* path = argv[1];
+	off_t fileSize = argc > 2
+		? (off_t)atoi(argv[2]) * 1024 * 1024 : kDefaultFileSize;
+	int32 operations = argc > 3 ? atoi(argv[3]) : kDefaultOperations;
+	int32 depth = argc > 4 ? atoi(argv[4]) : kDefaultDepth;
+	if (fileSize < (off_t)kBlockSize || operations < 1 || depth < 1
+		|| depth > IO_RING_MAX_ENTRIES) {
+		fprintf(stderr, "Invalid arguments.\n");
+		return 1;
+	}
+
+	if (!prepare_file(path, fileSize))
+		return 1;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open \"%s\": %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	off_t blocks = fileSize / kBlockSize;
+
+	system_info info;
+	get_system_info(&info);
+
+	run_pread(fd, blocks, operations, 1);
+	if (info.cpu_count > 1)
+		run_pread(fd, blocks, operations, info.cpu_count);
+	run_pread(fd, blocks, operations, depth);
+
+	run_io_ring(fd, blocks, operations, 1, 0);
+	run_io_ring(fd, blocks, operations, depth, 0);
+	run_io_ring(fd, blocks, operations, depth, IO_RING_POLL);
+
+	close(fd);
+	return 0;
+}
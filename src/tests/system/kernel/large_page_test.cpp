@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Creates a locked area with B_LARGE_PAGES_AREA, checks that it is mapped
+	with large pages, times accessing it, and checks that protecting and
+	resizing parts of it, which splits large pages, keeps its contents.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <memory_private.h>
+
+
+static const size_t kLargePageSize = 2 * 1024 * 1024;
+static const size_t kAreaSize = 8 * kLargePageSize;
+
+
+static bool
+check_pattern(const uint32* data, size_t size, const char* step)
+{
+	for (size_t i = 0; i < size / sizeof(uint32); i++) {
+		if (data[i] != (uint32)i) {
+			fprintf(stderr, "%s: unexpected value %#" B_PRIx32 " at offset %#"
+				B_PRIxSIZE "\n", step, data[i], i * sizeof(uint32));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+is_large_page(const void* address)
+{
+	uint32 protection;
+	uint32 lock;
+	if (get_memory_properties(getpid(), address, &protection, &lock)
+			!= B_OK) {
+		return false;
+	}
+
+	return (protection & B_LARGE_PAGES_AREA) != 0;
+}
+
+
+static bigtime_t
+time_access(const uint32* data, size_t size)
+{
+	// touch one word per page in an order that defeats the prefetcher
+	size_t pageCount = size / B_PAGE_SIZE;
+	size_t wordsPerPage = B_PAGE_SIZE / sizeof(uint32);
+	uint32 sum = 0;
+
+	bigtime_t startTime = system_time();
+	for (int32 round = 0; round < 100; round++) {
+		for (size_t i = 0; i < pageCount; i++) {
+			size_t page = (i * 509) % pageCount;
+			sum += data[page * wordsPerPage + round];
+		}
+	}
+	bigtime_t time = system_time() - startTime;
+
+	if (sum == 0)
+		printf(" ");
+	return time;
+}
+
+
+int
+main()
+{
+	uint32* data;
+	area_id area = create_area("large page test", (void**)&data,
+		B_ANY_ADDRESS, kAreaSize, B_FULL_LOCK,
+		B_READ_AREA | B_WRITE_AREA | B_LARGE_PAGES_AREA);
+	if (area < 0) {
+		fprintf(stderr, "Failed to create area: %s\n", strerror(area));
+		return 1;
+	}
+
+	for (size_t i = 0; i < kAreaSize / sizeof(uint32); i++)
+		data[i] = i;
+
+	// The area is aligned to the large page size, so unless physical memory
+	// is badly fragmented, it is mapped with large pages.
+	int32 largePages = 0;
+	for (size_t offset = 0; offset < kAreaSize; offset += kLargePageSize) {
+		if (is_large_page((uint8*)data + offset))
+			largePages++;
+	}
+	printf("%" B_PRId32 " of %" B_PRIuSIZE " chunks mapped with large pages\n",
+		largePages, kAreaSize / kLargePageSize);
+
+#ifdef __x86_64__
+	if (largePages == 0) {
+		fprintf(stderr, "The area isn't mapped with large pages!\n");
+		return 1;
+	}
+#endif
+
+	printf("random page access: %" B_PRId64 " us\n",
+		time_access(data, kAreaSize));
+
+	// Make a part in the middle of the first large page read-only, which
+	// has to split it.
+	if (mprotect((uint8*)data + kLargePageSize / 2, B_PAGE_SIZE * 4,
+			PROT_READ) != 0) {
+		fprintf(stderr, "Failed to protect range: %s\n", strerror(errno));
+		return 1;
+	}
+
+	if (!check_pattern(data, kAreaSize, "after protect"))
+		return 1;
+
+	if (is_large_page(data)) {
+		fprintf(stderr, "The protected large page hasn't been split!\n");
+		return 1;
+	}
+
+	// the rest must still be writable
+	data[0] = 0;
+	data[(kLargePageSize + B_PAGE_SIZE) / sizeof(uint32)]
+		= (kLargePageSize + B_PAGE_SIZE) / sizeof(uint32);
+
+	// Shrink the area to end in the middle of a large page.
+	size_t newSize = kAreaSize - kLargePageSize - kLargePageSize / 2;
+	status_t status = resize_area(area, newSize);
+	if (status != B_OK) {
+		fprintf(stderr, "Failed to resize area: %s\n", strerror(status));
+		return 1;
+	}
+
+	if (!check_pattern(data, newSize, "after resize"))
+		return 1;
+
+	delete_area(area);
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks the effects of madvise() on anonymous and file mappings, and that
+	invalid arguments are rejected.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const size_t kPageCount = 16;
+static const size_t kSize = kPageCount * B_PAGE_SIZE;
+
+
+static bool
+check_range(const uint8* data, size_t size, uint8 value, const char* step)
+{
+	for (size_t i = 0; i < size; i++) {
+		if (data[i] != value) {
+			fprintf(stderr, "%s: unexpected value %#x at offset %#" B_PRIxSIZE
+				"\n", step, data[i], i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+test_dont_need()
+{
+	uint8* data = (uint8*)mmap(NULL, kSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "Failed to map memory: %s\n", strerror(errno));
+		return false;
+	}
+
+	memset(data, 0x5a, kSize);
+
+	// discard the middle half, the rest must be kept
+	if (madvise(data + kSize / 4, kSize / 2, MADV_DONTNEED) != 0) {
+		fprintf(stderr, "MADV_DONTNEED failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	if (!check_range(data, kSize / 4, 0x5a, "MADV_DONTNEED head")
+		|| !check_range(data + kSize / 4, kSize / 2, 0, "MADV_DONTNEED")
+		|| !check_range(data + kSize * 3 / 4, kSize / 4, 0x5a,
+			"MADV_DONTNEED tail")) {
+		return false;
+	}
+
+	// the range must still be usable
+	memset(data, 0xa5, kSize);
+	if (!check_range(data, kSize, 0xa5, "after MADV_DONTNEED"))
+		return false;
+
+	munmap(data, kSize);
+	return true;
+}
+
+
+static bool
+test_free()
+{
+	uint8* data = (uint8*)mmap(NULL, kSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "Failed to map memory: %s\n", strerror(errno));
+		return false;
+	}
+
+	memset(data, 0x5a, kSize);
+
+	if (madvise(data, kSize, MADV_FREE) != 0) {
+		fprintf(stderr, "MADV_FREE failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	// Each page either keeps its contents or is zeroed, depending on whether
+	// the page daemon got to it.
+	for (size_t i = 0; i < kPageCount; i++) {
+		const uint8* page = data + i * B_PAGE_SIZE;
+		if (!check_range(page, B_PAGE_SIZE, page[0] == 0 ? 0 : 0x5a,
+				"MADV_FREE")) {
+			return false;
+		}
+	}
+
+	// writing again must keep the data
+	memset(data, 0xa5, kSize);
+	if (!check_range(data, kSize, 0xa5, "after MADV_FREE"))
+		return false;
+
+	munmap(data, kSize);
+	return true;
+}
+
+
+static bool
+test_file_mapping()
+{
+	char path[] = "/tmp/madvise_test_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create file: %s\n", strerror(errno));
+		return false;
+	}
+	unlink(path);
+
+	uint8 buffer[B_PAGE_SIZE];
+	memset(buffer, 0x33, sizeof(buffer));
+	for (size_t i = 0; i < kPageCount; i++) {
+		if (write(fd, buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer)) {
+			fprintf(stderr, "Failed to write file: %s\n", strerror(errno));
+			return false;
+		}
+	}
+
+	uint8* data = (uint8*)mmap(NULL, kSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "Failed to map file: %s\n", strerror(errno));
+		return false;
+	}
+
+	if (madvise(data, kSize, MADV_WILLNEED) != 0
+		|| madvise(data, kSize, MADV_SEQUENTIAL) != 0) {
+		fprintf(stderr, "Failed to advise file mapping: %s\n",
+			strerror(errno));
+		return false;
+	}
+
+	if (!check_range(data, kSize, 0x33, "MADV_SEQUENTIAL"))
+		return false;
+
+	// private changes are dropped, the file contents are visible again
+	memset(data, 0x77, kSize);
+	if (madvise(data, kSize, MADV_DONTNEED) != 0) {
+		fprintf(stderr, "MADV_DONTNEED failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	if (!check_range(data, kSize, 0x33, "MADV_DONTNEED on file"))
+		return false;
+
+	if (madvise(data, kSize, MADV_RANDOM) != 0
+		|| madvise(data, kSize, MADV_NORMAL) != 0) {
+		fprintf(stderr, "Failed to advise file mapping: %s\n",
+			strerror(errno));
+		return false;
+	}
+
+	munmap(data, kSize);
+	return true;
+}
+
+
+static bool
+test_invalid_arguments()
+{
+	uint8* data = (uint8*)mmap(NULL, kSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "Failed to map memory: %s\n", strerror(errno));
+		return false;
+	}
+
+	if (madvise(data + 1, B_PAGE_SIZE, MADV_NORMAL) == 0) {
+		fprintf(stderr, "Unaligned address was accepted\n");
+		return false;
+	}
+
+	if (madvise(data, kSize, 1234) == 0) {
+		fprintf(stderr, "Invalid advice was accepted\n");
+		return false;
+	}
+
+	munmap(data, kSize);
+
+	if (madvise(data, kSize, MADV_DONTNEED) == 0) {
+		fprintf(stderr, "Unmapped range was accepted\n");
+		return false;
+	}
+
+	// posix_madvise() reports errors directly
+	if (posix_madvise(data, kSize, POSIX_MADV_NORMAL) == 0) {
+		fprintf(stderr, "posix_madvise() accepted unmapped range\n");
+		return false;
+	}
+
+	return true;
+}
+
+
+int
+main()
+{
+	if (!test_dont_need() || !test_free() || !test_file_mapping()
+		|| !test_invalid_arguments()) {
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how page faults on fresh anonymous memory scale with the number
+	of threads causing them. Each fault allocates a page, and unmapping the
+	memory frees them again, so this mostly stresses the page allocator.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <OS.h>
+
+
+static const size_t kDefaultSize = 16 * 1024 * 1024;
+static const int32 kDefaultRounds = 20;
+
+
+struct thread_args {
+	size_t	size;
+	int32	rounds;
+};
+
+
+static status_t
+fault_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+
+	for (int32 round = 0; round < args->rounds; round++) {
+		uint8* address = (uint8*)mmap(NULL, args->size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (address == MAP_FAILED)
+			return B_NO_MEMORY;
+
+		for (size_t offset = 0; offset < args->size; offset += B_PAGE_SIZE)
+			address[offset] = 1;
+
+		munmap(address, args->size);
+	}
+
+	return B_OK;
+}
+
+
+static void
+run_test(int32 threadCount, size_t size, int32 rounds, double& singleRate)
+{
+	thread_args args;
+	args.size = size;
+	args.rounds = rounds;
+
+	thread_id threads[threadCount];
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&fault_thread, "page faulter",
+			B_NORMAL_PRIORITY, &args);
+		resume_thread(threads[i]);
+	}
+
+	status_t result = B_OK;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t threadResult;
+		wait_for_thread(threads[i], &threadResult);
+		if (threadResult != B_OK)
+			result = threadResult;
+	}
+
+	bigtime_t totalTime = system_time() - startTime;
+	if (result != B_OK) {
+		printf("%2" B_PRId32 " threads: failed: %s\n", threadCount,
+			strerror(result));
+		return;
+	}
+
+	double faults = (double)threadCount * rounds * (size / B_PAGE_SIZE);
+	double rate = faults / (totalTime / 1000000.0);
+	if (threadCount == 1)
+		singleRate = rate;
+
+	printf("%2" B_PRId32 " thread%s %12.0f faults/s  %6.2fx\n", threadCount,
+		threadCount == 1 ? " " : "s", rate,
+		singleRate > 0 ? rate / singleRate : 0.0);
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	if (argc > 1 && (strcmp(argv[1], "-h") == 0
+			|| strcmp(argv[1], "--help") == 0)) {
+		printf("Usage: %s [<MB per thread> [<rounds> [<max threads>]]]\n"
+			"Times page faults on anonymous memory with an increasing number "
+			"of threads.\n", argv[0]);
+		return 0;
+	}
+
+	size_t size = argc > 1 ? (size_t)atoi(argv[1]) * 1024 * 1024
+		: kDefaultSize;
+	int32 rounds = argc > 2 ? atoi(argv[2]) : kDefaultRounds;
+
+	system_info info;
+	get_system_info(&info);
+	int32 maxThreads = argc > 3 ? atoi(argv[3]) : (int32)info.cpu_count;
+
+	if (size < B_PAGE_SIZE || rounds < 1 || maxThreads < 1) {
+		fprintf(stderr, "Invalid arguments.\n");
+		return 1;
+	}
+
+	double singleRate = 0;
+	for (int32 threads = 1; threads <= maxThreads; threads *= 2)
+		run_test(threads, size, rounds, singleRate);
+
+	if ((maxThreads & (maxThreads - 1)) != 0)
+		run_test(maxThreads, size, rounds, singleRate);
+
+	return 0;
+}
@@ -1,14 +1,39 @@
 /*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
  * Copyright 2008, Ingo Weinhold, ingo_weinhold@gmx.de.
  * Distributed under the terms of the MIT License.
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <OS.h>
 
 
+static const int32 kIterations = 10000;
+
+static const int32 kDefaultDepth = 16;
+static const int32 kWidth = 4;
+	// directories per level of the deep tree
+
+
+enum operation {
+	OPERATION_LSTAT,
+	OPERATION_STAT_MISSING,
+	OPERATION_OPEN
+};
+
+struct thread_args {
+	const char*	path;
+	operation	op;
+};
+
+
 static void
 time_lstat(const char* path)
 {
@@ -16,20 +41,215 @@ time_lstat(const char* path)
 	fflush(stdout);
 	bigtime_t startTime = system_time();
 
-	static const int32 iterations = 10000;
-	for (int32 i = 0; i < iterations; i++) {
+	for (int32 i = 0; i < kIterations; i++) {
 		struct stat st;
 		lstat(path, &st);
 	}
 
 	bigtime_t totalTime = system_time() - startTime;
-	printf(" %5.3f us/call\n", (double)totalTime / iterations);
+	printf(" %5.3f us/call\n", (double)totalTime / kIterations);
+}
+
+
+static status_t
+run_operation(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+
+	for (int32 i = 0; i < kIterations; i++) {
+		struct stat st;
+		switch (args->op) {
+			case OPERATION_LSTAT:
+				if (lstat(args->path, &st) != 0)
+					return errno;
+				break;
+			case OPERATION_STAT_MISSING:
+				if (stat(args->path, &st) == 0 || errno != ENOENT)
+					return B_ERROR;
+				break;
+			case OPERATION_OPEN:
+			{
+				int fd = open(args->path, O_RDONLY);
+				if (fd < 0)
+					return errno;
+				close(fd);
+				break;
+			}
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	Runs \a op on \a path in \a threadCount threads at the same time, and
+	prints the average time per call.
+*/
+static void
+time_operation(const char* name, const char* path, operation op,
+	int32 threadCount)
+{
+	printf("%-20s %2" B_PRId32 " thread%s ...", name, threadCount,
+		threadCount == 1 ? " " : "s");
+	fflush(stdout);
+
+	thread_args args;
+	args.path = path;
+	args.op = op;
+
+	thread_id* threads = (thread_id*)malloc(threadCount * sizeof(thread_id));
+	if (threads == NULL) {
+		printf(" out of memory\n");
+		return;
+	}
+
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&run_operation, name, B_NORMAL_PRIORITY,
+			&args);
+		resume_thread(threads[i]);
+	}
+
+	status_t result = B_OK;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t threadResult;
+		wait_for_thread(threads[i], &threadResult);
+		if (threadResult != B_OK)
+			result = threadResult;
+	}
+
+	bigtime_t totalTime = system_time() - startTime;
+	free(threads);
+
+	if (result != B_OK) {
+		printf(" failed: %s\n", strerror(result));
+		return;
+	}
+
+	printf(" %7.3f us/call\n", (double)totalTime / kIterations);
+}
+
+
+/*!	Creates a tree \a depth levels deep below \a base, with kWidth
+	directories on each level, and a file in the last one. Returns the path
+	of that file in \a leafPath.
+*/
+static bool
+create_tree(const char* base, int32 depth, char* leafPath, size_t size)
+{
+	strlcpy(leafPath, base, size);
+
+	for (int32 level = 0; level < depth; level++) {
+		size_t length = strlen(leafPath);
+		for (int32 i = 0; i < kWidth; i++) {
+			snprintf(leafPath + length, size - length, "/level%02" B_PRId32
+				"-%" B_PRId32, level, i);
+			if (mkdir(leafPath, 0755) != 0 && errno != EEXIST) {
+				fprintf(stderr, "Failed to create \"%s\": %s\n", leafPath,
+					strerror(errno));
+				return false;
+			}
+		}
+		// descend into the last one
+	}
+
+	strlcat(leafPath, "/file", size);
+	int fd = open(leafPath, O_CREAT | O_WRONLY, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create \"%s\": %s\n", leafPath,
+			strerror(errno));
+		return false;
+	}
+	close(fd);
+
+	return true;
+}
+
+
+static void
+remove_tree(const char* base, int32 depth)
+{
+	char path[B_PATH_NAME_LENGTH];
+
+	for (int32 level = depth; level > 0; level--) {
+		// build the path of the deepest remaining level
+		strlcpy(path, base, sizeof(path));
+		for (int32 i = 0; i < level - 1; i++) {
+			size_t length = strlen(path);
+			snprintf(path + length, sizeof(path) - length,
+				"/level%02" B_PRId32 "-%" B_PRId32, i, kWidth - 1);
+		}
+
+		size_t length = strlen(path);
+		if (level == depth) {
+			snprintf(path + length, sizeof(path) - length,
+				"/level%02" B_PRId32 "-%" B_PRId32 "/file", level - 1,
+				kWidth - 1);
+			unlink(path);
+		}
+
+		for (int32 i = 0; i < kWidth; i++) {
+			snprintf(path + length, sizeof(path) - length,
+				"/level%02" B_PRId32 "-%" B_PRId32, level - 1, i);
+			rmdir(path);
+		}
+	}
+}
+
+
+static void
+run_deep_tree_test(const char* base, int32 depth)
+{
+	char leafPath[B_PATH_NAME_LENGTH];
+	if (!create_tree(base, depth, leafPath, sizeof(leafPath))) {
+		remove_tree(base, depth);
+		return;
+	}
+
+	char missingPath[B_PATH_NAME_LENGTH];
+	snprintf(missingPath, sizeof(missingPath), "%s.missing", leafPath);
+
+	system_info info;
+	get_system_info(&info);
+
+	printf("%" B_PRId32 " levels below %s\n", depth, base);
+
+	int32 threadCounts[] = { 1, (int32)info.cpu_count };
+	int32 runs = info.cpu_count > 1 ? 2 : 1;
+	for (int32 i = 0; i < runs; i++) {
+		time_operation("lstat", leafPath, OPERATION_LSTAT, threadCounts[i]);
+		time_operation("stat missing", missingPath, OPERATION_STAT_MISSING,
+			threadCounts[i]);
+		time_operation("open/close", leafPath, OPERATION_OPEN,
+			threadCounts[i]);
+	}
+
+	remove_tree(base, depth);
 }
 
 
 int
-main()
+main(int argc, const char* const* argv)
 {
+	if (argc > 1) {
+		if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+			printf("Usage: %s [<directory> [<depth>]]\n"
+				"Without arguments, resolves some paths of the system. "
+				"Otherwise, creates\na tree <depth> levels deep in "
+				"<directory>, and times stat() and open() in it.\n",
+				argv[0]);
+			return 0;
+		}
+
+		int32 depth = argc > 2 ? atoi(argv[2]) : kDefaultDepth;
+		if (depth < 1)
+			depth = 1;
+
+		run_deep_tree_test(argv[1], depth);
+		return 0;
+	}
+
 	const char* const paths[] = {
 		"/",
 		"/boot",
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the round trip latency of ports, with two threads sending a
+	message back and forth, and their throughput, with one thread writing
+	messages as fast as it can and another one reading them.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int32 kDefaultMessages = 200000;
+static const size_t kMaxMessageSize = 64 * 1024;
+static const size_t kMessageSizes[] = { 0, 64, 256, 1024, 16 * 1024 };
+
+
+struct thread_args {
+	port_id		in;
+	port_id		out;
+	int32		messages;
+};
+
+
+static status_t
+echo_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+	char* buffer = (char*)malloc(kMaxMessageSize);
+
+	for (int32 i = 0; i < args->messages; i++) {
+		int32 code;
+		ssize_t size = read_port(args->in, &code, buffer, kMaxMessageSize);
+		if (size < 0 || write_port(args->out, code, buffer, size) != B_OK)
+			break;
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static status_t
+reader_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+	char* buffer = (char*)malloc(kMaxMessageSize);
+
+	for (int32 i = 0; i < args->messages; i++) {
+		int32 code;
+		if (read_port(args->in, &code, buffer, kMaxMessageSize) < 0)
+			break;
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static void
+run_ping_pong(int32 messages, size_t size)
+{
+	thread_args args;
+	args.in = create_port(1, "ping");
+	args.out = create_port(1, "pong");
+	args.messages = messages;
+
+	char* buffer = (char*)calloc(1, kMaxMessageSize);
+
+	thread_id thread = spawn_thread(&echo_thread, "echo", B_NORMAL_PRIORITY,
+		&args);
+	resume_thread(thread);
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < messages; i++) {
+		int32 code;
+		if (write_port(args.in, i, buffer, size) != B_OK
+			|| read_port(args.out, &code, buffer, kMaxMessageSize) < 0) {
+			fprintf(stderr, "ping pong failed after %" B_PRId32
+				" messages\n", i);
+			break;
+		}
+	}
+	bigtime_t time = system_time() - start;
+
+	status_t result;
+	wait_for_thread(thread, &result);
+	delete_port(args.in);
+	delete_port(args.out);
+	free(buffer);
+
+	printf("ping pong  %6" B_PRIuSIZE " bytes: %8.2f us round trip\n", size,
+		(double)time / messages);
+}
+
+
+static void
+run_stream(int32 messages, size_t size)
+{
+	thread_args args;
+	args.in = create_port(64, "stream");
+	args.out = -1;
+	args.messages = messages;
+
+	char* buffer = (char*)calloc(1, kMaxMessageSize);
+
+	thread_id thread = spawn_thread(&reader_thread, "reader",
+		B_NORMAL_PRIORITY, &args);
+	resume_thread(thread);
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < messages; i++) {
+		if (write_port(args.in, i, buffer, size) != B_OK) {
+			fprintf(stderr, "stream failed after %" B_PRId32 " messages\n",
+				i);
+			break;
+		}
+	}
+
+	status_t result;
+	wait_for_thread(thread, &result);
+	bigtime_t time = system_time() - start;
+
+	delete_port(args.in);
+	free(buffer);
+
+	double seconds = time / 1000000.0;
+	printf("stream     %6" B_PRIuSIZE " bytes: %10.0f messages/s %8.2f MB/s\n",
+		size, messages / seconds, messages * (double)size / seconds
+			/ (1024 * 1024));
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 messages = kDefaultMessages;
+	if (argc > 1) {
+		messages = atoi(argv[1]);
+		if (messages <= 0 || strcmp(argv[1], "-h") == 0) {
+			fprintf(stderr, "Usage: %s [<messages>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const size_t sizeCount = sizeof(kMessageSizes) / sizeof(kMessageSizes[0]);
+	for (size_t i = 0; i < sizeCount; i++)
+		run_ping_pong(messages, kMessageSizes[i]);
+	for (size_t i = 0; i < sizeCount; i++)
+		run_stream(messages, kMessageSizes[i]);
+
+	return 0;
+}
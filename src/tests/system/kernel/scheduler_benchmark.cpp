@@ -0,0 +1,248 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Runs a mix of CPU bound threads, which do nothing but compute, and I/O
+	bound threads, which compute a little and then wait for a short while,
+	and reports how much work they got done and how often the CPU bound
+	threads were switched out.
+
+	The kernel doesn't export a context switch counter, so the CPU bound
+	threads detect them themselves: they check the time between their work
+	units, and count any gap that is way longer than a work unit takes.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+#include <scheduler.h>
+
+
+static const bigtime_t kDefaultDuration = 5000000;
+static const bigtime_t kSwitchThreshold = 50;
+static const bigtime_t kIOWait = 1000;
+static const int32 kIOBurst = 2000;
+
+
+struct thread_args {
+	bigtime_t			endTime;
+	uint64				work;
+	uint64				switches;
+	bigtime_t			maxLatency;
+	bigtime_t			totalLatency;
+};
+
+
+static const char* const kModeNames[] = {
+	"low_latency",
+	"power_saving",
+	"throughput"
+};
+static const int32 kModeCount = sizeof(kModeNames) / sizeof(kModeNames[0]);
+
+
+static inline uint32
+do_work(uint32 value, int32 iterations)
+{
+	for (int32 i = 0; i < iterations; i++)
+		value = value * 1103515245 + 12345;
+	return value;
+}
+
+
+static status_t
+cpu_bound_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+
+	volatile uint32 value = 0;
+	bigtime_t last = system_time();
+	while (last < args->endTime) {
+		value = do_work(value, 256);
+		args->work++;
+
+		bigtime_t now = system_time();
+		if (now - last > kSwitchThreshold)
+			args->switches++;
+		last = now;
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+io_bound_thread(void* _args)
+{
+	thread_args* args = (thread_args*)_args;
+
+	volatile uint32 value = 0;
+	while (system_time() < args->endTime) {
+		value = do_work(value, kIOBurst);
+
+		bigtime_t start = system_time();
+		snooze(kIOWait);
+		bigtime_t latency = system_time() - start - kIOWait;
+
+		if (latency > args->maxLatency)
+			args->maxLatency = latency;
+		args->totalLatency += latency;
+		args->work++;
+	}
+
+	return B_OK;
+}
+
+
+static void
+run_test(int32 cpuThreads, int32 ioThreads, bigtime_t duration)
+{
+	int32 count = cpuThreads + ioThreads;
+	thread_id threads[count];
+	thread_args args[count];
+	memset(args, 0, sizeof(args));
+
+	bigtime_t endTime = system_time() + duration;
+
+	for (int32 i = 0; i < count; i++) {
+		args[i].endTime = endTime;
+		threads[i] = spawn_thread(
+			i < cpuThreads ? &cpu_bound_thread : &io_bound_thread,
+			i < cpuThreads ? "cpu bound" : "io bound", B_NORMAL_PRIORITY,
+			&args[i]);
+	}
+
+	for (int32 i = 0; i < count; i++)
+		resume_thread(threads[i]);
+
+	for (int32 i = 0; i < count; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	uint64 cpuWork = 0;
+	uint64 switches = 0;
+	for (int32 i = 0; i < cpuThreads; i++) {
+		cpuWork += args[i].work;
+		switches += args[i].switches;
+	}
+
+	uint64 ioWork = 0;
+	bigtime_t maxLatency = 0;
+	bigtime_t totalLatency = 0;
+	for (int32 i = cpuThreads; i < count; i++) {
+		ioWork += args[i].work;
+		totalLatency += args[i].totalLatency;
+		if (args[i].maxLatency > maxLatency)
+			maxLatency = args[i].maxLatency;
+	}
+
+	double seconds = duration / 1000000.0;
+	printf("%3" B_PRId32 " cpu %3" B_PRId32 " io: %12.0f units/s %9.0f "
+		"switches/s %9.0f io/s", cpuThreads, ioThreads, cpuWork / seconds,
+		switches / seconds, ioWork / seconds);
+	if (ioWork > 0) {
+		printf("  wakeup latency %5" B_PRIdBIGTIME " us avg %6"
+			B_PRIdBIGTIME " us max", totalLatency / (bigtime_t)ioWork,
+			maxLatency);
+	}
+	printf("\n");
+}
+
+
+static void
+usage(const char* name)
+{
+	printf("Usage: %s [-m <mode>] [-d <seconds>] [<cpu threads> "
+		"[<io threads>]]\n"
+		"Measures throughput and context switches of CPU bound threads that "
+		"compete\nwith I/O bound ones. Without thread counts, a series of "
+		"mixes is run.\n"
+		"  -m <mode>     scheduler mode to use during the test: low_latency,\n"
+		"                power_saving, or throughput.\n"
+		"  -d <seconds>  duration of each run, default is 5 seconds.\n",
+		name);
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	int32 mode = -1;
+	bigtime_t duration = kDefaultDuration;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			i++;
+			for (int32 j = 0; j < kModeCount; j++) {
+				if (strcmp(argv[i], kModeNames[j]) == 0)
+					mode = j;
+			}
+			if (mode < 0) {
+				fprintf(stderr, "Unknown scheduler mode \"%s\".\n", argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			duration = (bigtime_t)atoi(argv[++i]) * 1000000;
+		} else {
+			usage(argv[0]);
+			return strcmp(argv[i], "-h") == 0
+				|| strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	int32 cpuThreads = -1;
+	int32 ioThreads = 0;
+	if (i < argc) {
+		cpuThreads = atoi(argv[i]);
+		if (i + 1 < argc)
+			ioThreads = atoi(argv[i + 1]);
+		if (cpuThreads < 0 || ioThreads < 0 || cpuThreads + ioThreads == 0) {
+			fprintf(stderr, "Invalid thread counts.\n");
+			return 1;
+		}
+	}
+
+	if (duration <= 0) {
+		fprintf(stderr, "Invalid duration.\n");
+		return 1;
+	}
+
+	int32 previousMode = get_scheduler_mode();
+	if (mode >= 0) {
+		status_t status = set_scheduler_mode(mode);
+		if (status != B_OK) {
+			fprintf(stderr, "Could not set scheduler mode: %s\n",
+				strerror(status));
+			return 1;
+		}
+	}
+
+	int32 currentMode = get_scheduler_mode();
+	printf("scheduler mode: %s\n", currentMode >= 0 && currentMode < kModeCount
+		? kModeNames[currentMode] : "unknown");
+
+	if (cpuThreads >= 0)
+		run_test(cpuThreads, ioThreads, duration);
+	else {
+		system_info info;
+		get_system_info(&info);
+		int32 cpuCount = info.cpu_count;
+
+		run_test(cpuCount, 0, duration);
+		run_test(cpuCount, cpuCount, duration);
+		run_test(2 * cpuCount, cpuCount, duration);
+		run_test(4 * cpuCount, 4 * cpuCount, duration);
+	}
+
+	if (mode >= 0)
+		set_scheduler_mode(previousMode);
+
+	return 0;
+}
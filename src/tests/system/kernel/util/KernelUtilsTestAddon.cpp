@@ -4,6 +4,7 @@
 //#include "AVLTreeMapTest.h"
 #include "SinglyLinkedListTest.h"
 #include "DoublyLinkedListTest.h"
+#include "LZ4Test.h"
 #include "VectorMapTest.h"
 #include "VectorSetTest.h"
 #include "VectorTest.h"
@@ -14,6 +15,7 @@ BTestSuite* getTestSuite() {
 //	suite->addTest("AVLTreeMap", AVLTreeMapTest::Suite());
 	suite->addTest("SinglyLinkedList", SinglyLinkedListTest::Suite());
 	suite->addTest("DoublyLinkedList", DoublyLinkedListTest::Suite());
+	suite->addTest("LZ4", LZ4Test::Suite());
 	suite->addTest("VectorMap", VectorMapTest::Suite());
 	suite->addTest("VectorSet", VectorSetTest::Suite());
 	suite->addTest("Vector", VectorTest::Suite());
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <TestUtils.h>
+#include <cppunit/Test.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+
+#include <util/LZ4.h>
+
+#include "common.h"
+#include "LZ4Test.h"
+
+
+static const size_t kPageSize = 4096;
+
+
+LZ4Test::LZ4Test(std::string name)
+	: BTestCase(name)
+{
+}
+
+
+CppUnit::Test*
+LZ4Test::Suite()
+{
+	CppUnit::TestSuite *suite = new CppUnit::TestSuite("LZ4");
+
+	ADD_TEST4(LZ4, suite, LZ4Test, EmptyTest);
+	ADD_TEST4(LZ4, suite, LZ4Test, UniformTest);
+	ADD_TEST4(LZ4, suite, LZ4Test, TextTest);
+	ADD_TEST4(LZ4, suite, LZ4Test, RandomTest);
+	ADD_TEST4(LZ4, suite, LZ4Test, OverflowTest);
+	ADD_TEST4(LZ4, suite, LZ4Test, CorruptTest);
+
+	return suite;
+}
+
+
+//! Compresses and decompresses \a data, and compares the result.
+void
+LZ4Test::RoundTrip(const uint8* data, size_t size, ssize_t maxCompressedSize)
+{
+	uint8 workMemory[LZ4_WORK_MEMORY_SIZE];
+	uint8 compressed[kPageSize * 2];
+	uint8 decompressed[kPageSize];
+
+	ssize_t compressedSize = lz4_compress(data, size, compressed,
+		sizeof(compressed), workMemory);
+	CHK(compressedSize > 0);
+	CHK(compressedSize <= maxCompressedSize);
+
+	ssize_t decompressedSize = lz4_decompress(compressed, compressedSize,
+		decompressed, sizeof(decompressed));
+	CHK(decompressedSize == (ssize_t)size);
+	CHK(memcmp(data, decompressed, size) == 0);
+}
+
+
+void
+LZ4Test::EmptyTest()
+{
+	uint8 data[16] = { 1, 2, 3 };
+
+	NextSubTest();
+	RoundTrip(data, 0, 1);
+
+	NextSubTest();
+	RoundTrip(data, 3, 4);
+
+	NextSubTest();
+	RoundTrip(data, sizeof(data), sizeof(data) + 2);
+}
+
+
+void
+LZ4Test::UniformTest()
+{
+	uint8 data[kPageSize];
+
+	NextSubTest();
+	memset(data, 0, sizeof(data));
+	RoundTrip(data, sizeof(data), 64);
+
+	NextSubTest();
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = i % 7;
+	RoundTrip(data, sizeof(data), 64);
+}
+
+
+void
+LZ4Test::TextTest()
+{
+	static const char* kWords[] = {
+		"page ", "cache ", "swap ", "area ", "team ", "thread ", "vnode "
+	};
+
+	uint8 data[kPageSize];
+	size_t size = 0;
+	srand(42);
+	while (size < sizeof(data)) {
+		const char* word
+			= kWords[rand() % (sizeof(kWords) / sizeof(kWords[0]))];
+		size_t length = min_c(strlen(word), sizeof(data) - size);
+		memcpy(data + size, word, length);
+		size += length;
+	}
+
+	NextSubTest();
+	RoundTrip(data, sizeof(data), sizeof(data) / 2);
+}
+
+
+void
+LZ4Test::RandomTest()
+{
+	uint8 data[kPageSize];
+	srand(7);
+
+	for (int32 round = 0; round < 100; round++) {
+		NextSubTest();
+		size_t size = rand() % (sizeof(data) + 1);
+		for (size_t i = 0; i < size; i++)
+			data[i] = round % 2 == 0 ? rand() : rand() % 4;
+
+		// incompressible data must not grow by more than the literal overhead
+		RoundTrip(data, size, size + size / 255 + 16);
+	}
+}
+
+
+void
+LZ4Test::OverflowTest()
+{
+	uint8 workMemory[LZ4_WORK_MEMORY_SIZE];
+	uint8 data[kPageSize];
+	uint8 compressed[kPageSize * 2];
+
+	srand(13);
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+
+	NextSubTest();
+	ssize_t size = lz4_compress(data, sizeof(data), compressed,
+		sizeof(compressed), workMemory);
+	CHK(size > 0);
+
+	// any smaller buffer has to be rejected
+	NextSubTest();
+	CHK(lz4_compress(data, sizeof(data), compressed, size - 1, workMemory)
+		== B_BUFFER_OVERFLOW);
+	CHK(lz4_compress(data, sizeof(data), compressed, kPageSize / 2,
+		workMemory) == B_BUFFER_OVERFLOW);
+
+	// decompressing into a too small buffer has to fail
+	NextSubTest();
+	uint8 decompressed[kPageSize];
+	CHK(lz4_decompress(compressed, size, decompressed, kPageSize - 1)
+		== B_BAD_DATA);
+}
+
+
+void
+LZ4Test::CorruptTest()
+{
+	uint8 workMemory[LZ4_WORK_MEMORY_SIZE];
+	uint8 data[kPageSize];
+	uint8 compressed[kPageSize * 2];
+	uint8 decompressed[kPageSize];
+
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (i / 13) % 11;
+
+	ssize_t size = lz4_compress(data, sizeof(data), compressed,
+		sizeof(compressed), workMemory);
+	CHK(size > 0);
+
+	// truncated input
+	NextSubTest();
+	for (ssize_t length = 0; length < size; length++) {
+		ssize_t result = lz4_decompress(compressed, length, decompressed,
+			sizeof(decompressed));
+		CHK(result != (ssize_t)sizeof(decompressed));
+	}
+
+	// a match offset pointing before the start of the output
+	NextSubTest();
+	uint8 badOffset[] = { 0x10, 'a', 0x10, 0x00 };
+	CHK(lz4_decompress(badOffset, sizeof(badOffset), decompressed,
+		sizeof(decompressed)) == B_BAD_DATA);
+
+	// random corruption must never write out of bounds
+	NextSubTest();
+	srand(3);
+	for (int32 round = 0; round < 1000; round++) {
+		uint8 corrupt[kPageSize * 2];
+		memcpy(corrupt, compressed, size);
+		corrupt[rand() % size] = rand();
+		lz4_decompress(corrupt, size, decompressed, sizeof(decompressed));
+	}
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _lz4_test_h_
+#define _lz4_test_h_
+
+#include <SupportDefs.h>
+#include <TestCase.h>
+
+class LZ4Test : public BTestCase {
+public:
+	LZ4Test(std::string name = "");
+
+	static CppUnit::Test* Suite();
+
+	void EmptyTest();
+	void UniformTest();
+	void TextTest();
+	void RandomTest();
+	void OverflowTest();
+	void CorruptTest();
+
+private:
+	void RoundTrip(const uint8* data, size_t size, ssize_t maxCompressedSize);
+};
+
+#endif // _lz4_test_h_
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Allocation benchmarks for the malloc() implementation in use. To compare
+	with the Hoard based allocator, run it as
+		LD_PRELOAD=libroot_hoard.so malloc_benchmark
+*/
+
+
+#include <OS.h>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const int32 kMaxThreads = 16;
+static const int32 kQueueSize = 1024;
+
+
+struct mstats {
+	size_t bytes_total;
+	size_t chunks_used;
+	size_t bytes_used;
+	size_t chunks_free;
+	size_t bytes_free;
+};
+
+extern "C" struct mstats mstats(void);
+
+
+struct benchmark {
+	const char*	name;
+	void*		(*function)(void* data);
+};
+
+
+static int32 sThreadCount = 4;
+static int32 sIterations = 1000000;
+
+
+static inline uint32
+random_value(uint32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+
+static inline size_t
+random_size(uint32& seed)
+{
+	// mostly small objects, some medium sized ones, and a few large ones
+	uint32 value = random_value(seed);
+	switch (value % 64) {
+		case 0:
+			return 16384 + value % 262144;
+		case 1:
+		case 2:
+		case 3:
+			return 1024 + value % 8192;
+		default:
+			return 8 + value % 256;
+	}
+}
+
+
+// #pragma mark - alloc/free storm
+
+
+/*!	Every thread allocates and immediately frees objects of the same size.
+*/
+static void*
+storm_same_size_thread(void* /*data*/)
+{
+	for (int32 i = 0; i < sIterations; i++) {
+		void* object = malloc(64);
+		*(uint8*)object = 0;
+		free(object);
+	}
+
+	return NULL;
+}
+
+
+/*!	Every thread keeps a set of live objects of random sizes, and replaces
+	random ones of them.
+*/
+static void*
+storm_random_thread(void* data)
+{
+	static const int32 kSlots = 512;
+	void* slots[kSlots];
+	memset(slots, 0, sizeof(slots));
+
+	uint32 seed = (uint32)(addr_t)data;
+	for (int32 i = 0; i < sIterations; i++) {
+		int32 slot = random_value(seed) % kSlots;
+		free(slots[slot]);
+
+		size_t size = random_size(seed);
+		slots[slot] = malloc(size);
+		memset(slots[slot], 0, size < 64 ? size : 64);
+	}
+
+	for (int32 i = 0; i < kSlots; i++)
+		free(slots[i]);
+
+	return NULL;
+}
+
+
+// #pragma mark - producer/consumer
+
+
+struct queue {
+	pthread_mutex_t	lock;
+	pthread_cond_t	condition;
+	void*			objects[kQueueSize];
+	int32			count;
+	bool			done;
+};
+
+
+static queue sQueues[kMaxThreads];
+
+
+/*!	Threads are paired: the even one allocates objects and passes them to
+	the odd one, which frees them. This stresses frees of objects allocated
+	by other threads.
+*/
+static void*
+producer_consumer_thread(void* data)
+{
+	int32 index = (int32)(addr_t)data;
+	queue& queue = sQueues[index / 2];
+
+	if (index % 2 == 0) {
+		uint32 seed = index;
+		for (int32 i = 0; i < sIterations; i++) {
+			size_t size = 8 + random_value(seed) % 512;
+			void* object = malloc(size);
+			memset(object, 0, size < 64 ? size : 64);
+
+			pthread_mutex_lock(&queue.lock);
+			while (queue.count == kQueueSize)
+				pthread_cond_wait(&queue.condition, &queue.lock);
+			queue.objects[queue.count++] = object;
+			pthread_cond_broadcast(&queue.condition);
+			pthread_mutex_unlock(&queue.lock);
+		}
+
+		pthread_mutex_lock(&queue.lock);
+		queue.done = true;
+		pthread_cond_broadcast(&queue.condition);
+		pthread_mutex_unlock(&queue.lock);
+		return NULL;
+	}
+
+	void* objects[kQueueSize];
+	while (true) {
+		pthread_mutex_lock(&queue.lock);
+		while (queue.count == 0 && !queue.done)
+			pthread_cond_wait(&queue.condition, &queue.lock);
+
+		int32 count = queue.count;
+		memcpy(objects, queue.objects, count * sizeof(void*));
+		queue.count = 0;
+		bool done = queue.done;
+		pthread_cond_broadcast(&queue.condition);
+		pthread_mutex_unlock(&queue.lock);
+
+		for (int32 i = 0; i < count; i++)
+			free(objects[i]);
+
+		if (done && count == 0)
+			return NULL;
+	}
+}
+
+
+// #pragma mark - fragmentation
+
+
+/*!	Allocates many small objects, frees most of them, leaving a few live
+	ones scattered over the heap, and then allocates objects of another
+	size. A heap that doesn't reuse or return the freed memory grows with
+	every round.
+*/
+static void*
+fragmentation_thread(void* data)
+{
+	static const int32 kObjectCount = 65536;
+	static const int32 kRounds = 16;
+
+	void** objects = (void**)malloc(kObjectCount * sizeof(void*));
+	uint32 seed = (uint32)(addr_t)data;
+
+	for (int32 round = 0; round < kRounds; round++) {
+		size_t size = round % 2 == 0 ? 48 : 400;
+		for (int32 i = 0; i < kObjectCount; i++) {
+			objects[i] = malloc(size);
+			*(uint8*)objects[i] = 0;
+		}
+
+		// keep every 32nd object alive
+		for (int32 i = 0; i < kObjectCount; i++) {
+			if (i % 32 != 0)
+				free(objects[i]);
+		}
+
+		for (int32 i = 0; i < kObjectCount / 8; i++) {
+			void* object = malloc(random_size(seed));
+			free(object);
+		}
+
+		for (int32 i = 0; i < kObjectCount; i += 32)
+			free(objects[i]);
+	}
+
+	free(objects);
+	return NULL;
+}
+
+
+// #pragma mark -
+
+
+static const benchmark kBenchmarks[] = {
+	{ "storm-same-size", storm_same_size_thread },
+	{ "storm-random", storm_random_thread },
+	{ "producer-consumer", producer_consumer_thread },
+	{ "fragmentation", fragmentation_thread },
+};
+static const int32 kBenchmarkCount
+	= sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+
+static void
+run_benchmark(const benchmark& benchmark)
+{
+	for (int32 i = 0; i < kMaxThreads; i++) {
+		pthread_mutex_init(&sQueues[i].lock, NULL);
+		pthread_cond_init(&sQueues[i].condition, NULL);
+		sQueues[i].count = 0;
+		sQueues[i].done = false;
+	}
+
+	int32 threadCount = sThreadCount;
+	if (benchmark.function == producer_consumer_thread && threadCount % 2 != 0)
+		threadCount++;
+
+	pthread_t threads[kMaxThreads];
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		if (pthread_create(&threads[i], NULL, benchmark.function,
+				(void*)(addr_t)i) != 0) {
+			fprintf(stderr, "Could not create thread!\n");
+			exit(1);
+		}
+	}
+
+	for (int32 i = 0; i < threadCount; i++)
+		pthread_join(threads[i], NULL);
+
+	bigtime_t time = system_time() - start;
+	struct mstats stats = mstats();
+
+	printf("%-20s %2" B_PRId32 " threads %8" B_PRId64 " ms, heap %6" B_PRIuSIZE
+		" KiB, used %6" B_PRIuSIZE " KiB\n", benchmark.name, threadCount,
+		time / 1000, stats.bytes_total / 1024, stats.bytes_used / 1024);
+
+	for (int32 i = 0; i < kMaxThreads; i++) {
+		pthread_mutex_destroy(&sQueues[i].lock);
+		pthread_cond_destroy(&sQueues[i].condition);
+	}
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* name = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			sThreadCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+			sIterations = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			name = argv[i];
+		else {
+			fprintf(stderr, "usage: %s [-t <threads>] [-i <iterations>] "
+				"[<benchmark>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (sThreadCount < 1 || sThreadCount > kMaxThreads) {
+		fprintf(stderr, "The thread count must be between 1 and %" B_PRId32
+			".\n", kMaxThreads);
+		return 1;
+	}
+
+	bool found = false;
+	for (int32 i = 0; i < kBenchmarkCount; i++) {
+		if (name != NULL && strcmp(name, kBenchmarks[i].name) != 0)
+			continue;
+
+		run_benchmark(kBenchmarks[i]);
+		found = true;
+	}
+
+	if (!found) {
+		fprintf(stderr, "Unknown benchmark \"%s\".\n", name);
+		return 1;
+	}
+
+	return 0;
+}